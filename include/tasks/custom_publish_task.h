@@ -1,8 +1,8 @@
 /**
  * @file custom_publish_task.h
- * @brief Task de publicação de dados customizados
+ * @brief Job de publicação de dados customizados
  *
- * Esta task é responsável por publicar periodicamente dados
+ * Este job (executado pelo job_scheduler) publica periodicamente dados
  * customizados da aplicação via MQTT, incluindo:
  * - Contadores de loops
  * - Status operacional
@@ -15,30 +15,29 @@
 #ifndef CUSTOM_PUBLISH_TASK_H
 #define CUSTOM_PUBLISH_TASK_H
 
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
+#include "esp_err.h"
 
 /*
  * =============================================================================
- * CONFIGURAÇÕES DA TASK
+ * CONFIGURAÇÕES DO JOB
  * =============================================================================
  */
 
 /** @brief Intervalo de publicação em milissegundos (5 minutos) */
 #define CUSTOM_PUBLISH_INTERVAL_MS 300000
 
-/** @brief Tamanho da stack da task em bytes */
-#define CUSTOM_PUBLISH_TASK_STACK_SIZE 2560
-
-/** @brief Prioridade da task de publicação */
-#define CUSTOM_PUBLISH_TASK_PRIORITY 2
-
-/** @brief Nome da task para debug */
-#define CUSTOM_PUBLISH_TASK_NAME "CustomPublish"
+/** @brief Nome do job para debug */
+#define CUSTOM_PUBLISH_JOB_NAME "CustomPublish"
 
 /** @brief Tópico MQTT para publicação customizada */
 #define CUSTOM_PUBLISH_TOPIC "demo/central/custom"
 
+/** @brief Variação mínima para republicar luminosidade e temperatura */
+#define CUSTOM_PUBLISH_DEADBAND 1.0f
+
+/** @brief Republicação forçada sem mudança (30 minutos) */
+#define CUSTOM_PUBLISH_HEARTBEAT_MS 1800000
+
 /*
  * =============================================================================
  * PROTÓTIPOS DE FUNÇÕES
@@ -46,13 +45,23 @@
  */
 
 /**
- * @brief Função da task de publicação de dados customizados
+ * @brief Registra as políticas de deadband dos tópicos do job
+ *
+ * Deve ser chamada uma vez, antes de registrar o job.
+ *
+ * @return ESP_OK ou o erro de report_policy_register()
+ */
+esp_err_t custom_publish_init(void);
+
+/**
+ * @brief Callback do job de publicação de dados customizados
  *
- * Esta task publica periodicamente dados específicos da aplicação
- * via MQTT, permitindo monitoramento remoto do estado operacional.
+ * Registrada com período CUSTOM_PUBLISH_INTERVAL_MS; publica dados
+ * específicos da aplicação via MQTT, permitindo monitoramento remoto do
+ * estado operacional.
  *
- * @param pvParameters Parâmetros passados para a task (não utilizado)
+ * @param ctx Contexto do job (não utilizado)
  */
-void custom_publish_task(void *pvParameters);
+void custom_publish_job(void *ctx);
 
 #endif /* CUSTOM_PUBLISH_TASK_H */
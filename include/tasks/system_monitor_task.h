@@ -1,8 +1,8 @@
 /**
  * @file system_monitor_task.h
- * @brief Task de monitoramento do sistema
+ * @brief Job de monitoramento do sistema
  *
- * Esta task é responsável por monitorar periodicamente:
+ * Este job (executado pelo job_scheduler) monitora periodicamente:
  * - Status de conectividade MQTT
  * - Estatísticas de mensagens
  * - Saúde do sistema (heap, WiFi, uptime)
@@ -15,26 +15,17 @@
 #ifndef SYSTEM_MONITOR_TASK_H
 #define SYSTEM_MONITOR_TASK_H
 
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-
 /*
  * =============================================================================
- * CONFIGURAÇÕES DA TASK
+ * CONFIGURAÇÕES DO JOB
  * =============================================================================
  */
 
 /** @brief Intervalo de monitoramento em milissegundos (1 minuto) */
 #define MONITOR_INTERVAL_MS 60000
 
-/** @brief Tamanho da stack da task em bytes */
-#define MONITOR_TASK_STACK_SIZE 3072
-
-/** @brief Prioridade da task de monitoramento */
-#define MONITOR_TASK_PRIORITY 3
-
-/** @brief Nome da task para debug */
-#define MONITOR_TASK_NAME "SystemMonitor"
+/** @brief Nome do job para debug */
+#define MONITOR_JOB_NAME "SystemMonitor"
 
 /*
  * =============================================================================
@@ -43,16 +34,16 @@
  */
 
 /**
- * @brief Função da task de monitoramento do sistema
+ * @brief Callback do job de monitoramento do sistema
  *
- * Esta task executa periodicamente verificações de:
+ * Registrada com período MONITOR_INTERVAL_MS; executa verificações de:
  * - Conectividade MQTT
  * - Estatísticas de comunicação
  * - Status de saúde do sistema
  * - Alertas de memória e WiFi
  *
- * @param pvParameters Parâmetros passados para a task (não utilizado)
+ * @param ctx Contexto do job (não utilizado)
  */
-void system_monitor_task(void *pvParameters);
+void system_monitor_job(void *ctx);
 
 #endif /* SYSTEM_MONITOR_TASK_H */
@@ -0,0 +1,67 @@
+/**
+ * @file bench_report.c
+ * @brief Saída legível por máquina dos benchmarks - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#if defined(CONFIG_BENCHMARK_MODE) || defined(CONFIG_LOADGEN_MODE)
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "bench/bench_report.h"
+#include "services/json_writer.h"
+
+#include <stdio.h>
+#include "esp_log.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "BENCH_REPORT";
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+void bench_report(const char *suite, const char *name,
+                  const bench_metric_t *metrics, int count)
+{
+    char line[BENCH_REPORT_LINE_MAX];
+    json_writer_t jw;
+    json_writer_init(&jw, line, sizeof(line));
+
+    json_begin_object(&jw);
+    json_add_string(&jw, "suite", suite);
+    json_add_string(&jw, "case", name);
+    for (int i = 0; i < count; i++)
+    {
+        json_add_uint(&jw, metrics[i].key, metrics[i].value);
+    }
+    json_end_object(&jw);
+
+    int len = json_writer_finish(&jw);
+    if (len < 0)
+    {
+        ESP_LOGW(TAG, "Resultado de '%s' maior que a linha", name);
+        return;
+    }
+
+    printf(BENCH_REPORT_PREFIX "%.*s\n", len, line);
+}
+
+void bench_report_done(const char *suite)
+{
+    printf(BENCH_REPORT_DONE_PREFIX "{\"suite\":\"%s\"}\n", suite);
+}
+
+#endif /* CONFIG_BENCHMARK_MODE || CONFIG_LOADGEN_MODE */
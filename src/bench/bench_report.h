@@ -0,0 +1,46 @@
+/**
+ * @file bench_report.h
+ * @brief Saída legível por máquina dos benchmarks
+ *
+ * Além da tabela no log, cada resultado é impresso numa linha própria:
+ *
+ *   BENCH {"suite":"publish","case":"publish_data_qos0","cycles":1834,...}
+ *
+ * e cada suíte termina com "BENCH_DONE {"suite":...}". As linhas vão
+ * direto para o console (sem prefixo do ESP_LOG), para que
+ * tools/bench_check.py as extraia do monitor serial ou da saída do QEMU e
+ * compare com uma referência. Usado pelos benchmarks (CONFIG_BENCHMARK_MODE)
+ * e pelo gerador de carga (CONFIG_LOADGEN_MODE, loadgen.h).
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <stdint.h>
+
+#define BENCH_REPORT_PREFIX "BENCH "		   ///< Prefixo das linhas de resultado
+#define BENCH_REPORT_DONE_PREFIX "BENCH_DONE " ///< Prefixo do fim de uma suíte
+#define BENCH_REPORT_LINE_MAX 512			   ///< Tamanho máximo de uma linha
+
+/** Métrica de um resultado */
+typedef struct
+{
+	const char *key; ///< Nome da métrica
+	uint32_t value;	 ///< Valor (inteiro, na unidade do nome)
+} bench_metric_t;
+
+/**
+ * @brief Imprime o resultado de um caso
+ */
+void bench_report(const char *suite, const char *name,
+				  const bench_metric_t *metrics, int count);
+
+/**
+ * @brief Marca o fim de uma suíte
+ */
+void bench_report_done(const char *suite);
+
+#endif /* BENCH_REPORT_H */
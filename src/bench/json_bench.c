@@ -0,0 +1,270 @@
+/**
+ * @file json_bench.c
+ * @brief Microbenchmark dos serializadores - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifdef CONFIG_BENCHMARK_MODE
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "bench/json_bench.h"
+#include "bench/bench_report.h"
+#include "services/mqtt_system.h"
+#include "services/payload_codec.h"
+
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "JSON_BENCH";
+
+typedef int (*bench_encode_fn_t)(uint8_t *buf, size_t cap, uint32_t i);
+
+/** Variante medida */
+typedef struct
+{
+    const char *name;
+    bench_encode_fn_t encode;
+} bench_case_t;
+
+/** Resultado de uma variante, preenchido pela task de medição */
+typedef struct
+{
+    const bench_case_t *bench;
+    uint32_t cycles;
+    int bytes;
+    uint32_t stack_used;
+    TaskHandle_t caller;
+} bench_result_t;
+
+static telemetry_data_t s_telemetry = {
+    .temperatura = 23.456f,
+    .umidade = 55.5f,
+    .contador = 0,
+    .timestamp = 1234567890ULL,
+};
+
+static health_status_t s_health = {
+    .free_heap = 187432,
+    .min_free_heap = 165200,
+    .wifi_rssi = -63,
+    .uptime_sec = 86400,
+    .mqtt_connected = true,
+};
+
+static mqtt_statistics_t s_stats = {
+    .total_publicadas = 12345,
+    .total_recebidas = 678,
+    .falhas_publicacao = 2,
+    .desconexoes = 1,
+};
+
+/*
+ * =============================================================================
+ * VARIANTES
+ * =============================================================================
+ */
+
+/** Serialização original (antes do json_writer) */
+static int telemetry_snprintf(uint8_t *buf, size_t cap, uint32_t i)
+{
+    s_telemetry.contador = i;
+    return snprintf((char *)buf, cap,
+                    "{"
+                    "\"temperatura\":%.2f,"
+                    "\"umidade\":%.2f,"
+                    "\"contador\":%lu,"
+                    "\"timestamp\":%llu"
+                    "}",
+                    s_telemetry.temperatura,
+                    s_telemetry.umidade,
+                    s_telemetry.contador,
+                    s_telemetry.timestamp);
+}
+
+static int telemetry_json(uint8_t *buf, size_t cap, uint32_t i)
+{
+    s_telemetry.contador = i;
+    return payload_encode_telemetry(MQTT_PAYLOAD_FORMAT_JSON, &s_telemetry,
+                                    buf, cap);
+}
+
+static int telemetry_cbor(uint8_t *buf, size_t cap, uint32_t i)
+{
+    s_telemetry.contador = i;
+    return payload_encode_telemetry(MQTT_PAYLOAD_FORMAT_CBOR, &s_telemetry,
+                                    buf, cap);
+}
+
+static int telemetry_packed(uint8_t *buf, size_t cap, uint32_t i)
+{
+    s_telemetry.contador = i;
+    return payload_encode_telemetry(MQTT_PAYLOAD_FORMAT_PACKED, &s_telemetry,
+                                    buf, cap);
+}
+
+/** Serialização original (antes do json_writer) */
+static int health_snprintf(uint8_t *buf, size_t cap, uint32_t i)
+{
+    s_stats.total_publicadas = i;
+    return snprintf((char *)buf, cap,
+                    "{"
+                    "\"free_heap\":%lu,"
+                    "\"min_free_heap\":%lu,"
+                    "\"wifi_rssi\":%d,"
+                    "\"uptime_sec\":%llu,"
+                    "\"mqtt_connected\":%d,"
+                    "\"msgs_sent\":%lu,"
+                    "\"msgs_received\":%lu,"
+                    "\"mqtt_failures\":%lu,"
+                    "\"disconnects\":%lu"
+                    "}",
+                    s_health.free_heap,
+                    s_health.min_free_heap,
+                    s_health.wifi_rssi,
+                    s_health.uptime_sec,
+                    s_health.mqtt_connected ? 1 : 0,
+                    s_stats.total_publicadas,
+                    s_stats.total_recebidas,
+                    s_stats.falhas_publicacao,
+                    s_stats.desconexoes);
+}
+
+static int health_json(uint8_t *buf, size_t cap, uint32_t i)
+{
+    s_stats.total_publicadas = i;
+    return payload_encode_health(MQTT_PAYLOAD_FORMAT_JSON, &s_health,
+                                 &s_stats, buf, cap);
+}
+
+static int health_cbor(uint8_t *buf, size_t cap, uint32_t i)
+{
+    s_stats.total_publicadas = i;
+    return payload_encode_health(MQTT_PAYLOAD_FORMAT_CBOR, &s_health,
+                                 &s_stats, buf, cap);
+}
+
+static int health_packed(uint8_t *buf, size_t cap, uint32_t i)
+{
+    s_stats.total_publicadas = i;
+    return payload_encode_health(MQTT_PAYLOAD_FORMAT_PACKED, &s_health,
+                                 &s_stats, buf, cap);
+}
+
+static const bench_case_t s_cases[] = {
+    {"telemetry snprintf", telemetry_snprintf},
+    {"telemetry json_writer", telemetry_json},
+    {"telemetry cbor", telemetry_cbor},
+    {"telemetry packed", telemetry_packed},
+    {"health snprintf", health_snprintf},
+    {"health json_writer", health_json},
+    {"health cbor", health_cbor},
+    {"health packed", health_packed},
+};
+
+/*
+ * =============================================================================
+ * MEDIÇÃO
+ * =============================================================================
+ */
+
+/**
+ * @brief Task de medição de uma variante
+ *
+ * Não usa log: a stack medida deve refletir apenas a serialização.
+ */
+static void bench_task(void *pvParameters)
+{
+    bench_result_t *result = (bench_result_t *)pvParameters;
+    uint8_t buf[512];
+    int bytes = 0;
+
+    /* Aquecimento do cache de instruções */
+    result->bench->encode(buf, sizeof(buf), 0);
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (uint32_t i = 0; i < JSON_BENCH_ITERATIONS; i++)
+    {
+        bytes = result->bench->encode(buf, sizeof(buf), i);
+    }
+    uint32_t elapsed = esp_cpu_get_cycle_count() - start;
+
+    result->cycles = elapsed / JSON_BENCH_ITERATIONS;
+    result->bytes = bytes;
+    result->stack_used = JSON_BENCH_TASK_STACK_SIZE -
+                         uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t);
+
+    xTaskNotifyGive(result->caller);
+    vTaskDelete(NULL);
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+void json_bench_run(void)
+{
+    const uint32_t cpu_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+
+    ESP_LOGI(TAG, "=== Benchmark de serializacao (%d mensagens, CPU %lu MHz) ===",
+             JSON_BENCH_ITERATIONS, cpu_mhz);
+    ESP_LOGI(TAG, "%-24s %10s %8s %8s %8s", "variante", "ciclos/msg", "us/msg",
+             "bytes", "stack");
+
+    for (size_t c = 0; c < sizeof(s_cases) / sizeof(s_cases[0]); c++)
+    {
+        bench_result_t result = {
+            .bench = &s_cases[c],
+            .caller = xTaskGetCurrentTaskHandle(),
+        };
+
+        /* Mesmo núcleo e prioridade acima das demais tasks */
+        if (xTaskCreatePinnedToCore(bench_task, "JsonBench",
+                                    JSON_BENCH_TASK_STACK_SIZE, &result,
+                                    configMAX_PRIORITIES - 2, NULL,
+                                    xPortGetCoreID()) != pdPASS)
+        {
+            ESP_LOGE(TAG, "Falha ao criar task de medicao");
+            return;
+        }
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t ns = result.cycles * 1000 / cpu_mhz;
+        ESP_LOGI(TAG, "%-24s %10lu %5lu.%02lu %8d %8lu", s_cases[c].name,
+                 result.cycles, ns / 1000, (ns % 1000) / 10, result.bytes,
+                 result.stack_used);
+
+        const bench_metric_t metrics[] = {
+            {"cycles", result.cycles},
+            {"ns", ns},
+            {"bytes", (uint32_t)result.bytes},
+            {"stack", result.stack_used},
+        };
+        bench_report("json", s_cases[c].name, metrics,
+                     sizeof(metrics) / sizeof(metrics[0]));
+    }
+
+    bench_report_done("json");
+
+    ESP_LOGI(TAG, "=== Fim do benchmark ===");
+}
+
+#endif /* CONFIG_BENCHMARK_MODE */
@@ -0,0 +1,30 @@
+/**
+ * @file json_bench.h
+ * @brief Microbenchmark dos serializadores de telemetria e health check
+ *
+ * Compara, em ciclos de CPU por mensagem, a serialização original com
+ * snprintf e as implementações atuais (json_writer, CBOR e PACKED).
+ * Cada variante roda em uma task própria para medir também o pico de
+ * stack. Compilado apenas com CONFIG_BENCHMARK_MODE (ambiente
+ * esp32-bench do platformio.ini), substituindo a aplicação normal.
+ * Os resultados também saem como linhas BENCH (bench_report.h).
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef JSON_BENCH_H
+#define JSON_BENCH_H
+
+/** Mensagens serializadas por variante */
+#define JSON_BENCH_ITERATIONS 2000
+
+/** Stack de cada task de medição */
+#define JSON_BENCH_TASK_STACK_SIZE 4096
+
+/**
+ * @brief Executa todas as variantes e imprime a tabela de resultados
+ */
+void json_bench_run(void);
+
+#endif /* JSON_BENCH_H */
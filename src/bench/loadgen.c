@@ -0,0 +1,629 @@
+/**
+ * @file loadgen.c
+ * @brief Gerador de carga: N dispositivos virtuais contra o broker - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifdef CONFIG_LOADGEN_MODE
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "bench/loadgen.h"
+#include "bench/bench_report.h"
+#include "services/mqtt_system.h"
+#include "services/app_config.h"
+#include "services/mqtt_tls.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "mqtt_client.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+#if defined(CONFIG_BENCHMARK_MODE) || defined(CONFIG_DEEP_SLEEP_MODE)
+#error "CONFIG_LOADGEN_MODE precisa do cliente MQTT real e da aplicacao continua"
+#endif
+
+_Static_assert(LOADGEN_CLIENTS >= 1 && LOADGEN_CLIENTS <= LOADGEN_MAX_CLIENTS,
+               "CONFIG_LOADGEN_CLIENTS fora da faixa");
+_Static_assert(LOADGEN_PAYLOAD_MIN >= 48 && LOADGEN_PAYLOAD_MIN <= LOADGEN_PAYLOAD_MAX &&
+                   LOADGEN_PAYLOAD_MAX <= LOADGEN_BUFFER_SIZE - 128,
+               "CONFIG_LOADGEN_PAYLOAD_MIN/MAX fora da faixa");
+_Static_assert(LOADGEN_QOS1_PCT >= 0 && LOADGEN_QOS1_PCT <= 100,
+               "CONFIG_LOADGEN_QOS1_PCT fora da faixa");
+
+static const char *TAG = "LOADGEN";
+
+#define INTERVAL_US ((int64_t)LOADGEN_INTERVAL_MS * 1000)
+
+/** Estado de uma QoS 1 rastreada (como em mqtt_inflight.c) */
+typedef enum
+{
+    SLOT_FREE = 0, ///< Livre
+    SLOT_WAITING,  ///< Publicada, aguardando ACK
+    SLOT_EARLY_ACK ///< ACK recebido antes do registro pelo publicador
+} slot_state_t;
+
+typedef struct
+{
+    int msg_id;         ///< ID da mensagem
+    int64_t stamp_us;   ///< Envio (WAITING) ou ACK (EARLY_ACK)
+    slot_state_t state; ///< Estado
+} pending_slot_t;
+
+/** Dispositivo virtual */
+typedef struct
+{
+    esp_mqtt_client_handle_t client;
+    char client_id[48];
+    char topic[80];
+    pending_slot_t pending[LOADGEN_PENDING_SLOTS]; ///< Protegido por s_lock
+    int64_t next_us;                               ///< Próxima publicação
+    uint32_t rng;                                  ///< Gerador próprio: sequência independe das demais
+    uint32_t seq;
+    uint32_t publish_gen; ///< s_phase_gen durante a publicação, 0 fora dela (s_lock)
+    volatile bool connected;
+} vdev_t;
+
+/** Métricas da fase em andamento (s_lock) */
+typedef struct
+{
+    uint32_t sent;
+    uint32_t sent_qos1;
+    uint32_t bytes;
+    uint32_t failures;
+    uint32_t late;
+    uint32_t acks;
+    uint32_t untracked;
+    uint32_t expired;
+    uint32_t disconnects;
+    uint32_t max_us;
+    uint32_t hist[LOADGEN_LATENCY_BUCKETS];
+} phase_window_t;
+
+/** Limite superior (exclusivo) das faixas do histograma; a última é aberta */
+static const uint32_t s_bounds_us[LOADGEN_LATENCY_BUCKETS - 1] = {
+    250, 500, 1000, 2000, 5000, 10000, 20000, 50000,
+    100000, 200000, 500000, 1000000, 2000000, 5000000, 10000000};
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+static vdev_t s_devs[LOADGEN_CLIENTS];
+static int s_started = 0;
+
+/** O cliente copia o URI na criação; a cópia vale para todas as fases */
+static char s_broker_uri[APP_CONFIG_URI_MAX_LEN];
+
+/** Payload montado pela task do gerador antes de cada publicação */
+static char s_payload[LOADGEN_PAYLOAD_MAX];
+
+/** Seções curtas: task do gerador + tasks esp-mqtt de cada cliente */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static phase_window_t s_window;
+
+/** Incrementada a cada fase (s_lock); 0 nunca é uma fase */
+static uint32_t s_phase_gen = 0;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES (pending_*: chamadas com s_lock)
+ * =============================================================================
+ */
+
+static uint32_t next_random(uint32_t *state)
+{
+    /* xorshift32 */
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void record_latency(uint32_t latency_us)
+{
+    int bucket = 0;
+    while (bucket < LOADGEN_LATENCY_BUCKETS - 1 && latency_us >= s_bounds_us[bucket])
+    {
+        bucket++;
+    }
+
+    s_window.hist[bucket]++;
+    s_window.acks++;
+    if (latency_us > s_window.max_us)
+    {
+        s_window.max_us = latency_us;
+    }
+}
+
+static pending_slot_t *pending_find(vdev_t *dev, int msg_id)
+{
+    for (int i = 0; i < LOADGEN_PENDING_SLOTS; i++)
+    {
+        if (dev->pending[i].state != SLOT_FREE && dev->pending[i].msg_id == msg_id)
+        {
+            return &dev->pending[i];
+        }
+    }
+    return NULL;
+}
+
+/** Entrada livre; com a tabela cheia, a mais antiga deixa de ser rastreada */
+static pending_slot_t *pending_alloc(vdev_t *dev)
+{
+    pending_slot_t *oldest = NULL;
+
+    for (int i = 0; i < LOADGEN_PENDING_SLOTS; i++)
+    {
+        pending_slot_t *slot = &dev->pending[i];
+
+        if (slot->state == SLOT_FREE)
+        {
+            return slot;
+        }
+        if (oldest == NULL || slot->stamp_us < oldest->stamp_us)
+        {
+            oldest = slot;
+        }
+    }
+
+    if (oldest->state == SLOT_WAITING)
+    {
+        s_window.untracked++;
+    }
+    return oldest;
+}
+
+static void pending_track(vdev_t *dev, int msg_id, int64_t start_us)
+{
+    pending_slot_t *slot = pending_find(dev, msg_id);
+
+    if (slot != NULL && slot->state == SLOT_EARLY_ACK)
+    {
+        record_latency((uint32_t)(slot->stamp_us - start_us));
+        slot->state = SLOT_FREE;
+        return;
+    }
+
+    if (slot == NULL)
+    {
+        slot = pending_alloc(dev);
+    }
+    slot->msg_id = msg_id;
+    slot->stamp_us = start_us;
+    slot->state = SLOT_WAITING;
+}
+
+static void pending_ack(vdev_t *dev, int msg_id)
+{
+    int64_t now = esp_timer_get_time();
+    pending_slot_t *slot = pending_find(dev, msg_id);
+
+    if (slot != NULL && slot->state == SLOT_WAITING)
+    {
+        record_latency((uint32_t)(now - slot->stamp_us));
+        slot->state = SLOT_FREE;
+    }
+    else if (slot == NULL && dev->publish_gen == s_phase_gen)
+    {
+        /*
+         * ACK antes do registro só existe com a publicação em andamento;
+         * fora dela é de uma fase anterior (tabela zerada) ou de uma
+         * entrada já sem rastreio e é ignorado, para não casar com um
+         * msg_id reutilizado depois
+         */
+        slot = pending_alloc(dev);
+        slot->msg_id = msg_id;
+        slot->stamp_us = now;
+        slot->state = SLOT_EARLY_ACK;
+    }
+}
+
+/** Publicação expirada no outbox: sai dos pendentes para não contar duas vezes */
+static void pending_drop(vdev_t *dev, int msg_id)
+{
+    pending_slot_t *slot = pending_find(dev, msg_id);
+
+    if (slot != NULL && slot->state == SLOT_WAITING)
+    {
+        slot->state = SLOT_FREE;
+    }
+}
+
+static uint32_t percentile(const phase_window_t *w, uint32_t pct)
+{
+    if (w->acks == 0)
+    {
+        return 0;
+    }
+
+    /* Primeira faixa em que a contagem acumulada alcança o percentil */
+    uint32_t target = (uint32_t)(((uint64_t)w->acks * pct + 99) / 100);
+    uint32_t cumulative = 0;
+    for (int bucket = 0; bucket < LOADGEN_LATENCY_BUCKETS - 1; bucket++)
+    {
+        cumulative += w->hist[bucket];
+        if (cumulative >= target)
+        {
+            return s_bounds_us[bucket] < w->max_us ? s_bounds_us[bucket] : w->max_us;
+        }
+    }
+    return w->max_us;
+}
+
+static int connected_count(int count)
+{
+    int connected = 0;
+    for (int i = 0; i < count; i++)
+    {
+        connected += s_devs[i].connected ? 1 : 0;
+    }
+    return connected;
+}
+
+/*
+ * =============================================================================
+ * HANDLERS
+ * =============================================================================
+ */
+
+/** Eventos de um dispositivo virtual (task esp-mqtt do cliente) */
+static void vdev_event_handler(void *handler_args, esp_event_base_t base,
+                               int32_t event_id, void *event_data)
+{
+    vdev_t *dev = (vdev_t *)handler_args;
+    esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)event_data;
+
+    switch ((esp_mqtt_event_id_t)event_id)
+    {
+    case MQTT_EVENT_CONNECTED:
+        dev->connected = true;
+        break;
+
+    case MQTT_EVENT_DISCONNECTED:
+        if (dev->connected)
+        {
+            portENTER_CRITICAL(&s_lock);
+            s_window.disconnects++;
+            portEXIT_CRITICAL(&s_lock);
+        }
+        dev->connected = false;
+        break;
+
+    case MQTT_EVENT_PUBLISHED:
+        portENTER_CRITICAL(&s_lock);
+        pending_ack(dev, event->msg_id);
+        portEXIT_CRITICAL(&s_lock);
+        break;
+
+    case MQTT_EVENT_DELETED:
+        /* Expirou no outbox sem ACK: conta em expiradas, não em sem ACK */
+        portENTER_CRITICAL(&s_lock);
+        pending_drop(dev, event->msg_id);
+        s_window.expired++;
+        portEXIT_CRITICAL(&s_lock);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/*
+ * =============================================================================
+ * DISPOSITIVOS VIRTUAIS
+ * =============================================================================
+ */
+
+static esp_err_t vdev_start(vdev_t *dev, int index)
+{
+    snprintf(dev->client_id, sizeof(dev->client_id), "%s-lg%02d",
+             CONFIG_MQTT_CLIENT_ID, index);
+    snprintf(dev->topic, sizeof(dev->topic), LOADGEN_TOPIC_PREFIX "/%s/data",
+             dev->client_id);
+
+    dev->rng = LOADGEN_SEED ^ ((uint32_t)(index + 1) * 0x9e3779b9u);
+    if (dev->rng == 0)
+    {
+        dev->rng = 1;
+    }
+    dev->seq = 0;
+
+    esp_mqtt_client_config_t cfg = {
+        .broker.address.uri = s_broker_uri,
+        .credentials = {
+            .client_id = dev->client_id,
+            .username = CONFIG_MQTT_USERNAME,
+            .authentication = {
+                .password = CONFIG_MQTT_PASSWORD,
+            }},
+        .session.keepalive = MQTT_KEEPALIVE_SEC,
+        .network.timeout_ms = MQTT_TIMEOUT_MS,
+        .buffer.size = LOADGEN_BUFFER_SIZE,
+        .buffer.out_size = LOADGEN_BUFFER_SIZE,
+        .task.stack_size = LOADGEN_CLIENT_STACK_SIZE,
+    };
+
+    esp_err_t ret = mqtt_tls_configure(&cfg);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    dev->client = esp_mqtt_client_init(&cfg);
+    if (dev->client == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ret = esp_mqtt_client_register_event(dev->client, ESP_EVENT_ANY_ID,
+                                         vdev_event_handler, dev);
+    if (ret == ESP_OK)
+    {
+        ret = esp_mqtt_client_start(dev->client);
+    }
+    if (ret != ESP_OK)
+    {
+        esp_mqtt_client_destroy(dev->client);
+        dev->client = NULL;
+    }
+    return ret;
+}
+
+static void vdev_publish(vdev_t *dev)
+{
+    int len = LOADGEN_PAYLOAD_MIN +
+              (int)(next_random(&dev->rng) % (LOADGEN_PAYLOAD_MAX - LOADGEN_PAYLOAD_MIN + 1));
+    int qos = (next_random(&dev->rng) % 100) < LOADGEN_QOS1_PCT ? 1 : 0;
+
+    /* {"seq":<n>,"qos":<q>,"pad":"xxx...x"} com exatamente len bytes */
+    int head = snprintf(s_payload, sizeof(s_payload), "{\"seq\":%lu,\"qos\":%d,\"pad\":\"",
+                        dev->seq++, qos);
+    memset(s_payload + head, 'x', len - head - 2);
+    s_payload[len - 2] = '"';
+    s_payload[len - 1] = '}';
+
+    portENTER_CRITICAL(&s_lock);
+    dev->publish_gen = s_phase_gen;
+    portEXIT_CRITICAL(&s_lock);
+
+    int64_t start_us = esp_timer_get_time();
+    int msg_id = esp_mqtt_client_publish(dev->client, dev->topic, s_payload, len, qos, 0);
+
+    portENTER_CRITICAL(&s_lock);
+    dev->publish_gen = 0;
+    if (msg_id < 0)
+    {
+        s_window.failures++;
+    }
+    else
+    {
+        s_window.sent++;
+        s_window.bytes += len;
+        if (qos > 0)
+        {
+            s_window.sent_qos1++;
+            pending_track(dev, msg_id, start_us);
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/*
+ * =============================================================================
+ * FASES
+ * =============================================================================
+ */
+
+static void report_phase(int count, int connected, uint32_t heap_base)
+{
+    phase_window_t w;
+    uint32_t unacked = 0;
+
+    portENTER_CRITICAL(&s_lock);
+    w = s_window;
+    for (int i = 0; i < count; i++)
+    {
+        for (int j = 0; j < LOADGEN_PENDING_SLOTS; j++)
+        {
+            unacked += s_devs[i].pending[j].state == SLOT_WAITING ? 1 : 0;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    uint32_t free_heap = esp_get_free_heap_size();
+    uint32_t heap_per_client = connected > 0 && heap_base > free_heap
+                                   ? (heap_base - free_heap) / connected
+                                   : 0;
+
+    uint32_t target_s = (uint32_t)((uint64_t)count * 1000 / LOADGEN_INTERVAL_MS);
+    uint32_t sent_s = (uint32_t)((uint64_t)w.sent * 1000 / LOADGEN_PHASE_MS);
+    uint32_t acked_s = (uint32_t)((uint64_t)w.acks * 1000 / LOADGEN_PHASE_MS);
+    uint32_t bytes_s = (uint32_t)((uint64_t)w.bytes * 1000 / LOADGEN_PHASE_MS);
+
+    ESP_LOGI(TAG, "=== %d dispositivos (%d conectados) ===", count, connected);
+    ESP_LOGI(TAG, "  msgs/s     : alvo %lu, enviadas %lu (%lu B/s), confirmadas %lu",
+             target_s, sent_s, bytes_s, acked_s);
+    ESP_LOGI(TAG, "  ACK (us)   : p50=%lu p90=%lu p99=%lu max=%lu (%lu amostras)",
+             percentile(&w, 50), percentile(&w, 90), percentile(&w, 99),
+             w.max_us, w.acks);
+    ESP_LOGI(TAG, "  Perdas     : sem ACK=%lu expiradas=%lu sem rastreio=%lu "
+                  "falhas=%lu atrasadas=%lu desconexoes=%lu",
+             unacked, w.expired, w.untracked, w.failures, w.late, w.disconnects);
+    ESP_LOGI(TAG, "  Heap       : %lu bytes por cliente, %lu livres",
+             heap_per_client, free_heap);
+
+    char name[24];
+    snprintf(name, sizeof(name), "clients_%d", count);
+
+    const bench_metric_t metrics[] = {
+        {"connected", (uint32_t)connected},
+        {"target_msgs_s", target_s},
+        {"msgs_s", sent_s},
+        {"acked_msgs_s", acked_s},
+        {"bytes_s", bytes_s},
+        {"ack_p50_us", percentile(&w, 50)},
+        {"ack_p90_us", percentile(&w, 90)},
+        {"ack_p99_us", percentile(&w, 99)},
+        {"ack_max_us", w.max_us},
+        {"unacked", unacked + w.expired},
+        {"late", w.late},
+        {"failures", w.failures},
+        {"disconnects", w.disconnects},
+        {"heap_per_client", heap_per_client},
+        {"free_heap", free_heap},
+    };
+    bench_report("loadgen", name, metrics, sizeof(metrics) / sizeof(metrics[0]));
+}
+
+static void run_phase(int count, uint32_t heap_base)
+{
+    for (; s_started < count; s_started++)
+    {
+        esp_err_t ret = vdev_start(&s_devs[s_started], s_started);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Falha ao criar o dispositivo %d: %s", s_started,
+                     esp_err_to_name(ret));
+            break;
+        }
+    }
+    count = s_started;
+
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)LOADGEN_CONNECT_TIMEOUT_MS * 1000;
+    while (connected_count(count) < count && esp_timer_get_time() < deadline_us)
+    {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    int connected = connected_count(count);
+    if (connected < count)
+    {
+        ESP_LOGW(TAG, "Apenas %d de %d dispositivos conectaram", connected, count);
+    }
+
+    /* ACKs atrasados da fase anterior deixam de ser aceitos como antecipados */
+    portENTER_CRITICAL(&s_lock);
+    s_phase_gen++;
+    memset(&s_window, 0, sizeof(s_window));
+    for (int i = 0; i < count; i++)
+    {
+        memset(s_devs[i].pending, 0, sizeof(s_devs[i].pending));
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    /* Partidas espalhadas no intervalo: sem rajadas sincronizadas */
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < count; i++)
+    {
+        s_devs[i].next_us = start_us + INTERVAL_US * i / count;
+    }
+
+    int64_t end_us = start_us + (int64_t)LOADGEN_PHASE_MS * 1000;
+    TickType_t wake = xTaskGetTickCount();
+    int64_t now;
+
+    while ((now = esp_timer_get_time()) < end_us)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            vdev_t *dev = &s_devs[i];
+            if (dev->next_us > now)
+            {
+                continue;
+            }
+
+            if (dev->connected)
+            {
+                vdev_publish(dev);
+            }
+            dev->next_us += INTERVAL_US;
+
+            /* Mais de um intervalo atrasado: pula em vez de disparar em rajada */
+            if (dev->next_us <= now)
+            {
+                uint32_t skipped = (uint32_t)((now - dev->next_us) / INTERVAL_US) + 1;
+                dev->next_us += INTERVAL_US * skipped;
+                portENTER_CRITICAL(&s_lock);
+                s_window.late += skipped;
+                portEXIT_CRITICAL(&s_lock);
+            }
+        }
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(LOADGEN_TICK_MS));
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(LOADGEN_ACK_GRACE_MS));
+    report_phase(count, connected, heap_base);
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+void loadgen_run(void)
+{
+    app_config_t cfg;
+    app_config_get(&cfg);
+    memcpy(s_broker_uri, cfg.broker_uri, sizeof(s_broker_uri));
+
+    ESP_LOGI(TAG, "Gerador de carga: ate %d dispositivos em %s", LOADGEN_CLIENTS,
+             s_broker_uri);
+    ESP_LOGI(TAG, "  1 msg a cada %d ms por dispositivo, %d%% QoS 1, payload %d-%d bytes, "
+                  "fases de %d ms",
+             LOADGEN_INTERVAL_MS, LOADGEN_QOS1_PCT, LOADGEN_PAYLOAD_MIN,
+             LOADGEN_PAYLOAD_MAX, LOADGEN_PHASE_MS);
+
+    if (mqtt_system_wait_connected(LOADGEN_CONNECT_TIMEOUT_MS) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Broker inacessivel, gerador de carga cancelado");
+        return;
+    }
+
+    /* Heap com o cliente principal já conectado: a diferença é dos virtuais */
+    uint32_t heap_base = esp_get_free_heap_size();
+
+    int count = 1;
+    while (true)
+    {
+        run_phase(count, heap_base);
+
+        if (count >= LOADGEN_CLIENTS || s_started < count)
+        {
+            break;
+        }
+        count = count * 2 < LOADGEN_CLIENTS ? count * 2 : LOADGEN_CLIENTS;
+    }
+
+    for (int i = 0; i < s_started; i++)
+    {
+        esp_mqtt_client_destroy(s_devs[i].client);
+        s_devs[i].client = NULL;
+        s_devs[i].connected = false;
+    }
+    s_started = 0;
+
+    bench_report_done("loadgen");
+    ESP_LOGI(TAG, "Gerador de carga concluido");
+}
+
+#endif /* CONFIG_LOADGEN_MODE */
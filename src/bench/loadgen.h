@@ -0,0 +1,117 @@
+/**
+ * @file loadgen.h
+ * @brief Gerador de carga: N dispositivos virtuais contra o broker
+ *
+ * Firmware de medição (CONFIG_LOADGEN_MODE, ambiente esp32-loadgen do
+ * platformio.ini) para achar os limites de escala do broker e do próprio
+ * firmware. O mqtt_system sobe normalmente (WiFi, cliente principal,
+ * TLS, health check) e, no lugar dos jobs da aplicação, loadgen_run()
+ * cria clientes esp-mqtt adicionais, um por dispositivo virtual, no
+ * mesmo broker e com a mesma verificação TLS (app_config, mqtt_tls.h):
+ *
+ *   client_id: CONFIG_MQTT_CLIENT_ID "-lg<n>"
+ *   tópico   : LOADGEN_TOPIC_PREFIX "/<client_id>/data"
+ *
+ * Cada dispositivo publica a cada LOADGEN_INTERVAL_MS (partidas
+ * espalhadas no intervalo), com LOADGEN_QOS1_PCT % das mensagens em QoS 1
+ * e payload entre LOADGEN_PAYLOAD_MIN e LOADGEN_PAYLOAD_MAX bytes. Tamanho
+ * e QoS saem de um gerador pseudoaleatório com semente fixa
+ * (LOADGEN_SEED): duas execuções com a mesma configuração geram a mesma
+ * sequência. O payload começa com {"seq":<n>,... para conferência no
+ * lado do broker.
+ *
+ * A carga sobe em fases de 1, 2, 4... até LOADGEN_CLIENTS dispositivos,
+ * cada uma por LOADGEN_PHASE_MS com todos os clientes da fase conectados.
+ * Ao fim de cada fase são impressos (no log e numa linha BENCH, ver
+ * bench_report.h, suíte "loadgen", caso "clients_<n>"):
+ *
+ * - msgs/s pretendidas, aceitas pelos clientes e confirmadas (PUBACK);
+ * - latência publicação->PUBACK: p50, p90, p99 e máximo (histograma com
+ *   faixas de ~2x, como em mqtt_inflight.h);
+ * - QoS 1 sem ACK ao fim da fase, falhas de publicação e desconexões;
+ * - publicações puladas porque o agendamento atrasou mais de um
+ *   intervalo (o firmware não acompanhou a taxa);
+ * - heap por cliente (queda do heap livre desde antes do primeiro
+ *   cliente, dividida pelos conectados) e heap livre.
+ *
+ * O ponto em que msgs/s confirmadas deixa de acompanhar as pretendidas,
+ * ou a latência dispara, é o limite da configuração medida; variar
+ * LOADGEN_INTERVAL_MS e o payload separa o limite do broker (latência) do
+ * limite do firmware (heap, CPU, falhas de publicação).
+ *
+ * Comparar duas execuções: tools/bench_check.py sobre o log.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES (build_flags -DCONFIG_LOADGEN_...)
+ * =============================================================================
+ */
+
+#ifndef CONFIG_LOADGEN_CLIENTS
+#define CONFIG_LOADGEN_CLIENTS 8
+#endif
+
+#ifndef CONFIG_LOADGEN_INTERVAL_MS
+#define CONFIG_LOADGEN_INTERVAL_MS 200
+#endif
+
+#ifndef CONFIG_LOADGEN_QOS1_PCT
+#define CONFIG_LOADGEN_QOS1_PCT 50
+#endif
+
+#ifndef CONFIG_LOADGEN_PAYLOAD_MIN
+#define CONFIG_LOADGEN_PAYLOAD_MIN 48
+#endif
+
+#ifndef CONFIG_LOADGEN_PAYLOAD_MAX
+#define CONFIG_LOADGEN_PAYLOAD_MAX 512
+#endif
+
+#ifndef CONFIG_LOADGEN_PHASE_MS
+#define CONFIG_LOADGEN_PHASE_MS 30000
+#endif
+
+#ifndef CONFIG_LOADGEN_SEED
+#define CONFIG_LOADGEN_SEED 0x2545f491
+#endif
+
+#define LOADGEN_CLIENTS CONFIG_LOADGEN_CLIENTS			 ///< Dispositivos virtuais na última fase
+#define LOADGEN_MAX_CLIENTS 32							 ///< Teto de LOADGEN_CLIENTS
+#define LOADGEN_INTERVAL_MS CONFIG_LOADGEN_INTERVAL_MS	 ///< Intervalo de publicação por dispositivo
+#define LOADGEN_QOS1_PCT CONFIG_LOADGEN_QOS1_PCT		 ///< Mensagens em QoS 1 (%), as demais QoS 0
+#define LOADGEN_PAYLOAD_MIN CONFIG_LOADGEN_PAYLOAD_MIN	 ///< Menor payload (bytes)
+#define LOADGEN_PAYLOAD_MAX CONFIG_LOADGEN_PAYLOAD_MAX	 ///< Maior payload (bytes)
+#define LOADGEN_PHASE_MS CONFIG_LOADGEN_PHASE_MS		 ///< Duração de cada fase
+#define LOADGEN_SEED CONFIG_LOADGEN_SEED				 ///< Semente do tamanho e do QoS
+
+#define LOADGEN_TOPIC_PREFIX "loadgen"		 ///< Raiz dos tópicos dos dispositivos virtuais
+#define LOADGEN_BUFFER_SIZE 1024			 ///< Buffers de entrada e saída de cada cliente
+#define LOADGEN_CLIENT_STACK_SIZE 4096		 ///< Stack da task esp-mqtt de cada cliente
+#define LOADGEN_PENDING_SLOTS 32			 ///< QoS 1 aguardando ACK rastreadas por cliente
+#define LOADGEN_CONNECT_TIMEOUT_MS 30000	 ///< Espera pela conexão dos clientes de uma fase
+#define LOADGEN_ACK_GRACE_MS 2000			 ///< Espera por ACKs após o fim de uma fase
+#define LOADGEN_TICK_MS 10					 ///< Granularidade do agendamento das publicações
+#define LOADGEN_LATENCY_BUCKETS 16			 ///< Faixas do histograma de latência de ACK
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Executa todas as fases e imprime os resultados
+ *
+ * @note Chamada por app_main() após mqtt_system_init(); espera o cliente
+ *       principal conectar e, ao terminar, destrói os clientes virtuais
+ */
+void loadgen_run(void);
+
+#endif /* LOADGEN_H */
@@ -0,0 +1,510 @@
+/**
+ * @file publish_bench.c
+ * @brief Benchmark dos caminhos de publicação e de recepção MQTT - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifdef CONFIG_BENCHMARK_MODE
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "bench/publish_bench.h"
+#include "bench/bench_report.h"
+#include "services/rtos_config.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "mqtt_client.h"
+#include "sdkconfig.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "PUBLISH_BENCH";
+
+/** ACKs pendentes por chamada (uma chamada publica no máximo um lote) */
+#define BENCH_ACK_SLOTS 8
+
+typedef int (*publish_case_fn_t)(uint32_t i);
+
+/** Caso de publicação medido */
+typedef struct
+{
+    const char *name;
+    publish_case_fn_t run;
+} publish_case_t;
+
+/** Caso em medição e resultado, preenchido pela task de medição */
+typedef struct
+{
+    const publish_case_t *bench;
+    publish_bench_result_t *result;
+    TaskHandle_t caller;
+} publish_job_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/* Cliente substituto */
+static int s_next_msg_id = 0;
+static int s_acks[BENCH_ACK_SLOTS];
+static int s_ack_count = 0;
+static uint32_t s_sink_bytes = 0;
+
+/* Despacho: instantes de injeção e de entrega de cada mensagem da rajada */
+static int64_t s_sent_us[PUBLISH_BENCH_BURST_SIZE];
+static volatile int64_t s_recv_us[PUBLISH_BENCH_BURST_SIZE];
+static volatile int s_received = 0;
+static TaskHandle_t s_waiter = NULL;
+
+static bool s_ready = false;
+
+static const char s_payload[] = "{\"publish_count\":1234,\"status\":\"operational\"}";
+
+static telemetry_data_t s_telemetry = {
+    .temperatura = 20.0f,
+    .umidade = 55.5f,
+    .contador = 0,
+    .timestamp = 1234567890ULL,
+};
+
+/*
+ * =============================================================================
+ * CLIENTE SUBSTITUTO
+ * =============================================================================
+ */
+
+static int bench_client_publish(const char *topic, const char *data,
+                                int len, int qos, bool retain)
+{
+    int msg_id = ++s_next_msg_id;
+
+    s_sink_bytes += len;
+    if (qos > 0 && s_ack_count < BENCH_ACK_SLOTS)
+    {
+        s_acks[s_ack_count++] = msg_id;
+    }
+
+    return msg_id;
+}
+
+/**
+ * @brief Confirma as publicações QoS 1 da última chamada, como o broker
+ */
+static void deliver_acks(void)
+{
+    for (int i = 0; i < s_ack_count; i++)
+    {
+        esp_mqtt_event_t event = {.msg_id = s_acks[i]};
+        mqtt_system_bench_event(MQTT_EVENT_PUBLISHED, &event);
+    }
+    s_ack_count = 0;
+}
+
+/*
+ * =============================================================================
+ * CASOS DE PUBLICAÇÃO
+ * =============================================================================
+ */
+
+static int case_data_qos0(uint32_t i)
+{
+    return mqtt_publish_data(PUBLISH_BENCH_TOPIC, s_payload,
+                             sizeof(s_payload) - 1, 0, false);
+}
+
+static int case_data_qos1(uint32_t i)
+{
+    return mqtt_publish_data(PUBLISH_BENCH_TOPIC, s_payload,
+                             sizeof(s_payload) - 1, 1, false);
+}
+
+/** Tópico com regra local: inclui a entrega local e a atuação */
+static int case_value_local(uint32_t i)
+{
+    return mqtt_publish_value(MQTT_TOPIC_TEMPERATURA, 18 + (i % 8), 0, 1, false);
+}
+
+/** Valor alternado além da deadband: toda amostra entra no lote */
+static int case_telemetry(uint32_t i)
+{
+    s_telemetry.temperatura = 20.0f + (i % 2);
+    s_telemetry.contador = i;
+    return mqtt_publish_telemetry(&s_telemetry);
+}
+
+static int case_health(uint32_t i)
+{
+    return mqtt_publish_health_check();
+}
+
+static const publish_case_t s_cases[] = {
+    {"publish_data_qos0", case_data_qos0},
+    {"publish_data_qos1", case_data_qos1},
+    {"publish_value_local", case_value_local},
+    {"publish_telemetry", case_telemetry},
+    {"publish_health_check", case_health},
+};
+
+#define CASE_COUNT (sizeof(s_cases) / sizeof(s_cases[0]))
+
+/*
+ * =============================================================================
+ * MEDIÇÃO
+ * =============================================================================
+ */
+
+/**
+ * @brief Task de medição de um caso de publicação
+ */
+static void publish_task(void *pvParameters)
+{
+    publish_job_t *job = (publish_job_t *)pvParameters;
+    publish_bench_result_t *result = job->result;
+    uint32_t cycles = 0;
+
+    /* Aquecimento do cache de instruções */
+    job->bench->run(0);
+    deliver_acks();
+
+    uint32_t heap_before = esp_get_free_heap_size();
+    uint32_t bytes_before = s_sink_bytes;
+
+    for (uint32_t i = 0; i < PUBLISH_BENCH_ITERATIONS; i++)
+    {
+        uint32_t start = esp_cpu_get_cycle_count();
+        int ret = job->bench->run(i);
+        cycles += esp_cpu_get_cycle_count() - start;
+
+        if (ret < 0 && ret != MQTT_PUBLISH_SUPPRESSED)
+        {
+            result->failures++;
+        }
+        deliver_acks();
+    }
+
+    uint32_t heap_after = esp_get_free_heap_size();
+
+    result->cycles = cycles / PUBLISH_BENCH_ITERATIONS;
+    result->bytes = s_sink_bytes - bytes_before;
+    result->heap_used = heap_before > heap_after ? heap_before - heap_after : 0;
+    result->stack_used = PUBLISH_BENCH_TASK_STACK_SIZE -
+                         uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t);
+
+    xTaskNotifyGive(job->caller);
+    vTaskDelete(NULL);
+}
+
+/** Handler do tópico de despacho: registra o instante de entrega */
+static void bench_topic_handler(const char *topic, int topic_len,
+                                const char *data, int data_len, void *ctx)
+{
+    uint32_t seq;
+    if (data_len != sizeof(seq))
+    {
+        return;
+    }
+    memcpy(&seq, data, sizeof(seq));
+
+    if (seq < PUBLISH_BENCH_BURST_SIZE)
+    {
+        s_recv_us[seq] = esp_timer_get_time();
+    }
+    if (++s_received == PUBLISH_BENCH_BURST_SIZE)
+    {
+        xTaskNotifyGive(s_waiter);
+    }
+}
+
+/**
+ * @brief Injeta rajadas de MQTT_EVENT_DATA e mede a entrega na task de despacho
+ */
+static void run_dispatch(publish_bench_dispatch_t *out)
+{
+    static const char topic[] = PUBLISH_BENCH_TOPIC "/in";
+    uint32_t seqs[PUBLISH_BENCH_BURST_SIZE];
+    uint64_t cycles = 0;
+    uint64_t latency_sum = 0;
+
+    memset(out, 0, sizeof(*out));
+    out->latency_min_us = UINT32_MAX;
+
+    if (mqtt_register_topic_handler(topic, bench_topic_handler, NULL) != ESP_OK)
+    {
+        out->latency_min_us = 0;
+        return;
+    }
+
+    s_waiter = xTaskGetCurrentTaskHandle();
+
+    for (int burst = 0; burst < PUBLISH_BENCH_BURSTS; burst++)
+    {
+        s_received = 0;
+        ulTaskNotifyTake(pdTRUE, 0);
+
+        for (int k = 0; k < PUBLISH_BENCH_BURST_SIZE; k++)
+        {
+            seqs[k] = k;
+            esp_mqtt_event_t event = {
+                .topic = (char *)topic,
+                .topic_len = sizeof(topic) - 1,
+                .data = (char *)&seqs[k],
+                .data_len = sizeof(seqs[k]),
+                .total_data_len = sizeof(seqs[k]),
+                .current_data_offset = 0,
+            };
+
+            s_recv_us[k] = 0;
+            s_sent_us[k] = esp_timer_get_time();
+
+            uint32_t start = esp_cpu_get_cycle_count();
+            mqtt_system_bench_event(MQTT_EVENT_DATA, &event);
+            cycles += esp_cpu_get_cycle_count() - start;
+        }
+
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PUBLISH_BENCH_DISPATCH_TIMEOUT_MS));
+
+        for (int k = 0; k < PUBLISH_BENCH_BURST_SIZE; k++)
+        {
+            if (s_recv_us[k] == 0)
+            {
+                out->dropped++;
+                continue;
+            }
+
+            uint32_t latency = (uint32_t)(s_recv_us[k] - s_sent_us[k]);
+            latency_sum += latency;
+            out->delivered++;
+            if (latency < out->latency_min_us)
+            {
+                out->latency_min_us = latency;
+            }
+            if (latency > out->latency_max_us)
+            {
+                out->latency_max_us = latency;
+            }
+        }
+
+        /* A task de despacho libera o último slot após o handler */
+        vTaskDelay(1);
+    }
+
+    mqtt_unregister_topic_handler(topic, bench_topic_handler, NULL);
+
+    uint32_t injected = PUBLISH_BENCH_BURSTS * PUBLISH_BENCH_BURST_SIZE;
+    out->handler_cycles = (uint32_t)(cycles / injected);
+    if (out->delivered > 0)
+    {
+        out->latency_avg_us = (uint32_t)(latency_sum / out->delivered);
+    }
+    else
+    {
+        out->latency_min_us = 0;
+    }
+}
+
+static uint32_t task_stack_free(rtos_task_id_t id)
+{
+    TaskHandle_t task = xTaskGetHandle(rtos_task_config(id)->name);
+    return task != NULL ? uxTaskGetStackHighWaterMark(task) * sizeof(StackType_t) : 0;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t publish_bench_setup(void)
+{
+    if (s_ready)
+    {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = mqtt_system_bench_init(bench_client_publish);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao inicializar o sistema: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    s_ready = true;
+    return ESP_OK;
+}
+
+int publish_bench_case_count(void)
+{
+    return CASE_COUNT;
+}
+
+int publish_bench_find_case(const char *name)
+{
+    for (size_t c = 0; c < CASE_COUNT; c++)
+    {
+        if (strcmp(s_cases[c].name, name) == 0)
+        {
+            return (int)c;
+        }
+    }
+    return -1;
+}
+
+esp_err_t publish_bench_run_case(int index, publish_bench_result_t *out)
+{
+    if (!s_ready || index < 0 || index >= (int)CASE_COUNT || out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->name = s_cases[index].name;
+    publish_job_t job = {&s_cases[index], out, xTaskGetCurrentTaskHandle()};
+
+    /* Sem escrita no console durante a medição */
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    /* Mesmo núcleo e prioridade acima das demais tasks */
+    if (xTaskCreatePinnedToCore(publish_task, "PublishBench",
+                                PUBLISH_BENCH_TASK_STACK_SIZE, &job,
+                                configMAX_PRIORITIES - 2, NULL,
+                                xPortGetCoreID()) != pdPASS)
+    {
+        esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+        ESP_LOGE(TAG, "Falha ao criar task de medicao");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+
+    const bench_metric_t metrics[] = {
+        {"cycles", out->cycles},
+        {"ns", out->cycles * 1000 / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ},
+        {"bytes", out->bytes},
+        {"stack", out->stack_used},
+        {"heap", out->heap_used},
+        {"failures", out->failures},
+    };
+    bench_report("publish", out->name, metrics, sizeof(metrics) / sizeof(metrics[0]));
+
+    return ESP_OK;
+}
+
+esp_err_t publish_bench_run_dispatch(publish_bench_dispatch_t *out)
+{
+    if (!s_ready || out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, configMAX_PRIORITIES - 2);
+    run_dispatch(out);
+    vTaskPrioritySet(NULL, priority);
+    esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+
+    const bench_metric_t metrics[] = {
+        {"handler_cycles", out->handler_cycles},
+        {"latency_min_us", out->latency_min_us},
+        {"latency_avg_us", out->latency_avg_us},
+        {"latency_max_us", out->latency_max_us},
+        {"delivered", out->delivered},
+        {"dropped", out->dropped},
+    };
+    bench_report("publish", "dispatch_burst", metrics, sizeof(metrics) / sizeof(metrics[0]));
+
+    return out->delivered > 0 ? ESP_OK : ESP_FAIL;
+}
+
+void publish_bench_memory(publish_bench_memory_t *out)
+{
+    out->free_heap = esp_get_free_heap_size();
+    out->min_free_heap = esp_get_minimum_free_heap_size();
+    out->largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    out->job_worker_stack_free = task_stack_free(RTOS_TASK_JOB_WORKER);
+    out->mqtt_dispatch_stack_free = task_stack_free(RTOS_TASK_MQTT_DISPATCH);
+
+    const bench_metric_t metrics[] = {
+        {"free_heap", out->free_heap},
+        {"min_free_heap", out->min_free_heap},
+        {"largest_block", out->largest_block},
+        {"job_worker_stack_free", out->job_worker_stack_free},
+        {"mqtt_dispatch_stack_free", out->mqtt_dispatch_stack_free},
+    };
+    bench_report("publish", "memory", metrics, sizeof(metrics) / sizeof(metrics[0]));
+}
+
+void publish_bench_run(void)
+{
+    const uint32_t cpu_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    publish_bench_result_t results[CASE_COUNT] = {0};
+    publish_bench_dispatch_t dispatch;
+    publish_bench_memory_t memory;
+
+    ESP_LOGI(TAG, "=== Benchmark de publicacao e despacho (%d chamadas, CPU %lu MHz) ===",
+             PUBLISH_BENCH_ITERATIONS, cpu_mhz);
+
+    if (publish_bench_setup() != ESP_OK)
+    {
+        return;
+    }
+
+    for (size_t c = 0; c < CASE_COUNT; c++)
+    {
+        if (publish_bench_run_case(c, &results[c]) != ESP_OK)
+        {
+            return;
+        }
+    }
+
+    publish_bench_run_dispatch(&dispatch);
+
+    ESP_LOGI(TAG, "%-22s %10s %8s %8s %8s %6s %6s", "caso", "ciclos/msg",
+             "us/msg", "bytes", "stack", "heap", "falhas");
+
+    for (size_t c = 0; c < CASE_COUNT; c++)
+    {
+        const publish_bench_result_t *r = &results[c];
+        uint32_t ns = r->cycles * 1000 / cpu_mhz;
+
+        ESP_LOGI(TAG, "%-22s %10lu %5lu.%02lu %8lu %8lu %6lu %6lu", r->name,
+                 r->cycles, ns / 1000, (ns % 1000) / 10, r->bytes,
+                 r->stack_used, r->heap_used, r->failures);
+    }
+
+    ESP_LOGI(TAG, "Despacho: %d rajadas de %d, handler %lu ciclos/msg, "
+                  "latencia min/med/max %lu/%lu/%lu us, %lu perdidas",
+             PUBLISH_BENCH_BURSTS, PUBLISH_BENCH_BURST_SIZE,
+             dispatch.handler_cycles, dispatch.latency_min_us,
+             dispatch.latency_avg_us, dispatch.latency_max_us, dispatch.dropped);
+
+    publish_bench_memory(&memory);
+    ESP_LOGI(TAG, "Heap livre %lu (minimo %lu, maior bloco %lu), "
+                  "folga de stack JobWorker %lu / MqttDispatch %lu",
+             memory.free_heap, memory.min_free_heap, memory.largest_block,
+             memory.job_worker_stack_free, memory.mqtt_dispatch_stack_free);
+
+    bench_report_done("publish");
+    ESP_LOGI(TAG, "=== Fim do benchmark ===");
+}
+
+#endif /* CONFIG_BENCHMARK_MODE */
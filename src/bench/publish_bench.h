@@ -0,0 +1,136 @@
+/**
+ * @file publish_bench.h
+ * @brief Benchmark dos caminhos de publicação e de recepção MQTT
+ *
+ * Sobe o sistema com mqtt_system_bench_init() (sem WiFi nem broker, com
+ * um cliente substituto que só conta bytes e devolve msg_id) e mede:
+ *
+ * - ciclos por chamada de mqtt_publish_data() (QoS 0 e 1),
+ *   mqtt_publish_value() num tópico com regra local (entrega local e
+ *   atuação incluídas), mqtt_publish_telemetry() (lote e política de
+ *   reporte) e mqtt_publish_health_check();
+ * - latência de despacho de rajadas de MQTT_EVENT_DATA sintéticos, do
+ *   handler de eventos do esp-mqtt até o handler do tópico na task de
+ *   despacho, e o custo do handler de eventos para o produtor;
+ * - picos de stack (task de medição, JobWorker, MqttDispatch) e o heap.
+ *
+ * Os ACKs de QoS 1 são entregues como MQTT_EVENT_PUBLISHED fora da
+ * medição. Durante as medições o log fica em WARN: a latência não inclui
+ * a escrita no console. Compilado apenas com CONFIG_BENCHMARK_MODE, roda
+ * após json_bench_run() no hardware (esp32-bench) ou no QEMU
+ * (esp32-bench-qemu).
+ *
+ * Os casos também rodam um a um pela suíte Unity de test/ ("pio test -e
+ * esp32-bench" ou "pio test -e esp32-bench-qemu"), que confere falhas,
+ * perdas e folgas de stack; as linhas BENCH saem do mesmo jeito.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef PUBLISH_BENCH_H
+#define PUBLISH_BENCH_H
+
+#include "services/mqtt_system.h"
+
+/** Chamadas medidas por caso de publicação */
+#define PUBLISH_BENCH_ITERATIONS 500
+
+/** Stack da task de medição das publicações */
+#define PUBLISH_BENCH_TASK_STACK_SIZE 4096
+
+/** Rajadas de mensagens recebidas e mensagens por rajada (cabem na fila) */
+#define PUBLISH_BENCH_BURSTS 50
+#define PUBLISH_BENCH_BURST_SIZE MQTT_INBOUND_QUEUE_SLOTS
+
+/** Espera máxima pelo despacho de uma rajada */
+#define PUBLISH_BENCH_DISPATCH_TIMEOUT_MS 1000
+
+/** Tópico usado pelo benchmark */
+#define PUBLISH_BENCH_TOPIC MQTT_TOPIC_BASE "/bench"
+
+/*
+ * =============================================================================
+ * TIPOS
+ * =============================================================================
+ */
+
+/** Resultado de um caso de publicação */
+typedef struct
+{
+	const char *name;	 ///< Nome do caso (linha BENCH)
+	uint32_t cycles;	 ///< Ciclos por chamada
+	uint32_t failures;	 ///< Chamadas com erro (supressões não contam)
+	uint32_t bytes;		 ///< Bytes entregues ao cliente substituto
+	uint32_t stack_used; ///< Pico de stack da task de medição
+	uint32_t heap_used;	 ///< Queda do heap livre durante o caso
+} publish_bench_result_t;
+
+/** Resultado do despacho de rajadas */
+typedef struct
+{
+	uint32_t handler_cycles; ///< Custo do handler de eventos por mensagem
+	uint32_t latency_min_us; ///< Latência até o handler do tópico
+	uint32_t latency_avg_us;
+	uint32_t latency_max_us;
+	uint32_t delivered; ///< Mensagens entregues ao handler
+	uint32_t dropped;	///< Mensagens não entregues no prazo
+} publish_bench_dispatch_t;
+
+/** Heap e folgas de stack ao fim das medições */
+typedef struct
+{
+	uint32_t free_heap;
+	uint32_t min_free_heap;
+	uint32_t largest_block;
+	uint32_t job_worker_stack_free;
+	uint32_t mqtt_dispatch_stack_free;
+} publish_bench_memory_t;
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Sobe o sistema com o cliente substituto (uma vez por boot)
+ */
+esp_err_t publish_bench_setup(void);
+
+/**
+ * @brief Número de casos de publicação
+ */
+int publish_bench_case_count(void);
+
+/**
+ * @brief Índice do caso com o nome informado, ou -1
+ */
+int publish_bench_find_case(const char *name);
+
+/**
+ * @brief Mede um caso de publicação e imprime sua linha BENCH
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (índice, ou sem publish_bench_setup())
+ *         ou ESP_ERR_NO_MEM (task de medição)
+ */
+esp_err_t publish_bench_run_case(int index, publish_bench_result_t *out);
+
+/**
+ * @brief Mede o despacho de rajadas e imprime sua linha BENCH
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG ou ESP_FAIL (nada entregue)
+ */
+esp_err_t publish_bench_run_dispatch(publish_bench_dispatch_t *out);
+
+/**
+ * @brief Lê heap e folgas de stack e imprime a linha BENCH
+ */
+void publish_bench_memory(publish_bench_memory_t *out);
+
+/**
+ * @brief Executa os casos e imprime a tabela e as linhas BENCH
+ */
+void publish_bench_run(void);
+
+#endif /* PUBLISH_BENCH_H */
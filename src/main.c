@@ -2,10 +2,11 @@
  * @file main.c
  * @brief Aplicação principal com arquitetura baseada em Tasks FreeRTOS
  *
- * Este arquivo contém apenas a inicialização do sistema e criação das tasks.
- * Toda a lógica está distribuída em tasks modulares e independentes:
- * - Task de monitoramento do sistema
- * - Task de publicação de dados customizados
+ * Este arquivo contém apenas a inicialização do sistema e o registro dos
+ * jobs da aplicação. Toda a lógica está distribuída em jobs modulares,
+ * executados pelo job_scheduler na mesma task de trabalho:
+ * - Job de monitoramento do sistema
+ * - Job de publicação de dados customizados
  *
  * A biblioteca mqtt_system.h cuida da infraestrutura de comunicação IoT.
  *
@@ -18,9 +19,26 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "services/mqtt_system.h"
+#include "services/job_scheduler.h"
+#include "services/rtos_config.h"
+#include "services/log_sink.h"
+#include "services/app_config.h"
 #include "tasks/system_monitor_task.h"
 #include "tasks/custom_publish_task.h"
 
+#ifdef CONFIG_BENCHMARK_MODE
+#include "bench/json_bench.h"
+#include "bench/publish_bench.h"
+#endif
+
+#ifdef CONFIG_DEEP_SLEEP_MODE
+#include "services/sleep_cycle.h"
+#endif
+
+#ifdef CONFIG_LOADGEN_MODE
+#include "bench/loadgen.h"
+#endif
+
 /*
  * =============================================================================
  * CONFIGURAÇÕES DA APLICAÇÃO
@@ -29,6 +47,31 @@
 
 static const char *TAG = "MAIN_APP";
 
+static job_id_t s_job_monitor = -1;
+static job_id_t s_job_custom = -1;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+/**
+ * @brief Aplica os intervalos novos aos jobs da aplicação
+ */
+static void on_config_changed(const app_config_t *now,
+                              const app_config_t *old, void *ctx)
+{
+    if (now->monitor_interval_ms != old->monitor_interval_ms)
+    {
+        job_set_period(s_job_monitor, now->monitor_interval_ms);
+    }
+    if (now->custom_publish_interval_ms != old->custom_publish_interval_ms)
+    {
+        job_set_period(s_job_custom, now->custom_publish_interval_ms);
+    }
+}
+
 /*
  * =============================================================================
  * FUNÇÃO PRINCIPAL
@@ -39,14 +82,34 @@ static const char *TAG = "MAIN_APP";
  * @brief Ponto de entrada da aplicação
  *
  * Responsável por:
- * 1. Inicializar o sistema (WiFi, MQTT, telemetria)
- * 2. Criar as tasks da aplicação usando xTaskCreate
+ * 1. Inicializar o sistema (WiFi e MQTT conectam em segundo plano)
+ * 2. Registrar os jobs da aplicação no job_scheduler
  * 3. Retornar o controle para o FreeRTOS
  *
  * Após a inicialização, o FreeRTOS assume o controle do sistema.
+ *
+ * @note Fora do build de "pio test" (PIO_UNIT_TESTING), em que o
+ *       app_main() é o da suíte em test/
  */
+#ifndef PIO_UNIT_TESTING
 void app_main(void)
 {
+    /* Daqui em diante o log não espera pela UART */
+    log_sink_init();
+
+#ifdef CONFIG_BENCHMARK_MODE
+    /* Firmware de benchmark: serialização, publicação e despacho, sem rede */
+    json_bench_run();
+    publish_bench_run();
+    return;
+#endif
+
+#ifdef CONFIG_DEEP_SLEEP_MODE
+    /* Nó a bateria: amostra, publica a cada N despertares e volta a dormir */
+    sleep_cycle_run();
+    return;
+#endif
+
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "╔═════════════════════════════════╗");
     ESP_LOGI(TAG, "║   Sistema de Demonstracao IoT   ║");
@@ -64,6 +127,10 @@ void app_main(void)
      * - Cliente MQTT
      * - Tasks de telemetria e monitoramento
      * - Watchdog de conectividade
+     *
+     * Não espera pela rede: os jobs abaixo começam a amostrar e a atuar
+     * logo após o boot, e o que for publicado antes da conexão fica no
+     * buffer offline.
      */
     esp_err_t ret = mqtt_system_init();
 
@@ -77,52 +144,67 @@ void app_main(void)
     ESP_LOGI(TAG, "Sistema MQTT inicializado com sucesso");
     ESP_LOGI(TAG, "");
 
+#ifdef CONFIG_LOADGEN_MODE
+    /* Firmware de carga: dispositivos virtuais no lugar dos jobs da aplicação */
+    loadgen_run();
+    return;
+#endif
+
     /*
-     * PASSO 2: Criar tasks da aplicação
+     * PASSO 2: Registrar jobs da aplicação
      *
-     * Cada task executa de forma independente e concorrente.
-     * O FreeRTOS gerencia o escalonamento e prioridades.
+     * Os jobs compartilham a task de trabalho do job_scheduler, que dorme
+     * até o próximo vencimento; não há uma stack por funcionalidade.
      */
 
-    ESP_LOGI(TAG, "Criando tasks da aplicacao...");
+    ESP_LOGI(TAG, "Registrando jobs da aplicacao...");
+
+    /* Intervalos do NVS (ou padrão), ajustáveis em APP_CONFIG_TOPIC */
+    app_config_t cfg;
+    app_config_get(&cfg);
 
-    /* Task 1: Monitoramento do Sistema */
-    BaseType_t task_created = xTaskCreate(
-        system_monitor_task,     // Ponteiro para a função da Task
-        MONITOR_TASK_NAME,       // Nome da Task (para debug)
-        MONITOR_TASK_STACK_SIZE, // Tamanho da Stack em bytes
-        NULL,                    // Parâmetros passados (não usado)
-        MONITOR_TASK_PRIORITY,   // Prioridade (0-24, maior = mais prioritário)
-        NULL                     // Handle da Task (não usado)
+    /* Job 1: Monitoramento do Sistema */
+    s_job_monitor = job_register(
+        MONITOR_JOB_NAME,        // Nome do job (para debug)
+        cfg.monitor_interval_ms, // Período
+        cfg.monitor_interval_ms, // Primeira execução após um período
+        system_monitor_job,      // Callback
+        NULL                     // Contexto (não usado)
     );
 
-    if (task_created != pdPASS)
+    if (s_job_monitor < 0)
     {
-        ESP_LOGE(TAG, "Falha ao criar task de monitoramento");
+        ESP_LOGE(TAG, "Falha ao registrar job de monitoramento");
         return;
     }
 
-    ESP_LOGI(TAG, "   [OK] Task: %s (Prioridade: %d)",
-             MONITOR_TASK_NAME, MONITOR_TASK_PRIORITY);
-
-    /* Task 2: Publicação de Dados Customizados */
-    task_created = xTaskCreate(
-        custom_publish_task,            // Ponteiro para a função da Task
-        CUSTOM_PUBLISH_TASK_NAME,       // Nome da Task (para debug)
-        CUSTOM_PUBLISH_TASK_STACK_SIZE, // Tamanho da Stack em bytes
-        NULL,                           // Parâmetros passados (não usado)
-        CUSTOM_PUBLISH_TASK_PRIORITY,   // Prioridade (0-24, maior = mais prioritário)
-        NULL                            // Handle da Task (não usado)
+    ESP_LOGI(TAG, "   [OK] Job: %s", MONITOR_JOB_NAME);
+
+    /* Job 2: Publicação de Dados Customizados */
+    ret = custom_publish_init();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao registrar politicas de publicacao");
+        return;
+    }
+
+    s_job_custom = job_register(
+        CUSTOM_PUBLISH_JOB_NAME,        // Nome do job (para debug)
+        cfg.custom_publish_interval_ms, // Período
+        cfg.custom_publish_interval_ms, // Primeira execução após um período
+        custom_publish_job,             // Callback
+        NULL                            // Contexto (não usado)
     );
 
-    if (task_created != pdPASS)
+    if (s_job_custom < 0)
     {
-        ESP_LOGE(TAG, "Falha ao criar task de publicacao customizada");
+        ESP_LOGE(TAG, "Falha ao registrar job de publicacao customizada");
         return;
     }
 
-    ESP_LOGI(TAG, "   [OK] Task: %s (Prioridade: %d)",
-             CUSTOM_PUBLISH_TASK_NAME, CUSTOM_PUBLISH_TASK_PRIORITY);
+    app_config_add_listener(on_config_changed, NULL);
+
+    ESP_LOGI(TAG, "   [OK] Job: %s", CUSTOM_PUBLISH_JOB_NAME);
 
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "════════════════════════════════════════");
@@ -130,33 +212,34 @@ void app_main(void)
     ESP_LOGI(TAG, "════════════════════════════════════════");
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "Funcionalidades ativas:");
-    ESP_LOGI(TAG, "   - Telemetria automatica a cada %d segundos",
-             TELEMETRY_INTERVAL_MS / 1000);
-    ESP_LOGI(TAG, "   - Health check a cada %d segundos",
-             HEALTH_CHECK_INTERVAL_MS / 1000);
+    ESP_LOGI(TAG, "   - Telemetria automatica a cada %lu segundos",
+             cfg.telemetry_interval_ms / 1000);
+    ESP_LOGI(TAG, "   - Health check a cada %lu segundos",
+             cfg.health_interval_ms / 1000);
     ESP_LOGI(TAG, "   - Watchdog WiFi monitorando conectividade");
-    ESP_LOGI(TAG, "   - Monitoramento do sistema a cada %d segundos",
-             MONITOR_INTERVAL_MS / 1000);
-    ESP_LOGI(TAG, "   - Publicacao customizada a cada %d segundos",
-             CUSTOM_PUBLISH_INTERVAL_MS / 1000);
+    ESP_LOGI(TAG, "   - Monitoramento do sistema a cada %lu segundos",
+             cfg.monitor_interval_ms / 1000);
+    ESP_LOGI(TAG, "   - Publicacao customizada a cada %lu segundos",
+             cfg.custom_publish_interval_ms / 1000);
     ESP_LOGI(TAG, "");
-    ESP_LOGI(TAG, "Tasks criadas: 2");
-    ESP_LOGI(TAG, "   1. %s (P%d)", MONITOR_TASK_NAME, MONITOR_TASK_PRIORITY);
-    ESP_LOGI(TAG, "   2. %s (P%d)", CUSTOM_PUBLISH_TASK_NAME, CUSTOM_PUBLISH_TASK_PRIORITY);
+    job_scheduler_print();
+    rtos_print_task_plan();
+    rtos_print_memory_report();
     ESP_LOGI(TAG, "");
 
     /*
      * PASSO 3: app_main termina, FreeRTOS assume controle
      *
      * A partir daqui, o scheduler do FreeRTOS gerencia a execução
-     * das tasks criadas conforme suas prioridades e estados.
+     * das tasks conforme suas prioridades e estados.
      *
-     * As tasks continuam executando indefinidamente em seus loops.
+     * Os jobs continuam executando periodicamente na task de trabalho.
      */
 
     ESP_LOGI(TAG, "app_main() finalizando...");
     ESP_LOGI(TAG, "FreeRTOS scheduler assumiu o controle");
     ESP_LOGI(TAG, "");
 
-    /* app_main retorna, mas as tasks continuam executando */
+    /* app_main retorna, mas os jobs continuam executando */
 }
+#endif /* PIO_UNIT_TESTING */
@@ -0,0 +1,577 @@
+/**
+ * @file app_config.c
+ * @brief Configuração da aplicação: NVS, atualização por MQTT e recarga a quente - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "app_config.h"
+#include "mqtt_router.h"
+#include "tasks/system_monitor_task.h"
+#include "tasks/custom_publish_task.h"
+#include "rtos_config.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "APP_CONFIG";
+
+/** Chave do NVS e versão do layout gravado */
+#define CONFIG_NVS_KEY "cfg"
+#define CONFIG_NVS_VERSION 1
+
+/** Faixa aceita para os intervalos dos jobs */
+#define INTERVAL_MIN_MS 1000
+#define INTERVAL_MAX_MS 86400000
+
+/** Faixa aceita para os limiares de heap */
+#define HEAP_MAX_BYTES 1000000
+
+typedef enum
+{
+    FIELD_U32,
+    FIELD_URI,
+} field_type_t;
+
+/** Campo da configuração no formato texto */
+typedef struct
+{
+    const char *key;
+    field_type_t type;
+    size_t offset;
+    uint32_t min;
+    uint32_t max;
+} config_field_t;
+
+static const config_field_t s_fields[] = {
+    {"telemetry_ms", FIELD_U32, offsetof(app_config_t, telemetry_interval_ms),
+     INTERVAL_MIN_MS, INTERVAL_MAX_MS},
+    {"health_ms", FIELD_U32, offsetof(app_config_t, health_interval_ms),
+     INTERVAL_MIN_MS, INTERVAL_MAX_MS},
+    {"monitor_ms", FIELD_U32, offsetof(app_config_t, monitor_interval_ms),
+     INTERVAL_MIN_MS, INTERVAL_MAX_MS},
+    {"custom_ms", FIELD_U32, offsetof(app_config_t, custom_publish_interval_ms),
+     INTERVAL_MIN_MS, INTERVAL_MAX_MS},
+    {"heap_warn", FIELD_U32, offsetof(app_config_t, heap_warn_bytes),
+     0, HEAP_MAX_BYTES},
+    {"heap_low", FIELD_U32, offsetof(app_config_t, heap_low_bytes),
+     0, HEAP_MAX_BYTES},
+    {"broker", FIELD_URI, offsetof(app_config_t, broker_uri), 0, 0},
+};
+
+#define FIELD_COUNT (sizeof(s_fields) / sizeof(s_fields[0]))
+
+/** Registro gravado no NVS */
+typedef struct
+{
+    uint32_t version;
+    app_config_t config;
+} stored_config_t;
+
+typedef struct
+{
+    app_config_listener_t fn;
+    void *ctx;
+} listener_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/**
+ * Protege s_config e o estado do broker em teste: a task de despacho
+ * aplica configurações novas e a task do esp-mqtt confirma ou descarta
+ * o broker
+ */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_config_t s_config;
+
+/**
+ * Último broker com conexão confirmada (ou o do boot) e se o URI em uso
+ * ainda está em teste; enquanto em teste, o NVS guarda o confirmado
+ */
+static char s_trusted_uri[APP_CONFIG_URI_MAX_LEN];
+static bool s_broker_pending = false;
+
+/** Broker descartado neste boot: a configuração retida o traria de volta */
+static char s_rejected_uri[APP_CONFIG_URI_MAX_LEN];
+
+/** Serializa as gravações no NVS das duas tasks */
+static SemaphoreHandle_t s_save_mutex = NULL;
+RTOS_STATIC(StaticSemaphore_t, s_save_mutex_buf);
+
+static listener_t s_listeners[APP_CONFIG_MAX_LISTENERS];
+static int s_listener_count = 0;
+
+static bool s_initialized = false;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static void set_defaults(app_config_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->telemetry_interval_ms = TELEMETRY_INTERVAL_MS;
+    cfg->health_interval_ms = HEALTH_CHECK_INTERVAL_MS;
+    cfg->monitor_interval_ms = MONITOR_INTERVAL_MS;
+    cfg->custom_publish_interval_ms = CUSTOM_PUBLISH_INTERVAL_MS;
+    cfg->heap_warn_bytes = APP_CONFIG_DEFAULT_HEAP_WARN_BYTES;
+    cfg->heap_low_bytes = APP_CONFIG_DEFAULT_HEAP_LOW_BYTES;
+    strncpy(cfg->broker_uri, CONFIG_MQTT_BROKER_URI, sizeof(cfg->broker_uri) - 1);
+}
+
+static bool valid_uri(const char *uri, size_t len)
+{
+    if (len == 0 || len >= APP_CONFIG_URI_MAX_LEN)
+    {
+        return false;
+    }
+    return strncmp(uri, "mqtt://", 7) == 0 || strncmp(uri, "mqtts://", 8) == 0;
+}
+
+/**
+ * @brief Confere as faixas de todos os campos (configuração vinda do NVS)
+ */
+static bool valid_config(const app_config_t *cfg)
+{
+    for (size_t i = 0; i < FIELD_COUNT; i++)
+    {
+        const config_field_t *field = &s_fields[i];
+        const uint8_t *base = (const uint8_t *)cfg + field->offset;
+
+        if (field->type == FIELD_U32)
+        {
+            uint32_t value;
+            memcpy(&value, base, sizeof(value));
+            if (value < field->min || value > field->max)
+            {
+                return false;
+            }
+        }
+        else if (!valid_uri((const char *)base, strnlen((const char *)base,
+                                                        APP_CONFIG_URI_MAX_LEN)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static char *trim(char *s)
+{
+    while (*s == ' ' || *s == '\t' || *s == '\r')
+    {
+        s++;
+    }
+
+    char *end = s + strlen(s);
+    while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+    {
+        *--end = '\0';
+    }
+    return s;
+}
+
+/**
+ * @brief Aplica um par chave=valor sobre @p cfg
+ */
+static bool apply_pair(char *pair, app_config_t *cfg)
+{
+    char *eq = strchr(pair, '=');
+    if (eq == NULL)
+    {
+        return false;
+    }
+    *eq = '\0';
+
+    const char *key = trim(pair);
+    char *value = trim(eq + 1);
+
+    for (size_t i = 0; i < FIELD_COUNT; i++)
+    {
+        const config_field_t *field = &s_fields[i];
+        if (strcmp(key, field->key) != 0)
+        {
+            continue;
+        }
+
+        uint8_t *base = (uint8_t *)cfg + field->offset;
+
+        if (field->type == FIELD_U32)
+        {
+            char *end;
+            unsigned long parsed = strtoul(value, &end, 10);
+            if (end == value || *end != '\0' || value[0] == '-' ||
+                parsed < field->min || parsed > field->max)
+            {
+                return false;
+            }
+            uint32_t u32 = (uint32_t)parsed;
+            memcpy(base, &u32, sizeof(u32));
+            return true;
+        }
+
+        size_t len = strlen(value);
+        if (!valid_uri(value, len))
+        {
+            return false;
+        }
+        memset(base, 0, APP_CONFIG_URI_MAX_LEN);
+        memcpy(base, value, len);
+        return true;
+    }
+
+    ESP_LOGW(TAG, "Chave desconhecida: '%s'", key);
+    return false;
+}
+
+/**
+ * @brief Grava no NVS a configuração em uso, com o broker confirmado no
+ *        lugar de um em teste
+ *
+ * O estado é lido já com o mutex de gravação: entre gravações das duas
+ * tasks, a última deixa no NVS o estado mais recente. A configuração
+ * padrão apaga a chave.
+ */
+static void save_config(void)
+{
+    nvs_handle_t nvs;
+    stored_config_t stored = {.version = CONFIG_NVS_VERSION};
+    app_config_t defaults;
+
+    set_defaults(&defaults);
+    xSemaphoreTake(s_save_mutex, portMAX_DELAY);
+
+    portENTER_CRITICAL(&s_lock);
+    stored.config = s_config;
+    if (s_broker_pending)
+    {
+        memcpy(stored.config.broker_uri, s_trusted_uri, sizeof(s_trusted_uri));
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (nvs_open(APP_CONFIG_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK)
+    {
+        xSemaphoreGive(s_save_mutex);
+        ESP_LOGW(TAG, "NVS indisponivel, configuracao nao persistida");
+        return;
+    }
+
+    if (memcmp(&stored.config, &defaults, sizeof(defaults)) == 0)
+    {
+        nvs_erase_key(nvs, CONFIG_NVS_KEY);
+    }
+    else
+    {
+        nvs_set_blob(nvs, CONFIG_NVS_KEY, &stored, sizeof(stored));
+    }
+
+    nvs_commit(nvs);
+    nvs_close(nvs);
+    xSemaphoreGive(s_save_mutex);
+}
+
+static bool load_stored(app_config_t *out)
+{
+    stored_config_t stored;
+    size_t size = sizeof(stored);
+    nvs_handle_t nvs;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    if (nvs_open(APP_CONFIG_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK)
+    {
+        ret = nvs_get_blob(nvs, CONFIG_NVS_KEY, &stored, &size);
+        nvs_close(nvs);
+    }
+
+    if (ret != ESP_OK)
+    {
+        return false;
+    }
+
+    /* Layout de outra versão do firmware, ou gravação corrompida */
+    if (size != sizeof(stored) || stored.version != CONFIG_NVS_VERSION ||
+        !valid_config(&stored.config))
+    {
+        ESP_LOGW(TAG, "Configuracao do NVS invalida, usando padrao");
+        return false;
+    }
+
+    *out = stored.config;
+    return true;
+}
+
+/**
+ * @brief Avisa os consumidores de uma troca já aplicada em s_config
+ */
+static void notify_listeners(const app_config_t *now, const app_config_t *old)
+{
+    for (int i = 0; i < s_listener_count; i++)
+    {
+        s_listeners[i].fn(now, old, s_listeners[i].ctx);
+    }
+}
+
+/*
+ * =============================================================================
+ * HANDLERS
+ * =============================================================================
+ */
+
+static void config_handler(const char *topic, int topic_len,
+                           const char *data, int data_len, void *ctx)
+{
+    esp_err_t ret = app_config_load(data, data_len, true);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Configuracao recebida rejeitada (%s), mantida a atual",
+                 esp_err_to_name(ret));
+    }
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t app_config_init(void)
+{
+    if (!s_initialized)
+    {
+        s_save_mutex = RTOS_MUTEX_CREATE(s_save_mutex_buf);
+        if (s_save_mutex == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+
+        app_config_t cfg;
+        if (!load_stored(&cfg))
+        {
+            set_defaults(&cfg);
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        s_config = cfg;
+        memcpy(s_trusted_uri, cfg.broker_uri, sizeof(s_trusted_uri));
+        portEXIT_CRITICAL(&s_lock);
+
+        s_initialized = true;
+        app_config_print();
+    }
+
+    return mqtt_register_topic_handler(APP_CONFIG_TOPIC, config_handler, NULL);
+}
+
+void app_config_get(app_config_t *out)
+{
+    portENTER_CRITICAL(&s_lock);
+    *out = s_config;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t app_config_load(const char *text, int len, bool persist)
+{
+    static char work[APP_CONFIG_TEXT_MAX_LEN];
+
+    if (text == NULL || len < 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len >= APP_CONFIG_TEXT_MAX_LEN)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    app_config_t old;
+    app_config_get(&old);
+
+    bool is_default = (len == 0);
+    app_config_t staging;
+
+    if (is_default)
+    {
+        set_defaults(&staging);
+    }
+    else
+    {
+        /* Chaves ausentes mantêm o valor em uso */
+        staging = old;
+
+        memcpy(work, text, len);
+        work[len] = '\0';
+
+        char *save = NULL;
+        for (char *pair = strtok_r(work, ";\n", &save); pair != NULL;
+             pair = strtok_r(NULL, ";\n", &save))
+        {
+            if (trim(pair)[0] == '\0')
+            {
+                continue;
+            }
+            if (!apply_pair(pair, &staging))
+            {
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+    }
+
+    /*
+     * Aplicação atômica em relação à task do esp-mqtt: o broker pode ter
+     * sido descartado (e s_config trocada) desde a leitura de old
+     */
+    portENTER_CRITICAL(&s_lock);
+    bool rejected = s_rejected_uri[0] != '\0' &&
+                    strcmp(staging.broker_uri, s_rejected_uri) == 0;
+    if (rejected)
+    {
+        memcpy(staging.broker_uri, s_config.broker_uri, sizeof(staging.broker_uri));
+    }
+
+    old = s_config;
+
+    /* Configuração retida é reentregue a cada conexão */
+    bool changed = memcmp(&staging, &old, sizeof(staging)) != 0;
+    if (changed)
+    {
+        /* Broker novo só é gravado após a primeira conexão aceita nele */
+        s_broker_pending = strcmp(staging.broker_uri, s_trusted_uri) != 0;
+        s_config = staging;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (rejected)
+    {
+        ESP_LOGW(TAG, "Broker rejeitado neste boot, mantido %s", old.broker_uri);
+    }
+    if (!changed)
+    {
+        return ESP_OK;
+    }
+
+    if (persist)
+    {
+        save_config();
+    }
+
+    notify_listeners(&staging, &old);
+    app_config_print();
+    return ESP_OK;
+}
+
+bool app_config_broker_pending(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool pending = s_broker_pending;
+    portEXIT_CRITICAL(&s_lock);
+
+    return pending;
+}
+
+void app_config_broker_confirmed(const char *uri)
+{
+    bool confirmed = false;
+
+    /* Só o broker ainda em teste: outro pode ter sido aplicado no meio */
+    portENTER_CRITICAL(&s_lock);
+    if (s_broker_pending && strcmp(s_config.broker_uri, uri) == 0)
+    {
+        memcpy(s_trusted_uri, s_config.broker_uri, sizeof(s_trusted_uri));
+        s_broker_pending = false;
+        confirmed = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (confirmed)
+    {
+        save_config();
+        ESP_LOGI(TAG, "Broker %s confirmado e gravado", uri);
+    }
+}
+
+void app_config_broker_rejected(const char *uri)
+{
+    app_config_t old;
+    app_config_t now;
+    bool rejected = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_broker_pending && strcmp(s_config.broker_uri, uri) == 0)
+    {
+        old = s_config;
+        now = old;
+        memcpy(now.broker_uri, s_trusted_uri, sizeof(s_trusted_uri));
+        memcpy(s_rejected_uri, old.broker_uri, sizeof(s_rejected_uri));
+        s_broker_pending = false;
+        s_config = now;
+        rejected = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (rejected)
+    {
+        ESP_LOGW(TAG, "Broker %s sem conexao, voltando para %s",
+                 old.broker_uri, now.broker_uri);
+        notify_listeners(&now, &old);
+    }
+}
+
+esp_err_t app_config_add_listener(app_config_listener_t fn, void *ctx)
+{
+    if (fn == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Reinicialização do mqtt_system registra de novo */
+    for (int i = 0; i < s_listener_count; i++)
+    {
+        if (s_listeners[i].fn == fn && s_listeners[i].ctx == ctx)
+        {
+            return ESP_OK;
+        }
+    }
+
+    if (s_listener_count >= APP_CONFIG_MAX_LISTENERS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_listeners[s_listener_count++] = (listener_t){fn, ctx};
+    return ESP_OK;
+}
+
+void app_config_print(void)
+{
+    app_config_t cfg;
+    app_config_get(&cfg);
+
+    ESP_LOGI(TAG, "Intervalos: telemetria %lu ms, health %lu ms, monitor %lu ms, custom %lu ms",
+             cfg.telemetry_interval_ms, cfg.health_interval_ms,
+             cfg.monitor_interval_ms, cfg.custom_publish_interval_ms);
+    ESP_LOGI(TAG, "Alertas de heap: monitor < %lu, health < %lu bytes; broker %s",
+             cfg.heap_warn_bytes, cfg.heap_low_bytes, cfg.broker_uri);
+}
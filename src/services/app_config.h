@@ -0,0 +1,160 @@
+/**
+ * @file app_config.h
+ * @brief Configuração da aplicação: NVS, atualização por MQTT e recarga a quente
+ *
+ * Intervalos dos jobs, limiares de alerta de heap e o URI do broker ficam
+ * numa única struct tipada, carregada do NVS no boot (ou dos #define
+ * padrão) e trocada inteira, sob trava, quando chega uma mensagem em
+ * APP_CONFIG_TOPIC. Os consumidores leem uma cópia com app_config_get() e
+ * reagem às mudanças com app_config_add_listener(): os jobs trocam de
+ * período, e o cliente MQTT troca de broker e reconecta, sem reboot.
+ *
+ * Formato texto (pares separados por ';' ou quebra de linha):
+ *
+ *   <chave>=<valor>
+ *
+ *   ex.: "telemetry_ms=30000;health_ms=300000"
+ *
+ * Chaves ausentes mantêm o valor em uso; payload vazio restaura os
+ * padrões. Uma chave desconhecida ou um valor fora da faixa rejeitam a
+ * mensagem inteira e nada muda. A configuração aceita é gravada no NVS
+ * apenas quando difere da atual (mensagens retidas voltam a cada conexão).
+ *
+ * Um broker novo fica em teste: o NVS mantém o último broker com conexão
+ * confirmada até o primeiro CONNACK no novo (app_config_broker_confirmed()).
+ * Se as tentativas se esgotarem (app_config_broker_rejected(), chamada
+ * pelo mqtt_system após MQTT_BROKER_TRIAL_ATTEMPTS falhas), o broker
+ * anterior volta a valer e o URI descartado é ignorado até o reboot (a
+ * configuração retida o reentregaria a cada conexão). Um URI errado não
+ * deixa o dispositivo fora do plano de controle, nem após um reboot.
+ *
+ * Os limiares das regras de atuação (luminosidade, temperatura) têm
+ * tópico e persistência próprios no rule_engine (RULE_ENGINE_CONFIG_TOPIC).
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "mqtt_system.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define APP_CONFIG_TOPIC MQTT_TOPIC_CONFIG "/app" ///< Tópico de configuração
+#define APP_CONFIG_NVS_NAMESPACE "app_cfg"		  ///< Namespace NVS
+#define APP_CONFIG_TEXT_MAX_LEN 256				  ///< Mensagem máxima
+#define APP_CONFIG_URI_MAX_LEN 96				  ///< URI do broker (com o terminador)
+#define APP_CONFIG_MAX_LISTENERS 4				  ///< Consumidores avisados das mudanças
+
+#define APP_CONFIG_DEFAULT_HEAP_WARN_BYTES 30000 ///< Alerta do monitor do sistema
+#define APP_CONFIG_DEFAULT_HEAP_LOW_BYTES 20000	 ///< Alerta do health check
+
+/*
+ * =============================================================================
+ * TIPOS
+ * =============================================================================
+ */
+
+/** Configuração em uso (chave do formato texto entre parênteses) */
+typedef struct
+{
+	uint32_t telemetry_interval_ms;		 ///< Job de telemetria (telemetry_ms)
+	uint32_t health_interval_ms;		 ///< Job de health check (health_ms)
+	uint32_t monitor_interval_ms;		 ///< Job de monitoramento (monitor_ms)
+	uint32_t custom_publish_interval_ms; ///< Job de publicação customizada (custom_ms)
+	uint32_t heap_warn_bytes;			 ///< Alerta do monitor (heap_warn)
+	uint32_t heap_low_bytes;			 ///< Alerta do health check (heap_low)
+	char broker_uri[APP_CONFIG_URI_MAX_LEN]; ///< mqtt:// ou mqtts:// (broker)
+} app_config_t;
+
+/**
+ * @brief Chamada após cada mudança, na task que recebeu a configuração
+ *
+ * @param now Configuração nova
+ * @param old Configuração anterior
+ * @param ctx Contexto informado no registro
+ */
+typedef void (*app_config_listener_t)(const app_config_t *now,
+									  const app_config_t *old, void *ctx);
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Carrega a configuração (NVS ou padrão) e registra o tópico
+ *
+ * @return ESP_OK, ou o erro do registro no mqtt_router
+ *
+ * @note Chamada por mqtt_system_init() após mqtt_router_init() e antes
+ *       do registro dos jobs
+ */
+esp_err_t app_config_init(void);
+
+/**
+ * @brief Copia a configuração em uso
+ */
+void app_config_get(app_config_t *out);
+
+/**
+ * @brief Aplica um texto de configuração
+ *
+ * @param text    Texto (não precisa ser terminado em null; vazio = padrões)
+ * @param len     Comprimento do texto
+ * @param persist Gravar no NVS
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (chave ou valor inválido) ou
+ *         ESP_ERR_INVALID_SIZE (texto longo demais)
+ */
+esp_err_t app_config_load(const char *text, int len, bool persist);
+
+/**
+ * @brief Indica se o broker em uso ainda não teve conexão confirmada
+ */
+bool app_config_broker_pending(void);
+
+/**
+ * @brief Confirma o broker em teste e o grava no NVS
+ *
+ * @param uri Broker em que a conexão foi aceita
+ *
+ * @note Chamada no MQTT_EVENT_CONNECTED; nada faz sem broker em teste ou
+ *       se @p uri não for mais o broker em uso (configuração trocada no
+ *       meio da conexão)
+ */
+void app_config_broker_confirmed(const char *uri);
+
+/**
+ * @brief Descarta o broker em teste e volta ao último confirmado
+ *
+ * Os consumidores são avisados como numa mudança comum, na task que chama.
+ *
+ * @param uri Broker que esgotou as tentativas; ignorado se não for mais o
+ *            broker em uso
+ */
+void app_config_broker_rejected(const char *uri);
+
+/**
+ * @brief Registra um consumidor das mudanças
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG ou ESP_ERR_NO_MEM (tabela cheia)
+ */
+esp_err_t app_config_add_listener(app_config_listener_t fn, void *ctx);
+
+/**
+ * @brief Imprime a configuração em uso no log
+ */
+void app_config_print(void);
+
+#endif /* APP_CONFIG_H */
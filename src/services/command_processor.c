@@ -0,0 +1,420 @@
+/**
+ * @file command_processor.c
+ * @brief Comandos recebidos em MQTT_TOPIC_COMMANDS - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "command_processor.h"
+#include "mqtt_router.h"
+#include "deadline.h"
+#include "json_writer.h"
+#include "log_sink.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_system.h"
+#include "driver/gpio.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "COMMANDS";
+
+/** Resultado de um comando na resposta */
+typedef struct
+{
+    const char *error; ///< NULL = executado
+    bool has_value;    ///< Incluir "value"
+    int32_t value;     ///< Leitura após o comando (gpio)
+} command_result_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/** Usados só pela task de despacho */
+static char s_work[MQTT_INBOUND_DATA_MAX_LEN + 1];
+static char s_reply[COMMAND_REPLY_MAX_LEN];
+
+static deadline_id_t s_deadline_reboot = -1;
+static bool s_initialized = false;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static char *trim(char *s)
+{
+    while (*s == ' ' || *s == '\t' || *s == '\r')
+    {
+        s++;
+    }
+
+    char *end = s + strlen(s);
+    while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+    {
+        *--end = '\0';
+    }
+    return s;
+}
+
+static bool parse_long(const char *s, long *out)
+{
+    char *end;
+
+    if (s == NULL)
+    {
+        return false;
+    }
+
+    long value = strtol(s, &end, 10);
+    if (end == s || *end != '\0')
+    {
+        return false;
+    }
+
+    *out = value;
+    return true;
+}
+
+/** Prazo do reboot vencido (task do esp_timer) */
+static void reboot_deadline(void *ctx)
+{
+    ESP_LOGW(TAG, "Reiniciando por comando remoto");
+    log_sink_flush();
+    esp_restart();
+}
+
+static void cmd_gpio(char *args[], int argc, command_result_t *result)
+{
+    long pin;
+    long level;
+
+    if (argc != 2 || !parse_long(args[0], &pin) || !parse_long(args[1], &level) ||
+        (level != 0 && level != 1))
+    {
+        result->error = "invalid_args";
+        return;
+    }
+    if (pin < 0 || pin > 63 || (COMMAND_GPIO_ALLOWED_MASK & (1ULL << pin)) == 0)
+    {
+        result->error = "not_allowed";
+        return;
+    }
+
+    /* Entrada e saída, para a resposta trazer o nível lido do pino */
+    if (gpio_set_direction((gpio_num_t)pin, GPIO_MODE_INPUT_OUTPUT) != ESP_OK ||
+        gpio_set_level((gpio_num_t)pin, (uint32_t)level) != ESP_OK)
+    {
+        result->error = "failed";
+        return;
+    }
+
+    result->has_value = true;
+    result->value = gpio_get_level((gpio_num_t)pin);
+    ESP_LOGI(TAG, "GPIO %ld = %ld", pin, level);
+}
+
+static void cmd_publish(char *args[], int argc, command_result_t *result)
+{
+    esp_err_t ret;
+
+    if (argc != 1)
+    {
+        result->error = "invalid_args";
+        return;
+    }
+
+    if (strcmp(args[0], "telemetry") == 0)
+    {
+        ret = mqtt_request_telemetry();
+    }
+    else if (strcmp(args[0], "health") == 0 || strcmp(args[0], "cpu") == 0)
+    {
+        /* Os dois saem pelo job de health, fora da task de despacho */
+        ret = mqtt_request_health();
+    }
+    else
+    {
+        result->error = "invalid_args";
+        return;
+    }
+
+    if (ret != ESP_OK)
+    {
+        result->error = "failed";
+    }
+}
+
+static void cmd_stats(char *args[], int argc, command_result_t *result,
+                      bool *want_stats)
+{
+    if (argc == 0)
+    {
+        *want_stats = true;
+    }
+    else if (argc == 1 && strcmp(args[0], "reset") == 0)
+    {
+        mqtt_reset_statistics();
+        ESP_LOGI(TAG, "Estatisticas zeradas");
+    }
+    else
+    {
+        result->error = "invalid_args";
+    }
+}
+
+static void cmd_reboot(char *args[], int argc, command_result_t *result)
+{
+    if (argc != 0)
+    {
+        result->error = "invalid_args";
+        return;
+    }
+
+    /* A resposta sai antes; o prazo dá tempo ao esp-mqtt de enviá-la */
+    if (deadline_arm(s_deadline_reboot, COMMAND_REBOOT_DELAY_MS) != ESP_OK)
+    {
+        result->error = "failed";
+        return;
+    }
+    ESP_LOGW(TAG, "Reboot em %d ms", COMMAND_REBOOT_DELAY_MS);
+}
+
+static void add_stats(json_writer_t *jw)
+{
+    mqtt_statistics_t stats;
+    mqtt_get_statistics(&stats);
+
+    json_begin_object_key(jw, "stats");
+    json_add_uint(jw, "msgs_sent", stats.total_publicadas);
+    json_add_uint(jw, "msgs_received", stats.total_recebidas);
+    json_add_uint(jw, "mqtt_failures", stats.falhas_publicacao);
+    json_add_uint(jw, "disconnects", stats.desconexoes);
+    json_add_uint(jw, "disconnected_ms", stats.tempo_desconectado_ms);
+    json_add_uint(jw, "inbound_dropped", stats.descartadas_entrada);
+    json_add_uint(jw, "suppressed", stats.suprimidas);
+    json_add_uint(jw, "offline_queued", stats.fila_offline);
+    json_add_uint(jw, "offline_dropped", stats.descartadas_offline);
+    json_begin_object_key(jw, "outbox_dropped");
+    json_add_uint(jw, "critical", stats.descartadas_outbox[MQTT_PRIORITY_CRITICAL]);
+    json_add_uint(jw, "telemetry", stats.descartadas_outbox[MQTT_PRIORITY_TELEMETRY]);
+    json_add_uint(jw, "custom", stats.descartadas_outbox[MQTT_PRIORITY_CUSTOM]);
+    json_end_object(jw);
+    json_add_uint(jw, "bytes_sent", stats.bytes_enviados);
+    json_add_uint(jw, "bytes_received", stats.bytes_recebidos);
+    json_add_uint(jw, "latency_max_us", stats.latencia_max_us);
+    json_add_uint(jw, "inflight", stats.em_voo);
+    json_end_object(jw);
+}
+
+/*
+ * =============================================================================
+ * HANDLERS
+ * =============================================================================
+ */
+
+static void command_handler(const char *topic, int topic_len,
+                            const char *data, int data_len, void *ctx)
+{
+    command_processor_run(data, data_len);
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t command_processor_init(void)
+{
+    if (!s_initialized)
+    {
+        s_deadline_reboot = deadline_register("Reboot", reboot_deadline, NULL);
+        if (s_deadline_reboot < 0)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        s_initialized = true;
+    }
+
+    return mqtt_register_topic_handler(MQTT_TOPIC_COMMANDS, command_handler, NULL);
+}
+
+int command_processor_run(const char *text, int len)
+{
+    if (text == NULL || len <= 0 || len > MQTT_INBOUND_DATA_MAX_LEN)
+    {
+        ESP_LOGW(TAG, "Mensagem de comandos vazia ou longa demais (%d bytes)", len);
+        return -1;
+    }
+
+    memcpy(s_work, text, len);
+    s_work[len] = '\0';
+
+    const char *id = "";
+    int executed = 0;
+    int errors = 0;
+    bool want_stats = false;
+
+    json_writer_t jw;
+    json_writer_init(&jw, s_reply, sizeof(s_reply));
+    json_begin_object(&jw);
+
+    char *save = NULL;
+    char *item = strtok_r(s_work, ";\n", &save);
+
+    /* Correlação só no primeiro item */
+    if (item != NULL && strncmp(trim(item), "id=", 3) == 0)
+    {
+        id = trim(item) + 3;
+        if (strlen(id) >= COMMAND_ID_MAX_LEN)
+        {
+            /* Nenhum comando é executado; o id não é ecoado, mas a falha chega */
+            ESP_LOGW(TAG, "Id de correlacao longo demais, mensagem ignorada");
+            json_add_string(&jw, "id", "");
+            json_add_uint(&jw, "ok", 0);
+            json_add_uint(&jw, "errors", 0);
+            json_add_string(&jw, "error", "id_too_long");
+            json_end_object(&jw);
+
+            int reply_len = json_writer_finish(&jw);
+            if (mqtt_publish_data(COMMAND_REPLY_TOPIC, s_reply, reply_len, 1, false) < 0)
+            {
+                ESP_LOGE(TAG, "Falha ao publicar a resposta (id longo demais)");
+            }
+            return -1;
+        }
+        item = strtok_r(NULL, ";\n", &save);
+    }
+
+    json_add_string(&jw, "id", id);
+    json_begin_array(&jw, "results");
+
+    for (; item != NULL; item = strtok_r(NULL, ";\n", &save))
+    {
+        char *line = trim(item);
+        if (line[0] == '\0')
+        {
+            continue;
+        }
+
+        char *tok_save = NULL;
+        char *name = strtok_r(line, " \t", &tok_save);
+        char *args[3];
+        int argc = 0;
+        bool too_many = false;
+
+        for (char *tok = strtok_r(NULL, " \t", &tok_save); tok != NULL;
+             tok = strtok_r(NULL, " \t", &tok_save))
+        {
+            if (argc == 3)
+            {
+                too_many = true;
+                break;
+            }
+            args[argc++] = tok;
+        }
+
+        command_result_t result = {0};
+
+        if (executed + errors >= COMMAND_MAX_PER_MESSAGE)
+        {
+            result.error = "limit";
+        }
+        else if (too_many)
+        {
+            result.error = "invalid_args";
+        }
+        else if (strcmp(name, "gpio") == 0)
+        {
+            cmd_gpio(args, argc, &result);
+        }
+        else if (strcmp(name, "publish") == 0)
+        {
+            cmd_publish(args, argc, &result);
+        }
+        else if (strcmp(name, "stats") == 0)
+        {
+            cmd_stats(args, argc, &result, &want_stats);
+        }
+        else if (strcmp(name, "reboot") == 0)
+        {
+            cmd_reboot(args, argc, &result);
+        }
+        else
+        {
+            result.error = "unknown";
+        }
+
+        if (result.error != NULL)
+        {
+            errors++;
+            ESP_LOGW(TAG, "Comando '%s': %s", name, result.error);
+        }
+        else
+        {
+            executed++;
+        }
+
+        json_begin_object(&jw);
+        json_add_string(&jw, "cmd", name);
+        json_add_bool(&jw, "ok", result.error == NULL);
+        if (result.error != NULL)
+        {
+            json_add_string(&jw, "error", result.error);
+        }
+        else if (result.has_value)
+        {
+            json_add_int(&jw, "value", result.value);
+        }
+        json_end_object(&jw);
+    }
+
+    json_end_array(&jw);
+    json_add_uint(&jw, "ok", executed);
+    json_add_uint(&jw, "errors", errors);
+    if (want_stats)
+    {
+        add_stats(&jw);
+    }
+    json_end_object(&jw);
+
+    int reply_len = json_writer_finish(&jw);
+    if (reply_len < 0)
+    {
+        /* Resultados não couberam: ao menos a contagem chega */
+        json_writer_init(&jw, s_reply, sizeof(s_reply));
+        json_begin_object(&jw);
+        json_add_string(&jw, "id", id);
+        json_add_uint(&jw, "ok", executed);
+        json_add_uint(&jw, "errors", errors);
+        json_add_bool(&jw, "truncated", true);
+        json_end_object(&jw);
+        reply_len = json_writer_finish(&jw);
+    }
+
+    if (mqtt_publish_data(COMMAND_REPLY_TOPIC, s_reply, reply_len, 1, false) < 0)
+    {
+        ESP_LOGE(TAG, "Falha ao publicar a resposta (id '%s')", id);
+    }
+
+    ESP_LOGI(TAG, "Mensagem '%s': %d executados, %d com erro", id, executed, errors);
+    return errors;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file command_processor.h
+ * @brief Comandos recebidos em MQTT_TOPIC_COMMANDS, com resposta correlacionada
+ *
+ * Uma mensagem carrega vários comandos, executados em ordem na task de
+ * despacho (mqtt_inbound), fora da task do esp-mqtt. Ao final sai uma única
+ * resposta em COMMAND_REPLY_TOPIC com o id da mensagem e o resultado de
+ * cada comando, então o painel de controle não precisa de uma ida e volta
+ * por comando.
+ *
+ * Formato texto (comandos separados por ';' ou quebra de linha):
+ *
+ *   [id=<correlação>;]<comando> [argumentos];...
+ *
+ *   ex.: "id=42;gpio 18 1;publish health;stats;stats reset"
+ *
+ * Comandos:
+ *
+ * - gpio <pino> <0|1>   : aciona uma saída de COMMAND_GPIO_ALLOWED_MASK
+ *                         (as regras do rule_engine podem mudá-la de novo);
+ * - publish <telemetry|health|cpu> : antecipa o job (telemetry: nova amostra
+ *                         e envio do lote; health e cpu: job de health, que
+ *                         publica os dois), sem fechar as janelas periódicas;
+ * - stats               : inclui os contadores MQTT na resposta;
+ * - stats reset         : mqtt_reset_statistics();
+ * - reboot              : reinicia COMMAND_REBOOT_DELAY_MS após a resposta.
+ *
+ * Um comando inválido não impede os seguintes; cada um tem seu resultado.
+ *
+ * Resposta (JSON):
+ *
+ *   {"id":"42","results":[{"cmd":"gpio","ok":true,"value":1},
+ *    {"cmd":"xyz","ok":false,"error":"unknown"},...],"ok":3,"errors":1,
+ *    "stats":{...}}
+ *
+ * Códigos de erro: unknown, invalid_args, not_allowed, failed e limit
+ * (comandos além de COMMAND_MAX_PER_MESSAGE, não executados).
+ *
+ * Um id com COMMAND_ID_MAX_LEN caracteres ou mais rejeita a mensagem
+ * inteira, sem executar nada: {"id":"","ok":0,"errors":0,
+ * "error":"id_too_long"}.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef COMMAND_PROCESSOR_H
+#define COMMAND_PROCESSOR_H
+
+#include "esp_err.h"
+#include "mqtt_system.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define COMMAND_REPLY_TOPIC MQTT_TOPIC_COMMANDS "/resposta" ///< Tópico das respostas
+#define COMMAND_MAX_PER_MESSAGE 16						   ///< Comandos por mensagem
+#define COMMAND_ID_MAX_LEN 32							   ///< Id de correlação
+#define COMMAND_REPLY_MAX_LEN 1536						   ///< Resposta máxima
+#define COMMAND_REBOOT_DELAY_MS 1000						   ///< Espera antes do reboot
+
+/** Saídas acionáveis por "gpio" (as das regras padrão: 18 e 19) */
+#define COMMAND_GPIO_ALLOWED_MASK ((1ULL << 18) | (1ULL << 19))
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Registra o tópico de comandos no mqtt_router
+ *
+ * @return ESP_OK, ou o erro do registro no mqtt_router
+ *
+ * @note Chamada por mqtt_system_init() após mqtt_router_init() e
+ *       deadline_init()
+ */
+esp_err_t command_processor_init(void);
+
+/**
+ * @brief Executa um texto de comandos e publica a resposta
+ *
+ * @param text Texto (não precisa ser terminado em null)
+ * @param len  Comprimento do texto
+ *
+ * @return Comandos com erro (0 = todos executados), -1 se o texto foi
+ *         rejeitado por inteiro (vazio ou longo demais, sem resposta; id
+ *         longo demais, com resposta de erro)
+ */
+int command_processor_run(const char *text, int len);
+
+#endif /* COMMAND_PROCESSOR_H */
@@ -0,0 +1,260 @@
+/**
+ * @file deadline.c
+ * @brief Prazos one-shot sobre um único esp_timer - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "deadline.h"
+#include "mqtt_system.h"
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "DEADLINE";
+
+/** Estado de um prazo registrado */
+typedef struct
+{
+    const char *name; ///< Nome para log
+    deadline_fn_t fn; ///< Callback
+    void *ctx;        ///< Contexto da callback
+    int64_t due_us;   ///< Vencimento (0 = desarmado)
+    uint32_t fired;   ///< Vencimentos ocorridos
+} deadline_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+static deadline_t s_deadlines[DEADLINE_MAX_SLOTS];
+static int s_deadline_count = 0;
+
+static esp_timer_handle_t s_timer = NULL;
+
+/** Vencimento para o qual o esp_timer está programado (0 = parado) */
+static int64_t s_programmed_us = 0;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static bool valid_id(deadline_id_t id)
+{
+    return s_timer != NULL && id >= 0 && id < s_deadline_count;
+}
+
+/**
+ * @brief Programa o esp_timer para o vencimento mais próximo
+ *
+ * @note Chamada com s_lock; as funções do esp_timer usam sua própria
+ *       trava e podem ser chamadas dentro de uma seção crítica
+ */
+static void reprogram_locked(int64_t now)
+{
+    int64_t earliest = 0;
+
+    for (int i = 0; i < s_deadline_count; i++)
+    {
+        int64_t due = s_deadlines[i].due_us;
+        if (due != 0 && (earliest == 0 || due < earliest))
+        {
+            earliest = due;
+        }
+    }
+
+    if (earliest == s_programmed_us)
+    {
+        return;
+    }
+
+    esp_timer_stop(s_timer);
+    s_programmed_us = earliest;
+
+    if (earliest != 0)
+    {
+        esp_timer_start_once(s_timer, earliest > now ? earliest - now : 0);
+    }
+}
+
+/**
+ * @brief Callback do esp_timer: chama os prazos vencidos
+ */
+static void timer_callback(void *arg)
+{
+    deadline_fn_t fns[DEADLINE_MAX_SLOTS];
+    void *ctxs[DEADLINE_MAX_SLOTS];
+    int due_count = 0;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    s_programmed_us = 0;
+
+    for (int i = 0; i < s_deadline_count; i++)
+    {
+        deadline_t *d = &s_deadlines[i];
+        if (d->due_us != 0 && d->due_us <= now)
+        {
+            d->due_us = 0;
+            d->fired++;
+            fns[due_count] = d->fn;
+            ctxs[due_count++] = d->ctx;
+        }
+    }
+
+    reprogram_locked(now);
+    portEXIT_CRITICAL(&s_lock);
+
+    /* Fora da trava: as callbacks podem rearmar prazos */
+    for (int i = 0; i < due_count; i++)
+    {
+        fns[i](ctxs[i]);
+    }
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t deadline_init(void)
+{
+    if (s_timer != NULL)
+    {
+        return ESP_OK;
+    }
+
+    const esp_timer_create_args_t args = {
+        .callback = timer_callback,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "deadline",
+    };
+
+    return esp_timer_create(&args, &s_timer);
+}
+
+deadline_id_t deadline_register(const char *name, deadline_fn_t fn, void *ctx)
+{
+    if (s_timer == NULL || fn == NULL)
+    {
+        return -1;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+
+    if (s_deadline_count >= DEADLINE_MAX_SLOTS)
+    {
+        portEXIT_CRITICAL(&s_lock);
+        ESP_LOGE(TAG, "Tabela de prazos cheia");
+        return -1;
+    }
+
+    deadline_id_t id = s_deadline_count;
+    s_deadlines[id] = (deadline_t){
+        .name = name,
+        .fn = fn,
+        .ctx = ctx,
+    };
+    s_deadline_count++;
+
+    portEXIT_CRITICAL(&s_lock);
+
+    return id;
+}
+
+esp_err_t deadline_arm(deadline_id_t id, uint32_t ms)
+{
+    if (!valid_id(id))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    /* +1: zero significa desarmado */
+    s_deadlines[id].due_us = now + (int64_t)ms * 1000 + 1;
+    reprogram_locked(now);
+    portEXIT_CRITICAL(&s_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t deadline_cancel(deadline_id_t id)
+{
+    if (!valid_id(id))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_deadlines[id].due_us != 0)
+    {
+        s_deadlines[id].due_us = 0;
+        reprogram_locked(esp_timer_get_time());
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    return ESP_OK;
+}
+
+bool deadline_is_armed(deadline_id_t id)
+{
+    return valid_id(id) && s_deadlines[id].due_us != 0;
+}
+
+uint32_t deadline_remaining_ms(deadline_id_t id)
+{
+    if (!valid_id(id))
+    {
+        return 0;
+    }
+
+    /* Leitura de 64 bits não é atômica no Xtensa */
+    portENTER_CRITICAL(&s_lock);
+    int64_t due = s_deadlines[id].due_us;
+    portEXIT_CRITICAL(&s_lock);
+    int64_t now = esp_timer_get_time();
+
+    return (due != 0 && due > now) ? (uint32_t)((due - now) / 1000) : 0;
+}
+
+void deadline_print(void)
+{
+    ESP_LOGI(TAG, "=== Prazos (%d) ===", s_deadline_count);
+
+    for (int i = 0; i < s_deadline_count; i++)
+    {
+        const deadline_t *d = &s_deadlines[i];
+
+        if (d->due_us != 0)
+        {
+            ESP_LOGI(TAG, "%-12s armado, vence em %lu ms (vencidos: %lu)",
+                     d->name, deadline_remaining_ms(i), d->fired);
+        }
+        else
+        {
+            ESP_LOGI(TAG, "%-12s desarmado (vencidos: %lu)", d->name, d->fired);
+        }
+    }
+}
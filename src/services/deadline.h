@@ -0,0 +1,89 @@
+/**
+ * @file deadline.h
+ * @brief Prazos one-shot (tempos de permanência) sobre um único esp_timer
+ *
+ * Um prazo é registrado uma vez, com callback e contexto, e depois armado
+ * e cancelado quantas vezes for preciso. Em vez de um job que verifica
+ * periodicamente se um instante já passou, a callback é chamada quando o
+ * prazo vence, com a precisão do esp_timer.
+ *
+ * Todos os prazos compartilham um esp_timer, sempre programado para o
+ * vencimento mais próximo; armar ou cancelar custa uma varredura de
+ * DEADLINE_MAX_SLOTS entradas, o que com poucas entradas é mais barato
+ * que manter uma roda de tempo. As callbacks executam na task do
+ * esp_timer e devem ser curtas; podem rearmar o próprio prazo.
+ *
+ * Um cancelamento que ocorra enquanto a callback já está sendo chamada não
+ * a impede: o usuário deve confirmar seu próprio estado na callback (como
+ * faz o rule_engine).
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/**
+ * @brief Callback de um prazo vencido
+ *
+ * @param ctx Contexto informado no registro
+ */
+typedef void (*deadline_fn_t)(void *ctx);
+
+/** Identificador de um prazo registrado (>= 0) */
+typedef int deadline_id_t;
+
+/**
+ * @brief Cria o esp_timer compartilhado
+ *
+ * Chamadas repetidas não têm efeito.
+ *
+ * @return ESP_OK, ou o erro de esp_timer_create()
+ */
+esp_err_t deadline_init(void);
+
+/**
+ * @brief Registra um prazo (inicialmente desarmado)
+ *
+ * @param name Nome para log (deve permanecer válido)
+ * @param fn   Callback chamada no vencimento
+ * @param ctx  Contexto passado à callback
+ *
+ * @return ID do prazo, ou -1 se a tabela estiver cheia ou os argumentos
+ *         forem inválidos
+ */
+deadline_id_t deadline_register(const char *name, deadline_fn_t fn, void *ctx);
+
+/**
+ * @brief Arma (ou rearma) um prazo para daqui a @p ms
+ *
+ * Pode ser chamada de qualquer task, inclusive da callback.
+ */
+esp_err_t deadline_arm(deadline_id_t id, uint32_t ms);
+
+/**
+ * @brief Desarma um prazo (sem efeito se não estiver armado)
+ */
+esp_err_t deadline_cancel(deadline_id_t id);
+
+/**
+ * @brief Informa se o prazo está armado
+ */
+bool deadline_is_armed(deadline_id_t id);
+
+/**
+ * @brief Tempo até o vencimento em ms (0 se vencido ou desarmado)
+ */
+uint32_t deadline_remaining_ms(deadline_id_t id);
+
+/**
+ * @brief Imprime no log os prazos, seu estado e quantos venceram
+ */
+void deadline_print(void);
+
+#endif /* DEADLINE_H */
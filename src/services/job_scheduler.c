@@ -0,0 +1,348 @@
+/**
+ * @file job_scheduler.c
+ * @brief Escalonador cooperativo de jobs periódicos - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "job_scheduler.h"
+#include "mqtt_system.h"
+#include "rtos_config.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "JOB_SCHED";
+
+/** Estado de um job registrado */
+typedef struct
+{
+    const char *name;   ///< Nome para log
+    job_fn_t fn;        ///< Callback
+    void *ctx;          ///< Contexto da callback
+    uint32_t period_ms; ///< Período (0 = apenas sob demanda)
+    int64_t next_us;    ///< Próximo vencimento
+    bool enabled;       ///< Execução periódica habilitada
+    bool pending;       ///< Execução imediata solicitada
+    uint32_t runs;      ///< Execuções realizadas
+    uint32_t max_us;    ///< Maior tempo de execução observado
+} job_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+static job_t s_jobs[JOB_SCHEDULER_MAX_JOBS];
+static int s_job_count = 0;
+
+static SemaphoreHandle_t s_jobs_mutex = NULL;
+RTOS_STATIC(StaticSemaphore_t, s_jobs_mutex_buf);
+static TaskHandle_t s_task_worker = NULL;
+
+/** Janela de alinhamento dos despertares (0 = desabilitada) */
+static int64_t s_wake_window_us = 0;
+
+/** Tempo acumulado executando jobs */
+static uint64_t s_busy_us = 0;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static bool valid_id(job_id_t id)
+{
+    return s_jobs_mutex != NULL && id >= 0 && id < s_job_count;
+}
+
+/** Acorda a task de trabalho para recalcular o próximo vencimento */
+static void wake_worker(void)
+{
+    if (s_task_worker != NULL)
+    {
+        xTaskNotifyGive(s_task_worker);
+    }
+}
+
+/**
+ * @brief Instante em que o job deve de fato executar
+ *
+ * Com janela de despertar, jobs longos são adiados até a borda da janela.
+ */
+static int64_t effective_due(const job_t *job)
+{
+    int64_t window = s_wake_window_us;
+
+    if (window <= 0 || (int64_t)job->period_ms * 1000 < window)
+    {
+        return job->next_us;
+    }
+
+    return ((job->next_us + window - 1) / window) * window;
+}
+
+/**
+ * @brief Escolhe o job a executar agora, ou o instante do próximo vencimento
+ *
+ * Deve ser chamada com o mutex. Execuções pendentes (job_trigger) têm
+ * precedência; entre jobs vencidos, o mais atrasado vai primeiro.
+ */
+static job_t *pick_due(int64_t now, int64_t *next_us)
+{
+    job_t *due = NULL;
+    *next_us = INT64_MAX;
+
+    for (int i = 0; i < s_job_count; i++)
+    {
+        job_t *job = &s_jobs[i];
+
+        if (job->pending)
+        {
+            job->pending = false;
+            return job;
+        }
+
+        if (!job->enabled || job->period_ms == 0)
+        {
+            continue;
+        }
+
+        int64_t due_us = effective_due(job);
+
+        if (due_us <= now)
+        {
+            if (due == NULL || job->next_us < due->next_us)
+            {
+                due = job;
+            }
+        }
+        else if (due_us < *next_us)
+        {
+            *next_us = due_us;
+        }
+    }
+
+    if (due != NULL)
+    {
+        /* Taxa fixa; se atrasou mais de um período, realinha a partir de agora */
+        int64_t period_us = (int64_t)due->period_ms * 1000;
+        due->next_us += period_us;
+        if (due->next_us <= now)
+        {
+            due->next_us = now + period_us;
+        }
+    }
+
+    return due;
+}
+
+static void worker_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Task do escalonador iniciada");
+
+    while (1)
+    {
+        int64_t now = esp_timer_get_time();
+        int64_t next_us;
+
+        xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+        job_t *job = pick_due(now, &next_us);
+        xSemaphoreGive(s_jobs_mutex);
+
+        if (job != NULL)
+        {
+            job->fn(job->ctx);
+
+            uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - now);
+            s_busy_us += elapsed_us;
+            job->runs++;
+            if (elapsed_us > job->max_us)
+            {
+                job->max_us = elapsed_us;
+            }
+            continue;
+        }
+
+        TickType_t wait = portMAX_DELAY;
+        if (next_us != INT64_MAX)
+        {
+            /* Arredonda para cima para não acordar antes do vencimento */
+            uint32_t wait_ms = (uint32_t)((next_us - now + 999) / 1000);
+            wait = (wait_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+        }
+
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t job_scheduler_start(void)
+{
+    if (s_task_worker != NULL)
+    {
+        return ESP_OK;
+    }
+
+    if (s_jobs_mutex == NULL)
+    {
+        s_jobs_mutex = RTOS_MUTEX_CREATE(s_jobs_mutex_buf);
+        if (s_jobs_mutex == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    esp_err_t ret = rtos_task_create(RTOS_TASK_JOB_WORKER, worker_task, NULL,
+                                     &s_task_worker);
+
+    return ret == ESP_OK ? ESP_OK : ESP_FAIL;
+}
+
+job_id_t job_register(const char *name, uint32_t period_ms, uint32_t first_ms,
+                      job_fn_t fn, void *ctx)
+{
+    if (s_jobs_mutex == NULL || name == NULL || fn == NULL)
+    {
+        return -1;
+    }
+
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+
+    if (s_job_count >= JOB_SCHEDULER_MAX_JOBS)
+    {
+        xSemaphoreGive(s_jobs_mutex);
+        ESP_LOGE(TAG, "Tabela de jobs cheia, '%s' nao registrado", name);
+        return -1;
+    }
+
+    job_id_t id = s_job_count;
+    job_t *job = &s_jobs[id];
+
+    job->name = name;
+    job->fn = fn;
+    job->ctx = ctx;
+    job->period_ms = period_ms;
+    job->next_us = esp_timer_get_time() + (int64_t)first_ms * 1000;
+    job->enabled = true;
+    job->pending = false;
+    job->runs = 0;
+    job->max_us = 0;
+    s_job_count++;
+
+    xSemaphoreGive(s_jobs_mutex);
+
+    ESP_LOGI(TAG, "  Job '%s' registrado (periodo %lu ms)", name, period_ms);
+
+    wake_worker();
+
+    return id;
+}
+
+esp_err_t job_set_period(job_id_t id, uint32_t period_ms)
+{
+    if (!valid_id(id))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    s_jobs[id].period_ms = period_ms;
+    s_jobs[id].next_us = esp_timer_get_time() + (int64_t)period_ms * 1000;
+    xSemaphoreGive(s_jobs_mutex);
+
+    wake_worker();
+
+    return ESP_OK;
+}
+
+esp_err_t job_set_enabled(job_id_t id, bool enabled)
+{
+    if (!valid_id(id))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+
+    job_t *job = &s_jobs[id];
+    if (enabled && !job->enabled)
+    {
+        job->next_us = esp_timer_get_time() + (int64_t)job->period_ms * 1000;
+    }
+    job->enabled = enabled;
+
+    xSemaphoreGive(s_jobs_mutex);
+
+    wake_worker();
+
+    return ESP_OK;
+}
+
+esp_err_t job_trigger(job_id_t id)
+{
+    if (!valid_id(id))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    s_jobs[id].pending = true;
+    xSemaphoreGive(s_jobs_mutex);
+
+    wake_worker();
+
+    return ESP_OK;
+}
+
+void job_scheduler_set_wake_window(uint32_t window_ms)
+{
+    s_wake_window_us = (int64_t)window_ms * 1000;
+    wake_worker();
+}
+
+uint64_t job_scheduler_busy_us(void)
+{
+    return s_busy_us;
+}
+
+void job_scheduler_print(void)
+{
+    ESP_LOGI(TAG, "=== Jobs ===");
+
+    for (int i = 0; i < s_job_count; i++)
+    {
+        const job_t *job = &s_jobs[i];
+        ESP_LOGI(TAG, "%-14s %7lu ms %s  exec=%lu  max=%lu us",
+                 job->name, job->period_ms, job->enabled ? "on " : "off",
+                 job->runs, job->max_us);
+    }
+
+    if (s_task_worker != NULL)
+    {
+        ESP_LOGI(TAG, "Stack livre (min): %u bytes",
+                 (unsigned)uxTaskGetStackHighWaterMark(s_task_worker));
+    }
+}
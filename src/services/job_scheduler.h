@@ -0,0 +1,108 @@
+/**
+ * @file job_scheduler.h
+ * @brief Escalonador cooperativo de jobs periódicos
+ *
+ * Substitui as tasks com laço de vTaskDelay por jobs executados em uma
+ * única task de trabalho. Cada job tem um período e uma callback; a task
+ * dorme até o próximo vencimento (bloqueada em uma notificação com
+ * timeout), então não há wakeups intermediários e o idle/tickless pode
+ * dormir por todo o intervalo.
+ *
+ * Os jobs são cooperativos: uma callback não deve bloquear por muito
+ * tempo, pois atrasa os demais. Trabalho longo ou orientado a eventos
+ * continua em tasks próprias (ex.: despacho de mensagens recebidas).
+ *
+ * O agendamento é de taxa fixa: o próximo vencimento é calculado a partir
+ * do anterior, sem acumular o atraso de execução. Se um job atrasar mais
+ * de um período, as execuções perdidas não são recuperadas.
+ *
+ * Com uma janela de despertar (job_scheduler_set_wake_window), os
+ * vencimentos dos jobs com período maior ou igual à janela são adiados
+ * até o próximo múltiplo da janela. Assim jobs de períodos múltiplos
+ * (10 s, 60 s, 5 min) executam juntos e o rádio acorda em uma só rajada.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/**
+ * @brief Callback de um job
+ *
+ * @param ctx Contexto informado no registro
+ */
+typedef void (*job_fn_t)(void *ctx);
+
+/** Identificador de um job registrado (>= 0) */
+typedef int job_id_t;
+
+/**
+ * @brief Cria a task de trabalho do escalonador
+ *
+ * Core, prioridade e stack vêm do plano de tasks (rtos_config.h). Chamadas repetidas não têm efeito.
+ *
+ * @return ESP_OK em sucesso, ESP_ERR_NO_MEM ou ESP_FAIL
+ */
+esp_err_t job_scheduler_start(void);
+
+/**
+ * @brief Registra um job periódico
+ *
+ * @param name        Nome para log (deve permanecer válido)
+ * @param period_ms   Período de execução (0 = apenas sob job_trigger())
+ * @param first_ms    Atraso até a primeira execução
+ * @param fn          Callback
+ * @param ctx         Contexto passado à callback
+ *
+ * @return ID do job, ou -1 se a tabela estiver cheia ou os argumentos
+ *         forem inválidos
+ */
+job_id_t job_register(const char *name, uint32_t period_ms, uint32_t first_ms,
+					  job_fn_t fn, void *ctx);
+
+/**
+ * @brief Altera o período de um job
+ *
+ * O novo período passa a valer a partir de agora (próxima execução em
+ * period_ms).
+ */
+esp_err_t job_set_period(job_id_t id, uint32_t period_ms);
+
+/**
+ * @brief Habilita ou desabilita um job
+ *
+ * Ao ser habilitado, o job volta a executar um período depois.
+ */
+esp_err_t job_set_enabled(job_id_t id, bool enabled);
+
+/**
+ * @brief Agenda a execução imediata de um job (também se desabilitado)
+ *
+ * Pode ser chamada de qualquer task, inclusive de dentro de um job.
+ */
+esp_err_t job_trigger(job_id_t id);
+
+/**
+ * @brief Define a janela de alinhamento dos despertares
+ *
+ * @param window_ms Janela em ms (0 = sem alinhamento, padrão)
+ */
+void job_scheduler_set_wake_window(uint32_t window_ms);
+
+/**
+ * @brief Tempo total gasto executando jobs desde o início (us)
+ */
+uint64_t job_scheduler_busy_us(void);
+
+/**
+ * @brief Imprime no log execuções e tempo máximo de cada job
+ */
+void job_scheduler_print(void);
+
+#endif /* JOB_SCHEDULER_H */
@@ -0,0 +1,367 @@
+/**
+ * @file json_writer.c
+ * @brief Serializador JSON incremental sem alocação - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "json_writer.h"
+
+#include <string.h>
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+/** Potências de 10 usadas no ponto fixo */
+static const uint32_t s_pow10[JSON_WRITER_MAX_DECIMALS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000};
+
+static const char s_hex[] = "0123456789abcdef";
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES - ESCRITA
+ * =============================================================================
+ */
+
+static void put_char(json_writer_t *w, char c)
+{
+    if (w->len >= w->cap)
+    {
+        w->overflow = true;
+        return;
+    }
+    w->buf[w->len++] = c;
+}
+
+static void put_mem(json_writer_t *w, const char *src, size_t len)
+{
+    if (len > w->cap - w->len)
+    {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, src, len);
+    w->len += len;
+}
+
+/** Converte um inteiro de 32 bits, escrevendo os dígitos do fim para o início */
+static void put_u32(json_writer_t *w, uint32_t value)
+{
+    char digits[10];
+    int i = sizeof(digits);
+
+    do
+    {
+        digits[--i] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    put_mem(w, digits + i, sizeof(digits) - i);
+}
+
+/**
+ * Divide por 10000 em parcelas de 16 bits (divisão longa): os restos ficam
+ * abaixo de 10000 e cada passo cabe em 32 bits, sem a divisão de 64 bits
+ * em software
+ */
+static void put_u64(json_writer_t *w, uint64_t value)
+{
+    if (value <= UINT32_MAX)
+    {
+        put_u32(w, (uint32_t)value);
+        return;
+    }
+
+    uint16_t limbs[4] = {
+        (uint16_t)(value >> 48), (uint16_t)(value >> 32),
+        (uint16_t)(value >> 16), (uint16_t)value};
+    char digits[20];
+    int i = sizeof(digits);
+    bool more;
+
+    do
+    {
+        uint32_t rem = 0;
+        more = false;
+        for (int k = 0; k < 4; k++)
+        {
+            uint32_t cur = (rem << 16) | limbs[k];
+            limbs[k] = (uint16_t)(cur / 10000);
+            rem = cur % 10000;
+            more = more || limbs[k] != 0;
+        }
+        for (int d = 0; d < 4; d++)
+        {
+            digits[--i] = '0' + (rem % 10);
+            rem /= 10;
+        }
+    } while (more);
+
+    while (digits[i] == '0')
+    {
+        i++;
+    }
+    put_mem(w, digits + i, sizeof(digits) - i);
+}
+
+/** Escreve a vírgula entre elementos e a chave, se houver */
+static void begin_value(json_writer_t *w, const char *key)
+{
+    if (w->depth > 0)
+    {
+        uint8_t bit = 1u << (w->depth - 1);
+
+        if (w->has_items & bit)
+        {
+            put_char(w, ',');
+        }
+        w->has_items |= bit;
+    }
+
+    if (key != NULL)
+    {
+        put_char(w, '"');
+        put_mem(w, key, strlen(key));
+        put_char(w, '"');
+        put_char(w, ':');
+    }
+}
+
+static void open_level(json_writer_t *w, const char *key, char c)
+{
+    begin_value(w, key);
+
+    if (w->depth >= JSON_WRITER_MAX_DEPTH)
+    {
+        w->overflow = true;
+        return;
+    }
+
+    put_char(w, c);
+    w->depth++;
+    w->has_items &= ~(1u << (w->depth - 1));
+}
+
+static void close_level(json_writer_t *w, char c)
+{
+    if (w->depth == 0)
+    {
+        w->overflow = true;
+        return;
+    }
+
+    put_char(w, c);
+    w->depth--;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+void json_writer_init(json_writer_t *w, char *buf, size_t cap)
+{
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->depth = 0;
+    w->has_items = 0;
+    w->overflow = (buf == NULL);
+}
+
+int json_writer_finish(json_writer_t *w)
+{
+    if (w->overflow || w->depth != 0)
+    {
+        return -1;
+    }
+
+    if (w->len < w->cap)
+    {
+        w->buf[w->len] = '\0';
+    }
+
+    return (int)w->len;
+}
+
+void json_begin_object(json_writer_t *w)
+{
+    open_level(w, NULL, '{');
+}
+
+void json_begin_object_key(json_writer_t *w, const char *key)
+{
+    open_level(w, key, '{');
+}
+
+void json_end_object(json_writer_t *w)
+{
+    close_level(w, '}');
+}
+
+void json_begin_array(json_writer_t *w, const char *key)
+{
+    open_level(w, key, '[');
+}
+
+void json_end_array(json_writer_t *w)
+{
+    close_level(w, ']');
+}
+
+void json_add_uint(json_writer_t *w, const char *key, uint64_t value)
+{
+    begin_value(w, key);
+    put_u64(w, value);
+}
+
+void json_add_int(json_writer_t *w, const char *key, int64_t value)
+{
+    begin_value(w, key);
+
+    if (value < 0)
+    {
+        put_char(w, '-');
+        put_u64(w, (uint64_t)0 - (uint64_t)value);
+    }
+    else
+    {
+        put_u64(w, (uint64_t)value);
+    }
+}
+
+void json_add_bool(json_writer_t *w, const char *key, bool value)
+{
+    begin_value(w, key);
+
+    if (value)
+    {
+        put_mem(w, "true", 4);
+    }
+    else
+    {
+        put_mem(w, "false", 5);
+    }
+}
+
+void json_add_null(json_writer_t *w, const char *key)
+{
+    begin_value(w, key);
+    put_mem(w, "null", 4);
+}
+
+void json_add_fixed(json_writer_t *w, const char *key, float value,
+                    uint8_t decimals)
+{
+    if (decimals > JSON_WRITER_MAX_DECIMALS)
+    {
+        decimals = JSON_WRITER_MAX_DECIMALS;
+    }
+
+    /* NaN, infinito ou fora da faixa de 64 bits após a escala */
+    if (!(value > -9.0e12f && value < 9.0e12f))
+    {
+        json_add_null(w, key);
+        return;
+    }
+
+    begin_value(w, key);
+
+    bool negative = value < 0.0f;
+    float magnitude = negative ? -value : value;
+    uint32_t scale = s_pow10[decimals];
+    float scaled = magnitude * (float)scale + 0.5f;
+    uint64_t integer;
+    uint32_t fraction;
+
+    if (scaled < 4294967296.0f)
+    {
+        /* Caso comum: o valor escalado cabe em 32 bits */
+        uint32_t fixed = (uint32_t)scaled;
+        integer = fixed / scale;
+        fraction = fixed % scale;
+    }
+    else
+    {
+        /*
+         * Parte inteira e fração separadas antes da escala: a divisão não
+         * passa por 64 bits. Acima de 2^24 o float não tem fração.
+         */
+        integer = (uint64_t)magnitude;
+        fraction = 0;
+        if (magnitude < 16777216.0f)
+        {
+            fraction = (uint32_t)((magnitude - (float)integer) * (float)scale + 0.5f);
+            if (fraction >= scale)
+            {
+                fraction -= scale;
+                integer++;
+            }
+        }
+    }
+
+    if (negative && (integer != 0 || fraction != 0))
+    {
+        put_char(w, '-');
+    }
+
+    put_u64(w, integer);
+
+    if (decimals > 0)
+    {
+        char digits[JSON_WRITER_MAX_DECIMALS + 1];
+        digits[0] = '.';
+        for (int i = decimals; i >= 1; i--)
+        {
+            digits[i] = '0' + (fraction % 10);
+            fraction /= 10;
+        }
+        put_mem(w, digits, decimals + 1);
+    }
+}
+
+void json_add_string(json_writer_t *w, const char *key, const char *value)
+{
+    begin_value(w, key);
+    put_char(w, '"');
+
+    for (const char *p = value; *p != '\0'; p++)
+    {
+        unsigned char c = (unsigned char)*p;
+
+        if (c == '"' || c == '\\')
+        {
+            put_char(w, '\\');
+            put_char(w, (char)c);
+        }
+        else if (c < 0x20)
+        {
+            char esc[6] = {'\\', 'u', '0', '0', s_hex[c >> 4], s_hex[c & 0x0F]};
+            put_mem(w, esc, sizeof(esc));
+        }
+        else
+        {
+            put_char(w, (char)c);
+        }
+    }
+
+    put_char(w, '"');
+}
+
+void json_add_raw(json_writer_t *w, const char *key, const char *raw,
+                  size_t len)
+{
+    begin_value(w, key);
+    put_mem(w, raw, len);
+}
@@ -0,0 +1,111 @@
+/**
+ * @file json_writer.h
+ * @brief Serializador JSON incremental sem alocação
+ *
+ * Escreve diretamente no buffer fornecido pelo chamador (por exemplo o
+ * buffer de um lote MQTT), sem cópia intermediária, sem heap e sem
+ * printf. Inteiros usam conversão própria com caminho rápido de 32 bits
+ * (o Xtensa não tem divisão de 64 bits em hardware) e números reais são
+ * escritos em ponto fixo com um número fixo de casas decimais.
+ *
+ * Estouros de buffer não escrevem além da capacidade: o writer marca o
+ * erro e json_writer_finish() retorna -1.
+ *
+ * Exemplo:
+ * @code
+ * json_writer_t w;
+ * json_writer_init(&w, buf, sizeof(buf));
+ * json_begin_object(&w);
+ * json_add_fixed(&w, "temperatura", 23.456f, 2);
+ * json_add_uint(&w, "contador", 7);
+ * json_end_object(&w);
+ * int len = json_writer_finish(&w); // {"temperatura":23.46,"contador":7}
+ * @endcode
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/** Profundidade máxima de objetos/arrays aninhados */
+#define JSON_WRITER_MAX_DEPTH 8
+
+/** Casas decimais máximas em json_add_fixed() */
+#define JSON_WRITER_MAX_DECIMALS 6
+
+/**
+ * @brief Estado do serializador
+ *
+ * Os campos são privados; use apenas as funções json_*.
+ */
+typedef struct
+{
+	char *buf;			 ///< Buffer de saída
+	size_t cap;			 ///< Capacidade do buffer
+	size_t len;			 ///< Bytes escritos
+	uint8_t depth;		 ///< Nível de aninhamento atual
+	uint8_t has_items;	 ///< Bit n = o nível n já tem algum elemento
+	bool overflow;		 ///< Buffer insuficiente ou aninhamento inválido
+} json_writer_t;
+
+/**
+ * @brief Inicializa o serializador sobre um buffer
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t cap);
+
+/**
+ * @brief Finaliza a escrita
+ *
+ * Termina a string com null se houver espaço (o null não é contado).
+ *
+ * @return Bytes escritos, ou -1 em estouro ou aninhamento incompleto
+ */
+int json_writer_finish(json_writer_t *w);
+
+/** Abre/fecha um objeto. Dentro de um objeto, use as funções com chave. */
+void json_begin_object(json_writer_t *w);
+void json_end_object(json_writer_t *w);
+
+/** Abre um array como valor do campo @p key (NULL dentro de arrays) */
+void json_begin_array(json_writer_t *w, const char *key);
+void json_end_array(json_writer_t *w);
+
+/** Abre um objeto como valor do campo @p key (NULL dentro de arrays) */
+void json_begin_object_key(json_writer_t *w, const char *key);
+
+/**
+ * @brief Campos de objeto (ou elementos de array com key = NULL)
+ *
+ * As chaves são escritas sem escape e devem ser literais ASCII simples.
+ */
+void json_add_uint(json_writer_t *w, const char *key, uint64_t value);
+void json_add_int(json_writer_t *w, const char *key, int64_t value);
+void json_add_bool(json_writer_t *w, const char *key, bool value);
+void json_add_null(json_writer_t *w, const char *key);
+
+/**
+ * @brief Número real em ponto fixo (ex.: 23.456 com 2 casas -> 23.46)
+ *
+ * Valores não finitos são escritos como null.
+ */
+void json_add_fixed(json_writer_t *w, const char *key, float value,
+					uint8_t decimals);
+
+/**
+ * @brief String com escape de aspas, barra invertida e controles
+ */
+void json_add_string(json_writer_t *w, const char *key, const char *value);
+
+/**
+ * @brief Valor JSON já serializado, copiado sem alteração
+ */
+void json_add_raw(json_writer_t *w, const char *key, const char *raw,
+				  size_t len);
+
+#endif /* JSON_WRITER_H */
@@ -0,0 +1,467 @@
+/**
+ * @file log_sink.c
+ * @brief Saída do log assíncrona, com limite por tag e supressão de repetições - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "log_sink.h"
+#include "rtos_config.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "esp_log.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "LOG_SINK";
+
+/** Linha de aviso gerada pelo próprio log_sink */
+#define NOTICE_MAX 96
+
+/** Limite de uma tag (balde em milésimos de linha) */
+typedef struct
+{
+    uint32_t hash;                     ///< FNV-1a da tag
+    char name[LOG_SINK_TAG_NAME_MAX];  ///< Tag (para o aviso)
+    uint16_t burst;                    ///< Capacidade do balde (linhas)
+    uint16_t per_min;                  ///< Reposição (0 = sem limite)
+    uint32_t tokens;                   ///< Saldo (milésimos de linha)
+    uint32_t last_ms;                  ///< Última reposição
+    uint32_t suppressed;               ///< Linhas descartadas desde a última aceita
+} tag_limit_t;
+
+/** Repetições a relatar */
+typedef struct
+{
+    uint32_t count;
+    char level;
+    char tag[LOG_SINK_TAG_NAME_MAX];
+} repeat_notice_t;
+
+/** Partes de uma linha "X (timestamp) TAG: texto" */
+typedef struct
+{
+    char level;      ///< 'E', 'W', 'I', 'D', 'V' (0 = fora do formato)
+    const char *tag; ///< Início da tag
+    int tag_len;     ///< Comprimento da tag (0 = sem tag)
+    const char *body; ///< Linha a partir da tag (sem o timestamp)
+} line_info_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static RingbufHandle_t s_ring = NULL;
+static bool s_started = false;
+
+#ifdef CONFIG_STATIC_ALLOCATION
+static uint8_t s_ring_storage[LOG_SINK_RING_SIZE];
+static StaticRingbuffer_t s_ring_buf;
+#endif
+
+/** Limites por tag (protegidos por s_lock) */
+static tag_limit_t s_tags[LOG_SINK_MAX_TAGS];
+static int s_tag_count = 0;
+
+/** Última linha aceita e repetições desde ela (protegidos por s_lock) */
+static uint32_t s_last_hash = 0;
+static char s_last_level = 0;
+static char s_last_tag[LOG_SINK_TAG_NAME_MAX];
+static uint32_t s_repeats = 0;
+static uint32_t s_repeat_since_ms = 0;
+
+/** Linhas perdidas com o ring buffer cheio */
+static uint32_t s_dropped = 0;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static uint32_t fnv1a(uint32_t hash, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void copy_tag(char *dst, const char *tag, int len)
+{
+    if (len >= LOG_SINK_TAG_NAME_MAX)
+    {
+        len = LOG_SINK_TAG_NAME_MAX - 1;
+    }
+    memcpy(dst, tag, len);
+    dst[len] = '\0';
+}
+
+static void parse_line(const char *line, line_info_t *info)
+{
+    memset(info, 0, sizeof(*info));
+    info->body = line;
+
+    if (strchr("EWIDV", line[0]) == NULL || line[0] == '\0' || line[1] != ' ')
+    {
+        return;
+    }
+
+    const char *body = strstr(line, ") ");
+    if (body == NULL)
+    {
+        return;
+    }
+    body += 2;
+
+    const char *sep = strstr(body, ": ");
+    info->level = line[0];
+    info->body = body;
+    info->tag = body;
+    info->tag_len = sep != NULL ? (int)(sep - body) : 0;
+}
+
+/**
+ * @brief Procura (ou cria) o limite de uma tag; chamada sob s_lock
+ */
+static tag_limit_t *find_tag(const char *tag, int len, uint32_t now_ms)
+{
+    uint32_t hash = fnv1a(2166136261u, tag, len);
+
+    for (int i = 0; i < s_tag_count; i++)
+    {
+        if (s_tags[i].hash == hash)
+        {
+            return &s_tags[i];
+        }
+    }
+
+    if (s_tag_count >= LOG_SINK_MAX_TAGS)
+    {
+        return NULL;
+    }
+
+    tag_limit_t *entry = &s_tags[s_tag_count++];
+    entry->hash = hash;
+    copy_tag(entry->name, tag, len);
+    entry->burst = LOG_SINK_TAG_BURST;
+    entry->per_min = LOG_SINK_TAG_PER_MIN;
+    entry->tokens = LOG_SINK_TAG_BURST * 1000u;
+    entry->last_ms = now_ms;
+    entry->suppressed = 0;
+    return entry;
+}
+
+/**
+ * @brief Repõe o balde e consome uma linha; chamada sob s_lock
+ *
+ * @param released Recebe as linhas descartadas antes desta, se aceita
+ */
+static bool rate_allow(tag_limit_t *entry, uint32_t now_ms, uint32_t *released)
+{
+    if (entry->per_min == 0)
+    {
+        return true;
+    }
+
+    uint64_t tokens = entry->tokens +
+                      (uint64_t)(now_ms - entry->last_ms) * entry->per_min * 1000u / 60000u;
+    uint32_t cap = entry->burst * 1000u;
+    entry->tokens = tokens > cap ? cap : (uint32_t)tokens;
+    entry->last_ms = now_ms;
+
+    if (entry->tokens < 1000u)
+    {
+        entry->suppressed++;
+        return false;
+    }
+
+    entry->tokens -= 1000u;
+    *released = entry->suppressed;
+    entry->suppressed = 0;
+    return true;
+}
+
+/**
+ * @brief Retira as repetições pendentes; chamada sob s_lock
+ */
+static void take_repeats(repeat_notice_t *out)
+{
+    out->count = s_repeats;
+    out->level = s_last_level != 0 ? s_last_level : 'I';
+    memcpy(out->tag, s_last_tag, sizeof(out->tag));
+    s_repeats = 0;
+}
+
+static void push(const char *data, size_t len)
+{
+    if (xRingbufferSend(s_ring, data, len, 0) != pdTRUE)
+    {
+        __atomic_fetch_add(&s_dropped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static int format_notice(char *buf, char level, const char *tag,
+                         const char *fmt, uint32_t count)
+{
+    int len = snprintf(buf, NOTICE_MAX, "%c (%lu) %s: ", level,
+                       esp_log_timestamp(), tag);
+    len += snprintf(buf + len, NOTICE_MAX - len, fmt, count);
+    return len < NOTICE_MAX ? len : NOTICE_MAX - 1;
+}
+
+static void push_repeats(const repeat_notice_t *repeat)
+{
+    if (repeat->count == 0)
+    {
+        return;
+    }
+
+    char notice[NOTICE_MAX];
+    int len = format_notice(notice, repeat->level, repeat->tag,
+                            "ultima mensagem repetida %lu vezes\n", repeat->count);
+    push(notice, len);
+}
+
+/**
+ * @brief Escreve direto o aviso de linhas perdidas (o ring buffer encheu)
+ */
+static void report_dropped(void)
+{
+    uint32_t dropped = __atomic_exchange_n(&s_dropped, 0, __ATOMIC_RELAXED);
+    if (dropped == 0)
+    {
+        return;
+    }
+
+    char notice[NOTICE_MAX];
+    int len = format_notice(notice, 'W', TAG,
+                            "%lu linhas descartadas (buffer de log cheio)\n", dropped);
+    fwrite(notice, 1, len, stdout);
+}
+
+/**
+ * @brief vprintf do esp_log: formata, filtra e copia para o ring buffer
+ *
+ * Executa na task que chamou ESP_LOGx, sem esperar pela UART.
+ */
+static int sink_vprintf(const char *fmt, va_list args)
+{
+    char line[LOG_SINK_LINE_MAX];
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    if (len < 0)
+    {
+        return len;
+    }
+    if (len >= (int)sizeof(line))
+    {
+        len = sizeof(line) - 1;
+        line[len - 1] = '\n';
+    }
+
+    line_info_t info;
+    parse_line(line, &info);
+
+    uint32_t now_ms = esp_log_timestamp();
+    uint32_t hash = fnv1a(fnv1a(2166136261u, &info.level, 1), info.body,
+                          len - (info.body - line));
+
+    repeat_notice_t repeat = {0};
+    char tag[LOG_SINK_TAG_NAME_MAX] = "";
+    uint32_t released = 0;
+    bool emit = true;
+
+    portENTER_CRITICAL(&s_lock);
+    if (hash == s_last_hash)
+    {
+        if (s_repeats++ == 0)
+        {
+            s_repeat_since_ms = now_ms;
+        }
+        else if (now_ms - s_repeat_since_ms >= LOG_SINK_REPEAT_FLUSH_MS)
+        {
+            take_repeats(&repeat);
+        }
+        emit = false;
+    }
+    else
+    {
+        take_repeats(&repeat);
+
+        if (info.tag_len > 0 && info.level != 'E' && now_ms >= LOG_SINK_RATE_GRACE_MS)
+        {
+            tag_limit_t *entry = find_tag(info.tag, info.tag_len, now_ms);
+            if (entry != NULL)
+            {
+                emit = rate_allow(entry, now_ms, &released);
+            }
+        }
+
+        /* Linha descartada não é referência de repetição: "repetida N
+         * vezes" de uma linha que não saiu não diria nada */
+        s_last_hash = emit ? hash : 0;
+        s_last_level = info.level;
+        copy_tag(s_last_tag, info.tag != NULL ? info.tag : "", info.tag_len);
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    push_repeats(&repeat);
+
+    if (released > 0)
+    {
+        copy_tag(tag, info.tag, info.tag_len);
+        char notice[NOTICE_MAX];
+        int notice_len = format_notice(notice, 'W', tag,
+                                       "%lu linhas suprimidas pelo limite da tag\n",
+                                       released);
+        push(notice, notice_len);
+    }
+
+    if (emit)
+    {
+        push(line, len);
+    }
+
+    return len;
+}
+
+/**
+ * @brief Task LogSink: escreve na UART o que chega ao ring buffer
+ */
+static void sink_task(void *pvParameters)
+{
+    while (1)
+    {
+        size_t size;
+        char *item = xRingbufferReceive(s_ring, &size,
+                                        pdMS_TO_TICKS(LOG_SINK_REPEAT_FLUSH_MS));
+        if (item != NULL)
+        {
+            fwrite(item, 1, size, stdout);
+            vRingbufferReturnItem(s_ring, item);
+        }
+        else
+        {
+            /* Log parado: repetições pendentes não esperam a próxima linha */
+            repeat_notice_t repeat = {0};
+
+            portENTER_CRITICAL(&s_lock);
+            if (s_repeats > 0)
+            {
+                take_repeats(&repeat);
+            }
+            portEXIT_CRITICAL(&s_lock);
+
+            push_repeats(&repeat);
+        }
+
+        report_dropped();
+    }
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t log_sink_init(void)
+{
+    if (s_started)
+    {
+        return ESP_OK;
+    }
+
+    if (s_ring == NULL)
+    {
+#ifdef CONFIG_STATIC_ALLOCATION
+        s_ring = xRingbufferCreateStatic(sizeof(s_ring_storage), RINGBUF_TYPE_NOSPLIT,
+                                         s_ring_storage, &s_ring_buf);
+#else
+        s_ring = xRingbufferCreate(LOG_SINK_RING_SIZE, RINGBUF_TYPE_NOSPLIT);
+#endif
+        if (s_ring == NULL)
+        {
+            ESP_LOGE(TAG, "Falha ao criar buffer de log");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    esp_err_t ret = rtos_task_create(RTOS_TASK_LOG_SINK, sink_task, NULL, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao criar task de log");
+        return ret;
+    }
+
+    esp_log_set_vprintf(sink_vprintf);
+    s_started = true;
+
+    ESP_LOGI(TAG, "Log assincrono: buffer de %d bytes, %d linhas/min por tag",
+             LOG_SINK_RING_SIZE, LOG_SINK_TAG_PER_MIN);
+    return ESP_OK;
+}
+
+esp_err_t log_sink_set_tag_limit(const char *tag, uint16_t burst, uint16_t per_min)
+{
+    if (tag == NULL || tag[0] == '\0' || strlen(tag) >= LOG_SINK_TAG_NAME_MAX ||
+        (per_min > 0 && burst == 0))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t now_ms = esp_log_timestamp();
+
+    portENTER_CRITICAL(&s_lock);
+    tag_limit_t *entry = find_tag(tag, strlen(tag), now_ms);
+    if (entry != NULL)
+    {
+        entry->burst = burst;
+        entry->per_min = per_min;
+        entry->tokens = burst * 1000u;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    return entry != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void log_sink_flush(void)
+{
+    if (s_ring == NULL)
+    {
+        return;
+    }
+
+    size_t size;
+    char *item;
+    while ((item = xRingbufferReceive(s_ring, &size, 0)) != NULL)
+    {
+        fwrite(item, 1, size, stdout);
+        vRingbufferReturnItem(s_ring, item);
+    }
+
+    report_dropped();
+    fflush(stdout);
+}
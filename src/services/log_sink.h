@@ -0,0 +1,88 @@
+/**
+ * @file log_sink.h
+ * @brief Saída do log assíncrona, com limite por tag e supressão de repetições
+ *
+ * A 115200 baud cada linha de ESP_LOGx ocupa a UART por alguns ms, e
+ * sem o driver da UART quem espera é a task que chamou o log: o job que
+ * publica, a task de despacho, o esp-mqtt. O log_sink instala um
+ * esp_log_set_vprintf() que apenas formata a linha e a copia para um
+ * ring buffer; a task LogSink (plano do rtos_config, prioridade mínima)
+ * escreve na UART.
+ *
+ * No caminho até o ring buffer:
+ *
+ * - linhas iguais em sequência (mesmo nível, tag e texto, sem contar o
+ *   timestamp) viram uma linha "ultima mensagem repetida N vezes", emitida
+ *   quando chega outra linha ou a cada LOG_SINK_REPEAT_FLUSH_MS;
+ * - cada tag tem um balde de LOG_SINK_TAG_BURST linhas, reposto a
+ *   LOG_SINK_TAG_PER_MIN linhas por minuto (ajustável por tag com
+ *   log_sink_set_tag_limit()); o excedente é descartado e contado, e a
+ *   contagem sai na próxima linha aceita da tag. Erros não são limitados,
+ *   e nos primeiros LOG_SINK_RATE_GRACE_MS do boot nada é;
+ * - com o ring buffer cheio a linha é descartada e contada.
+ *
+ * Vale para todas as tags, inclusive as do ESP-IDF. Linhas de ESP_EARLY_LOG,
+ * do panic handler e printf() não passam pelo vprintf e saem direto; o
+ * que estiver no ring buffer num reset é perdido. Antes de deep sleep ou
+ * restart, log_sink_flush().
+ *
+ * O nível máximo compilado vem de CONFIG_LOG_MAXIMUM_LEVEL (INFO em todos
+ * os sdkconfig): ESP_LOGD e ESP_LOGV nem entram no binário.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define LOG_SINK_RING_SIZE 4096		   ///< Ring buffer de linhas (bytes)
+#define LOG_SINK_LINE_MAX 192		   ///< Linha formatada (maior é truncada)
+#define LOG_SINK_MAX_TAGS 24		   ///< Tags acompanhadas (as demais sem limite)
+#define LOG_SINK_TAG_NAME_MAX 16	   ///< Tag guardada para os avisos
+#define LOG_SINK_TAG_BURST 30		   ///< Linhas seguidas permitidas por tag
+#define LOG_SINK_TAG_PER_MIN 60		   ///< Reposição do balde (linhas/min)
+#define LOG_SINK_RATE_GRACE_MS 15000   ///< Sem limite por tag no início do boot
+#define LOG_SINK_REPEAT_FLUSH_MS 5000  ///< Espera máxima do aviso de repetição
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Cria o ring buffer e a task LogSink e redireciona o esp_log
+ *
+ * Chamada no início de app_main(); até aqui o log sai direto na UART.
+ *
+ * @return ESP_OK, ou ESP_ERR_NO_MEM (o log continua síncrono)
+ */
+esp_err_t log_sink_init(void);
+
+/**
+ * @brief Ajusta o limite de uma tag
+ *
+ * @param tag     Tag do ESP_LOGx (copiada, até LOG_SINK_TAG_NAME_MAX - 1)
+ * @param burst   Linhas seguidas permitidas
+ * @param per_min Reposição em linhas por minuto (0 = tag sem limite)
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG ou ESP_ERR_NO_MEM (tabela cheia)
+ */
+esp_err_t log_sink_set_tag_limit(const char *tag, uint16_t burst, uint16_t per_min);
+
+/**
+ * @brief Escreve na UART, na task que chama, tudo o que está no ring buffer
+ */
+void log_sink_flush(void);
+
+#endif /* LOG_SINK_H */
@@ -0,0 +1,255 @@
+/**
+ * @file mqtt_batch.c
+ * @brief Agregação de amostras em uma única publicação MQTT - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "mqtt_batch.h"
+#include "mqtt_system.h"
+#include "rtos_config.h"
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "MQTT_BATCH";
+
+const mqtt_batch_framing_t MQTT_BATCH_FRAMING_JSON = {
+    .open = "[", .open_len = 1,
+    .sep = ",", .sep_len = 1,
+    .close = "]", .close_len = 1,
+};
+
+const mqtt_batch_framing_t MQTT_BATCH_FRAMING_CBOR = {
+    .open = "\x9f", .open_len = 1,
+    .sep = "", .sep_len = 0,
+    .close = "\xff", .close_len = 1,
+};
+
+const mqtt_batch_framing_t MQTT_BATCH_FRAMING_PACKED = {
+    .open = "", .open_len = 0,
+    .sep = "", .sep_len = 0,
+    .close = "", .close_len = 0,
+};
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static void batch_reset(mqtt_batch_t *batch)
+{
+    memcpy(batch->buf, batch->framing->open, batch->framing->open_len);
+    batch->len = batch->framing->open_len;
+    batch->count = 0;
+    batch->first_item_us = 0;
+}
+
+/** Fecha o lote e publica. Deve ser chamada com o mutex do lote. */
+static int batch_flush_locked(mqtt_batch_t *batch)
+{
+    if (batch->count == 0)
+    {
+        return 0;
+    }
+
+    memcpy(batch->buf + batch->len, batch->framing->close,
+           batch->framing->close_len);
+    batch->len += batch->framing->close_len;
+
+    int msg_id = mqtt_publish_data(batch->topic, batch->buf, batch->len,
+                                   batch->qos, false);
+
+    ESP_LOGD(TAG, "Lote publicado em '%s': %lu itens, %u bytes",
+             batch->topic, batch->count, (unsigned)batch->len);
+
+    batch_reset(batch);
+
+    return msg_id;
+}
+
+static bool batch_expired(const mqtt_batch_t *batch)
+{
+    if (batch->count == 0)
+    {
+        return false;
+    }
+
+    int64_t age_us = esp_timer_get_time() - batch->first_item_us;
+    return age_us >= (int64_t)batch->max_age_ms * 1000;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t mqtt_batch_init(mqtt_batch_t *batch, const char *topic,
+                          const mqtt_batch_framing_t *framing, int qos,
+                          char *buf, size_t cap, uint32_t max_count,
+                          size_t max_bytes, uint32_t max_age_ms)
+{
+    if (batch == NULL || topic == NULL || framing == NULL || buf == NULL ||
+        max_count == 0 || max_bytes > cap ||
+        max_bytes <= (size_t)framing->open_len + framing->close_len)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    batch->topic = topic;
+    batch->framing = framing;
+    batch->qos = qos;
+    batch->buf = buf;
+    batch->cap = cap;
+    batch->max_count = max_count;
+    batch->max_bytes = max_bytes;
+    batch->max_age_ms = max_age_ms;
+
+    batch->mutex = RTOS_MUTEX_CREATE(batch->mutex_buf);
+    if (batch->mutex == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    batch_reset(batch);
+
+    return ESP_OK;
+}
+
+int mqtt_batch_set_target(mqtt_batch_t *batch, const char *topic,
+                          const mqtt_batch_framing_t *framing)
+{
+    if (batch == NULL || batch->mutex == NULL || topic == NULL ||
+        framing == NULL ||
+        batch->max_bytes <= (size_t)framing->open_len + framing->close_len)
+    {
+        return -1;
+    }
+
+    xSemaphoreTake(batch->mutex, portMAX_DELAY);
+
+    int msg_id = batch_flush_locked(batch);
+    batch->topic = topic;
+    batch->framing = framing;
+    batch_reset(batch);
+
+    xSemaphoreGive(batch->mutex);
+
+    return msg_id;
+}
+
+int mqtt_batch_add_encoded(mqtt_batch_t *batch, mqtt_batch_encode_fn_t encode,
+                           void *ctx)
+{
+    if (batch == NULL || batch->mutex == NULL || encode == NULL)
+    {
+        return -1;
+    }
+
+    int msg_id = 0;
+    int len = -1;
+
+    xSemaphoreTake(batch->mutex, portMAX_DELAY);
+
+    const mqtt_batch_framing_t *framing = batch->framing;
+
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        size_t sep_len = batch->count > 0 ? framing->sep_len : 0;
+        size_t start = batch->len + sep_len;
+        size_t reserved = start + framing->close_len;
+
+        if (reserved < batch->max_bytes)
+        {
+            len = encode((uint8_t *)batch->buf + start,
+                         batch->max_bytes - reserved, ctx);
+        }
+
+        if (len > 0)
+        {
+            /* O separador vai antes do item já escrito */
+            memcpy(batch->buf + batch->len, framing->sep, sep_len);
+            batch->len = start + len;
+            break;
+        }
+
+        if (batch->count == 0)
+        {
+            break;
+        }
+
+        msg_id = batch_flush_locked(batch);
+    }
+
+    if (len <= 0)
+    {
+        xSemaphoreGive(batch->mutex);
+        ESP_LOGW(TAG, "Item nao cabe no lote");
+        return -1;
+    }
+
+    if (batch->count == 0)
+    {
+        batch->first_item_us = esp_timer_get_time();
+    }
+    batch->count++;
+
+    if (batch->count >= batch->max_count || batch_expired(batch))
+    {
+        msg_id = batch_flush_locked(batch);
+    }
+
+    xSemaphoreGive(batch->mutex);
+
+    return msg_id;
+}
+
+int mqtt_batch_poll(mqtt_batch_t *batch)
+{
+    if (batch == NULL || batch->mutex == NULL)
+    {
+        return -1;
+    }
+
+    int msg_id = 0;
+
+    xSemaphoreTake(batch->mutex, portMAX_DELAY);
+
+    if (batch_expired(batch))
+    {
+        msg_id = batch_flush_locked(batch);
+    }
+
+    xSemaphoreGive(batch->mutex);
+
+    return msg_id;
+}
+
+int mqtt_batch_flush(mqtt_batch_t *batch)
+{
+    if (batch == NULL || batch->mutex == NULL)
+    {
+        return -1;
+    }
+
+    xSemaphoreTake(batch->mutex, portMAX_DELAY);
+    int msg_id = batch_flush_locked(batch);
+    xSemaphoreGive(batch->mutex);
+
+    return msg_id;
+}
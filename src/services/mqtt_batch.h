@@ -0,0 +1,140 @@
+/**
+ * @file mqtt_batch.h
+ * @brief Agregação de amostras em uma única publicação MQTT
+ *
+ * Um lote acumula itens serializados em um buffer pré-alocado pelo
+ * chamador e publica todos de uma vez quando um dos limites é atingido:
+ * quantidade de itens, tamanho em bytes ou idade do item mais antigo.
+ * O enquadramento do lote (abertura, separador e fechamento) depende do
+ * formato do payload: array JSON, array CBOR indefinido ou registros
+ * binários concatenados. Menos publicações significam menos segmentos TCP,
+ * menos round trips de QoS 1 e menos tempo de rádio ligado.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef MQTT_BATCH_H
+#define MQTT_BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+/**
+ * @brief Enquadramento dos itens de um lote
+ */
+typedef struct
+{
+	const char *open;  ///< Bytes de abertura do lote
+	uint8_t open_len;  ///< Tamanho da abertura
+	const char *sep;   ///< Separador entre itens
+	uint8_t sep_len;   ///< Tamanho do separador
+	const char *close; ///< Bytes de fechamento do lote
+	uint8_t close_len; ///< Tamanho do fechamento
+} mqtt_batch_framing_t;
+
+/** Array JSON: [item,item] */
+extern const mqtt_batch_framing_t MQTT_BATCH_FRAMING_JSON;
+
+/** Array CBOR de tamanho indefinido: 0x9F item item 0xFF */
+extern const mqtt_batch_framing_t MQTT_BATCH_FRAMING_CBOR;
+
+/** Registros binários de tamanho fixo concatenados */
+extern const mqtt_batch_framing_t MQTT_BATCH_FRAMING_PACKED;
+
+/**
+ * @brief Codificador que escreve um item diretamente no buffer do lote
+ *
+ * @param buf Posição do item dentro do buffer do lote
+ * @param cap Espaço disponível para o item
+ * @param ctx Contexto do chamador
+ *
+ * @return Bytes escritos, ou -1 se o item não couber
+ */
+typedef int (*mqtt_batch_encode_fn_t)(uint8_t *buf, size_t cap, void *ctx);
+
+/**
+ * @brief Estado de um lote de publicação
+ *
+ * Os campos são privados; use apenas as funções mqtt_batch_*.
+ */
+typedef struct
+{
+	const char *topic;					 ///< Tópico de destino
+	const mqtt_batch_framing_t *framing; ///< Enquadramento dos itens
+	int qos;							 ///< QoS da publicação agregada
+	char *buf;							 ///< Buffer pré-alocado pelo chamador
+	size_t cap;							 ///< Capacidade do buffer
+	size_t len;							 ///< Bytes ocupados (inclui a abertura)
+	uint32_t count;						 ///< Itens acumulados
+	uint32_t max_count;					 ///< Limite de itens por publicação
+	size_t max_bytes;					 ///< Limite de bytes por publicação
+	uint32_t max_age_ms;				 ///< Idade máxima do item mais antigo
+	int64_t first_item_us;				 ///< Instante do primeiro item do lote
+	SemaphoreHandle_t mutex;			 ///< Protege o lote entre tasks
+#ifdef CONFIG_STATIC_ALLOCATION
+	StaticSemaphore_t mutex_buf;		 ///< Armazenamento do mutex
+#endif
+} mqtt_batch_t;
+
+/**
+ * @brief Inicializa um lote
+ *
+ * @param batch      Lote a inicializar
+ * @param topic      Tópico de destino (deve permanecer válido)
+ * @param framing    Enquadramento (ex.: &MQTT_BATCH_FRAMING_JSON)
+ * @param qos        QoS da publicação
+ * @param buf        Buffer de trabalho (tipicamente static)
+ * @param cap        Tamanho do buffer
+ * @param max_count  Publica ao atingir este número de itens
+ * @param max_bytes  Publica antes de ultrapassar este tamanho (<= cap)
+ * @param max_age_ms Publica quando o item mais antigo atingir esta idade
+ *
+ * @return ESP_OK em sucesso, ESP_ERR_INVALID_ARG ou ESP_ERR_NO_MEM
+ */
+esp_err_t mqtt_batch_init(mqtt_batch_t *batch, const char *topic,
+						  const mqtt_batch_framing_t *framing, int qos,
+						  char *buf, size_t cap, uint32_t max_count,
+						  size_t max_bytes, uint32_t max_age_ms);
+
+/**
+ * @brief Troca tópico e enquadramento, publicando antes o que estiver acumulado
+ *
+ * @return ID da mensagem se havia itens publicados, 0 caso contrário,
+ *         -1 em erro
+ */
+int mqtt_batch_set_target(mqtt_batch_t *batch, const char *topic,
+						  const mqtt_batch_framing_t *framing);
+
+/**
+ * @brief Acrescenta um item serializado diretamente no buffer do lote
+ *
+ * Publica se algum limite for atingido. O codificador é chamado com o
+ * mutex do lote e escreve no espaço livre, sem buffer intermediário. Se
+ * o item não couber, o lote atual é publicado e o codificador é chamado
+ * de novo com o buffer vazio.
+ *
+ * @return ID da mensagem se o lote foi publicado, 0 se o item apenas foi
+ *         acumulado, -1 em erro
+ */
+int mqtt_batch_add_encoded(mqtt_batch_t *batch, mqtt_batch_encode_fn_t encode,
+						   void *ctx);
+
+/**
+ * @brief Publica o lote se o item mais antigo já atingiu a idade máxima
+ *
+ * @return ID da mensagem se publicado, 0 se nada a fazer, -1 em erro
+ */
+int mqtt_batch_poll(mqtt_batch_t *batch);
+
+/**
+ * @brief Publica imediatamente o que estiver acumulado
+ *
+ * @return ID da mensagem se publicado, 0 se o lote estava vazio, -1 em erro
+ */
+int mqtt_batch_flush(mqtt_batch_t *batch);
+
+#endif /* MQTT_BATCH_H */
@@ -0,0 +1,218 @@
+/**
+ * @file mqtt_inbound.c
+ * @brief Fila de entrada de mensagens MQTT e task de despacho - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "mqtt_inbound.h"
+#include "mqtt_system.h"
+#include "mqtt_router.h"
+#include "mqtt_stats.h"
+#include "rtos_config.h"
+#include "trace.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "MQTT_INBOUND";
+
+/** Slot pré-alocado para uma mensagem recebida */
+typedef struct
+{
+    char topic[MQTT_INBOUND_TOPIC_MAX_LEN]; ///< Tópico
+    char data[MQTT_INBOUND_DATA_MAX_LEN];   ///< Payload (remontado)
+    uint16_t topic_len;                     ///< Comprimento do tópico
+    uint16_t data_len;                      ///< Bytes já recebidos
+    uint16_t total_len;                     ///< Comprimento total esperado
+} inbound_slot_t;
+
+/** Estado da remontagem do slot em preenchimento */
+typedef enum
+{
+    FILL_IDLE = 0, ///< Nenhuma mensagem em andamento
+    FILL_ACTIVE,   ///< Recebendo fragmentos no slot de s_head
+    FILL_DISCARD   ///< Ignorando fragmentos de mensagem descartada
+} fill_state_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/** Anel de slots (alocação estática) */
+static inbound_slot_t s_slots[MQTT_INBOUND_QUEUE_SLOTS];
+
+/** Contadores livres do anel: escritos apenas pelo produtor / consumidor */
+static volatile uint32_t s_head = 0;
+static volatile uint32_t s_tail = 0;
+
+/** Estado de remontagem (acessado apenas pelo produtor) */
+static fill_state_t s_fill_state = FILL_IDLE;
+
+/** Handle da task de despacho */
+static TaskHandle_t s_task_dispatch = NULL;
+
+/*
+ * =============================================================================
+ * TASK DE DESPACHO
+ * =============================================================================
+ */
+
+static void dispatch_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Task de despacho iniciada");
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t tail = s_tail;
+
+        while (tail != __atomic_load_n(&s_head, __ATOMIC_ACQUIRE))
+        {
+            inbound_slot_t *slot = &s_slots[tail % MQTT_INBOUND_QUEUE_SLOTS];
+
+            ESP_LOGI(TAG, "Mensagem MQTT:");
+            ESP_LOGI(TAG, "  Topico: %.*s", slot->topic_len, slot->topic);
+            ESP_LOGI(TAG, "  Dados: %.*s", slot->data_len, slot->data);
+
+            if (mqtt_router_consume_echo(slot->topic, slot->topic_len,
+                                         slot->data, slot->data_len))
+            {
+                ESP_LOGD(TAG, "Eco de entrega local descartado");
+            }
+            else
+            {
+                TRACE_BEGIN(t);
+                int handlers = mqtt_router_dispatch(slot->topic, slot->topic_len,
+                                                    slot->data, slot->data_len);
+                TRACE_END(TRACE_DISPATCH, t, handlers);
+
+                if (handlers == 0)
+                {
+                    ESP_LOGD(TAG, "Nenhum handler para '%.*s'",
+                             slot->topic_len, slot->topic);
+                }
+            }
+
+            tail++;
+            __atomic_store_n(&s_tail, tail, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t mqtt_inbound_start(void)
+{
+    if (s_task_dispatch != NULL)
+    {
+        return ESP_OK;
+    }
+
+    s_head = 0;
+    s_tail = 0;
+    s_fill_state = FILL_IDLE;
+
+    if (rtos_task_create(RTOS_TASK_MQTT_DISPATCH, dispatch_task, NULL,
+                         &s_task_dispatch) != ESP_OK)
+    {
+        s_task_dispatch = NULL;
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+void mqtt_inbound_stop(void)
+{
+    if (s_task_dispatch != NULL)
+    {
+        vTaskDelete(s_task_dispatch);
+        s_task_dispatch = NULL;
+    }
+
+    s_fill_state = FILL_IDLE;
+    s_tail = s_head;
+}
+
+bool mqtt_inbound_post(const char *topic, int topic_len,
+                       const char *data, int data_len,
+                       int offset, int total_len)
+{
+    if (s_task_dispatch == NULL)
+    {
+        return false;
+    }
+
+    uint32_t head = s_head;
+    inbound_slot_t *slot = &s_slots[head % MQTT_INBOUND_QUEUE_SLOTS];
+
+    if (offset == 0)
+    {
+        /* Primeiro fragmento: reserva um slot novo */
+        uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+
+        if (head - tail >= MQTT_INBOUND_QUEUE_SLOTS ||
+            topic_len <= 0 || topic_len > MQTT_INBOUND_TOPIC_MAX_LEN ||
+            total_len > MQTT_INBOUND_DATA_MAX_LEN)
+        {
+            s_fill_state = (data_len < total_len) ? FILL_DISCARD : FILL_IDLE;
+            return false;
+        }
+
+        memcpy(slot->topic, topic, topic_len);
+        slot->topic_len = topic_len;
+        slot->data_len = 0;
+        slot->total_len = total_len;
+        s_fill_state = FILL_ACTIVE;
+    }
+    else if (s_fill_state != FILL_ACTIVE ||
+             offset != slot->data_len ||
+             offset + data_len > slot->total_len)
+    {
+        /* Fragmento de mensagem já descartada ou fora de sequência */
+        bool already_discarded = (s_fill_state == FILL_DISCARD);
+
+        s_fill_state = (offset + data_len < total_len) ? FILL_DISCARD : FILL_IDLE;
+        return already_discarded;
+    }
+
+    memcpy(slot->data + offset, data, data_len);
+    slot->data_len = offset + data_len;
+
+    if (slot->data_len < slot->total_len)
+    {
+        return true;
+    }
+
+    /* Mensagem completa: publica o slot para o consumidor */
+    s_fill_state = FILL_IDLE;
+    __atomic_store_n(&s_head, head + 1, __ATOMIC_RELEASE);
+    xTaskNotifyGive(s_task_dispatch);
+
+    mqtt_stats_update_hwm(MQTT_HWM_FILA_ENTRADA,
+                          head + 1 - __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE));
+
+    return true;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file mqtt_inbound.h
+ * @brief Fila de entrada de mensagens MQTT e task de despacho
+ *
+ * Desacopla o processamento das mensagens recebidas da task do cliente
+ * esp-mqtt. O handler de eventos apenas copia tópico e payload para um
+ * slot de um anel pré-alocado e notifica a task de despacho, que entrega
+ * a mensagem ao mqtt_router fora do caminho de recepção/keepalive.
+ * Mensagens que são o eco de uma publicação já entregue localmente
+ * (mqtt_router_deliver_local()) são descartadas.
+ *
+ * O anel tem um único produtor (task do esp-mqtt) e um único consumidor
+ * (task de despacho), portanto dispensa locks e não aloca memória.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef MQTT_INBOUND_H
+#define MQTT_INBOUND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/**
+ * @brief Cria a task de despacho da fila de entrada
+ *
+ * Core, prioridade e stack vêm do plano de tasks (rtos_config.h).
+ *
+ * @return ESP_OK em sucesso, ESP_FAIL se a task não puder ser criada
+ */
+esp_err_t mqtt_inbound_start(void);
+
+/**
+ * @brief Para a task de despacho e descarta mensagens pendentes
+ */
+void mqtt_inbound_stop(void);
+
+/**
+ * @brief Enfileira (um fragmento de) uma mensagem recebida
+ *
+ * Mensagens maiores que o buffer do esp-mqtt chegam em vários eventos
+ * MQTT_EVENT_DATA; os fragmentos são remontados no mesmo slot e a
+ * mensagem só é liberada para o despacho quando estiver completa.
+ *
+ * @param topic      Tópico (somente no primeiro fragmento)
+ * @param topic_len  Comprimento do tópico
+ * @param data       Dados do fragmento
+ * @param data_len   Comprimento do fragmento
+ * @param offset     Posição do fragmento na mensagem
+ * @param total_len  Comprimento total da mensagem
+ *
+ * @return true se aceito, false se a mensagem foi descartada
+ *         (fila cheia, tópico ou payload maiores que o slot)
+ *
+ * @note Deve ser chamada apenas pela task do cliente MQTT (produtor único)
+ */
+bool mqtt_inbound_post(const char *topic, int topic_len,
+					   const char *data, int data_len,
+					   int offset, int total_len);
+
+#endif /* MQTT_INBOUND_H */
@@ -0,0 +1,295 @@
+/**
+ * @file mqtt_inflight.c
+ * @brief Rastreamento de publicações QoS 1/2 até o ACK do broker - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "mqtt_inflight.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+/** Estado de uma entrada da tabela */
+typedef enum
+{
+    SLOT_FREE = 0, ///< Livre
+    SLOT_WAITING,  ///< Publicada, aguardando ACK
+    SLOT_EARLY_ACK ///< ACK recebido antes do registro pelo publicador
+} slot_state_t;
+
+typedef struct
+{
+    int msg_id;         ///< ID da mensagem
+    int64_t stamp_us;   ///< Envio (WAITING) ou ACK (EARLY_ACK)
+    slot_state_t state; ///< Estado
+} inflight_slot_t;
+
+/** Métricas de uma janela */
+typedef struct
+{
+    uint32_t acks;
+    uint32_t timeouts;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t hist[MQTT_INFLIGHT_LATENCY_BUCKETS];
+} inflight_window_t;
+
+/** Limite superior (exclusivo) das faixas do histograma; a última é aberta */
+static const uint32_t s_bounds_us[MQTT_INFLIGHT_LATENCY_BUCKETS - 1] = {
+    250, 500, 1000, 2000, 5000, 10000, 20000, 50000,
+    100000, 200000, 500000, 1000000, 2000000, 5000000, 10000000};
+
+#define TIMEOUT_US ((int64_t)MQTT_INFLIGHT_TIMEOUT_MS * 1000)
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+static inflight_slot_t s_slots[MQTT_INFLIGHT_SLOTS];
+static inflight_window_t s_window = {.min_us = UINT32_MAX};
+
+/** Seções críticas curtas: publicadores em qualquer core + task do cliente */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES (chamadas com s_lock)
+ * =============================================================================
+ */
+
+static void record_latency(uint32_t latency_us)
+{
+    int bucket = 0;
+    while (bucket < MQTT_INFLIGHT_LATENCY_BUCKETS - 1 &&
+           latency_us >= s_bounds_us[bucket])
+    {
+        bucket++;
+    }
+
+    s_window.hist[bucket]++;
+    s_window.acks++;
+    s_window.sum_us += latency_us;
+    if (latency_us < s_window.min_us)
+    {
+        s_window.min_us = latency_us;
+    }
+    if (latency_us > s_window.max_us)
+    {
+        s_window.max_us = latency_us;
+    }
+}
+
+static inflight_slot_t *find(int msg_id)
+{
+    for (int i = 0; i < MQTT_INFLIGHT_SLOTS; i++)
+    {
+        if (s_slots[i].state != SLOT_FREE && s_slots[i].msg_id == msg_id)
+        {
+            return &s_slots[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Libera entradas vencidas
+ *
+ * Publicações sem ACK contam como timeout; ACKs órfãos (de mensagens não
+ * rastreadas) são apenas descartados.
+ */
+static void expire(int64_t now)
+{
+    for (int i = 0; i < MQTT_INFLIGHT_SLOTS; i++)
+    {
+        inflight_slot_t *slot = &s_slots[i];
+
+        if (slot->state != SLOT_FREE && now - slot->stamp_us >= TIMEOUT_US)
+        {
+            if (slot->state == SLOT_WAITING)
+            {
+                s_window.timeouts++;
+            }
+            slot->state = SLOT_FREE;
+        }
+    }
+}
+
+/** Entrada livre; com a tabela cheia, a mais antiga é contada como timeout */
+static inflight_slot_t *alloc(int64_t now)
+{
+    inflight_slot_t *oldest = NULL;
+
+    expire(now);
+
+    for (int i = 0; i < MQTT_INFLIGHT_SLOTS; i++)
+    {
+        inflight_slot_t *slot = &s_slots[i];
+
+        if (slot->state == SLOT_FREE)
+        {
+            return slot;
+        }
+        if (oldest == NULL || slot->stamp_us < oldest->stamp_us)
+        {
+            oldest = slot;
+        }
+    }
+
+    if (oldest->state == SLOT_WAITING)
+    {
+        s_window.timeouts++;
+    }
+    return oldest;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+void mqtt_inflight_track(int msg_id, int64_t start_us)
+{
+    if (msg_id <= 0)
+    {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+
+    inflight_slot_t *slot = find(msg_id);
+    if (slot != NULL && slot->state == SLOT_EARLY_ACK)
+    {
+        record_latency((uint32_t)(slot->stamp_us - start_us));
+        slot->state = SLOT_FREE;
+    }
+    else
+    {
+        if (slot == NULL)
+        {
+            slot = alloc(now);
+        }
+        slot->msg_id = msg_id;
+        slot->stamp_us = start_us;
+        slot->state = SLOT_WAITING;
+    }
+
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_inflight_ack(int msg_id)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+
+    inflight_slot_t *slot = find(msg_id);
+    if (slot != NULL && slot->state == SLOT_WAITING)
+    {
+        record_latency((uint32_t)(now - slot->stamp_us));
+        slot->state = SLOT_FREE;
+    }
+    else if (slot == NULL)
+    {
+        slot = alloc(now);
+        slot->msg_id = msg_id;
+        slot->stamp_us = now;
+        slot->state = SLOT_EARLY_ACK;
+    }
+
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_inflight_deleted(int msg_id)
+{
+    portENTER_CRITICAL(&s_lock);
+
+    inflight_slot_t *slot = find(msg_id);
+    if (slot != NULL && slot->state == SLOT_WAITING)
+    {
+        s_window.timeouts++;
+        slot->state = SLOT_FREE;
+    }
+
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_inflight_snapshot(mqtt_statistics_t *stats)
+{
+    inflight_window_t window;
+    uint32_t waiting = 0;
+
+    portENTER_CRITICAL(&s_lock);
+
+    expire(esp_timer_get_time());
+    for (int i = 0; i < MQTT_INFLIGHT_SLOTS; i++)
+    {
+        if (s_slots[i].state == SLOT_WAITING)
+        {
+            waiting++;
+        }
+    }
+    window = s_window;
+
+    portEXIT_CRITICAL(&s_lock);
+
+    stats->em_voo = waiting;
+    stats->ack_timeouts = window.timeouts;
+    stats->ack_amostras = window.acks;
+
+    if (window.acks == 0)
+    {
+        stats->ack_min_us = 0;
+        stats->ack_avg_us = 0;
+        stats->ack_p99_us = 0;
+        return;
+    }
+
+    stats->ack_min_us = window.min_us;
+    stats->ack_avg_us = (uint32_t)(window.sum_us / window.acks);
+
+    /* Primeira faixa em que a contagem acumulada alcança 99% */
+    uint32_t target = (uint32_t)(((uint64_t)window.acks * 99 + 99) / 100);
+    uint32_t cumulative = 0;
+    int bucket = 0;
+    for (; bucket < MQTT_INFLIGHT_LATENCY_BUCKETS - 1; bucket++)
+    {
+        cumulative += window.hist[bucket];
+        if (cumulative >= target)
+        {
+            break;
+        }
+    }
+
+    uint32_t p99 = bucket < MQTT_INFLIGHT_LATENCY_BUCKETS - 1
+                       ? s_bounds_us[bucket]
+                       : window.max_us;
+    stats->ack_p99_us = p99 < window.max_us ? p99 : window.max_us;
+}
+
+void mqtt_inflight_rotate(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    memset(&s_window, 0, sizeof(s_window));
+    s_window.min_us = UINT32_MAX;
+    portEXIT_CRITICAL(&s_lock);
+}
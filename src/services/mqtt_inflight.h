@@ -0,0 +1,63 @@
+/**
+ * @file mqtt_inflight.h
+ * @brief Rastreamento de publicações QoS 1/2 até o ACK do broker
+ *
+ * publish_now() registra cada msg_id com QoS > 0 numa tabela de tamanho
+ * fixo (MQTT_INFLIGHT_SLOTS) junto com o instante do envio; o evento
+ * MQTT_EVENT_PUBLISHED (PUBACK / PUBCOMP) fecha a entrada e registra a
+ * latência. Entradas sem ACK após MQTT_INFLIGHT_TIMEOUT_MS, e mensagens
+ * descartadas do outbox (MQTT_EVENT_DELETED), contam como timeout.
+ *
+ * As métricas são por janela: mqtt_inflight_rotate() é chamada a cada
+ * health check, então min/média/p99 refletem o último intervalo, e não a
+ * vida inteira do dispositivo - é o que permite detectar congestionamento
+ * do broker na frota. O p99 vem de um histograma com faixas de ~2x e é
+ * reportado como o limite superior da faixa, limitado ao máximo observado.
+ *
+ * O ACK pode chegar (na task do cliente MQTT) antes de o publicador
+ * registrar o msg_id; nesse caso a entrada é criada pelo ACK e a latência
+ * é fechada no registro.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef MQTT_INFLIGHT_H
+#define MQTT_INFLIGHT_H
+
+#include <stdint.h>
+#include "mqtt_system.h"
+
+/**
+ * @brief Registra uma publicação aguardando ACK
+ *
+ * @param msg_id   ID retornado por esp_mqtt_client_publish() (> 0)
+ * @param start_us esp_timer_get_time() imediatamente antes da publicação
+ */
+void mqtt_inflight_track(int msg_id, int64_t start_us);
+
+/**
+ * @brief Trata MQTT_EVENT_PUBLISHED
+ */
+void mqtt_inflight_ack(int msg_id);
+
+/**
+ * @brief Trata MQTT_EVENT_DELETED (mensagem expirada no outbox)
+ */
+void mqtt_inflight_deleted(int msg_id);
+
+/**
+ * @brief Preenche os campos em_voo e ack_* de @p stats com a janela atual
+ *
+ * Entradas vencidas são contabilizadas como timeout antes da leitura.
+ */
+void mqtt_inflight_snapshot(mqtt_statistics_t *stats);
+
+/**
+ * @brief Encerra a janela de medição e inicia uma nova
+ *
+ * As entradas em voo são mantidas.
+ */
+void mqtt_inflight_rotate(void);
+
+#endif /* MQTT_INFLIGHT_H */
@@ -0,0 +1,451 @@
+/**
+ * @file mqtt_offline.c
+ * @brief Buffer store-and-forward de publicações - Implementação
+ *
+ * Invariante de ordem: toda mensagem na NVS é mais antiga que qualquer
+ * mensagem na RAM, pois apenas a entrada mais antiga da RAM é transferida
+ * para a NVS. Assim a drenagem esvazia primeiro a NVS e depois a RAM.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "mqtt_offline.h"
+#include "mqtt_system.h"
+#include "mqtt_stats.h"
+#include "job_scheduler.h"
+#include "rtos_config.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "MQTT_OFFLINE";
+
+/** Namespace NVS do anel persistente */
+#define OFFLINE_NVS_NAMESPACE "mqtt_offline"
+
+/** Entrada armazenada: tópico terminado em null seguido do payload */
+typedef struct
+{
+    uint32_t seq;       ///< Número de sequência (identifica a entrada na RAM)
+    uint8_t qos;        ///< QoS da publicação
+    uint8_t retain;     ///< Flag de retain
+    uint16_t topic_len; ///< Comprimento do tópico (sem o null)
+    uint16_t data_len;  ///< Comprimento do payload
+    char buf[MQTT_OFFLINE_TOPIC_MAX_LEN + MQTT_OFFLINE_DATA_MAX_LEN];
+} offline_entry_t;
+
+/** Bytes efetivamente gravados na NVS para uma entrada */
+#define ENTRY_STORED_SIZE(e) \
+    (offsetof(offline_entry_t, buf) + (e)->topic_len + 1 + (e)->data_len)
+
+/** Entrada cheia na NVS: dados em entradas de 32 bytes, cabeçalho e índice do blob */
+#define NVS_ITEM_BYTES 32
+#define ENTRY_NVS_FOOTPRINT \
+    (((sizeof(offline_entry_t) + NVS_ITEM_BYTES - 1) / NVS_ITEM_BYTES + 2) * NVS_ITEM_BYTES)
+
+_Static_assert(MQTT_OFFLINE_NVS_MAX_ENTRIES * ENTRY_NVS_FOOTPRINT <= MQTT_OFFLINE_NVS_BUDGET_BYTES,
+               "Anel offline nao cabe em MQTT_OFFLINE_NVS_BUDGET_BYTES");
+
+/** Localização da entrada mais antiga lida pela drenagem */
+typedef struct
+{
+    bool in_flash;  ///< true = anel NVS, false = anel RAM
+    uint32_t index; ///< Índice livre no anel correspondente
+    uint32_t seq;   ///< Sequência da entrada (apenas RAM)
+} entry_location_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/** Anel em RAM (alocação estática) */
+static offline_entry_t s_ram[MQTT_OFFLINE_RAM_SLOTS];
+static uint32_t s_ram_head = 0;
+static uint32_t s_ram_tail = 0;
+
+/** Anel na NVS (índices persistidos) */
+static nvs_handle_t s_nvs = 0;
+static bool s_nvs_ok = false;
+static uint32_t s_flash_head = 0;
+static uint32_t s_flash_tail = 0;
+static uint32_t s_saved_head = 0; ///< Últimos índices gravados
+static uint32_t s_saved_tail = 0;
+
+static uint32_t s_next_seq = 0;
+static uint32_t s_dropped = 0;
+
+/** Entrada de trabalho da drenagem (evita ocupar a stack da task) */
+static offline_entry_t s_drain_entry;
+
+static SemaphoreHandle_t s_offline_mutex = NULL;
+RTOS_STATIC(StaticSemaphore_t, s_offline_mutex_buf);
+static job_id_t s_job_drain = -1;
+
+static mqtt_offline_send_fn_t s_send = NULL;
+static mqtt_offline_connected_fn_t s_connected = NULL;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES - NVS
+ * =============================================================================
+ */
+
+static void flash_key(uint32_t index, char *key, size_t key_size)
+{
+    snprintf(key, key_size, "m%02lu",
+             (unsigned long)(index % MQTT_OFFLINE_NVS_MAX_ENTRIES));
+}
+
+/** Grava só os índices que mudaram: cada escrita consome entradas da NVS */
+static void flash_save_indexes(void)
+{
+    if (s_flash_head != s_saved_head)
+    {
+        nvs_set_u32(s_nvs, "head", s_flash_head);
+        s_saved_head = s_flash_head;
+    }
+    if (s_flash_tail != s_saved_tail)
+    {
+        nvs_set_u32(s_nvs, "tail", s_flash_tail);
+        s_saved_tail = s_flash_tail;
+    }
+    nvs_commit(s_nvs);
+}
+
+/** Apaga o anel (blobs e índices) e grava o tamanho atual */
+static void flash_reset(void)
+{
+    nvs_erase_all(s_nvs);
+    nvs_set_u32(s_nvs, "slots", MQTT_OFFLINE_NVS_MAX_ENTRIES);
+    nvs_commit(s_nvs);
+    s_flash_head = 0;
+    s_flash_tail = 0;
+    s_saved_head = 0;
+    s_saved_tail = 0;
+}
+
+static esp_err_t flash_write(uint32_t index, const offline_entry_t *entry)
+{
+    char key[8];
+    flash_key(index, key, sizeof(key));
+
+    return nvs_set_blob(s_nvs, key, entry, ENTRY_STORED_SIZE(entry));
+}
+
+static esp_err_t flash_read(uint32_t index, offline_entry_t *entry)
+{
+    char key[8];
+    size_t size = sizeof(offline_entry_t);
+    flash_key(index, key, sizeof(key));
+
+    return nvs_get_blob(s_nvs, key, entry, &size);
+}
+
+/**
+ * @brief Move a entrada mais antiga da RAM para a NVS
+ *
+ * Se a NVS estiver cheia, a gravação ocupa a chave da entrada mais
+ * antiga da NVS, descartada só depois que a gravação dá certo. Em caso de
+ * falha de escrita, descarta apenas a entrada da RAM.
+ */
+static void spill_oldest_ram(void)
+{
+    offline_entry_t *oldest = &s_ram[s_ram_tail % MQTT_OFFLINE_RAM_SLOTS];
+
+    if (s_nvs_ok)
+    {
+        bool full = s_flash_head - s_flash_tail >= MQTT_OFFLINE_NVS_MAX_ENTRIES;
+
+        if (flash_write(s_flash_head, oldest) == ESP_OK)
+        {
+            if (full)
+            {
+                s_flash_tail++;
+                s_dropped++;
+            }
+            s_flash_head++;
+            flash_save_indexes();
+            s_ram_tail++;
+            return;
+        }
+
+        ESP_LOGW(TAG, "Falha ao gravar mensagem na NVS");
+    }
+
+    s_ram_tail++;
+    s_dropped++;
+}
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES - DRENAGEM
+ * =============================================================================
+ */
+
+/** Copia a entrada mais antiga para s_drain_entry */
+static bool peek_oldest(entry_location_t *loc)
+{
+    bool found = false;
+
+    xSemaphoreTake(s_offline_mutex, portMAX_DELAY);
+
+    while (!found && s_flash_head != s_flash_tail)
+    {
+        if (flash_read(s_flash_tail, &s_drain_entry) == ESP_OK)
+        {
+            loc->in_flash = true;
+            loc->index = s_flash_tail;
+            found = true;
+        }
+        else
+        {
+            /* Entrada ilegível: descarta para não travar a drenagem */
+            ESP_LOGW(TAG, "Entrada NVS invalida descartada");
+            s_flash_tail++;
+            s_dropped++;
+            flash_save_indexes();
+        }
+    }
+
+    if (!found && s_ram_head != s_ram_tail)
+    {
+        const offline_entry_t *entry = &s_ram[s_ram_tail % MQTT_OFFLINE_RAM_SLOTS];
+        memcpy(&s_drain_entry, entry, ENTRY_STORED_SIZE(entry));
+        loc->in_flash = false;
+        loc->index = s_ram_tail;
+        loc->seq = entry->seq;
+        found = true;
+    }
+
+    xSemaphoreGive(s_offline_mutex);
+
+    return found;
+}
+
+/** Remove a entrada enviada, se ela ainda for a mais antiga do seu anel */
+static void pop_sent(const entry_location_t *loc)
+{
+    xSemaphoreTake(s_offline_mutex, portMAX_DELAY);
+
+    if (loc->in_flash)
+    {
+        if (s_flash_tail == loc->index)
+        {
+            s_flash_tail++;
+            flash_save_indexes();
+        }
+    }
+    else if (s_ram_tail == loc->index &&
+             s_ram[loc->index % MQTT_OFFLINE_RAM_SLOTS].seq == loc->seq)
+    {
+        s_ram_tail++;
+    }
+
+    xSemaphoreGive(s_offline_mutex);
+}
+
+/**
+ * @brief Reenvia uma rodada de até MQTT_OFFLINE_DRAIN_BATCH mensagens
+ *
+ * Executado a cada MQTT_OFFLINE_DRAIN_INTERVAL_MS enquanto houver
+ * mensagens pendentes e conexão; depois se desabilita.
+ */
+static void drain_job(void *ctx)
+{
+    for (int i = 0; i < MQTT_OFFLINE_DRAIN_BATCH; i++)
+    {
+        entry_location_t loc;
+
+        if (!s_connected() || !peek_oldest(&loc))
+        {
+            break;
+        }
+
+        const char *topic = s_drain_entry.buf;
+        const char *data = s_drain_entry.buf + s_drain_entry.topic_len + 1;
+
+        if (s_send(topic, data, s_drain_entry.data_len,
+                   s_drain_entry.qos, s_drain_entry.retain) < 0)
+        {
+            break;
+        }
+
+        pop_sent(&loc);
+    }
+
+    if (mqtt_offline_pending() == 0 || !s_connected())
+    {
+        job_set_enabled(s_job_drain, false);
+    }
+}
+
+static void start_drain(void)
+{
+    job_set_enabled(s_job_drain, true);
+    job_trigger(s_job_drain);
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t mqtt_offline_init(mqtt_offline_send_fn_t send,
+                            mqtt_offline_connected_fn_t connected)
+{
+    if (send == NULL || connected == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_offline_mutex != NULL)
+    {
+        return ESP_OK;
+    }
+
+    s_send = send;
+    s_connected = connected;
+
+    s_offline_mutex = RTOS_MUTEX_CREATE(s_offline_mutex_buf);
+    if (s_offline_mutex == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = nvs_open(OFFLINE_NVS_NAMESPACE, NVS_READWRITE, &s_nvs);
+    if (ret == ESP_OK)
+    {
+        uint32_t slots = 0;
+
+        s_nvs_ok = true;
+        nvs_get_u32(s_nvs, "slots", &slots);
+        nvs_get_u32(s_nvs, "head", &s_flash_head);
+        nvs_get_u32(s_nvs, "tail", &s_flash_tail);
+        s_saved_head = s_flash_head;
+        s_saved_tail = s_flash_tail;
+
+        /* Chaves m<n> dependem do tamanho do anel: outro tamanho, outro anel */
+        if (slots != MQTT_OFFLINE_NVS_MAX_ENTRIES)
+        {
+            if (s_flash_head != s_flash_tail)
+            {
+                ESP_LOGW(TAG, "Anel NVS de %lu entradas, descartando buffer", slots);
+            }
+            flash_reset();
+        }
+        else if (s_flash_head - s_flash_tail > MQTT_OFFLINE_NVS_MAX_ENTRIES)
+        {
+            ESP_LOGW(TAG, "Indices NVS inconsistentes, descartando buffer");
+            flash_reset();
+        }
+    }
+    else
+    {
+        ESP_LOGW(TAG, "NVS indisponivel (%s), buffer apenas em RAM",
+                 esp_err_to_name(ret));
+    }
+
+    /* Limita a taxa de reenvio após a reconexão */
+    s_job_drain = job_register("OfflineDrain", MQTT_OFFLINE_DRAIN_INTERVAL_MS,
+                               0, drain_job, NULL);
+    if (s_job_drain < 0)
+    {
+        return ESP_FAIL;
+    }
+    job_set_enabled(s_job_drain, false);
+
+    if (s_flash_head != s_flash_tail)
+    {
+        ESP_LOGI(TAG, "  %lu mensagens pendentes recuperadas da NVS",
+                 s_flash_head - s_flash_tail);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mqtt_offline_enqueue(const char *topic, const char *data,
+                               int len, int qos, bool retain)
+{
+    if (s_offline_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t topic_len = strlen(topic);
+    if (topic_len >= MQTT_OFFLINE_TOPIC_MAX_LEN || len < 0 ||
+        len > MQTT_OFFLINE_DATA_MAX_LEN)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(s_offline_mutex, portMAX_DELAY);
+
+    if (s_ram_head - s_ram_tail >= MQTT_OFFLINE_RAM_SLOTS)
+    {
+        spill_oldest_ram();
+    }
+
+    offline_entry_t *entry = &s_ram[s_ram_head % MQTT_OFFLINE_RAM_SLOTS];
+    entry->seq = s_next_seq++;
+    entry->qos = qos;
+    entry->retain = retain ? 1 : 0;
+    entry->topic_len = topic_len;
+    entry->data_len = len;
+    memcpy(entry->buf, topic, topic_len + 1);
+    memcpy(entry->buf + topic_len + 1, data, len);
+    s_ram_head++;
+    mqtt_stats_update_hwm(MQTT_HWM_FILA_OFFLINE, mqtt_offline_pending());
+
+    xSemaphoreGive(s_offline_mutex);
+
+    /* Conectado com mensagens antigas pendentes: garante a drenagem */
+    if (s_connected())
+    {
+        start_drain();
+    }
+
+    return ESP_OK;
+}
+
+void mqtt_offline_resume(void)
+{
+    if (s_job_drain < 0 || mqtt_offline_pending() == 0)
+    {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Reenviando %lu mensagens armazenadas",
+             mqtt_offline_pending());
+
+    start_drain();
+}
+
+uint32_t mqtt_offline_pending(void)
+{
+    return (s_ram_head - s_ram_tail) + (s_flash_head - s_flash_tail);
+}
+
+uint32_t mqtt_offline_dropped(void)
+{
+    return s_dropped;
+}
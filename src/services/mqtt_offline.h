@@ -0,0 +1,100 @@
+/**
+ * @file mqtt_offline.h
+ * @brief Buffer store-and-forward de publicações enquanto o MQTT está offline
+ *
+ * Publicações feitas sem conexão com o broker entram em um anel em RAM.
+ * Quando o anel enche, as mensagens mais antigas são transferidas para
+ * um anel na NVS, que sobrevive a reinicializações. Ao reconectar, o
+ * job de drenagem (job_scheduler) reenvia tudo em ordem (NVS primeiro,
+ * depois RAM) em lotes limitados por intervalo, para não saturar o link.
+ * O job fica desabilitado enquanto não há nada a reenviar.
+ *
+ * Espaço na NVS: cada mensagem é um blob de até ~590 bytes (cabeçalho,
+ * tópico e um lote de telemetria cheio), que a NVS guarda em entradas de
+ * 32 bytes: ~21 entradas (672 bytes) com cabeçalho e índice do blob. O
+ * anel de MQTT_OFFLINE_NVS_MAX_ENTRIES mensagens ocupa no pior caso até
+ * MQTT_OFFLINE_NVS_BUDGET_BYTES (conferido na compilação), 2 das 6
+ * páginas de 4 KB da partição nvs padrão (24 KB, partitions_singleapp.csv);
+ * uma página fica reservada para a coleta da NVS e o restante sobra para
+ * WiFi (calibração do PHY), app_config, regras e cache do fast connect.
+ * Aumentar o anel exige uma tabela de partições com NVS maior. Mudando o
+ * tamanho do anel, o conteúdo gravado com o tamanho anterior é descartado
+ * no boot.
+ *
+ * Desgaste da flash: a NVS é um log, cada transferência grava o blob
+ * inteiro em entradas novas (~700 bytes com os índices, gravados só quando
+ * mudam) e a página é apagada depois, na coleta. Com as 6 páginas em
+ * rodízio, cada setor é apagado a cada ~30 transferências de mensagens
+ * cheias; a ~100 mil ciclos por setor, são ~3 milhões de transferências
+ * na vida útil. Só há transferência com o broker fora e a RAM cheia: uma
+ * mensagem por segundo nessa situação gasta a flash em ~35 dias de
+ * desconexão acumulada. Aplicações que publicam mais rápido offline devem
+ * reduzir a taxa (report_policy) ou aceitar o descarte em RAM.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef MQTT_OFFLINE_H
+#define MQTT_OFFLINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/**
+ * @brief Função usada para enviar uma mensagem durante a drenagem
+ *
+ * @return ID da mensagem (>= 0) em sucesso, -1 em erro
+ */
+typedef int (*mqtt_offline_send_fn_t)(const char *topic, const char *data,
+									  int len, int qos, bool retain);
+
+/**
+ * @brief Função usada para consultar se o broker está acessível
+ */
+typedef bool (*mqtt_offline_connected_fn_t)(void);
+
+/**
+ * @brief Inicializa o buffer offline e registra o job de drenagem
+ *
+ * Recupera da NVS as mensagens que ficaram pendentes antes do último boot.
+ *
+ * @param send      Função de envio usada na drenagem
+ * @param connected Função que informa se há conexão com o broker
+ *
+ * @return ESP_OK em sucesso, código de erro caso contrário
+ *
+ * @note Requer NVS já inicializada e job_scheduler_start()
+ */
+esp_err_t mqtt_offline_init(mqtt_offline_send_fn_t send,
+							mqtt_offline_connected_fn_t connected);
+
+/**
+ * @brief Armazena uma publicação para envio posterior
+ *
+ * @return ESP_OK se armazenada
+ *         ESP_ERR_INVALID_SIZE se tópico ou payload não cabem em uma entrada
+ *         ESP_ERR_INVALID_STATE se o buffer não foi inicializado
+ *
+ * @note Se RAM e NVS estiverem cheias, a mensagem mais antiga é descartada
+ */
+esp_err_t mqtt_offline_enqueue(const char *topic, const char *data,
+							   int len, int qos, bool retain);
+
+/**
+ * @brief Inicia a drenagem (chamar em MQTT_EVENT_CONNECTED)
+ */
+void mqtt_offline_resume(void);
+
+/**
+ * @brief Número de mensagens aguardando envio (RAM + NVS)
+ */
+uint32_t mqtt_offline_pending(void);
+
+/**
+ * @brief Número de mensagens descartadas por falta de espaço
+ */
+uint32_t mqtt_offline_dropped(void);
+
+#endif /* MQTT_OFFLINE_H */
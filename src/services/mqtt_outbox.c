@@ -0,0 +1,88 @@
+/**
+ * @file mqtt_outbox.c
+ * @brief Orçamento de memória do outbox do esp-mqtt por classe de prioridade - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "mqtt_outbox.h"
+#include "mqtt_stats.h"
+
+#include <string.h>
+#include "esp_log.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "MQTT_OUTBOX";
+
+/** Prefixo de tópico e sua classe; a primeira correspondência vale */
+typedef struct
+{
+    const char *prefix;
+    mqtt_priority_t priority;
+} priority_rule_t;
+
+static const priority_rule_t s_rules[] = {
+    {MQTT_TOPIC_STATUS, MQTT_PRIORITY_CRITICAL},
+    {MQTT_TOPIC_ALERTS, MQTT_PRIORITY_CRITICAL},
+    {MQTT_TOPIC_BOOT, MQTT_PRIORITY_CRITICAL},
+    {MQTT_TOPIC_COMMANDS, MQTT_PRIORITY_CRITICAL},
+    {MQTT_TOPIC_BASE "/", MQTT_PRIORITY_TELEMETRY},
+};
+
+#define RULE_COUNT (sizeof(s_rules) / sizeof(s_rules[0]))
+
+/** Parte do orçamento por classe (%) */
+static const uint32_t s_share_pct[MQTT_PRIORITY_COUNT] = {
+    [MQTT_PRIORITY_CRITICAL] = 100,
+    [MQTT_PRIORITY_TELEMETRY] = MQTT_OUTBOX_SHARE_TELEMETRY_PCT,
+    [MQTT_PRIORITY_CUSTOM] = MQTT_OUTBOX_SHARE_CUSTOM_PCT,
+};
+
+static const char *const s_names[MQTT_PRIORITY_COUNT] = {
+    [MQTT_PRIORITY_CRITICAL] = "critica",
+    [MQTT_PRIORITY_TELEMETRY] = "telemetria",
+    [MQTT_PRIORITY_CUSTOM] = "custom",
+};
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+mqtt_priority_t mqtt_outbox_priority(const char *topic)
+{
+    for (size_t i = 0; i < RULE_COUNT; i++)
+    {
+        if (strncmp(topic, s_rules[i].prefix, strlen(s_rules[i].prefix)) == 0)
+        {
+            return s_rules[i].priority;
+        }
+    }
+    return MQTT_PRIORITY_CUSTOM;
+}
+
+bool mqtt_outbox_has_room(mqtt_priority_t priority, int len, int outbox_bytes)
+{
+    uint32_t limit = (uint32_t)MQTT_OUTBOX_BUDGET_BYTES * s_share_pct[priority] / 100;
+
+    return outbox_bytes >= 0 && (uint32_t)outbox_bytes + (uint32_t)len <= limit;
+}
+
+void mqtt_outbox_dropped(mqtt_priority_t priority, const char *topic)
+{
+    mqtt_stats_inc((mqtt_stat_t)(MQTT_STAT_OUTBOX_DESCARTADAS + priority));
+    ESP_LOGW(TAG, "Outbox sem espaco para '%s' (classe %s), descartada",
+             topic, s_names[priority]);
+}
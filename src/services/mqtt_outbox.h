@@ -0,0 +1,61 @@
+/**
+ * @file mqtt_outbox.h
+ * @brief Orçamento de memória do outbox do esp-mqtt por classe de prioridade
+ *
+ * Cada publicação QoS 1/2 fica no outbox do cliente (heap) até o ACK do
+ * broker; com o link travado o outbox cresce sem limite e consome o heap
+ * vigiado pelo health check. O outbox passa a ter um teto,
+ * MQTT_OUTBOX_BUDGET_BYTES, dividido por classe de tópico:
+ *
+ *   crítica    (status, alertas, boot, respostas de comandos): 100%
+ *   telemetria (demais tópicos de MQTT_TOPIC_BASE): MQTT_OUTBOX_SHARE_TELEMETRY_PCT
+ *   custom     (tópicos fora de MQTT_TOPIC_BASE): MQTT_OUTBOX_SHARE_CUSTOM_PCT
+ *
+ * Uma publicação só entra se o outbox, com ela, couber na parte da sua
+ * classe. Com o link travado, custom é recusada primeiro, depois
+ * telemetria, e o restante do orçamento fica livre para as mensagens
+ * críticas. O esp-mqtt não permite remover mensagens já enfileiradas:
+ * elas saem com o ACK ou, as mais antigas primeiro, quando expiram
+ * (CONFIG_MQTT_OUTBOX_EXPIRED_TIMEOUT_MS, MQTT_EVENT_DELETED). O mesmo
+ * teto é passado ao cliente (outbox.limit), que recusa o excedente.
+ *
+ * QoS 0 não passa pelo outbox com o cliente conectado e não é limitada.
+ * As recusas são contadas por classe em mqtt_statistics_t
+ * (descartadas_outbox).
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef MQTT_OUTBOX_H
+#define MQTT_OUTBOX_H
+
+#include <stdbool.h>
+#include "mqtt_system.h"
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Classe de prioridade do tópico
+ */
+mqtt_priority_t mqtt_outbox_priority(const char *topic);
+
+/**
+ * @brief Indica se a publicação cabe na parte do orçamento da sua classe
+ *
+ * @param priority     Classe do tópico
+ * @param len          Payload da publicação (bytes)
+ * @param outbox_bytes Ocupação atual do outbox do cliente
+ */
+bool mqtt_outbox_has_room(mqtt_priority_t priority, int len, int outbox_bytes);
+
+/**
+ * @brief Conta uma publicação recusada por falta de orçamento
+ */
+void mqtt_outbox_dropped(mqtt_priority_t priority, const char *topic);
+
+#endif /* MQTT_OUTBOX_H */
@@ -0,0 +1,514 @@
+/**
+ * @file mqtt_router.c
+ * @brief Roteamento de mensagens MQTT recebidas - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "mqtt_router.h"
+#include "rtos_config.h"
+#include "trace.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "MQTT_ROUTER";
+
+/** Marca de fim de lista nos encadeamentos da tabela hash */
+#define ROUTER_NO_ENTRY -1
+
+/** Entrada da tabela de roteamento */
+typedef struct
+{
+    char filter[MQTT_ROUTER_FILTER_MAX_LEN]; ///< Filtro de tópico
+    uint16_t filter_len;                     ///< Comprimento do filtro
+    uint32_t hash;                           ///< Hash FNV-1a do filtro
+    bool wildcard;                           ///< Filtro contém + ou #
+    int16_t next;                            ///< Próxima entrada no mesmo bucket
+    mqtt_topic_handler_t callback;           ///< Handler registrado
+    void *ctx;                               ///< Contexto do handler
+} router_entry_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/** Entradas registradas (alocação estática) */
+static router_entry_t s_entries[MQTT_ROUTER_MAX_HANDLERS];
+static int s_entry_count = 0;
+
+/** Cabeças das listas de cada bucket (índice em s_entries) */
+static int16_t s_buckets[MQTT_ROUTER_HASH_BUCKETS];
+
+/** Índices das entradas com wildcard */
+static int16_t s_wildcards[MQTT_ROUTER_MAX_HANDLERS];
+static int s_wildcard_count = 0;
+
+/** Impressões das publicações enviadas cujo eco ainda não chegou */
+typedef struct
+{
+    uint32_t hash;     ///< Hash de tópico e payload
+    int64_t expiry_us; ///< Eco deixa de ser esperado neste instante
+    bool pending;      ///< Eco ainda esperado
+} router_echo_t;
+
+static router_echo_t s_echoes[MQTT_ROUTER_ECHO_SLOTS];
+static int s_echo_next = 0;
+
+/** Serializa registro e despacho (recursivo: handlers podem registrar) */
+static SemaphoreHandle_t s_router_mutex = NULL;
+RTOS_STATIC(StaticSemaphore_t, s_router_mutex_buf);
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static uint32_t fnv1a_update(uint32_t hash, const char *s, int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        hash ^= (uint8_t)s[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static uint32_t fnv1a_hash(const char *s, int len)
+{
+    return fnv1a_update(2166136261u, s, len);
+}
+
+/**
+ * @brief Impressão de uma mensagem: tópico, separador e payload
+ */
+static uint32_t message_hash(const char *topic, int topic_len,
+                             const char *data, int data_len)
+{
+    uint32_t hash = fnv1a_update(fnv1a_hash(topic, topic_len), "", 1);
+    return fnv1a_update(hash, data, data_len);
+}
+
+/**
+ * @brief Valida um filtro MQTT e informa se contém wildcards
+ *
+ * '+' deve ocupar um nível inteiro e '#' deve ser o último nível.
+ */
+static bool validate_filter(const char *filter, int len, bool *wildcard)
+{
+    *wildcard = false;
+
+    for (int i = 0; i < len; i++)
+    {
+        char c = filter[i];
+
+        if (c != '+' && c != '#')
+        {
+            continue;
+        }
+
+        bool starts_level = (i == 0) || (filter[i - 1] == '/');
+        bool ends_level = (i == len - 1) || (filter[i + 1] == '/');
+
+        if (!starts_level || !ends_level)
+        {
+            return false;
+        }
+
+        if (c == '#' && i != len - 1)
+        {
+            return false;
+        }
+
+        *wildcard = true;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Verifica se um tópico casa com um filtro com wildcards
+ */
+static bool topic_matches(const char *filter, int flen,
+                          const char *topic, int tlen)
+{
+    /* Tópicos de sistema ($SYS/...) não casam com wildcard no 1º nível */
+    if (tlen > 0 && topic[0] == '$' && (filter[0] == '+' || filter[0] == '#'))
+    {
+        return false;
+    }
+
+    int f = 0;
+    int t = 0;
+
+    while (f < flen)
+    {
+        if (filter[f] == '#')
+        {
+            return true;
+        }
+
+        if (filter[f] == '+')
+        {
+            while (t < tlen && topic[t] != '/')
+            {
+                t++;
+            }
+            f++;
+            continue;
+        }
+
+        if (t >= tlen || filter[f] != topic[t])
+        {
+            /* "a/#" também casa com o nível pai "a" */
+            return (t == tlen) && (flen - f == 2) &&
+                   filter[f] == '/' && filter[f + 1] == '#';
+        }
+
+        f++;
+        t++;
+    }
+
+    return t == tlen;
+}
+
+/**
+ * @brief Encadeia uma entrada no seu bucket ou na lista de wildcards
+ */
+static void link_entry(int16_t index)
+{
+    router_entry_t *entry = &s_entries[index];
+
+    if (entry->wildcard)
+    {
+        entry->next = ROUTER_NO_ENTRY;
+        s_wildcards[s_wildcard_count++] = index;
+    }
+    else
+    {
+        uint32_t bucket = entry->hash & (MQTT_ROUTER_HASH_BUCKETS - 1);
+        entry->next = s_buckets[bucket];
+        s_buckets[bucket] = index;
+    }
+}
+
+/**
+ * @brief Refaz buckets e lista de wildcards a partir de s_entries
+ *
+ * Usada após a remoção, que compacta a tabela; registros e remoções são
+ * raros, então O(n) aqui mantém o despacho simples.
+ */
+static void rebuild_index(void)
+{
+    for (int i = 0; i < MQTT_ROUTER_HASH_BUCKETS; i++)
+    {
+        s_buckets[i] = ROUTER_NO_ENTRY;
+    }
+    s_wildcard_count = 0;
+
+    for (int16_t i = 0; i < s_entry_count; i++)
+    {
+        link_entry(i);
+    }
+}
+
+/**
+ * @brief Copia os handlers cujos filtros casam com o tópico (com o mutex)
+ *
+ * @param callbacks NULL = apenas contar
+ *
+ * @return Número de handlers que casam
+ */
+static int collect_handlers(const char *topic, int topic_len,
+                            mqtt_topic_handler_t callbacks[], void *ctxs[])
+{
+    int delivered = 0;
+    uint32_t hash = fnv1a_hash(topic, topic_len);
+
+    /* Filtros exatos: um bucket, comparação completa apenas se o hash bater */
+    int16_t index = s_buckets[hash & (MQTT_ROUTER_HASH_BUCKETS - 1)];
+    while (index != ROUTER_NO_ENTRY)
+    {
+        const router_entry_t *entry = &s_entries[index];
+
+        if (entry->hash == hash && entry->filter_len == topic_len &&
+            memcmp(entry->filter, topic, topic_len) == 0)
+        {
+            if (callbacks != NULL)
+            {
+                callbacks[delivered] = entry->callback;
+                ctxs[delivered] = entry->ctx;
+            }
+            delivered++;
+        }
+
+        index = entry->next;
+    }
+
+    /* Filtros com wildcard */
+    for (int i = 0; i < s_wildcard_count; i++)
+    {
+        const router_entry_t *entry = &s_entries[s_wildcards[i]];
+
+        if (topic_matches(entry->filter, entry->filter_len, topic, topic_len))
+        {
+            if (callbacks != NULL)
+            {
+                callbacks[delivered] = entry->callback;
+                ctxs[delivered] = entry->ctx;
+            }
+            delivered++;
+        }
+    }
+
+    return delivered;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t mqtt_router_init(void)
+{
+    if (s_router_mutex != NULL)
+    {
+        return ESP_OK;
+    }
+
+    s_router_mutex = RTOS_RECURSIVE_MUTEX_CREATE(s_router_mutex_buf);
+    if (s_router_mutex == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < MQTT_ROUTER_HASH_BUCKETS; i++)
+    {
+        s_buckets[i] = ROUTER_NO_ENTRY;
+    }
+
+    s_entry_count = 0;
+    s_wildcard_count = 0;
+
+    return ESP_OK;
+}
+
+esp_err_t mqtt_register_topic_handler(const char *topic_filter,
+                                      mqtt_topic_handler_t callback,
+                                      void *ctx)
+{
+    if (topic_filter == NULL || callback == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_router_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int len = strlen(topic_filter);
+    bool wildcard = false;
+
+    if (len == 0 || len >= MQTT_ROUTER_FILTER_MAX_LEN ||
+        !validate_filter(topic_filter, len, &wildcard))
+    {
+        ESP_LOGE(TAG, "Filtro invalido: '%s'", topic_filter);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTakeRecursive(s_router_mutex, portMAX_DELAY);
+
+    if (s_entry_count >= MQTT_ROUTER_MAX_HANDLERS)
+    {
+        xSemaphoreGiveRecursive(s_router_mutex);
+        ESP_LOGE(TAG, "Tabela de handlers cheia");
+        return ESP_ERR_NO_MEM;
+    }
+
+    int16_t index = s_entry_count++;
+    router_entry_t *entry = &s_entries[index];
+
+    memcpy(entry->filter, topic_filter, len + 1);
+    entry->filter_len = len;
+    entry->hash = fnv1a_hash(topic_filter, len);
+    entry->wildcard = wildcard;
+    entry->callback = callback;
+    entry->ctx = ctx;
+    link_entry(index);
+
+    xSemaphoreGiveRecursive(s_router_mutex);
+
+    ESP_LOGD(TAG, "Handler registrado para '%s'", topic_filter);
+
+    return ESP_OK;
+}
+
+esp_err_t mqtt_unregister_topic_handler(const char *topic_filter,
+                                        mqtt_topic_handler_t callback,
+                                        void *ctx)
+{
+    if (topic_filter == NULL || callback == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_router_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    xSemaphoreTakeRecursive(s_router_mutex, portMAX_DELAY);
+
+    for (int i = 0; i < s_entry_count; i++)
+    {
+        router_entry_t *entry = &s_entries[i];
+
+        if (entry->callback == callback && entry->ctx == ctx &&
+            strcmp(entry->filter, topic_filter) == 0)
+        {
+            /* Compacta movendo a última entrada para o lugar da removida */
+            s_entry_count--;
+            if (i != s_entry_count)
+            {
+                *entry = s_entries[s_entry_count];
+            }
+            rebuild_index();
+            ret = ESP_OK;
+            break;
+        }
+    }
+
+    xSemaphoreGiveRecursive(s_router_mutex);
+
+    return ret;
+}
+
+int mqtt_router_dispatch(const char *topic, int topic_len,
+                         const char *data, int data_len)
+{
+    if (topic == NULL || topic_len <= 0 || s_router_mutex == NULL)
+    {
+        return 0;
+    }
+
+    /*
+     * Os handlers escolhidos são copiados antes de qualquer chamada: um
+     * handler pode registrar ou remover entradas (ex.: recarga de regras),
+     * o que reorganiza a tabela.
+     */
+    mqtt_topic_handler_t callbacks[MQTT_ROUTER_MAX_HANDLERS];
+    void *ctxs[MQTT_ROUTER_MAX_HANDLERS];
+
+    xSemaphoreTakeRecursive(s_router_mutex, portMAX_DELAY);
+
+    int delivered = collect_handlers(topic, topic_len, callbacks, ctxs);
+
+    for (int i = 0; i < delivered; i++)
+    {
+        callbacks[i](topic, topic_len, data, data_len, ctxs[i]);
+    }
+
+    xSemaphoreGiveRecursive(s_router_mutex);
+
+    return delivered;
+}
+
+int mqtt_router_deliver_local(const char *topic, int topic_len,
+                              const char *data, int data_len)
+{
+    if (s_router_mutex == NULL)
+    {
+        return 0;
+    }
+
+    TRACE_BEGIN(t);
+    xSemaphoreTakeRecursive(s_router_mutex, portMAX_DELAY);
+
+    int delivered = mqtt_router_dispatch(topic, topic_len, data, data_len);
+
+    xSemaphoreGiveRecursive(s_router_mutex);
+    TRACE_END(TRACE_LOCAL, t, delivered);
+
+    return delivered;
+}
+
+void mqtt_router_expect_echo(const char *topic, int topic_len,
+                             const char *data, int data_len)
+{
+    if (topic == NULL || topic_len <= 0 || s_router_mutex == NULL)
+    {
+        return;
+    }
+
+    xSemaphoreTakeRecursive(s_router_mutex, portMAX_DELAY);
+
+    /* Sem handler local, a mensagem não foi entregue antes e nem volta */
+    if (collect_handlers(topic, topic_len, NULL, NULL) > 0)
+    {
+        /* Anel cheio: o eco mais antigo deixa de ser esperado */
+        s_echoes[s_echo_next] = (router_echo_t){
+            .hash = message_hash(topic, topic_len, data, data_len),
+            .expiry_us = esp_timer_get_time() + (int64_t)MQTT_ROUTER_ECHO_TIMEOUT_MS * 1000,
+            .pending = true,
+        };
+        s_echo_next = (s_echo_next + 1) % MQTT_ROUTER_ECHO_SLOTS;
+    }
+
+    xSemaphoreGiveRecursive(s_router_mutex);
+}
+
+bool mqtt_router_consume_echo(const char *topic, int topic_len,
+                              const char *data, int data_len)
+{
+    if (topic == NULL || topic_len <= 0 || s_router_mutex == NULL)
+    {
+        return false;
+    }
+
+    uint32_t hash = message_hash(topic, topic_len, data, data_len);
+    int64_t now = esp_timer_get_time();
+    bool echo = false;
+
+    xSemaphoreTakeRecursive(s_router_mutex, portMAX_DELAY);
+
+    for (int i = 0; i < MQTT_ROUTER_ECHO_SLOTS; i++)
+    {
+        if (s_echoes[i].pending && now >= s_echoes[i].expiry_us)
+        {
+            s_echoes[i].pending = false;
+        }
+        if (s_echoes[i].pending && s_echoes[i].hash == hash)
+        {
+            s_echoes[i].pending = false;
+            echo = true;
+            break;
+        }
+    }
+
+    xSemaphoreGiveRecursive(s_router_mutex);
+
+    return echo;
+}
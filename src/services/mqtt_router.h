@@ -0,0 +1,171 @@
+/**
+ * @file mqtt_router.h
+ * @brief Roteamento de mensagens MQTT recebidas por filtro de tópico
+ *
+ * Mantém uma tabela de handlers registrados por filtro de tópico e
+ * despacha cada mensagem recebida para os handlers correspondentes.
+ *
+ * Filtros sem wildcard ficam em uma tabela hash (FNV-1a) pré-computada
+ * no registro, de modo que o custo por mensagem é um hash do tópico e
+ * uma comparação por colisão. Filtros com wildcards MQTT (+ e #) ficam
+ * em uma lista separada e são comparados nível a nível.
+ *
+ * O casamento trabalha diretamente sobre o ponteiro/comprimento entregue
+ * pelo esp-mqtt (event->topic/topic_len), sem cópia terminada em null.
+ *
+ * Entrega local: mqtt_publish_data() passa cada publicação por
+ * mqtt_router_deliver_local() antes de enviá-la ao broker. Os handlers
+ * da própria aplicação recebem os ponteiros do publicador, sem cópia e
+ * sem depender do broker. Como o dispositivo também assina esses
+ * tópicos, o broker devolve a mensagem: quando a cópia é de fato entregue
+ * ao cliente esp-mqtt (na hora ou na drenagem do buffer offline),
+ * mqtt_router_expect_echo() guarda uma impressão (hash de tópico e
+ * payload), e mqtt_router_consume_echo() descarta a primeira mensagem
+ * recebida que a reproduza. Publicações que falham, são recusadas pelo
+ * outbox ou se perdem no buffer offline não deixam impressão. As
+ * impressões ficam num anel de MQTT_ROUTER_ECHO_SLOTS e expiram após
+ * MQTT_ROUTER_ECHO_TIMEOUT_MS (QoS 0 perdida no caminho); uma mensagem
+ * externa idêntica a uma impressão pendente é descartada uma vez, sem
+ * efeito para handlers que dependem só do valor.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef MQTT_ROUTER_H
+#define MQTT_ROUTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define MQTT_ROUTER_MAX_HANDLERS 32	 ///< Máximo de handlers registrados
+#define MQTT_ROUTER_HASH_BUCKETS 64	 ///< Buckets da tabela hash (potência de 2)
+#define MQTT_ROUTER_FILTER_MAX_LEN 64 ///< Tamanho máximo de um filtro de tópico
+#define MQTT_ROUTER_ECHO_SLOTS 8		 ///< Ecos de entregas locais aguardados
+#define MQTT_ROUTER_ECHO_TIMEOUT_MS 30000 ///< Eco não recebido neste prazo deixa de ser esperado
+
+/*
+ * =============================================================================
+ * TIPOS
+ * =============================================================================
+ */
+
+/**
+ * @brief Assinatura de um handler de tópico
+ *
+ * Tópico e dados NÃO são terminados em null: use sempre os comprimentos.
+ * Os ponteiros são válidos apenas durante a chamada.
+ *
+ * @param topic     Tópico da mensagem recebida
+ * @param topic_len Comprimento do tópico
+ * @param data      Payload da mensagem
+ * @param data_len  Comprimento do payload
+ * @param ctx       Contexto informado no registro
+ */
+typedef void (*mqtt_topic_handler_t)(const char *topic, int topic_len,
+									 const char *data, int data_len,
+									 void *ctx);
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Inicializa a tabela de roteamento
+ *
+ * @return ESP_OK em sucesso, ESP_ERR_NO_MEM se o mutex não puder ser criado
+ *
+ * @note Chamada por mqtt_system_init(); não é necessário chamá-la na aplicação
+ */
+esp_err_t mqtt_router_init(void);
+
+/**
+ * @brief Registra um handler para um filtro de tópico
+ *
+ * O filtro segue a sintaxe MQTT: '+' casa exatamente um nível e '#'
+ * (apenas no último nível) casa o restante do tópico, inclusive o nível pai.
+ * Um mesmo tópico pode casar com vários filtros; todos os handlers
+ * correspondentes são chamados.
+ *
+ * @param topic_filter Filtro de tópico (copiado internamente)
+ * @param callback     Função chamada para cada mensagem que casar
+ * @param ctx          Ponteiro repassado ao callback
+ *
+ * @return ESP_OK em sucesso
+ *         ESP_ERR_INVALID_ARG se o filtro for inválido ou longo demais
+ *         ESP_ERR_NO_MEM se a tabela estiver cheia
+ *         ESP_ERR_INVALID_STATE se o roteador não foi inicializado
+ *
+ * @note O handler executa no contexto de quem entrega a mensagem e deve
+ *       ser curto
+ */
+esp_err_t mqtt_register_topic_handler(const char *topic_filter,
+									  mqtt_topic_handler_t callback,
+									  void *ctx);
+
+/**
+ * @brief Remove um handler registrado com mqtt_register_topic_handler()
+ *
+ * Filtro, callback e contexto devem ser os mesmos do registro. Pode ser
+ * chamada de dentro de um handler: o despacho em andamento já escolheu
+ * os handlers e não é afetado.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND se não houver registro correspondente,
+ *         ESP_ERR_INVALID_STATE se o roteador não foi inicializado
+ */
+esp_err_t mqtt_unregister_topic_handler(const char *topic_filter,
+										mqtt_topic_handler_t callback,
+										void *ctx);
+
+/**
+ * @brief Entrega uma mensagem aos handlers cujo filtro casa com o tópico
+ *
+ * @param topic     Tópico (não precisa ser terminado em null)
+ * @param topic_len Comprimento do tópico
+ * @param data      Payload
+ * @param data_len  Comprimento do payload
+ *
+ * @return Número de handlers chamados
+ */
+int mqtt_router_dispatch(const char *topic, int topic_len,
+						 const char *data, int data_len);
+
+/**
+ * @brief Entrega uma publicação da própria aplicação aos handlers locais
+ *
+ * Os handlers executam no contexto do publicador, com os ponteiros dele.
+ *
+ * @return Número de handlers chamados
+ */
+int mqtt_router_deliver_local(const char *topic, int topic_len,
+							  const char *data, int data_len);
+
+/**
+ * @brief Passa a esperar o eco de uma publicação aceita pelo cliente esp-mqtt
+ *
+ * Só registra a impressão se algum handler local casa com o tópico, isto
+ * é, se a mensagem foi entregue por mqtt_router_deliver_local().
+ */
+void mqtt_router_expect_echo(const char *topic, int topic_len,
+							 const char *data, int data_len);
+
+/**
+ * @brief Verifica se uma mensagem recebida é o eco de uma entrega local
+ *
+ * Cada entrega local casa com no máximo uma mensagem recebida.
+ *
+ * @return true se a mensagem já foi entregue e deve ser descartada
+ */
+bool mqtt_router_consume_echo(const char *topic, int topic_len,
+							  const char *data, int data_len);
+
+#endif /* MQTT_ROUTER_H */
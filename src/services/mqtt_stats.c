@@ -0,0 +1,192 @@
+/**
+ * @file mqtt_stats.c
+ * @brief Contadores de estatísticas MQTT sem bloqueio - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "mqtt_stats.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+/** Limite superior (exclusivo) de cada faixa do histograma; a última é aberta */
+static const uint32_t s_latency_bounds_us[MQTT_STATS_LATENCY_BUCKETS - 1] = {
+    500, 1000, 2000, 5000, 10000, 20000, 50000};
+
+#define LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/** Valores correntes (só crescem) */
+static uint32_t s_counters[MQTT_STAT_COUNT];
+static uint32_t s_latency_hist[MQTT_STATS_LATENCY_BUCKETS];
+
+/** Linha de base gravada pelo último reset */
+static uint32_t s_counters_base[MQTT_STAT_COUNT];
+static uint32_t s_latency_base[MQTT_STATS_LATENCY_BUCKETS];
+
+static uint32_t s_latency_max_us;
+static uint32_t s_hwm[MQTT_HWM_COUNT];
+static uint32_t s_last_message_ms;
+
+/** Geração do reset: ímpar enquanto a linha de base está sendo gravada */
+static uint32_t s_generation;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+/** Eleva *target para value, se maior (CAS sem bloqueio) */
+static void atomic_max(uint32_t *target, uint32_t value)
+{
+    uint32_t current = LOAD(target);
+
+    while (value > current &&
+           !__atomic_compare_exchange_n(target, &current, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+/** Aguarda uma geração par (sem reset em andamento) */
+static uint32_t stable_generation(void)
+{
+    uint32_t gen;
+
+    while ((gen = __atomic_load_n(&s_generation, __ATOMIC_ACQUIRE)) & 1)
+    {
+        /* Quem reseta pode ter prioridade menor: cede a CPU de fato */
+        vTaskDelay(1);
+    }
+
+    return gen;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+void mqtt_stats_add(mqtt_stat_t stat, uint32_t value)
+{
+    __atomic_fetch_add(&s_counters[stat], value, __ATOMIC_RELAXED);
+}
+
+void mqtt_stats_record_latency(uint32_t latency_us)
+{
+    int bucket = 0;
+
+    while (bucket < MQTT_STATS_LATENCY_BUCKETS - 1 &&
+           latency_us >= s_latency_bounds_us[bucket])
+    {
+        bucket++;
+    }
+
+    __atomic_fetch_add(&s_latency_hist[bucket], 1, __ATOMIC_RELAXED);
+    atomic_max(&s_latency_max_us, latency_us);
+}
+
+void mqtt_stats_update_hwm(mqtt_hwm_t hwm, uint32_t depth)
+{
+    atomic_max(&s_hwm[hwm], depth);
+}
+
+void mqtt_stats_set_last_message(uint32_t timestamp_ms)
+{
+    __atomic_store_n(&s_last_message_ms, timestamp_ms, __ATOMIC_RELAXED);
+}
+
+void mqtt_stats_snapshot(mqtt_statistics_t *out)
+{
+    uint32_t counters[MQTT_STAT_COUNT];
+    uint32_t gen;
+
+    do
+    {
+        gen = stable_generation();
+
+        for (int i = 0; i < MQTT_STAT_COUNT; i++)
+        {
+            counters[i] = LOAD(&s_counters[i]) - LOAD(&s_counters_base[i]);
+        }
+        for (int i = 0; i < MQTT_STATS_LATENCY_BUCKETS; i++)
+        {
+            out->latencia_hist[i] = LOAD(&s_latency_hist[i]) -
+                                    LOAD(&s_latency_base[i]);
+        }
+        out->latencia_max_us = LOAD(&s_latency_max_us);
+        out->hwm_fila_entrada = LOAD(&s_hwm[MQTT_HWM_FILA_ENTRADA]);
+        out->hwm_fila_offline = LOAD(&s_hwm[MQTT_HWM_FILA_OFFLINE]);
+        out->hwm_outbox_bytes = LOAD(&s_hwm[MQTT_HWM_OUTBOX_BYTES]);
+    } while (__atomic_load_n(&s_generation, __ATOMIC_ACQUIRE) != gen);
+
+    out->total_publicadas = counters[MQTT_STAT_PUBLICADAS];
+    out->total_recebidas = counters[MQTT_STAT_RECEBIDAS];
+    out->falhas_publicacao = counters[MQTT_STAT_FALHAS];
+    out->desconexoes = counters[MQTT_STAT_DESCONEXOES];
+    out->tempo_desconectado_ms = counters[MQTT_STAT_TEMPO_DESCONECTADO_MS];
+    out->descartadas_entrada = counters[MQTT_STAT_DESCARTADAS_ENTRADA];
+    out->bytes_enviados = counters[MQTT_STAT_BYTES_ENVIADOS];
+    out->bytes_recebidos = counters[MQTT_STAT_BYTES_RECEBIDOS];
+    out->suprimidas = counters[MQTT_STAT_SUPRIMIDAS];
+    for (int i = 0; i < MQTT_PRIORITY_COUNT; i++)
+    {
+        out->descartadas_outbox[i] = counters[MQTT_STAT_OUTBOX_DESCARTADAS + i];
+    }
+    out->ultima_mensagem_ts = LOAD(&s_last_message_ms);
+}
+
+void mqtt_stats_reset(void)
+{
+    /* Resets concorrentes são serializados pela própria geração */
+    uint32_t gen;
+    do
+    {
+        gen = stable_generation();
+    } while (!__atomic_compare_exchange_n(&s_generation, &gen, gen + 1, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    for (int i = 0; i < MQTT_STAT_COUNT; i++)
+    {
+        if (i == MQTT_STAT_DESCONEXOES || i == MQTT_STAT_TEMPO_DESCONECTADO_MS)
+        {
+            continue; /* Histórico */
+        }
+        __atomic_store_n(&s_counters_base[i], LOAD(&s_counters[i]),
+                         __ATOMIC_RELAXED);
+    }
+    for (int i = 0; i < MQTT_STATS_LATENCY_BUCKETS; i++)
+    {
+        __atomic_store_n(&s_latency_base[i], LOAD(&s_latency_hist[i]),
+                         __ATOMIC_RELAXED);
+    }
+
+    /* Máximos recomeçam do zero; perder uma atualização concorrente é inócuo */
+    __atomic_store_n(&s_latency_max_us, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < MQTT_HWM_COUNT; i++)
+    {
+        __atomic_store_n(&s_hwm[i], 0, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&s_generation, gen + 2, __ATOMIC_RELEASE);
+}
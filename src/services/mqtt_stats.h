@@ -0,0 +1,117 @@
+/**
+ * @file mqtt_stats.h
+ * @brief Contadores de estatísticas MQTT sem bloqueio
+ *
+ * Os contadores são incrementados de várias tasks (evento MQTT, jobs,
+ * drenagem offline) nos dois cores. Cada contador é uma palavra de 32 bits
+ * atualizada com operações atômicas relaxadas (S32C1I no ESP32), então
+ * nenhum incremento se perde e nenhum publicador bloqueia.
+ *
+ * mqtt_stats_reset() não zera os contadores (o que perderia incrementos
+ * concorrentes): guarda uma linha de base, e o snapshot devolve a
+ * diferença. Um contador de geração, incrementado antes e depois de
+ * gravar a base, permite ao snapshot repetir a leitura se um reset
+ * ocorrer no meio; os publicadores nunca tocam nesse contador.
+ *
+ * Os valores de 32 bits dão a volta (bytes enviados a 1 kB/s, em ~49 dias);
+ * consumidores devem calcular diferenças em aritmética módulo 2^32.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef MQTT_STATS_H
+#define MQTT_STATS_H
+
+#include <stdint.h>
+#include "mqtt_system.h"
+
+/*
+ * =============================================================================
+ * TIPOS
+ * =============================================================================
+ */
+
+/** Contadores monotônicos */
+typedef enum
+{
+	MQTT_STAT_PUBLICADAS = 0,		///< Publicações aceitas pelo cliente
+	MQTT_STAT_RECEBIDAS,			///< Mensagens recebidas (primeiro fragmento)
+	MQTT_STAT_FALHAS,				///< Falhas ao publicar
+	MQTT_STAT_DESCONEXOES,			///< Desconexões do broker
+	MQTT_STAT_TEMPO_DESCONECTADO_MS, ///< Tempo total desconectado
+	MQTT_STAT_DESCARTADAS_ENTRADA,	///< Recebidas descartadas
+	MQTT_STAT_BYTES_ENVIADOS,		///< Bytes de payload publicados
+	MQTT_STAT_BYTES_RECEBIDOS,		///< Bytes de payload recebidos
+	MQTT_STAT_SUPRIMIDAS,			///< Publicações evitadas por deadband
+	MQTT_STAT_OUTBOX_DESCARTADAS,	///< Recusadas pelo outbox, um contador por mqtt_priority_t
+	MQTT_STAT_OUTBOX_DESCARTADAS_FIM = MQTT_STAT_OUTBOX_DESCARTADAS + MQTT_PRIORITY_COUNT - 1,
+	MQTT_STAT_COUNT
+} mqtt_stat_t;
+
+/** Filas com marca de nível máximo (high-water mark) */
+typedef enum
+{
+	MQTT_HWM_FILA_ENTRADA = 0, ///< Slots ocupados da fila de entrada
+	MQTT_HWM_FILA_OFFLINE,	   ///< Mensagens no buffer offline (RAM + NVS)
+	MQTT_HWM_OUTBOX_BYTES,	   ///< Bytes no outbox do cliente MQTT
+	MQTT_HWM_COUNT
+} mqtt_hwm_t;
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Soma @p value a um contador (seguro em qualquer task ou core)
+ */
+void mqtt_stats_add(mqtt_stat_t stat, uint32_t value);
+
+/**
+ * @brief Incrementa um contador
+ */
+static inline void mqtt_stats_inc(mqtt_stat_t stat)
+{
+	mqtt_stats_add(stat, 1);
+}
+
+/**
+ * @brief Registra a latência de uma publicação no histograma
+ *
+ * Os limites superiores das faixas estão em mqtt_stats.c
+ * (500 us, 1, 2, 5, 10, 20, 50 ms e acima).
+ *
+ * @param latency_us Duração de esp_mqtt_client_publish()
+ */
+void mqtt_stats_record_latency(uint32_t latency_us);
+
+/**
+ * @brief Atualiza a marca de nível máximo de uma fila
+ *
+ * @param depth Ocupação atual da fila
+ */
+void mqtt_stats_update_hwm(mqtt_hwm_t hwm, uint32_t depth);
+
+/**
+ * @brief Registra o instante da última mensagem recebida (ms)
+ */
+void mqtt_stats_set_last_message(uint32_t timestamp_ms);
+
+/**
+ * @brief Copia os contadores para @p out (não bloqueia os publicadores)
+ *
+ * Preenche todos os campos de mqtt_statistics_t exceto fila_offline e
+ * descartadas_offline, que pertencem ao mqtt_offline.
+ */
+void mqtt_stats_snapshot(mqtt_statistics_t *out);
+
+/**
+ * @brief Zera contadores, histograma e marcas de nível máximo
+ *
+ * Desconexões e tempo desconectado são mantidos como histórico.
+ */
+void mqtt_stats_reset(void);
+
+#endif /* MQTT_STATS_H */
@@ -18,9 +18,32 @@
  * =============================================================================
  */
 #include "mqtt_system.h"
+#include "mqtt_inbound.h"
+#include "mqtt_router.h"
+#include "mqtt_offline.h"
+#include "mqtt_batch.h"
+#include "mqtt_stats.h"
+#include "mqtt_inflight.h"
+#include "mqtt_outbox.h"
+#include "payload_codec.h"
+#include "json_writer.h"
+#include "job_scheduler.h"
+#include "deadline.h"
+#include "power_manager.h"
+#include "sensor_adc.h"
+#include "report_policy.h"
+#include "rule_engine.h"
+#include "app_config.h"
+#include "command_processor.h"
+#include "mqtt_tls.h"
+#include "mqtt_v5.h"
+#include "wifi_fast_connect.h"
+#include "rtos_config.h"
+#include "trace.h"
 
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -33,7 +56,6 @@
 #include "esp_random.h"
 #include "nvs_flash.h"
 #include "mqtt_client.h"
-#include "driver/gpio.h"
 
 /*
  * =============================================================================
@@ -44,9 +66,13 @@
 /** Tag para logging */
 static const char *TAG = "MQTT_SYSTEM";
 
-/** Event bits para sincronização WiFi */
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT BIT1
+/** Bits de conectividade em s_conn_events */
+#define WIFI_CONNECTED_BIT BIT0 ///< STA com IP
+#define WIFI_FAIL_BIT BIT1      ///< STA sem IP após uma tentativa ou queda
+#define MQTT_CONNECTED_BIT BIT2 ///< Sessão MQTT ativa
+
+/** Retorno de esp_mqtt_client_publish() com o outbox no limite */
+#define CLIENT_OUTBOX_FULL (-2)
 
 /*
  * =============================================================================
@@ -54,26 +80,103 @@ static const char *TAG = "MQTT_SYSTEM";
  * =============================================================================
  */
 
-/** Instância global de estatísticas */
-static mqtt_statistics_t s_stats = {0};
+/** Início da desconexão atual do broker (0 = conectado ou nunca conectou) */
+static int64_t s_disconnected_since_us = 0;
 
 /** Handle do cliente MQTT */
 static esp_mqtt_client_handle_t s_mqtt_client = NULL;
 
+/**
+ * Configuração do cliente, mantida para reaplicar com outro protocolo
+ * (fallback do MQTT 5); o URI aponta para s_broker_uri
+ */
+static esp_mqtt_client_config_t s_mqtt_cfg;
+static char s_broker_uri[APP_CONFIG_URI_MAX_LEN];
+
 /** Flag indicando se MQTT está conectado */
 static bool s_mqtt_connected = false;
 
-/** Contador de tentativas de reconexão WiFi */
-static int s_wifi_retry_num = 0;
+/**
+ * Estado da conectividade para quem precisa esperar por ela; a
+ * inicialização não espera, os handlers de evento apenas atualizam os bits
+ */
+static EventGroupHandle_t s_conn_events = NULL;
+RTOS_STATIC(StaticEventGroup_t, s_conn_events_buf);
+
+/** Cliente MQTT já iniciado (ocorre no primeiro IP obtido) */
+static bool s_mqtt_started = false;
+
+/** Status e informações de boot já publicados nesta execução */
+static bool s_boot_announced = false;
+
+/** Tentativas de reconexão consecutivas (base do backoff) */
+static uint32_t s_wifi_attempts = 0;
+static uint32_t s_mqtt_attempts = 0;
+
+/** Tentativas falhas no broker em teste (app_config_broker_pending()) */
+static uint32_t s_broker_trial_failures = 0;
+
+/** Prazos que disparam a próxima tentativa de reconexão */
+static deadline_id_t s_deadline_wifi = -1;
+static deadline_id_t s_deadline_mqtt = -1;
+
+/** SUBSCRIBE da conexão atual e se algum já foi confirmado neste boot */
+static int s_subscribe_msg_id = -1;
+static bool s_subscribed_once = false;
+
+/** Estado do IP e se já houve IP alguma vez (distingue recuperação do boot) */
+static bool s_wifi_has_ip = false;
+static bool s_wifi_had_ip = false;
+
+/**
+ * Instante (ms) em que o WiFi se recuperou, até a primeira publicação
+ * (0 = nenhuma medição em andamento), e os resultados
+ */
+static uint32_t s_ttfp_start_ms = 0;
+static uint32_t s_ttfp_last_ms = 0;
+static uint32_t s_ttfp_max_ms = 0;
 
-/** Variável para controle do tempo de temperatura baixa do AC */
-static uint64_t s_temp_low_start_time_ms = 0;
+/** Jobs periódicos do sistema (executados pelo job_scheduler) */
+static job_id_t s_job_telemetry = -1;
+static job_id_t s_job_health = -1;
+static job_id_t s_job_wifi_watchdog = -1;
 
-/** Handles das tasks do sistema */
-static TaskHandle_t s_task_telemetry = NULL;
-static TaskHandle_t s_task_health = NULL;
-static TaskHandle_t s_task_wifi_watchdog = NULL;
-static TaskHandle_t s_task_ac_monitor = NULL;
+/**
+ * Execução antecipada pedida por mqtt_request_telemetry() (envia o lote
+ * após a amostra) e por mqtt_request_health() (sem fechar as janelas)
+ */
+static bool s_telemetry_flush_requested = false;
+static bool s_health_on_demand = false;
+
+/** Formato de payload em uso e tópicos/enquadramentos correspondentes */
+static mqtt_payload_format_t s_payload_format = MQTT_PAYLOAD_FORMAT_DEFAULT;
+
+static const char *const s_telemetry_topics[] = {
+    [MQTT_PAYLOAD_FORMAT_JSON] = MQTT_TOPIC_TELEMETRY,
+    [MQTT_PAYLOAD_FORMAT_CBOR] = MQTT_TOPIC_TELEMETRY "/cbor",
+    [MQTT_PAYLOAD_FORMAT_PACKED] = MQTT_TOPIC_TELEMETRY "/bin",
+};
+
+static const char *const s_health_topics[] = {
+    [MQTT_PAYLOAD_FORMAT_JSON] = MQTT_TOPIC_HEALTH,
+    [MQTT_PAYLOAD_FORMAT_CBOR] = MQTT_TOPIC_HEALTH "/cbor",
+    [MQTT_PAYLOAD_FORMAT_PACKED] = MQTT_TOPIC_HEALTH "/bin",
+};
+
+static const mqtt_batch_framing_t *const s_batch_framings[] = {
+    [MQTT_PAYLOAD_FORMAT_JSON] = &MQTT_BATCH_FRAMING_JSON,
+    [MQTT_PAYLOAD_FORMAT_CBOR] = &MQTT_BATCH_FRAMING_CBOR,
+    [MQTT_PAYLOAD_FORMAT_PACKED] = &MQTT_BATCH_FRAMING_PACKED,
+};
+
+/** Lote de amostras de telemetria e seu buffer pré-alocado */
+static mqtt_batch_t s_telemetry_batch;
+static char s_telemetry_batch_buf[TELEMETRY_BATCH_MAX_BYTES];
+
+#ifdef CONFIG_BENCHMARK_MODE
+/** Cliente substituto do benchmark (mqtt_system_bench_init) */
+static mqtt_bench_publish_fn_t s_bench_publish = NULL;
+#endif
 
 /** Flag indicando se sistema foi inicializado */
 static bool s_system_initialized = false;
@@ -92,21 +195,44 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
 
 /* Funções de inicialização */
 static esp_err_t init_nvs(void);
-static esp_err_t init_gpio(void);
+static esp_err_t init_base(void);
 
 static esp_err_t init_wifi(void);
 static esp_err_t init_mqtt(void);
-static esp_err_t create_tasks(void);
+static esp_err_t register_jobs(void);
+static esp_err_t register_topic_handlers(void);
 
-/* Tasks */
-static void telemetry_task(void *pvParameters);
-static void health_monitoring_task(void *pvParameters);
-static void wifi_watchdog_task(void *pvParameters);
-static void ac_monitor_task(void *pvParameters);
+/* Jobs */
+static void telemetry_job(void *ctx);
+static void health_monitoring_job(void *ctx);
+static void wifi_watchdog_job(void *ctx);
 
 /* Funções auxiliares */
-static esp_err_t wait_for_wifi_connection(uint32_t timeout_sec);
-static esp_err_t wait_for_mqtt_connection(uint32_t timeout_sec);
+static int publish_direct(const char *topic, const char *data,
+                          int len, int qos, bool retain);
+static int publish_drained(const char *topic, const char *data,
+                           int len, int qos, bool retain);
+static int publish_now(const char *topic, const char *data,
+                       int len, int qos, bool retain);
+static bool client_ready(void);
+static int client_publish(const char *topic, const char *data,
+                          int len, int qos, bool retain);
+static int client_outbox_size(void);
+static int encode_telemetry_item(uint8_t *buf, size_t cap, void *ctx);
+static int telemetry_batch_result(int msg_id);
+static uint32_t backoff_delay_ms(uint32_t attempt);
+static void wifi_retry_deadline(void *ctx);
+static void mqtt_retry_deadline(void *ctx);
+static void subscribe_all(void);
+static void on_config_changed(const app_config_t *now,
+                              const app_config_t *old, void *ctx);
+static void start_mqtt_client(void);
+static void publish_boot_info(void);
+#ifdef CONFIG_TRACE_ENABLE
+static void publish_trace_summary(void);
+static void on_trace_dump(const char *topic, int topic_len,
+                          const char *data, int data_len, void *ctx);
+#endif
 
 /*
  * =============================================================================
@@ -126,23 +252,22 @@ esp_err_t mqtt_system_init(void)
     ESP_LOGI(TAG, "   Sistema IoT MQTT - Inicializacao");
     ESP_LOGI(TAG, "===========================================");
 
-    esp_err_t ret;
-
     /* Fase 1: Subsistemas base */
     ESP_LOGI(TAG, "FASE 1: Inicializando subsistemas base...");
 
-    ret = init_gpio();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Falha ao inicializar GPIOs");
+    esp_err_t ret = init_base();
+    if (ret != ESP_OK)
+    {
         return ret;
     }
 
-    ret = init_nvs();
-    if (ret != ESP_OK)
+#ifndef CONFIG_DEEP_SLEEP_MODE
+    /* Sem ADC o sistema segue funcionando, apenas sem telemetria */
+    if (sensor_adc_start() != ESP_OK)
     {
-        ESP_LOGE(TAG, "Falha ao inicializar NVS");
-        return ret;
+        ESP_LOGE(TAG, "Falha ao iniciar aquisicao do ADC");
     }
+#endif
 
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_LOGI(TAG, "  Netif inicializado");
@@ -150,91 +275,82 @@ esp_err_t mqtt_system_init(void)
     ESP_ERROR_CHECK(esp_event_loop_create_default());
     ESP_LOGI(TAG, "  Event loop criado");
 
-    memset(&s_stats, 0, sizeof(mqtt_statistics_t));
-    ESP_LOGI(TAG, "  Estatisticas inicializadas");
-
-    /* Fase 2: WiFi */
+    /*
+     * Fase 2: rede. Nada aqui espera pela conexão: o WiFi conecta em
+     * segundo plano e o cliente MQTT é iniciado no primeiro IP obtido
+     * (wifi_event_handler). Até lá a telemetria vai para o buffer offline
+     * e as regras locais já atuam com o que chegar.
+     */
 #ifdef CONFIG_QEMU_MODE
-    ESP_LOGW(TAG, "FASE 2: MODO QEMU - WiFi desabilitado");
+    ESP_LOGW(TAG, "FASE 2: MODO QEMU - WiFi e MQTT desabilitados");
     ESP_LOGW(TAG, "  Executando em emulacao, funcionalidades de rede limitadas");
 #else
-    ESP_LOGI(TAG, "FASE 2: Configurando WiFi...");
+    ESP_LOGI(TAG, "FASE 2: Configurando WiFi e MQTT...");
 
-    ret = init_wifi();
+    ret = init_mqtt();
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "Falha ao inicializar WiFi");
+        ESP_LOGE(TAG, "Falha ao inicializar MQTT");
         return ret;
     }
 
-    ret = wait_for_wifi_connection(30);
+    ret = init_wifi();
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "Timeout aguardando conexão WiFi");
+        ESP_LOGE(TAG, "Falha ao inicializar WiFi");
         return ret;
     }
 #endif
 
-    /* Fase 3: MQTT */
-#ifdef CONFIG_QEMU_MODE
-    ESP_LOGW(TAG, "FASE 3: MODO QEMU - MQTT desabilitado");
-#else
-    ESP_LOGI(TAG, "FASE 3: Inicializando MQTT...");
+    /* Fase 3: Jobs */
+    ESP_LOGI(TAG, "FASE 3: Registrando jobs da aplicacao...");
 
-    ret = init_mqtt();
+    ret = register_jobs();
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "Falha ao inicializar MQTT");
+        ESP_LOGE(TAG, "Falha ao registrar jobs");
         return ret;
     }
 
-    ret = wait_for_mqtt_connection(20);
-    if (ret != ESP_OK)
-    {
-        ESP_LOGW(TAG, "Timeout MQTT - continuando em modo degradado");
-    }
-#endif
+    s_system_initialized = true;
+
+    ESP_LOGI(TAG, "");
+    ESP_LOGI(TAG, "===========================================");
+    ESP_LOGI(TAG, "  Sistema IoT MQTT Inicializado!");
+    ESP_LOGI(TAG, "===========================================");
+    ESP_LOGI(TAG, "");
 
-    /* Fase 4: Tasks */
-    ESP_LOGI(TAG, "FASE 4: Criando tasks da aplicacao...");
+    return ESP_OK;
+}
 
-    ret = create_tasks();
-    if (ret != ESP_OK)
+#ifdef CONFIG_BENCHMARK_MODE
+esp_err_t mqtt_system_bench_init(mqtt_bench_publish_fn_t publish)
+{
+    if (publish == NULL)
     {
-        ESP_LOGE(TAG, "Falha ao criar tasks");
-        return ret;
+        return ESP_ERR_INVALID_ARG;
     }
 
-    /* Publicar status online */
-    if (s_mqtt_connected)
+    esp_err_t ret = init_base();
+    if (ret != ESP_OK)
     {
-        mqtt_publish_status(true);
-
-        char boot_info[256];
-        snprintf(boot_info, sizeof(boot_info),
-                 "{\"device\":\"esp32_central\","
-                 "\"firmware\":\"1.0.0\","
-                 "\"reset_reason\":%d,"
-                 "\"free_heap\":%lu,"
-                 "\"idf_version\":\"%s\"}",
-                 esp_reset_reason(),
-                 esp_get_free_heap_size(),
-                 esp_get_idf_version());
-
-        mqtt_publish_data(MQTT_TOPIC_BOOT, boot_info, 0, 1, false);
+        return ret;
     }
 
+    s_bench_publish = publish;
+    s_mqtt_connected = true;
+    xEventGroupSetBits(s_conn_events, MQTT_CONNECTED_BIT);
     s_system_initialized = true;
 
-    ESP_LOGI(TAG, "");
-    ESP_LOGI(TAG, "===========================================");
-    ESP_LOGI(TAG, "  Sistema IoT MQTT Inicializado!");
-    ESP_LOGI(TAG, "===========================================");
-    ESP_LOGI(TAG, "");
-
     return ESP_OK;
 }
 
+void mqtt_system_bench_event(int32_t event_id, void *event_data)
+{
+    mqtt_event_handler(NULL, NULL, event_id, event_data);
+}
+#endif
+
 esp_err_t mqtt_system_shutdown(void)
 {
     if (!s_system_initialized)
@@ -244,6 +360,9 @@ esp_err_t mqtt_system_shutdown(void)
 
     ESP_LOGI(TAG, "Desligando sistema MQTT...");
 
+    /* Não perder amostras ainda não publicadas */
+    mqtt_flush_telemetry();
+
     /* Publicar offline */
     if (s_mqtt_connected)
     {
@@ -251,29 +370,15 @@ esp_err_t mqtt_system_shutdown(void)
         vTaskDelay(pdMS_TO_TICKS(100));
     }
 
-    /* Parar tasks */
-    if (s_task_telemetry)
-    {
-        vTaskDelete(s_task_telemetry);
-        s_task_telemetry = NULL;
-    }
-    if (s_task_health)
-    {
-        vTaskDelete(s_task_health);
-        s_task_health = NULL;
-    }
-    if (s_task_wifi_watchdog)
-    {
-        vTaskDelete(s_task_wifi_watchdog);
-        s_task_wifi_watchdog = NULL;
-    }
-    if (s_task_ac_monitor)
-    {
-        vTaskDelete(s_task_ac_monitor);
-        s_task_ac_monitor = NULL;
-    }
+    /* Parar jobs */
+    job_set_enabled(s_job_telemetry, false);
+    job_set_enabled(s_job_health, false);
+    job_set_enabled(s_job_wifi_watchdog, false);
+
+    sensor_adc_stop();
 
     /* Desconectar MQTT */
+    deadline_cancel(s_deadline_mqtt);
     if (s_mqtt_client)
     {
         esp_mqtt_client_stop(s_mqtt_client);
@@ -281,8 +386,12 @@ esp_err_t mqtt_system_shutdown(void)
         s_mqtt_client = NULL;
     }
 
+    mqtt_inbound_stop();
+
     s_system_initialized = false;
     s_mqtt_connected = false;
+    s_mqtt_started = false;
+    xEventGroupClearBits(s_conn_events, MQTT_CONNECTED_BIT);
 
     ESP_LOGI(TAG, "Sistema desligado");
 
@@ -294,20 +403,34 @@ bool mqtt_system_is_connected(void)
     return s_mqtt_connected;
 }
 
+esp_err_t mqtt_system_wait_connected(uint32_t timeout_ms)
+{
+    if (s_conn_events == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    EventBits_t bits = xEventGroupWaitBits(s_conn_events, MQTT_CONNECTED_BIT,
+                                           pdFALSE, pdTRUE,
+                                           pdMS_TO_TICKS(timeout_ms));
+
+    return (bits & MQTT_CONNECTED_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
 int mqtt_publish_data(const char *topic, const char *data,
                       int len, int qos, bool retain)
 {
-    if (s_mqtt_client == NULL)
+    if (!client_ready())
     {
         ESP_LOGE(TAG, "Cliente MQTT nao inicializado");
-        s_stats.falhas_publicacao++;
+        mqtt_stats_inc(MQTT_STAT_FALHAS);
         return -1;
     }
 
-    if (!s_mqtt_connected)
+    if (len < 0)
     {
-        ESP_LOGW(TAG, "MQTT desconectado, não e possível publicar");
-        s_stats.falhas_publicacao++;
+        /* Serialização do chamador falhou (buffer insuficiente) */
+        mqtt_stats_inc(MQTT_STAT_FALHAS);
         return -1;
     }
 
@@ -316,26 +439,26 @@ int mqtt_publish_data(const char *topic, const char *data,
         len = strlen(data);
     }
 
-    int msg_id = esp_mqtt_client_publish(s_mqtt_client,
-                                         topic,
-                                         data,
-                                         len,
-                                         qos,
-                                         retain ? 1 : 0);
+#if MQTT_LOCAL_LOOPBACK
+    /* Handlers locais primeiro: atuam mesmo sem broker */
+    mqtt_router_deliver_local(topic, strlen(topic), data, len);
+#endif
 
-    if (msg_id >= 0)
-    {
-        s_stats.total_publicadas++;
-        ESP_LOGD(TAG, "Publicado em '%s' (msg_id=%d, QoS=%d)",
-                 topic, msg_id, qos);
-    }
-    else
+    /* Sem conexão, ou com mensagens antigas pendentes: preserva a ordem */
+    if (!s_mqtt_connected || mqtt_offline_pending() > 0)
     {
-        s_stats.falhas_publicacao++;
-        ESP_LOGE(TAG, "Falha ao publicar em '%s'", topic);
+        if (mqtt_offline_enqueue(topic, data, len, qos, retain) == ESP_OK)
+        {
+            ESP_LOGD(TAG, "Armazenado para envio posterior: '%s'", topic);
+            return 0;
+        }
+
+        ESP_LOGW(TAG, "MQTT desconectado, não e possível publicar");
+        mqtt_stats_inc(MQTT_STAT_FALHAS);
+        return -1;
     }
 
-    return msg_id;
+    return publish_direct(topic, data, len, qos, retain);
 }
 
 int mqtt_publish_telemetry(const telemetry_data_t *data)
@@ -345,55 +468,180 @@ int mqtt_publish_telemetry(const telemetry_data_t *data)
         return -1;
     }
 
-    char buffer[256];
-    snprintf(buffer, sizeof(buffer),
-             "{"
-             "\"temperatura\":%.2f,"
-             "\"umidade\":%.2f,"
-             "\"contador\":%lu,"
-             "\"timestamp\":%llu"
-             "}",
-             data->temperatura,
-             data->umidade,
-             data->contador,
-             data->timestamp);
-
-    return mqtt_publish_data(MQTT_TOPIC_TELEMETRY, buffer, 0, 1, false);
+    float values[] = {data->temperatura, data->umidade};
+    if (!report_policy_should_publish(MQTT_TOPIC_TELEMETRY, values))
+    {
+        /* Sem amostra nova, o lote acumulado ainda sai pela idade */
+        telemetry_batch_result(mqtt_batch_poll(&s_telemetry_batch));
+        return MQTT_PUBLISH_SUPPRESSED;
+    }
+
+    /* A amostra é codificada direto no buffer do lote, sem cópia */
+    return telemetry_batch_result(mqtt_batch_add_encoded(&s_telemetry_batch,
+                                                         encode_telemetry_item,
+                                                         (void *)data));
 }
 
-int mqtt_publish_health_check(void)
+int mqtt_publish_telemetry_samples(const telemetry_data_t *samples, int count)
+{
+    if (samples == NULL || count < 0)
+    {
+        return -1;
+    }
+
+    int ret = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (mqtt_batch_add_encoded(&s_telemetry_batch, encode_telemetry_item,
+                                   (void *)&samples[i]) < 0)
+        {
+            ret = -1;
+        }
+    }
+
+    int flushed = mqtt_batch_flush(&s_telemetry_batch);
+
+    return telemetry_batch_result((ret < 0 || flushed < 0) ? -1 : flushed);
+}
+
+esp_err_t mqtt_set_payload_format(mqtt_payload_format_t format)
+{
+    if (format > MQTT_PAYLOAD_FORMAT_PACKED)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (format != s_payload_format)
+    {
+        telemetry_batch_result(mqtt_batch_set_target(&s_telemetry_batch,
+                                                     s_telemetry_topics[format],
+                                                     s_batch_framings[format]));
+        s_payload_format = format;
+        ESP_LOGI(TAG, "Formato de payload alterado para %d", format);
+    }
+
+    return ESP_OK;
+}
+
+mqtt_payload_format_t mqtt_get_payload_format(void)
+{
+    return s_payload_format;
+}
+
+int mqtt_publish_value(const char *topic, float value, int decimals,
+                       int qos, bool retain)
+{
+    if (topic == NULL)
+    {
+        return -1;
+    }
+
+    if (!report_policy_should_publish(topic, &value))
+    {
+        return MQTT_PUBLISH_SUPPRESSED;
+    }
+
+    char payload[24];
+    json_writer_t jw;
+    json_writer_init(&jw, payload, sizeof(payload));
+    if (decimals > 0)
+    {
+        json_add_fixed(&jw, NULL, value, decimals);
+    }
+    else
+    {
+        json_add_int(&jw, NULL, (int32_t)lroundf(value));
+    }
+
+    int ret = mqtt_publish_data(topic, payload, json_writer_finish(&jw),
+                                qos, retain);
+    if (ret < 0)
+    {
+        report_policy_invalidate(topic);
+    }
+
+    return ret;
+}
+
+int mqtt_flush_telemetry(void)
+{
+    return telemetry_batch_result(mqtt_batch_flush(&s_telemetry_batch));
+}
+
+/**
+ * @brief Publica o health check; @p rotate fecha a janela de latências de ACK
+ */
+static int publish_health(bool rotate)
 {
     health_status_t health;
+    mqtt_statistics_t stats;
+
+    if (mqtt_get_health_status(&health) != ESP_OK ||
+        mqtt_get_statistics(&stats) != ESP_OK)
+    {
+        return -1;
+    }
+
+    /* Latências de ACK são reportadas por intervalo de health check */
+    if (rotate)
+    {
+        mqtt_inflight_rotate();
+    }
+
+    mqtt_payload_format_t format = s_payload_format;
+    uint8_t buffer[512];
+    int len = payload_encode_health(format, &health, &stats,
+                                    buffer, sizeof(buffer));
+    if (len <= 0)
+    {
+        return -1;
+    }
+
+    return mqtt_publish_data(s_health_topics[format], (const char *)buffer,
+                             len, 0, false);
+}
+
+/**
+ * @brief Publica a carga de CPU; @p advance fecha a janela de medição
+ */
+static int publish_cpu_report(bool advance)
+{
+    rtos_cpu_report_t report;
+    if (rtos_cpu_report(&report, advance) != ESP_OK)
+    {
+        return -1;
+    }
 
-    if (mqtt_get_health_status(&health) != ESP_OK)
+    char buffer[640];
+    int len = rtos_cpu_report_json(&report, buffer, sizeof(buffer));
+    if (len <= 0)
     {
         return -1;
     }
 
-    char buffer[512];
-    snprintf(buffer, sizeof(buffer),
-             "{"
-             "\"free_heap\":%lu,"
-             "\"min_free_heap\":%lu,"
-             "\"wifi_rssi\":%d,"
-             "\"uptime_sec\":%llu,"
-             "\"mqtt_connected\":%d,"
-             "\"msgs_sent\":%lu,"
-             "\"msgs_received\":%lu,"
-             "\"mqtt_failures\":%lu,"
-             "\"disconnects\":%lu"
-             "}",
-             health.free_heap,
-             health.min_free_heap,
-             health.wifi_rssi,
-             health.uptime_sec,
-             health.mqtt_connected ? 1 : 0,
-             s_stats.total_publicadas,
-             s_stats.total_recebidas,
-             s_stats.falhas_publicacao,
-             s_stats.desconexoes);
-
-    return mqtt_publish_data(MQTT_TOPIC_HEALTH, buffer, 0, 0, false);
+    return mqtt_publish_data(MQTT_TOPIC_HEALTH "/cpu", buffer, len, 0, false);
+}
+
+int mqtt_publish_health_check(void)
+{
+    return publish_health(true);
+}
+
+int mqtt_publish_cpu_report(void)
+{
+    return publish_cpu_report(true);
+}
+
+esp_err_t mqtt_request_telemetry(void)
+{
+    __atomic_store_n(&s_telemetry_flush_requested, true, __ATOMIC_RELAXED);
+    return job_trigger(s_job_telemetry);
+}
+
+esp_err_t mqtt_request_health(void)
+{
+    __atomic_store_n(&s_health_on_demand, true, __ATOMIC_RELAXED);
+    return job_trigger(s_job_health);
 }
 
 int mqtt_publish_status(bool online)
@@ -424,6 +672,35 @@ int mqtt_subscribe_topic(const char *topic, int qos)
     return msg_id;
 }
 
+int mqtt_subscribe_topics(const mqtt_subscription_t *subs, int count)
+{
+    if (s_mqtt_client == NULL || !s_mqtt_connected || subs == NULL ||
+        count <= 0 || count > MQTT_SUBSCRIBE_MAX_FILTERS)
+    {
+        return -1;
+    }
+
+    esp_mqtt_topic_t topics[MQTT_SUBSCRIBE_MAX_FILTERS];
+    for (int i = 0; i < count; i++)
+    {
+        topics[i].filter = subs[i].topic;
+        topics[i].qos = subs[i].qos;
+    }
+
+    int msg_id = esp_mqtt_client_subscribe_multiple(s_mqtt_client, topics, count);
+
+    if (msg_id >= 0)
+    {
+        ESP_LOGI(TAG, "Subscrito em %d topicos (msg_id=%d)", count, msg_id);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Falha ao subscrever em %d topicos", count);
+    }
+
+    return msg_id;
+}
+
 int mqtt_unsubscribe_topic(const char *topic)
 {
     if (s_mqtt_client == NULL || !s_mqtt_connected)
@@ -449,19 +726,20 @@ esp_err_t mqtt_get_statistics(mqtt_statistics_t *stats)
         return ESP_ERR_INVALID_ARG;
     }
 
-    memcpy(stats, &s_stats, sizeof(mqtt_statistics_t));
+    mqtt_stats_snapshot(stats);
+    mqtt_inflight_snapshot(stats);
+    mqtt_tls_snapshot(stats);
+    stats->ttfp_ultimo_ms = __atomic_load_n(&s_ttfp_last_ms, __ATOMIC_RELAXED);
+    stats->ttfp_max_ms = __atomic_load_n(&s_ttfp_max_ms, __ATOMIC_RELAXED);
+    stats->fila_offline = mqtt_offline_pending();
+    stats->descartadas_offline = mqtt_offline_dropped();
     return ESP_OK;
 }
 
 void mqtt_reset_statistics(void)
 {
-    uint32_t desconexoes = s_stats.desconexoes;
-    uint32_t tempo_desconectado = s_stats.tempo_desconectado_ms;
-
-    memset(&s_stats, 0, sizeof(mqtt_statistics_t));
-
-    s_stats.desconexoes = desconexoes;
-    s_stats.tempo_desconectado_ms = tempo_desconectado;
+    mqtt_stats_reset();
+    mqtt_inflight_rotate();
 
     ESP_LOGI(TAG, "Estatisticas resetadas");
 }
@@ -477,6 +755,8 @@ esp_err_t mqtt_get_health_status(health_status_t *health)
     health->min_free_heap = esp_get_minimum_free_heap_size();
     health->uptime_sec = esp_timer_get_time() / 1000000ULL;
     health->mqtt_connected = s_mqtt_connected;
+    health->power_mode = power_manager_get_mode();
+    health->corrente_estimada_ua = power_manager_estimate_current_ua();
 
 #ifndef CONFIG_QEMU_MODE
     esp_wifi_sta_get_rssi(&health->wifi_rssi);
@@ -489,12 +769,46 @@ esp_err_t mqtt_get_health_status(health_status_t *health)
 
 void mqtt_print_statistics(void)
 {
+    mqtt_statistics_t stats;
+    mqtt_get_statistics(&stats);
+
     ESP_LOGI(TAG, "=== Estatisticas MQTT ===");
-    ESP_LOGI(TAG, "Publicadas   : %lu", s_stats.total_publicadas);
-    ESP_LOGI(TAG, "Recebidas    : %lu", s_stats.total_recebidas);
-    ESP_LOGI(TAG, "Falhas       : %lu", s_stats.falhas_publicacao);
-    ESP_LOGI(TAG, "Desconexoes  : %lu", s_stats.desconexoes);
-    ESP_LOGI(TAG, "Tempo offline: %lu ms", s_stats.tempo_desconectado_ms);
+    ESP_LOGI(TAG, "Publicadas   : %lu (%lu bytes)",
+             stats.total_publicadas, stats.bytes_enviados);
+    ESP_LOGI(TAG, "Recebidas    : %lu (%lu bytes)",
+             stats.total_recebidas, stats.bytes_recebidos);
+    ESP_LOGI(TAG, "Falhas       : %lu", stats.falhas_publicacao);
+    ESP_LOGI(TAG, "Desconexoes  : %lu", stats.desconexoes);
+    ESP_LOGI(TAG, "Tempo offline: %lu ms", stats.tempo_desconectado_ms);
+    ESP_LOGI(TAG, "Descartadas  : %lu", stats.descartadas_entrada);
+    ESP_LOGI(TAG, "Suprimidas   : %lu", stats.suprimidas);
+    ESP_LOGI(TAG, "Fila offline : %lu (max %lu)",
+             stats.fila_offline, stats.hwm_fila_offline);
+    ESP_LOGI(TAG, "Fila entrada : max %lu slots", stats.hwm_fila_entrada);
+    ESP_LOGI(TAG, "Outbox       : max %lu de %d bytes, descartadas critica=%lu "
+                  "telemetria=%lu custom=%lu",
+             stats.hwm_outbox_bytes, MQTT_OUTBOX_BUDGET_BYTES,
+             stats.descartadas_outbox[MQTT_PRIORITY_CRITICAL],
+             stats.descartadas_outbox[MQTT_PRIORITY_TELEMETRY],
+             stats.descartadas_outbox[MQTT_PRIORITY_CUSTOM]);
+    ESP_LOGI(TAG, "Latencia publ: <0.5ms=%lu <1=%lu <2=%lu <5=%lu <10=%lu "
+                  "<20=%lu <50=%lu >=50=%lu (max %lu us)",
+             stats.latencia_hist[0], stats.latencia_hist[1],
+             stats.latencia_hist[2], stats.latencia_hist[3],
+             stats.latencia_hist[4], stats.latencia_hist[5],
+             stats.latencia_hist[6], stats.latencia_hist[7],
+             stats.latencia_max_us);
+    ESP_LOGI(TAG, "ACK (janela) : %lu amostras, min=%lu avg=%lu p99=%lu us, "
+                  "timeouts=%lu, em voo=%lu",
+             stats.ack_amostras, stats.ack_min_us, stats.ack_avg_us,
+             stats.ack_p99_us, stats.ack_timeouts, stats.em_voo);
+    ESP_LOGI(TAG, "1a publicacao: %lu ms apos recuperar WiFi (max %lu ms)",
+             stats.ttfp_ultimo_ms, stats.ttfp_max_ms);
+    ESP_LOGI(TAG, "Conexao      : %lu ms (max %lu ms), pico de heap %lu bytes",
+             stats.conexao_ultima_ms, stats.conexao_max_ms, stats.conexao_heap_pico);
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    mqtt_v5_print();
+#endif
     ESP_LOGI(TAG, "========================");
 }
 
@@ -526,37 +840,141 @@ static esp_err_t init_nvs(void)
     return ret;
 }
 
-static esp_err_t init_wifi(void)
+/**
+ * @brief Subsistemas que não dependem da rede: NVS, jobs, prazos, buffer
+ *        offline, lote de telemetria, roteador e fila de entrada
+ */
+static esp_err_t init_base(void)
 {
-    esp_netif_create_default_wifi_sta();
+    esp_err_t ret = init_nvs();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao inicializar NVS");
+        return ret;
+    }
 
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+    ret = job_scheduler_start();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao criar task do escalonador de jobs");
+        return ret;
+    }
 
-    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT,
-                                               ESP_EVENT_ANY_ID,
-                                               &wifi_event_handler,
-                                               NULL));
+    ret = deadline_init();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao criar timer de prazos");
+        return ret;
+    }
 
-    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT,
-                                               IP_EVENT_STA_GOT_IP,
-                                               &wifi_event_handler,
-                                               NULL));
+    s_conn_events = RTOS_EVENT_GROUP_CREATE(s_conn_events_buf);
+    if (s_conn_events == NULL)
+    {
+        ESP_LOGE(TAG, "Falha ao criar grupo de eventos de conexao");
+        return ESP_ERR_NO_MEM;
+    }
 
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = CONFIG_WIFI_SSID,
-            .password = CONFIG_WIFI_PASSWORD,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-            .pmf_cfg = {
-                .capable = true,
-                .required = false},
-        },
-    };
+    s_deadline_wifi = deadline_register("WiFiRetry", wifi_retry_deadline, NULL);
+    s_deadline_mqtt = deadline_register("MqttRetry", mqtt_retry_deadline, NULL);
+    if (s_deadline_wifi < 0 || s_deadline_mqtt < 0)
+    {
+        ESP_LOGE(TAG, "Falha ao registrar prazos de reconexao");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ret = power_manager_init();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao configurar gerenciamento de energia");
+        return ret;
+    }
+
+    ret = mqtt_offline_init(publish_drained, mqtt_system_is_connected);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao inicializar buffer offline");
+        return ret;
+    }
+
+    ret = mqtt_batch_init(&s_telemetry_batch,
+                          s_telemetry_topics[s_payload_format],
+                          s_batch_framings[s_payload_format], 1,
+                          s_telemetry_batch_buf, sizeof(s_telemetry_batch_buf),
+                          TELEMETRY_BATCH_MAX_SAMPLES,
+                          TELEMETRY_BATCH_MAX_BYTES,
+                          TELEMETRY_BATCH_MAX_AGE_MS);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao inicializar lote de telemetria");
+        return ret;
+    }
+
+    const report_policy_t telemetry_policy = {
+        .deadband = {TELEMETRY_DEADBAND_TEMP_C, TELEMETRY_DEADBAND_UMIDADE},
+        .min_interval_ms = 0,
+        .heartbeat_ms = TELEMETRY_HEARTBEAT_MS,
+    };
+    ret = report_policy_register(MQTT_TOPIC_TELEMETRY, &telemetry_policy, 2);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao registrar politica de telemetria");
+        return ret;
+    }
+
+    ret = register_topic_handlers();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao registrar handlers de topicos");
+        return ret;
+    }
+
+    ret = mqtt_inbound_start();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao criar task de despacho MQTT");
+        return ret;
+    }
+    ESP_LOGI(TAG, "  Fila de entrada MQTT criada (%d slots)",
+             MQTT_INBOUND_QUEUE_SLOTS);
+
+    return ESP_OK;
+}
+
+static esp_err_t init_wifi(void)
+{
+    esp_netif_t *sta_netif = esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT,
+                                               ESP_EVENT_ANY_ID,
+                                               &wifi_event_handler,
+                                               NULL));
+
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT,
+                                               IP_EVENT_STA_GOT_IP,
+                                               &wifi_event_handler,
+                                               NULL));
+
+    wifi_config_t wifi_config = {
+        .sta = {
+            .ssid = CONFIG_WIFI_SSID,
+            .password = CONFIG_WIFI_PASSWORD,
+            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
+            .pmf_cfg = {
+                .capable = true,
+                .required = false},
+        },
+    };
+
+    power_manager_apply_wifi_config(&wifi_config);
+    wifi_fast_connect_apply(&wifi_config, sta_netif);
 
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
+    ESP_ERROR_CHECK(power_manager_apply_wifi_ps());
 
     ESP_LOGI(TAG, "  WiFi iniciado");
 
@@ -565,8 +983,12 @@ static esp_err_t init_wifi(void)
 
 static esp_err_t init_mqtt(void)
 {
-    esp_mqtt_client_config_t mqtt_cfg = {
-        .broker.address.uri = CONFIG_MQTT_BROKER_URI,
+    app_config_t cfg;
+    app_config_get(&cfg);
+    memcpy(s_broker_uri, cfg.broker_uri, sizeof(s_broker_uri));
+
+    s_mqtt_cfg = (esp_mqtt_client_config_t){
+        .broker.address.uri = s_broker_uri,
         .credentials = {
             .client_id = CONFIG_MQTT_CLIENT_ID,
             .username = CONFIG_MQTT_USERNAME,
@@ -581,14 +1003,41 @@ static esp_err_t init_mqtt(void)
         .session.last_will.retain = 1,
 
         .session.keepalive = MQTT_KEEPALIVE_SEC,
-        .session.disable_clean_session = false,
+        /*
+         * Sessão persistente: o broker guarda inscrições e mensagens QoS 1
+         * entre conexões do mesmo client_id, que por isso deve ser fixo e
+         * único por dispositivo (CONFIG_MQTT_CLIENT_ID).
+         */
+        .session.disable_clean_session = MQTT_PERSISTENT_SESSION,
         .network.timeout_ms = MQTT_TIMEOUT_MS,
 
+        /*
+         * Reconexão com backoff e jitter antecipada por mqtt_retry_deadline()
+         * (esp_mqtt_client_reconnect() só age com a reconexão automática
+         * ligada); a espera própria do cliente fica no teto do backoff e só
+         * vale se o prazo não disparar.
+         */
+        .network.reconnect_timeout_ms = RECONNECT_BACKOFF_MAX_MS,
+
         .buffer.size = MQTT_BUFFER_SIZE,
         .buffer.out_size = MQTT_BUFFER_SIZE,
+
+        /* Teto rígido; as classes de prioridade são aplicadas antes */
+        .outbox.limit = MQTT_OUTBOX_BUDGET_BYTES,
+
+#ifdef CONFIG_MQTT_PROTOCOL_5
+        .session.protocol_ver = MQTT_PROTOCOL_V_5,
+#endif
     };
 
-    s_mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
+    /* Verificação do servidor, usada se o URI (ou um novo) for mqtts:// */
+    esp_err_t ret = mqtt_tls_configure(&s_mqtt_cfg);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    s_mqtt_client = esp_mqtt_client_init(&s_mqtt_cfg);
 
     if (s_mqtt_client == NULL)
     {
@@ -597,161 +1046,457 @@ static esp_err_t init_mqtt(void)
     }
     ESP_LOGI(TAG, "  Cliente MQTT criado");
 
-    esp_err_t ret = esp_mqtt_client_register_event(s_mqtt_client,
-                                                   ESP_EVENT_ANY_ID,
-                                                   mqtt_event_handler,
-                                                   NULL);
-
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    ret = mqtt_v5_init(s_mqtt_client);
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "  Falha ao registrar handler");
+        ESP_LOGE(TAG, "  Falha ao configurar MQTT 5");
         esp_mqtt_client_destroy(s_mqtt_client);
         s_mqtt_client = NULL;
         return ret;
     }
-    ESP_LOGI(TAG, "  Handler registrado");
+#endif
 
-    ret = esp_mqtt_client_start(s_mqtt_client);
+    ret = esp_mqtt_client_register_event(s_mqtt_client,
+                                                   ESP_EVENT_ANY_ID,
+                                                   mqtt_event_handler,
+                                                   NULL);
 
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "  Falha ao iniciar cliente");
+        ESP_LOGE(TAG, "  Falha ao registrar handler");
         esp_mqtt_client_destroy(s_mqtt_client);
         s_mqtt_client = NULL;
         return ret;
     }
-    ESP_LOGI(TAG, "  Cliente MQTT iniciado");
+    ESP_LOGI(TAG, "  Handler registrado (inicio no primeiro IP)");
 
     return ESP_OK;
 }
 
-static esp_err_t create_tasks(void)
+static esp_err_t register_jobs(void)
 {
-    BaseType_t ret;
+#ifdef CONFIG_DEEP_SLEEP_MODE
+    /* Amostragem e publicação são feitas pelo sleep_cycle a cada despertar */
+    ESP_LOGI(TAG, "  Jobs periodicos ignorados (modo deep sleep)");
+    return ESP_OK;
+#endif
 
-    ret = xTaskCreate(telemetry_task, "Telemetry",
-                      4096, NULL, 5, &s_task_telemetry);
-    if (ret != pdPASS)
-    {
-        ESP_LOGE(TAG, "  Falha ao criar task de telemetria");
-        return ESP_FAIL;
-    }
-    ESP_LOGI(TAG, "  Task de telemetria criada");
+    app_config_t cfg;
+    app_config_get(&cfg);
 
-    ret = xTaskCreate(health_monitoring_task, "HealthMon",
-                      3072, NULL, 3, &s_task_health);
-    if (ret != pdPASS)
-    {
-        ESP_LOGE(TAG, "  Falha ao criar task de health");
-        return ESP_FAIL;
-    }
-    ESP_LOGI(TAG, "  Task de health criada");
+    s_job_telemetry = job_register("Telemetry", cfg.telemetry_interval_ms, 0,
+                                   telemetry_job, NULL);
+    s_job_health = job_register("HealthMon", cfg.health_interval_ms,
+                                cfg.health_interval_ms,
+                                health_monitoring_job, NULL);
 
-    ret = xTaskCreate(ac_monitor_task, "ACMonitor",
-                      2048, NULL, 3, &s_task_ac_monitor);
-    if (ret != pdPASS)
+    if (s_job_telemetry < 0 || s_job_health < 0)
     {
-        ESP_LOGE(TAG, "  Falha ao criar task de monitoramento do AC");
         return ESP_FAIL;
     }
-    ESP_LOGI(TAG, "  Task de monitoramento do AC criada");
 
 #ifndef CONFIG_QEMU_MODE
-    ret = xTaskCreate(wifi_watchdog_task, "WiFiWatchdog",
-                      2048, NULL, 4, &s_task_wifi_watchdog);
-    if (ret != pdPASS)
+    s_job_wifi_watchdog = job_register("WiFiWatchdog",
+                                       WIFI_WATCHDOG_INTERVAL_MS,
+                                       WIFI_WATCHDOG_INTERVAL_MS,
+                                       wifi_watchdog_job, NULL);
+    if (s_job_wifi_watchdog < 0)
     {
-        ESP_LOGE(TAG, "  Falha ao criar task de watchdog");
         return ESP_FAIL;
     }
-    ESP_LOGI(TAG, "  Task de watchdog criada");
 #else
-    ESP_LOGI(TAG, "  Task de watchdog ignorada (modo QEMU)");
+    ESP_LOGI(TAG, "  Job de watchdog ignorado (modo QEMU)");
 #endif
 
     return ESP_OK;
 }
 
-static esp_err_t wait_for_wifi_connection(uint32_t timeout_sec)
+/**
+ * @brief Publica imediatamente (mqtt_publish_data), dentro do orçamento do outbox
+ *
+ * Sem espaço na parte da classe do tópico, a publicação é descartada.
+ */
+static int publish_direct(const char *topic, const char *data,
+                          int len, int qos, bool retain)
 {
-    ESP_LOGI(TAG, "  Aguardando conexão WiFi...");
+    if (qos > 0 && client_ready())
+    {
+        mqtt_priority_t priority = mqtt_outbox_priority(topic);
+        if (!mqtt_outbox_has_room(priority, len, client_outbox_size()))
+        {
+            mqtt_outbox_dropped(priority, topic);
+            return -1;
+        }
+    }
 
-    uint32_t count = 0;
-    wifi_ap_record_t ap_info;
+    int msg_id = publish_now(topic, data, len, qos, retain);
+    if (msg_id == CLIENT_OUTBOX_FULL)
+    {
+        /* Outbox cresceu entre a consulta e a publicação */
+        mqtt_outbox_dropped(mqtt_outbox_priority(topic), topic);
+        msg_id = -1;
+    }
+    return msg_id;
+}
+
+/**
+ * @brief Envio da drenagem do buffer offline
+ *
+ * Sem espaço no outbox a mensagem não é descartada: continua no buffer
+ * offline e a drenagem tenta de novo na próxima rodada.
+ */
+static int publish_drained(const char *topic, const char *data,
+                           int len, int qos, bool retain)
+{
+    if (qos > 0 && client_ready() &&
+        !mqtt_outbox_has_room(mqtt_outbox_priority(topic), len, client_outbox_size()))
+    {
+        return -1;
+    }
+
+    return publish_now(topic, data, len, qos, retain);
+}
 
-    while (count < timeout_sec)
+/**
+ * @brief Publica imediatamente no cliente esp-mqtt, sem passar pelo buffer
+ *
+ * @return ID da mensagem, -1 em erro ou CLIENT_OUTBOX_FULL (o chamador decide
+ *         entre descartar e tentar de novo)
+ */
+static int publish_now(const char *topic, const char *data,
+                       int len, int qos, bool retain)
+{
+    if (!client_ready() || !s_mqtt_connected)
     {
-        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK)
-        {
-            ESP_LOGI(TAG, "  WiFi conectado!");
+        return -1;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    TRACE_BEGIN(t);
+    int msg_id = client_publish(topic, data, len, qos, retain);
+    TRACE_END(TRACE_PUBLISH, t, len);
+    mqtt_stats_record_latency((uint32_t)(esp_timer_get_time() - start_us));
 
-            esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-            if (netif != NULL)
+    if (msg_id >= 0)
+    {
+        /* Apenas o primeiro publicador após a recuperação encerra a medição */
+        uint32_t ttfp_start = __atomic_exchange_n(&s_ttfp_start_ms, 0,
+                                                  __ATOMIC_RELAXED);
+        if (ttfp_start != 0)
+        {
+            uint32_t ttfp = (uint32_t)(esp_timer_get_time() / 1000) - ttfp_start;
+            __atomic_store_n(&s_ttfp_last_ms, ttfp, __ATOMIC_RELAXED);
+            if (ttfp > __atomic_load_n(&s_ttfp_max_ms, __ATOMIC_RELAXED))
             {
-                esp_netif_ip_info_t ip_info;
-                if (esp_netif_get_ip_info(netif, &ip_info) == ESP_OK)
-                {
-                    ESP_LOGI(TAG, "  IP: " IPSTR, IP2STR(&ip_info.ip));
-                }
+                __atomic_store_n(&s_ttfp_max_ms, ttfp, __ATOMIC_RELAXED);
             }
-
-            return ESP_OK;
+            ESP_LOGI(TAG, "Primeira publicacao %lu ms apos recuperar o WiFi", ttfp);
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        count++;
-
-        if (count % 5 == 0)
+#if MQTT_LOCAL_LOOPBACK
+        /* Só uma cópia aceita pelo cliente volta do broker */
+        mqtt_router_expect_echo(topic, strlen(topic), data, len);
+#endif
+        mqtt_stats_inc(MQTT_STAT_PUBLICADAS);
+        if (qos > 0)
         {
-            ESP_LOGI(TAG, "  Aguardando... (%lu s)", count);
+            mqtt_inflight_track(msg_id, start_us);
         }
+        mqtt_stats_add(MQTT_STAT_BYTES_ENVIADOS, len);
+        mqtt_stats_update_hwm(MQTT_HWM_OUTBOX_BYTES, client_outbox_size());
+        ESP_LOGD(TAG, "Publicado em '%s' (msg_id=%d, QoS=%d)",
+                 topic, msg_id, qos);
+    }
+    else if (msg_id == CLIENT_OUTBOX_FULL)
+    {
+        ESP_LOGD(TAG, "Outbox cheio ao publicar em '%s'", topic);
+    }
+    else
+    {
+        mqtt_stats_inc(MQTT_STAT_FALHAS);
+        ESP_LOGE(TAG, "Falha ao publicar em '%s'", topic);
     }
 
-    return ESP_ERR_TIMEOUT;
+    return msg_id;
 }
 
-static esp_err_t init_gpio(void)
+static bool client_ready(void)
 {
-    // Configura GPIO 18 (Luzes) como saída
-    gpio_reset_pin(GPIO_NUM_18);
-    gpio_set_direction(GPIO_NUM_18, GPIO_MODE_OUTPUT);
-    gpio_set_level(GPIO_NUM_18, 0); // Começa desligado
+#ifdef CONFIG_BENCHMARK_MODE
+    return s_bench_publish != NULL;
+#else
+    return s_mqtt_client != NULL;
+#endif
+}
 
-    // Configura GPIO 19 (Ar Condicionado) como saída
-    gpio_reset_pin(GPIO_NUM_19);
-    gpio_set_direction(GPIO_NUM_19, GPIO_MODE_OUTPUT);
-    gpio_set_level(GPIO_NUM_19, 0); // Começa desligado
+static int client_publish(const char *topic, const char *data,
+                          int len, int qos, bool retain)
+{
+#ifdef CONFIG_BENCHMARK_MODE
+    return s_bench_publish(topic, data, len, qos, retain);
+#else
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (mqtt_v5_active())
+    {
+        return mqtt_v5_publish(s_mqtt_client, topic, data, len, qos, retain);
+    }
+#endif
+    return esp_mqtt_client_publish(s_mqtt_client, topic, data, len, qos,
+                                   retain ? 1 : 0);
+#endif
+}
 
-    ESP_LOGI(TAG, "  GPIOs 18 e 19 inicializados");
-    return ESP_OK;
+static int client_outbox_size(void)
+{
+#ifdef CONFIG_BENCHMARK_MODE
+    return 0;
+#else
+    return esp_mqtt_client_get_outbox_size(s_mqtt_client);
+#endif
+}
+
+/**
+ * @brief Codificador de amostras de telemetria para o lote (formato atual)
+ */
+static int encode_telemetry_item(uint8_t *buf, size_t cap, void *ctx)
+{
+    return payload_encode_telemetry(s_payload_format,
+                                    (const telemetry_data_t *)ctx, buf, cap);
 }
 
-static esp_err_t wait_for_mqtt_connection(uint32_t timeout_sec)
+/**
+ * @brief Resultado de uma operação no lote de telemetria
+ *
+ * Se a publicação do lote falhou, as amostras liberadas pela política de
+ * reporte se perderam: a referência do tópico é descartada e a próxima
+ * amostra sai mesmo sem mudança.
+ */
+static int telemetry_batch_result(int msg_id)
 {
-    ESP_LOGI(TAG, "  Aguardando conexão MQTT...");
+    if (msg_id < 0)
+    {
+        report_policy_invalidate(MQTT_TOPIC_TELEMETRY);
+    }
+    return msg_id;
+}
 
-    uint32_t count = 0;
+/**
+ * @brief Espera até a próxima tentativa de reconexão
+ *
+ * Backoff exponencial a partir de RECONNECT_BACKOFF_MIN_MS, limitado a
+ * RECONNECT_BACKOFF_MAX_MS, com metade da espera aleatória: dispositivos
+ * que caíram juntos (queda do AP ou do broker) não voltam todos no mesmo
+ * instante.
+ */
+static uint32_t backoff_delay_ms(uint32_t attempt)
+{
+    uint32_t ceiling = RECONNECT_BACKOFF_MAX_MS;
 
-    while (!s_mqtt_connected && count < timeout_sec)
+    if (attempt < 16 && ((uint32_t)RECONNECT_BACKOFF_MIN_MS << attempt) < ceiling)
     {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        count++;
+        ceiling = (uint32_t)RECONNECT_BACKOFF_MIN_MS << attempt;
+    }
+
+    return ceiling / 2 + esp_random() % (ceiling / 2 + 1);
+}
+
+/** Prazo de reconexão WiFi vencido (task do esp_timer) */
+static void wifi_retry_deadline(void *ctx)
+{
+    esp_wifi_connect();
+}
+
+/** Prazo de reconexão MQTT vencido (task do esp_timer) */
+static void mqtt_retry_deadline(void *ctx)
+{
+    /* Sem IP a tentativa falharia; IP_EVENT_STA_GOT_IP rearma o prazo */
+    if (s_mqtt_client == NULL || !s_wifi_has_ip || s_mqtt_connected)
+    {
+        return;
+    }
+
+    if (!s_mqtt_started)
+    {
+        start_mqtt_client();
+        return;
+    }
+
+    /*
+     * Falha = cliente não está esperando para reconectar: há uma tentativa
+     * em andamento, e o MQTT_EVENT_DISCONNECTED dela rearma o prazo
+     */
+    if (esp_mqtt_client_reconnect(s_mqtt_client) != ESP_OK)
+    {
+        ESP_LOGD(TAG, "Reconexao MQTT ignorada, tentativa em andamento");
+    }
+}
+
+/**
+ * @brief Inscreve em todos os tópicos do dispositivo com um único SUBSCRIBE
+ */
+static void subscribe_all(void)
+{
+    mqtt_subscription_t subs[MQTT_SUBSCRIBE_MAX_FILTERS];
+    int reserved = 2;
+#ifdef CONFIG_TRACE_ENABLE
+    reserved++;
+#endif
+    int count = rule_engine_subscriptions(subs, MQTT_SUBSCRIBE_MAX_FILTERS - reserved);
+
+    subs[count++] = (mqtt_subscription_t){MQTT_TOPIC_COMMANDS, 1};
+    subs[count++] = (mqtt_subscription_t){APP_CONFIG_TOPIC, 1};
+#ifdef CONFIG_TRACE_ENABLE
+    subs[count++] = (mqtt_subscription_t){MQTT_TOPIC_TRACE_DUMP, 0};
+#endif
 
-        if (count % 5 == 0)
+    s_subscribe_msg_id = mqtt_subscribe_topics(subs, count);
+}
+
+/**
+ * @brief Aplica a configuração nova aos jobs e ao cliente MQTT
+ *        (task de despacho)
+ *
+ * Troca de broker: o novo URI vale na próxima conexão, que é tentada já
+ * (conectado, o cliente desconecta antes). O URI fica em teste até o
+ * CONNACK; também é chamada, na task do cliente MQTT, quando o teste
+ * falha e o broker anterior volta (app_config_broker_rejected()).
+ */
+static void on_config_changed(const app_config_t *now,
+                              const app_config_t *old, void *ctx)
+{
+    if (now->telemetry_interval_ms != old->telemetry_interval_ms)
+    {
+        job_set_period(s_job_telemetry, now->telemetry_interval_ms);
+    }
+    if (now->health_interval_ms != old->health_interval_ms)
+    {
+        job_set_period(s_job_health, now->health_interval_ms);
+    }
+
+    if (strcmp(now->broker_uri, old->broker_uri) == 0 || s_mqtt_client == NULL)
+    {
+        return;
+    }
+
+    if (esp_mqtt_client_set_uri(s_mqtt_client, now->broker_uri) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao trocar o broker para %s", now->broker_uri);
+        return;
+    }
+    memcpy(s_broker_uri, now->broker_uri, sizeof(s_broker_uri));
+
+    ESP_LOGW(TAG, "Broker alterado para %s", now->broker_uri);
+    s_mqtt_attempts = 0;
+    s_broker_trial_failures = 0;
+
+    if (s_mqtt_connected)
+    {
+        /* MQTT_EVENT_DISCONNECTED arma a reconexão, já no novo URI */
+        if (esp_mqtt_client_disconnect(s_mqtt_client) == ESP_OK)
         {
-            ESP_LOGI(TAG, "  Aguardando... (%lu s)", count);
+            return;
         }
+        ESP_LOGW(TAG, "Falha ao desconectar do broker anterior");
     }
+    deadline_arm(s_deadline_mqtt, 0);
+}
 
-    if (s_mqtt_connected)
+/**
+ * @brief Inicia o cliente MQTT (chamada no primeiro IP obtido)
+ *
+ * Iniciar antes do IP só produziria uma tentativa falha e um backoff.
+ */
+static void start_mqtt_client(void)
+{
+    if (s_mqtt_client == NULL || s_mqtt_started)
     {
-        ESP_LOGI(TAG, "  MQTT conectado!");
-        return ESP_OK;
+        return;
+    }
+
+    if (esp_mqtt_client_start(s_mqtt_client) != ESP_OK)
+    {
+        /* Nova tentativa pelo prazo de reconexão (ou no próximo IP) */
+        uint32_t delay_ms = backoff_delay_ms(s_mqtt_attempts++);
+        deadline_arm(s_deadline_mqtt, delay_ms);
+        ESP_LOGE(TAG, "Falha ao iniciar cliente MQTT, nova tentativa em %lu ms", delay_ms);
+        return;
     }
 
-    return ESP_ERR_TIMEOUT;
+    s_mqtt_started = true;
+    ESP_LOGI(TAG, "Cliente MQTT iniciado");
+}
+
+/**
+ * @brief Publica status online e, na primeira conexão do boot, as
+ *        informações de boot
+ *
+ * O status é republicado a cada conexão porque o last will do broker o
+ * troca para "offline" a cada queda.
+ */
+static void publish_boot_info(void)
+{
+    mqtt_publish_status(true);
+
+    if (s_boot_announced)
+    {
+        return;
+    }
+    s_boot_announced = true;
+
+    char boot_info[256];
+    json_writer_t jw;
+    json_writer_init(&jw, boot_info, sizeof(boot_info));
+    json_begin_object(&jw);
+    json_add_string(&jw, "device", "esp32_central");
+    json_add_string(&jw, "firmware", "1.0.0");
+    json_add_int(&jw, "reset_reason", esp_reset_reason());
+    json_add_uint(&jw, "free_heap", esp_get_free_heap_size());
+    json_add_string(&jw, "idf_version", esp_get_idf_version());
+    json_add_uint(&jw, "boot_to_wifi_ms", wifi_fast_connect_boot_ms());
+    json_add_uint(&jw, "boot_to_mqtt_ms", (uint32_t)(esp_timer_get_time() / 1000));
+    json_add_bool(&jw, "wifi_fast_connect", wifi_fast_connect_used());
+    json_end_object(&jw);
+
+    int boot_len = json_writer_finish(&jw);
+    if (boot_len > 0)
+    {
+        mqtt_publish_data(MQTT_TOPIC_BOOT, boot_info, boot_len, 1, false);
+    }
 }
 
+#ifdef CONFIG_TRACE_ENABLE
+/**
+ * @brief Publica o resumo dos pontos de trace desde o resumo anterior
+ */
+static void publish_trace_summary(void)
+{
+    /* Estático: o resumo não pesa na stack do JobWorker, que ele mede */
+    static char buffer[1024];
+
+    int len = trace_summary_json(buffer, sizeof(buffer));
+    if (len <= 0)
+    {
+        ESP_LOGW(TAG, "Resumo de trace maior que o buffer");
+        return;
+    }
+
+    mqtt_publish_data(MQTT_TOPIC_TRACE, buffer, len, 0, false);
+}
+
+/**
+ * @brief Imprime os anéis de trace no log e antecipa o resumo
+ *
+ * O resumo sai pelo job de health, não pela task de despacho.
+ */
+static void on_trace_dump(const char *topic, int topic_len,
+                          const char *data, int data_len, void *ctx)
+{
+    trace_dump();
+    mqtt_request_health();
+}
+#endif
+
 /*
  * =============================================================================
  * HANDLERS DE EVENTOS
@@ -768,24 +1513,51 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
     }
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
     {
-        if (s_wifi_retry_num < WIFI_MAX_RETRY)
+        /* Sem limite de tentativas: a espera cresce até o teto */
+        s_wifi_has_ip = false;
+        xEventGroupClearBits(s_conn_events, WIFI_CONNECTED_BIT);
+        xEventGroupSetBits(s_conn_events, WIFI_FAIL_BIT);
+
+        /* Canal/BSSID guardados não serviram: varredura completa já */
+        if (wifi_fast_connect_on_disconnected())
         {
             esp_wifi_connect();
-            s_wifi_retry_num++;
-            ESP_LOGW(TAG, "Reconectando WiFi... (%d/%d)",
-                     s_wifi_retry_num, WIFI_MAX_RETRY);
-        }
-        else
-        {
-            ESP_LOGE(TAG, "Falha ao conectar WiFi após %d tentativas",
-                     WIFI_MAX_RETRY);
+            return;
         }
+
+        uint32_t delay_ms = backoff_delay_ms(s_wifi_attempts++);
+        deadline_arm(s_deadline_wifi, delay_ms);
+        ESP_LOGW(TAG, "WiFi desconectado, nova tentativa em %lu ms (#%lu)",
+                 delay_ms, s_wifi_attempts);
     }
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
     {
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
         ESP_LOGI(TAG, "IP obtido: " IPSTR, IP2STR(&event->ip_info.ip));
-        s_wifi_retry_num = 0;
+        s_wifi_attempts = 0;
+        s_wifi_has_ip = true;
+        deadline_cancel(s_deadline_wifi);
+        xEventGroupClearBits(s_conn_events, WIFI_FAIL_BIT);
+        xEventGroupSetBits(s_conn_events, WIFI_CONNECTED_BIT);
+        wifi_fast_connect_on_got_ip(event);
+
+        start_mqtt_client();
+
+        if (s_wifi_had_ip)
+        {
+            /* Recuperação: mede até a primeira publicação (0 = sem medição) */
+            uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+            __atomic_store_n(&s_ttfp_start_ms, now_ms != 0 ? now_ms : 1,
+                             __ATOMIC_RELAXED);
+
+            /* Caminho rápido: não espera o backoff do MQTT */
+            if (s_mqtt_client != NULL && !s_mqtt_connected)
+            {
+                s_mqtt_attempts = 0;
+                deadline_arm(s_deadline_mqtt, 0);
+            }
+        }
+        s_wifi_had_ip = true;
     }
 }
 
@@ -796,106 +1568,147 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
 
     switch ((esp_mqtt_event_id_t)event_id)
     {
+    case MQTT_EVENT_BEFORE_CONNECT:
+        mqtt_tls_connect_begin();
+        break;
+
     case MQTT_EVENT_CONNECTED:
         ESP_LOGI(TAG, "MQTT conectado ao broker!");
+#ifdef CONFIG_MQTT_PROTOCOL_5
+        /* Aliases da conexão anterior não valem mais */
+        mqtt_v5_on_connected();
+#endif
         s_mqtt_connected = true;
+        mqtt_tls_connect_end(true);
 
-        ESP_LOGI(TAG, "Inscrevendo-se nos tópicos do projeto...");
-        mqtt_subscribe_topic("casa/externo/luminosidade", 1);
-        mqtt_subscribe_topic("casa/sala/temperatura", 1);
+        if (s_disconnected_since_us != 0)
+        {
+            mqtt_stats_add(MQTT_STAT_TEMPO_DESCONECTADO_MS,
+                           (esp_timer_get_time() - s_disconnected_since_us) / 1000);
+            s_disconnected_since_us = 0;
+        }
+
+        s_mqtt_attempts = 0;
+        deadline_cancel(s_deadline_mqtt);
+        xEventGroupSetBits(s_conn_events, MQTT_CONNECTED_BIT);
+
+        /* Broker novo aceitou a conexão: passa a ser gravado no NVS */
+        s_broker_trial_failures = 0;
+        app_config_broker_confirmed(s_broker_uri);
+
+        /* Broker manteve a sessão criada neste boot: inscrições continuam */
+        if (MQTT_PERSISTENT_SESSION && event->session_present && s_subscribed_once)
+        {
+            ESP_LOGI(TAG, "Sessao persistente retomada, inscricoes mantidas");
+        }
+        else
+        {
+            subscribe_all();
+        }
+
+        publish_boot_info();
 
-        ESP_LOGI(TAG, "Inscrevendo-se nos tópicos padrão do sistema...");
-        mqtt_subscribe_topic(MQTT_TOPIC_COMMANDS, 1);
-        mqtt_subscribe_topic("demo/config/#", 0);
+        /* Reenvia o que foi publicado enquanto offline */
+        mqtt_offline_resume();
         break;
 
     case MQTT_EVENT_DISCONNECTED:
-        ESP_LOGW(TAG, "MQTT desconectado");
+    {
+        /* Também emitido a cada tentativa de conexão que falha */
+        mqtt_tls_connect_end(false);
+        if (s_mqtt_connected)
+        {
+            ESP_LOGW(TAG, "MQTT desconectado");
+            mqtt_stats_inc(MQTT_STAT_DESCONEXOES);
+            s_disconnected_since_us = esp_timer_get_time();
+        }
+        else if (s_wifi_has_ip && app_config_broker_pending() &&
+                 ++s_broker_trial_failures >= MQTT_BROKER_TRIAL_ATTEMPTS)
+        {
+            /* Volta ao broker anterior; on_config_changed() troca o URI */
+            app_config_broker_rejected(s_broker_uri);
+        }
         s_mqtt_connected = false;
-        s_stats.desconexoes++;
+        xEventGroupClearBits(s_conn_events, MQTT_CONNECTED_BIT);
+
+        uint32_t delay_ms = backoff_delay_ms(s_mqtt_attempts++);
+        deadline_arm(s_deadline_mqtt, delay_ms);
+        ESP_LOGI(TAG, "Reconexao MQTT em %lu ms (#%lu)",
+                 delay_ms, s_mqtt_attempts);
         break;
+    }
 
-    case MQTT_EVENT_DATA: {
-        // Bloco de escopo para VLA
-        ESP_LOGI(TAG, "Mensagem MQTT:");
-        ESP_LOGI(TAG, "  Topico: %.*s", event->topic_len, event->topic);
-        ESP_LOGI(TAG, "  Dados: %.*s", event->data_len, event->data);
-        s_stats.total_recebidas++;
-        s_stats.ultima_mensagem_ts = esp_timer_get_time() / 1000ULL;
-
-        // Copiar tópico e dados para strings terminadas em null
-        char topic[event->topic_len + 1];
-        char data[event->data_len + 1];
-        strncpy(topic, event->topic, event->topic_len);
-        topic[event->topic_len] = '\0';
-        strncpy(data, event->data, event->data_len);
-        data[event->data_len] = '\0';
-
-        // Tenta converter o dado para inteiro
-        int value = atoi(data);
-
-        // --- Lógica de Controle de Luminosidade (GPIO 18) ---
-        if (strcmp(topic, "casa/externo/luminosidade") == 0)
+    case MQTT_EVENT_SUBSCRIBED:
+        if (event->msg_id == s_subscribe_msg_id)
         {
-            if (value < 3)
-            {
-                // Acender luzes (GPIO 18 para 1)
-                gpio_set_level(GPIO_NUM_18, 1);
-                ESP_LOGI(TAG, "Luminosidade (%d < 3). Luzes (GPIO 18) ACESAS.", value);
-            }
-            else
-            {
-                // Apagar luzes (GPIO 18 para 0)
-                gpio_set_level(GPIO_NUM_18, 0);
-                ESP_LOGI(TAG, "Luminosidade (%d >= 3). Luzes (GPIO 18) APAGADAS.", value);
-            }
+            s_subscribed_once = true;
         }
+        break;
 
-        // --- Lógica de Controle de Temperatura (GPIO 19) ---
-        else if (strcmp(topic, "casa/sala/temperatura") == 0)
+    case MQTT_EVENT_DATA:
+    {
+        /* Apenas copia para a fila; o processamento ocorre na task de despacho */
+        TRACE_BEGIN(t);
+        if (event->current_data_offset == 0)
         {
-            if (value > 23)
-            {
-                // Ligar ar condicionado (GPIO 19 para 1)
-                gpio_set_level(GPIO_NUM_19, 1);
-                s_temp_low_start_time_ms = 0; // Reseta o contador de tempo
-                ESP_LOGI(TAG, "Temperatura (%d > 23). Ar Condicionado (GPIO 19) LIGADO.", value);
-            }
-            else if (value < 20)
-            {
-                // Temperatura abaixo de 20. Inicia/continua contagem.
-                if (gpio_get_level(GPIO_NUM_19) == 1) // Se o AC estiver ligado
-                {
-                    if (s_temp_low_start_time_ms == 0)
-                    {
-                        s_temp_low_start_time_ms = esp_timer_get_time() / 1000ULL;
-                        ESP_LOGW(TAG, "Temperatura (%d < 20). Iniciando contagem para desligar AC.", value);
-                    }
-                    else
-                    {
-                        // A lógica de desligamento por tempo será implementada na Fase 6
-                        ESP_LOGD(TAG, "Temperatura (%d < 20). Contagem em andamento.", value);
-                    }
-                }
-                else
-                {
-                    s_temp_low_start_time_ms = 0; // AC já está desligado
-                    ESP_LOGD(TAG, "Temperatura (%d < 20). AC já está desligado.", value);
-                }
-            }
-            else
-            {
-                // Temperatura entre 20 e 23. Reseta o contador de tempo.
-                s_temp_low_start_time_ms = 0;
-                ESP_LOGD(TAG, "Temperatura (%d entre 20 e 23). Contador de tempo resetado.", value);
-            }
+            mqtt_stats_inc(MQTT_STAT_RECEBIDAS);
+            mqtt_stats_set_last_message(esp_timer_get_time() / 1000ULL);
         }
+        mqtt_stats_add(MQTT_STAT_BYTES_RECEBIDOS, event->data_len);
 
+        if (!mqtt_inbound_post(event->topic, event->topic_len,
+                               event->data, event->data_len,
+                               event->current_data_offset,
+                               event->total_data_len))
+        {
+            mqtt_stats_inc(MQTT_STAT_DESCARTADAS_ENTRADA);
+        }
+        TRACE_END(TRACE_EVENT_DATA, t, event->data_len);
         break;
     }
 
+    case MQTT_EVENT_PUBLISHED:
+        mqtt_inflight_ack(event->msg_id);
+        break;
+
+    case MQTT_EVENT_DELETED:
+        /* Mensagem expirou no outbox sem ACK */
+        mqtt_inflight_deleted(event->msg_id);
+        break;
+
     case MQTT_EVENT_ERROR:
-        ESP_LOGE(TAG, "Erro MQTT");
+        if (event->error_handle != NULL &&
+            event->error_handle->error_type == MQTT_ERROR_TYPE_TCP_TRANSPORT)
+        {
+            /* Falhas de handshake e de certificado chegam por aqui */
+            ESP_LOGE(TAG, "Erro de transporte MQTT: %s (tls 0x%x, cert 0x%x, errno %d)",
+                     esp_err_to_name(event->error_handle->esp_tls_last_esp_err),
+                     event->error_handle->esp_tls_stack_err,
+                     event->error_handle->esp_tls_cert_verify_flags,
+                     event->error_handle->esp_transport_sock_errno);
+        }
+        else
+        {
+            ESP_LOGE(TAG, "Erro MQTT");
+        }
+
+#ifdef CONFIG_MQTT_PROTOCOL_5
+        /*
+         * Broker só 3.1.1: o CONNACK recusado chega antes do
+         * MQTT_EVENT_DISCONNECTED da mesma tentativa, que arma a próxima
+         * pelo prazo de reconexão; ela já sai em 3.1.1 e, como o broker
+         * respondeu, sem esperar o backoff acumulado
+         */
+        if (mqtt_v5_check_fallback(event))
+        {
+            s_mqtt_cfg.session.protocol_ver = MQTT_PROTOCOL_V_3_1_1;
+            if (esp_mqtt_set_config(s_mqtt_client, &s_mqtt_cfg) != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Falha ao voltar para MQTT 3.1.1");
+            }
+            s_mqtt_attempts = 0;
+        }
+#endif
         break;
 
     default:
@@ -906,128 +1719,140 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
 
 /*
  * =============================================================================
- * TASKS
+ * HANDLERS DE TÓPICOS
  * =============================================================================
  */
 
-static void telemetry_task(void *pvParameters)
+static esp_err_t register_topic_handlers(void)
 {
-    ESP_LOGI(TAG, "Task de telemetria iniciada");
-
-    telemetry_data_t data = {0};
+    esp_err_t ret = mqtt_router_init();
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
 
-    while (1)
+    /* Regras de atuação (luzes, AC): tabela do NVS ou padrão */
+    ret = rule_engine_init();
+    if (ret != ESP_OK)
     {
-        if (s_mqtt_connected)
-        {
-            data.temperatura = 20.0f + (esp_random() % 150) / 10.0f;
-            data.umidade = 40.0f + (esp_random() % 400) / 10.0f;
-            data.timestamp = esp_timer_get_time() / 1000ULL;
-            data.contador++;
+        return ret;
+    }
 
-            mqtt_publish_telemetry(&data);
+    /* Intervalos, alertas e broker: NVS ou padrão, antes dos jobs */
+    ret = app_config_init();
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    app_config_add_listener(on_config_changed, NULL);
 
-            ESP_LOGI(TAG, "Telemetria: T=%.1f°C, H=%.1f%% (#%lu)",
-                     data.temperatura, data.umidade, data.contador);
-        }
+    ret = command_processor_init();
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
 
-        vTaskDelay(pdMS_TO_TICKS(TELEMETRY_INTERVAL_MS));
+#ifdef CONFIG_TRACE_ENABLE
+    ret = mqtt_register_topic_handler(MQTT_TOPIC_TRACE_DUMP, on_trace_dump, NULL);
+    if (ret != ESP_OK)
+    {
+        return ret;
     }
+#endif
+
+    ESP_LOGI(TAG, "  Handlers de topicos registrados");
+    return ESP_OK;
 }
 
-static void health_monitoring_task(void *pvParameters)
+/*
+ * =============================================================================
+ * JOBS
+ * =============================================================================
+ */
+
+static void telemetry_job(void *ctx)
 {
-    ESP_LOGI(TAG, "Task de health monitoring iniciada");
+    static telemetry_data_t data = {0};
+    sensor_reading_t reading;
 
-    while (1)
-    {
-        vTaskDelay(pdMS_TO_TICKS(HEALTH_CHECK_INTERVAL_MS));
+    /* Idade do lote conferida a cada rodada, mesmo sem amostra nova */
+    telemetry_batch_result(mqtt_batch_poll(&s_telemetry_batch));
 
-        if (s_mqtt_connected)
-        {
-            mqtt_publish_health_check();
+    esp_err_t ret = sensor_adc_get(&reading);
+
+    /* Modo baixo consumo: dispara a rajada usada na próxima amostra */
+    sensor_adc_request();
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Sem leitura do ADC, amostra de telemetria ignorada");
+        return;
+    }
 
-            health_status_t health;
-            mqtt_get_health_status(&health);
+    /* Sem conexão, a amostra vai para o buffer offline */
+    data.temperatura = reading.temperatura_centi / 100.0f;
+    data.umidade = 40.0f + (esp_random() % 400) / 10.0f; /* Sem sensor: simulada */
+    data.timestamp = reading.timestamp_us / 1000ULL;
+    data.contador++;
 
-            ESP_LOGI(TAG, "Health: Heap=%lu bytes, RSSI=%d dBm",
-                     health.free_heap, health.wifi_rssi);
+    int ret_pub = mqtt_publish_telemetry(&data);
 
-            if (health.free_heap < 20000)
-            {
-                ESP_LOGW(TAG, "Memoria baixa!");
-            }
-        }
+    if (__atomic_exchange_n(&s_telemetry_flush_requested, false, __ATOMIC_RELAXED))
+    {
+        mqtt_flush_telemetry();
     }
+
+    ESP_LOGI(TAG, "Telemetria: T=%.1f°C, H=%.1f%% (#%lu)%s",
+             data.temperatura, data.umidade, data.contador,
+             ret_pub == MQTT_PUBLISH_SUPPRESSED ? " [sem mudanca]" : "");
 }
 
-static void ac_monitor_task(void *pvParameters)
+static void health_monitoring_job(void *ctx)
 {
-    ESP_LOGI(TAG, "Task de monitoramento do AC iniciada");
-
-    const uint64_t TEN_MINUTES_MS = 10 * 60 * 1000; // 10 minutos em milissegundos
+    /* Pedido remoto: mesmas mensagens, janelas periódicas intactas */
+    bool periodic = !__atomic_exchange_n(&s_health_on_demand, false, __ATOMIC_RELAXED);
 
-    while (1)
+    if (!s_mqtt_connected)
     {
-        // Verifica a cada 10 segundos
-        vTaskDelay(pdMS_TO_TICKS(10000));
+        return;
+    }
 
-        // Verifica se o AC está ligado (GPIO 19 == 1)
-        if (gpio_get_level(GPIO_NUM_19) == 1)
-        {
-            // Verifica se a contagem de tempo de temperatura baixa foi iniciada
-            if (s_temp_low_start_time_ms > 0)
-            {
-                uint64_t current_time_ms = esp_timer_get_time() / 1000ULL;
-                uint64_t elapsed_time_ms = current_time_ms - s_temp_low_start_time_ms;
-
-                if (elapsed_time_ms >= TEN_MINUTES_MS)
-                {
-                    // Desliga o ar condicionado (GPIO 19 para 0)
-                    gpio_set_level(GPIO_NUM_19, 0);
-                    s_temp_low_start_time_ms = 0; // Reseta o contador
-                    ESP_LOGW(TAG, "AC DESLIGADO: Temperatura abaixo de 20 por 10 minutos.");
-                }
-                else
-                {
-                    uint64_t remaining_sec = (TEN_MINUTES_MS - elapsed_time_ms) / 1000;
-                    ESP_LOGD(TAG, "AC LIGADO: Temp baixa por %llu segundos. Desliga em %llu segundos.",
-                             elapsed_time_ms / 1000, remaining_sec);
-                }
-            }
-            else
-            {
-                ESP_LOGD(TAG, "AC LIGADO: Temperatura OK ou contagem não iniciada.");
-            }
-        }
-        else
-        {
-            // AC está desligado, garante que o contador está zerado
-            s_temp_low_start_time_ms = 0;
-            ESP_LOGD(TAG, "AC DESLIGADO: Monitoramento inativo.");
-        }
+    publish_health(periodic);
+    publish_cpu_report(periodic);
+#ifdef CONFIG_TRACE_ENABLE
+    publish_trace_summary();
+#endif
+
+    health_status_t health;
+    mqtt_get_health_status(&health);
+
+    ESP_LOGI(TAG, "Health: Heap=%lu bytes, RSSI=%d dBm, Corrente~%lu uA",
+             health.free_heap, health.wifi_rssi, health.corrente_estimada_ua);
+
+    app_config_t cfg;
+    app_config_get(&cfg);
+
+    if (health.free_heap < cfg.heap_low_bytes)
+    {
+        ESP_LOGW(TAG, "Memoria baixa!");
     }
 }
 
-static void wifi_watchdog_task(void *pvParameters)
+static void wifi_watchdog_job(void *ctx)
 {
-    ESP_LOGI(TAG, "Task de WiFi watchdog iniciada");
-
     wifi_ap_record_t ap_info;
 
-    while (1)
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK)
     {
-        vTaskDelay(pdMS_TO_TICKS(WIFI_WATCHDOG_INTERVAL_MS));
-
-        if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK)
+        /* O backoff já agenda as tentativas; só age se nenhuma estiver pendente */
+        if (!deadline_is_armed(s_deadline_wifi))
         {
             ESP_LOGW(TAG, "WiFi desconectado, reconectando...");
-            s_wifi_retry_num = 0;
             esp_wifi_connect();
         }
-        else
-        {
-            ESP_LOGD(TAG, "WiFi OK - RSSI: %d dBm", ap_info.rssi);
-        }
+    }
+    else
+    {
+        ESP_LOGD(TAG, "WiFi OK - RSSI: %d dBm", ap_info.rssi);
     }
 }
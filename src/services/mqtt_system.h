@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "mqtt_router.h"
 
 /*
  * =============================================================================
@@ -62,22 +63,102 @@
 #define MQTT_KEEPALIVE_SEC 60				 ///< Intervalo de keep-alive MQTT
 #define MQTT_BUFFER_SIZE 2048				 ///< Tamanho do buffer MQTT
 #define MQTT_TIMEOUT_MS 10000				 ///< Timeout de operações MQTT
-#define WIFI_MAX_RETRY 5					 ///< Tentativas de reconexão WiFi
 #define TELEMETRY_INTERVAL_MS 10000		 ///< Intervalo de telemetria
+#ifdef CONFIG_DEEP_SLEEP_MODE
+/* Um lote por ciclo de publicação do deep sleep (ver sleep_cycle.h) */
+#define TELEMETRY_BATCH_MAX_SAMPLES 24		 ///< Amostras agregadas por publicação
+#else
+#define TELEMETRY_BATCH_MAX_SAMPLES 6		 ///< Amostras agregadas por publicação
+#endif
+#define TELEMETRY_BATCH_MAX_BYTES 512		 ///< Payload máximo de um lote de telemetria
+#define TELEMETRY_BATCH_MAX_AGE_MS 60000	 ///< Idade máxima da amostra mais antiga do lote
+#ifdef CONFIG_DEEP_SLEEP_MODE
+/* 24 registros de PAYLOAD_PACKED_TELEMETRY_SIZE cabem num lote de 512 bytes */
+#define MQTT_PAYLOAD_FORMAT_DEFAULT MQTT_PAYLOAD_FORMAT_PACKED ///< Formato de telemetria/health
+#else
+#define MQTT_PAYLOAD_FORMAT_DEFAULT MQTT_PAYLOAD_FORMAT_JSON ///< Formato de telemetria/health
+#endif
 #define HEALTH_CHECK_INTERVAL_MS 60000	 ///< Intervalo de health check
 #define WIFI_WATCHDOG_INTERVAL_MS 30000 ///< Intervalo de verificação WiFi
 
+/* Publicação por mudança (ver report_policy.h) */
+#define REPORT_POLICY_MAX_TOPICS 8			 ///< Tópicos com política
+#define REPORT_POLICY_MAX_VALUES 2			 ///< Valores avaliados por amostra
+#define TELEMETRY_DEADBAND_TEMP_C 0.2f		 ///< Variação mínima de temperatura
+#define TELEMETRY_DEADBAND_UMIDADE 1.0f	 ///< Variação mínima de umidade (%)
+#define TELEMETRY_HEARTBEAT_MS 900000		 ///< Telemetria forçada sem mudança (15 min)
+
+/** Retorno das funções de publicação quando a política suprimiu o envio */
+#define MQTT_PUBLISH_SUPPRESSED (-2)
+
+/* Sessão e reconexão */
+#define MQTT_PERSISTENT_SESSION 1			 ///< Sessão persistente (clean session desligado)
+#define MQTT_SUBSCRIBE_MAX_FILTERS 12		 ///< Filtros no SUBSCRIBE da conexão
+#define RECONNECT_BACKOFF_MIN_MS 500		 ///< Primeira espera de reconexão (WiFi e MQTT)
+#define RECONNECT_BACKOFF_MAX_MS 60000		 ///< Teto da espera de reconexão
+#define MQTT_BROKER_TRIAL_ATTEMPTS 5		 ///< Falhas num broker novo antes de voltar ao anterior
+#define MQTT_LOCAL_LOOPBACK 1				 ///< Publicações entregues também aos handlers locais
+
+/* Prazos one-shot compartilhando um esp_timer (ver deadline.h) */
+#define DEADLINE_MAX_SLOTS 16				 ///< Prazos registráveis
+
+/* Escalonador de jobs periódicos (task de trabalho em rtos_config.h) */
+#define JOB_SCHEDULER_MAX_JOBS 12			 ///< Jobs registráveis
+
+/* Fila de entrada das mensagens recebidas (task de despacho em rtos_config.h) */
+#define MQTT_INBOUND_QUEUE_SLOTS 8						///< Slots pré-alocados na fila
+#define MQTT_INBOUND_TOPIC_MAX_LEN 128					///< Tópico máximo por slot
+#define MQTT_INBOUND_DATA_MAX_LEN (MQTT_BUFFER_SIZE / 4) ///< Payload máximo por slot
+
+/* Buffer store-and-forward para publicações feitas sem conexão */
+#define MQTT_OFFLINE_RAM_SLOTS 12				///< Mensagens mantidas em RAM
+#define MQTT_OFFLINE_NVS_MAX_ENTRIES 12		///< Mensagens transferidas para a NVS
+#define MQTT_OFFLINE_NVS_BUDGET_BYTES 8192		///< Teto do anel na NVS (pior caso, ver mqtt_offline.h)
+#define MQTT_OFFLINE_TOPIC_MAX_LEN 64			///< Tópico máximo armazenado
+#define MQTT_OFFLINE_DATA_MAX_LEN TELEMETRY_BATCH_MAX_BYTES ///< Payload máximo armazenado
+#define MQTT_OFFLINE_DRAIN_BATCH 5				///< Mensagens reenviadas por rodada
+#define MQTT_OFFLINE_DRAIN_INTERVAL_MS 1000	///< Intervalo entre rodadas de reenvio
+
+/* Orçamento do outbox do esp-mqtt por classe de prioridade (ver mqtt_outbox.h) */
+#ifndef CONFIG_MQTT_OUTBOX_BUDGET_BYTES
+#define CONFIG_MQTT_OUTBOX_BUDGET_BYTES 16384
+#endif
+#define MQTT_OUTBOX_BUDGET_BYTES CONFIG_MQTT_OUTBOX_BUDGET_BYTES ///< Teto do outbox (bytes)
+#define MQTT_OUTBOX_SHARE_TELEMETRY_PCT 75		///< Parte do orçamento para telemetria
+#define MQTT_OUTBOX_SHARE_CUSTOM_PCT 50			///< Parte do orçamento para custom
+
+/* Estatísticas */
+#define MQTT_STATS_LATENCY_BUCKETS 8 ///< Faixas do histograma de latência de publicação
+
+/* Rastreamento de publicações QoS 1/2 até o ACK do broker */
+#define MQTT_INFLIGHT_SLOTS 16					   ///< Publicações rastreadas simultaneamente
+#define MQTT_INFLIGHT_TIMEOUT_MS MQTT_TIMEOUT_MS	   ///< Sem ACK após este tempo = timeout
+#define MQTT_INFLIGHT_LATENCY_BUCKETS 16		   ///< Faixas do histograma de latência de ACK
+
 /*
  * =============================================================================
  * TIPOS E ESTRUTURAS PÚBLICAS
  * =============================================================================
  */
 
+/**
+ * @brief Classes de prioridade das publicações QoS 1/2 (ver mqtt_outbox.h)
+ */
+typedef enum
+{
+	MQTT_PRIORITY_CRITICAL = 0, ///< Status, alertas, boot e respostas de comandos
+	MQTT_PRIORITY_TELEMETRY,	///< Demais tópicos de MQTT_TOPIC_BASE
+	MQTT_PRIORITY_CUSTOM,		///< Tópicos fora de MQTT_TOPIC_BASE
+	MQTT_PRIORITY_COUNT
+} mqtt_priority_t;
+
 /**
  * @brief Estrutura de estatísticas MQTT
  *
  * Mantém contadores e métricas sobre o funcionamento do sistema MQTT
- * para monitoramento e debug.
+ * para monitoramento e debug. É um snapshot dos contadores atômicos de
+ * mqtt_stats.h; os contadores dão a volta em 2^32. Os campos ack_* cobrem
+ * a janela desde o último health check (ver mqtt_inflight.h).
  */
 typedef struct
 {
@@ -87,6 +168,29 @@ typedef struct
 	uint32_t desconexoes;			  ///< Contador de desconexões MQTT
 	uint32_t tempo_desconectado_ms; ///< Tempo total desconectado (ms)
 	uint32_t ultima_mensagem_ts;	  ///< Timestamp da última mensagem (ms)
+	uint32_t descartadas_entrada;	  ///< Recebidas descartadas (fila cheia/grande demais)
+	uint32_t suprimidas;			  ///< Publicações evitadas pela política de deadband
+	uint32_t fila_offline;			  ///< Publicações aguardando reconexão (RAM + NVS)
+	uint32_t descartadas_offline;	  ///< Publicações offline perdidas por falta de espaço
+	uint32_t bytes_enviados;		  ///< Bytes de payload publicados
+	uint32_t bytes_recebidos;		  ///< Bytes de payload recebidos
+	uint32_t latencia_hist[MQTT_STATS_LATENCY_BUCKETS]; ///< Publicações por faixa de latência
+	uint32_t latencia_max_us;		  ///< Maior latência de publicação (us)
+	uint32_t hwm_fila_entrada;		  ///< Maior ocupação da fila de entrada (slots)
+	uint32_t hwm_fila_offline;		  ///< Maior ocupação do buffer offline (mensagens)
+	uint32_t hwm_outbox_bytes;		  ///< Maior ocupação do outbox do cliente (bytes)
+	uint32_t descartadas_outbox[MQTT_PRIORITY_COUNT]; ///< Recusadas pelo orçamento do outbox, por classe
+	uint32_t em_voo;				  ///< Publicações QoS 1/2 aguardando ACK
+	uint32_t ack_amostras;			  ///< ACKs recebidos na janela atual
+	uint32_t ack_min_us;			  ///< Menor latência publicação->ACK na janela (us)
+	uint32_t ack_avg_us;			  ///< Latência média publicação->ACK na janela (us)
+	uint32_t ack_p99_us;			  ///< Percentil 99 da latência na janela (us)
+	uint32_t ack_timeouts;			  ///< Publicações sem ACK na janela
+	uint32_t ttfp_ultimo_ms;		  ///< Da recuperação do WiFi à 1ª publicação (última, ms)
+	uint32_t ttfp_max_ms;			  ///< Maior tempo até a 1ª publicação após recuperação (ms)
+	uint32_t conexao_ultima_ms;	  ///< Duração da última conexão ao broker (TCP + TLS + CONNECT, ms)
+	uint32_t conexao_max_ms;		  ///< Maior duração de conexão desde o boot (ms)
+	uint32_t conexao_heap_pico;	  ///< Heap consumido no pico da última conexão (bytes)
 } mqtt_statistics_t;
 
 /**
@@ -101,6 +205,28 @@ typedef enum
 	MQTT_QOS_2 = 2	 ///< Exactly once - handshake completo
 } mqtt_qos_level_t;
 
+/**
+ * @brief Filtro para inscrição em lote (mqtt_subscribe_topics)
+ */
+typedef struct
+{
+	const char *topic; ///< Filtro de tópico (deve permanecer válido na chamada)
+	int qos;		   ///< Nível de QoS desejado
+} mqtt_subscription_t;
+
+/**
+ * @brief Formatos de payload para telemetria e health check
+ *
+ * Os tópicos são os mesmos em todos os formatos, com um sufixo que
+ * identifica o tipo de conteúdo. Esquemas em payload_codec.h.
+ */
+typedef enum
+{
+	MQTT_PAYLOAD_FORMAT_JSON = 0,	///< JSON (sem sufixo no tópico)
+	MQTT_PAYLOAD_FORMAT_CBOR = 1,	///< CBOR, tópico com sufixo "/cbor"
+	MQTT_PAYLOAD_FORMAT_PACKED = 2 ///< Registro binário fixo, sufixo "/bin"
+} mqtt_payload_format_t;
+
 /**
  * @brief Estrutura de dados de telemetria
  *
@@ -126,6 +252,8 @@ typedef struct
 	int wifi_rssi;				///< Força do sinal WiFi (dBm)
 	uint64_t uptime_sec;		///< Tempo desde boot (segundos)
 	bool mqtt_connected;		///< Status da conexão MQTT
+	uint8_t power_mode;		///< Modo de energia (power_mode_t)
+	uint32_t corrente_estimada_ua; ///< Corrente média estimada (uA)
 } health_status_t;
 
 /*
@@ -138,14 +266,18 @@ typedef struct
  * @brief Inicializa todo o sistema IoT MQTT
  *
  * Esta função orquestra a inicialização completa do sistema:
- * - Subsistemas base (NVS, netif, event loop)
- * - WiFi (configuração e conexão)
- * - Cliente MQTT (criação e conexão)
- * - Tasks da aplicação (telemetria, health, watchdog)
+ * - Subsistemas base (NVS, ADC, netif, event loop, regras locais)
+ * - WiFi (configuração; a conexão segue em segundo plano)
+ * - Cliente MQTT (criação; iniciado no primeiro IP obtido)
+ * - Jobs periódicos (telemetria, health, watchdog) no job_scheduler
  *
- * @return ESP_OK em sucesso, código de erro caso contrário
+ * Não espera pela rede: retorna assim que os subsistemas estão prontos.
+ * Status online e informações de boot são publicados ao conectar ao
+ * broker; quem precisar da conexão usa mqtt_system_wait_connected().
+ *
+ * @return ESP_OK em sucesso, código de erro caso contrário (falhas de
+ *         conexão não são erro de inicialização)
  *
- * @note Esta função bloqueia até WiFi conectar ou timeout
  * @warning Deve ser chamada apenas uma vez durante inicialização
  */
 esp_err_t mqtt_system_init(void);
@@ -167,6 +299,46 @@ esp_err_t mqtt_system_shutdown(void);
  */
 bool mqtt_system_is_connected(void);
 
+/**
+ * @brief Aguarda a conexão com o broker
+ *
+ * @param timeout_ms Espera máxima (ms)
+ *
+ * @return ESP_OK se conectado, ESP_ERR_TIMEOUT, ou ESP_ERR_INVALID_STATE
+ *         antes de mqtt_system_init()
+ */
+esp_err_t mqtt_system_wait_connected(uint32_t timeout_ms);
+
+#ifdef CONFIG_BENCHMARK_MODE
+/**
+ * @brief Substituto do esp_mqtt_client_publish() no benchmark
+ *
+ * @return msg_id (>= 0) ou -1
+ */
+typedef int (*mqtt_bench_publish_fn_t)(const char *topic, const char *data,
+									   int len, int qos, bool retain);
+
+/**
+ * @brief Inicializa os subsistemas base com um cliente MQTT substituto
+ *
+ * Sobe o mesmo caminho de publicação e recepção de mqtt_system_init()
+ * (buffer offline, lote, router, regras, fila de entrada), sem WiFi,
+ * broker nem jobs periódicos, e o considera conectado. As publicações
+ * terminam em publish.
+ *
+ * @return ESP_OK, ou o erro da inicialização dos subsistemas
+ */
+esp_err_t mqtt_system_bench_init(mqtt_bench_publish_fn_t publish);
+
+/**
+ * @brief Entrega um evento sintético ao handler de eventos do esp-mqtt
+ *
+ * @param event_id   esp_mqtt_event_id_t
+ * @param event_data esp_mqtt_event_t preenchido pelo chamador
+ */
+void mqtt_system_bench_event(int32_t event_id, void *event_data);
+#endif
+
 /*
  * =============================================================================
  * FUNÇÕES PÚBLICAS - PUBLICAÇÃO DE DADOS
@@ -185,9 +357,15 @@ bool mqtt_system_is_connected(void);
  * @param qos    Nível de QoS (0, 1, ou 2)
  * @param retain Se true, broker mantém última mensagem para novos subscribers
  *
- * @return ID da mensagem (>= 0) em sucesso, -1 em erro
+ * @return ID da mensagem (>= 0) em sucesso, 0 se armazenada para envio
+ *         posterior, -1 em erro
  *
- * @note Se MQTT não estiver conectado, retorna erro
+ * @note Se MQTT não estiver conectado (ou ainda houver mensagens antigas
+ *       pendentes), a mensagem vai para o buffer offline e é reenviada
+ *       em ordem na reconexão
+ * @note Com MQTT_LOCAL_LOOPBACK, handlers registrados no mqtt_router para
+ *       o tópico são chamados antes, nesta task, mesmo sem conexão (ver
+ *       mqtt_router.h)
  */
 int mqtt_publish_data(const char *topic, const char *data,
 							 int len, int qos, bool retain);
@@ -195,15 +373,86 @@ int mqtt_publish_data(const char *topic, const char *data,
 /**
  * @brief Publica dados de telemetria estruturados
  *
- * Converte estrutura telemetry_data_t em JSON e publica no tópico
- * padrão de telemetria.
+ * Converte estrutura telemetry_data_t em JSON e acrescenta ao lote de
+ * telemetria. O lote é publicado como um array JSON no tópico padrão de
+ * telemetria ao atingir TELEMETRY_BATCH_MAX_SAMPLES amostras,
+ * TELEMETRY_BATCH_MAX_BYTES bytes ou TELEMETRY_BATCH_MAX_AGE_MS de idade.
+ * A idade é conferida também a cada rodada do job de telemetria, com ou
+ * sem amostra nova; com telemetry_interval_ms acima de
+ * TELEMETRY_BATCH_MAX_AGE_MS o lote sai na rodada seguinte.
+ *
+ * A amostra passa antes pela política de deadband do tópico de telemetria
+ * (TELEMETRY_DEADBAND_*, TELEMETRY_HEARTBEAT_MS); uma amostra suprimida
+ * ainda confere a idade do lote acumulado. Se a publicação de um lote
+ * falhar, aqui ou em mqtt_flush_telemetry(), a referência da política é
+ * descartada e a próxima amostra é publicada.
  *
  * @param data Estrutura com dados de telemetria
  *
- * @return ID da mensagem (>= 0) em sucesso, -1 em erro
+ * @return ID da mensagem (>= 0) se o lote foi publicado, 0 se a amostra
+ *         apenas foi acumulada, MQTT_PUBLISH_SUPPRESSED se não mudou o
+ *         suficiente, -1 em erro
  */
 int mqtt_publish_telemetry(const telemetry_data_t *data);
 
+/**
+ * @brief Publica amostras já coletadas de uma vez, sem deadband
+ *
+ * As amostras são acrescentadas ao lote de telemetria (dividido apenas
+ * se excederem TELEMETRY_BATCH_MAX_SAMPLES ou TELEMETRY_BATCH_MAX_BYTES)
+ * e o lote é publicado em seguida. Usada pelo ciclo de deep sleep, em que
+ * cada amostra guardada deve chegar ao broker.
+ *
+ * @param samples Amostras em ordem cronológica
+ * @param count   Quantidade
+ *
+ * @return ID da última publicação (>= 0; 0 se não havia amostras), -1 em erro
+ */
+int mqtt_publish_telemetry_samples(const telemetry_data_t *samples, int count);
+
+/**
+ * @brief Publica um valor numérico simples, consultando a política do tópico
+ *
+ * O payload é o número em texto (ex.: "23" ou "23.50"). Se o tópico tiver
+ * política registrada (report_policy_register) e o valor não tiver mudado
+ * o suficiente, nada é enviado.
+ *
+ * @param topic    Tópico
+ * @param value    Valor
+ * @param decimals Casas decimais no payload (0 = inteiro)
+ * @param qos      Nível de QoS
+ * @param retain   Flag de retain
+ *
+ * @return Como mqtt_publish_data(), ou MQTT_PUBLISH_SUPPRESSED
+ */
+int mqtt_publish_value(const char *topic, float value, int decimals,
+					   int qos, bool retain);
+
+/**
+ * @brief Seleciona o formato de payload de telemetria e health check
+ *
+ * Amostras de telemetria já acumuladas são publicadas no formato anterior
+ * antes da troca.
+ *
+ * @param format Novo formato
+ *
+ * @return ESP_OK em sucesso, ESP_ERR_INVALID_ARG se o formato for inválido
+ */
+esp_err_t mqtt_set_payload_format(mqtt_payload_format_t format);
+
+/**
+ * @brief Retorna o formato de payload em uso
+ */
+mqtt_payload_format_t mqtt_get_payload_format(void);
+
+/**
+ * @brief Publica imediatamente as amostras de telemetria acumuladas
+ *
+ * @return ID da mensagem (>= 0) em sucesso, 0 se não havia amostras,
+ *         -1 em erro
+ */
+int mqtt_flush_telemetry(void);
+
 /**
  * @brief Publica health check do sistema
  *
@@ -214,6 +463,41 @@ int mqtt_publish_telemetry(const telemetry_data_t *data);
  */
 int mqtt_publish_health_check(void);
 
+/**
+ * @brief Publica a carga por core e das tasks mais ativas
+ *
+ * Publicado em MQTT_TOPIC_HEALTH "/cpu" (sempre JSON), cobrindo o
+ * intervalo desde a publicação anterior (ver rtos_config.h).
+ *
+ * @return ID da mensagem (>= 0) em sucesso, -1 em erro ou sem
+ *         estatísticas de tempo de execução no sdkconfig
+ *
+ * @note Fecha a janela de medição; fora do job de health, use
+ *       mqtt_request_health()
+ */
+int mqtt_publish_cpu_report(void);
+
+/**
+ * @brief Antecipa o job de telemetria: nova amostra e envio do lote
+ *
+ * A publicação ocorre no JobWorker, não na task que chama.
+ *
+ * @return ESP_OK, ou ESP_ERR_INVALID_ARG se o job não existe (deep sleep)
+ */
+esp_err_t mqtt_request_telemetry(void);
+
+/**
+ * @brief Antecipa o job de health: health check, carga de CPU e, com
+ *        CONFIG_TRACE_ENABLE, o resumo de trace
+ *
+ * A publicação ocorre no JobWorker, único chamador de rtos_cpu_report().
+ * A execução antecipada não fecha as janelas de latência de ACK nem de
+ * carga de CPU: o relatório seguinte do período continua completo.
+ *
+ * @return ESP_OK, ou ESP_ERR_INVALID_ARG se o job não existe (deep sleep)
+ */
+esp_err_t mqtt_request_health(void);
+
 /**
  * @brief Publica mensagem de status (online/offline)
  *
@@ -239,6 +523,18 @@ int mqtt_publish_status(bool online);
  */
 int mqtt_subscribe_topic(const char *topic, int qos);
 
+/**
+ * @brief Subscreve em vários tópicos com um único pacote SUBSCRIBE
+ *
+ * Uma ida e volta ao broker em vez de uma por tópico.
+ *
+ * @param subs  Filtros e QoS
+ * @param count Quantidade de filtros
+ *
+ * @return ID da mensagem (>= 0) em sucesso, -1 em erro
+ */
+int mqtt_subscribe_topics(const mqtt_subscription_t *subs, int count);
+
 /**
  * @brief Cancela subscrição em um tópico
  *
@@ -257,6 +553,8 @@ int mqtt_unsubscribe_topic(const char *topic);
 /**
  * @brief Obtém estatísticas atuais do sistema MQTT
  *
+ * Não bloqueia as tasks que publicam; pode ser chamada de qualquer task.
+ *
  * @param stats Ponteiro para estrutura onde copiar estatísticas
  *
  * @return ESP_OK em sucesso, ESP_ERR_INVALID_ARG se stats é NULL
@@ -305,10 +603,10 @@ void mqtt_print_statistics(void);
 /** Tópico de health check */
 #define MQTT_TOPIC_HEALTH MQTT_TOPIC_BASE "/health"
 
-/** Tópico de comandos recebidos */
+/** Tópico de comandos recebidos (ver command_processor.h) */
 #define MQTT_TOPIC_COMMANDS MQTT_TOPIC_BASE "/comandos"
 
-/** Tópico de configuração */
+/** Raiz dos tópicos de configuração (app_config, rule_engine) */
 #define MQTT_TOPIC_CONFIG MQTT_TOPIC_BASE "/config"
 
 /** Tópico de boot/informações iniciais */
@@ -317,4 +615,19 @@ void mqtt_print_statistics(void);
 /** Tópico de alertas/erros */
 #define MQTT_TOPIC_ALERTS MQTT_TOPIC_BASE "/alertas"
 
+/** Tópico de diagnóstico */
+#define MQTT_TOPIC_DIAG MQTT_TOPIC_BASE "/diag"
+
+/** Resumo dos pontos de trace e das stacks (CONFIG_TRACE_ENABLE, ver trace.h) */
+#define MQTT_TOPIC_TRACE MQTT_TOPIC_DIAG "/trace"
+
+/** Pedido de dump dos anéis de trace no log (CONFIG_TRACE_ENABLE) */
+#define MQTT_TOPIC_TRACE_DUMP MQTT_TOPIC_DIAG "/trace/dump"
+
+/** Tópico do sensor de luminosidade externa (regra padrão: luzes no GPIO 18) */
+#define MQTT_TOPIC_LUMINOSIDADE "casa/externo/luminosidade"
+
+/** Tópico do sensor de temperatura da sala (regra padrão: AC no GPIO 19) */
+#define MQTT_TOPIC_TEMPERATURA "casa/sala/temperatura"
+
 #endif /* MQTT_SYSTEM_H */
\ No newline at end of file
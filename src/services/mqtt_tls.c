@@ -0,0 +1,203 @@
+/**
+ * @file mqtt_tls.c
+ * @brief TLS da conexão MQTT e medição do custo de cada conexão - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "mqtt_tls.h"
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_crt_bundle.h"
+#ifdef CONFIG_MQTT_TLS_PSK
+#include "esp_tls.h"
+#endif
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "MQTT_TLS";
+
+#ifdef CONFIG_MQTT_TLS_PSK
+#ifndef CONFIG_ESP_TLS_PSK_VERIFICATION
+#error "CONFIG_MQTT_TLS_PSK exige CONFIG_ESP_TLS_PSK_VERIFICATION no sdkconfig"
+#endif
+#if !defined(CONFIG_MQTT_TLS_PSK_IDENTITY) || !defined(CONFIG_MQTT_TLS_PSK_KEY)
+#error "CONFIG_MQTT_TLS_PSK exige CONFIG_MQTT_TLS_PSK_IDENTITY e CONFIG_MQTT_TLS_PSK_KEY"
+#endif
+
+/** Bytes da chave (o sizeof do literal conta o terminador) */
+#define PSK_KEY_LEN ((sizeof(CONFIG_MQTT_TLS_PSK_KEY) - 1) / 2)
+
+_Static_assert(PSK_KEY_LEN > 0 && PSK_KEY_LEN <= MQTT_TLS_PSK_MAX_KEY_LEN,
+               "CONFIG_MQTT_TLS_PSK_KEY fora do tamanho aceito");
+#endif
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+#ifdef CONFIG_MQTT_TLS_PSK
+/** O cliente guarda o ponteiro: chave e dica vivem enquanto ele existir */
+static uint8_t s_psk_key[PSK_KEY_LEN];
+static const psk_hint_key_t s_psk = {
+    .key = s_psk_key,
+    .key_size = PSK_KEY_LEN,
+    .hint = CONFIG_MQTT_TLS_PSK_IDENTITY,
+};
+#endif
+
+/** Tentativa em curso (task do esp-mqtt) */
+static bool s_connecting = false;
+static int64_t s_connect_start_us = 0;
+static uint32_t s_heap_before = 0;
+
+/** Medições lidas pelo health check em outra task */
+static uint32_t s_connect_last_ms = 0;
+static uint32_t s_connect_max_ms = 0;
+static uint32_t s_connect_heap_peak = 0;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+#ifdef CONFIG_MQTT_TLS_PSK
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static bool decode_psk_key(void)
+{
+    const char *hex = CONFIG_MQTT_TLS_PSK_KEY;
+
+    if (strlen(hex) != PSK_KEY_LEN * 2)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < PSK_KEY_LEN; i++)
+    {
+        int hi = hex_value(hex[2 * i]);
+        int lo = hex_value(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0)
+        {
+            return false;
+        }
+        s_psk_key[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return true;
+}
+#endif
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t mqtt_tls_configure(esp_mqtt_client_config_t *cfg)
+{
+#ifdef CONFIG_MQTT_TLS_PSK
+    if (!decode_psk_key())
+    {
+        ESP_LOGE(TAG, "CONFIG_MQTT_TLS_PSK_KEY invalida (hexadecimal, %d bytes)",
+                 (int)PSK_KEY_LEN);
+        return ESP_ERR_INVALID_ARG;
+    }
+    cfg->broker.verification.psk_hint_key = &s_psk;
+    ESP_LOGI(TAG, "  TLS com chave pre-compartilhada (identidade '%s')",
+             CONFIG_MQTT_TLS_PSK_IDENTITY);
+#else
+    cfg->broker.verification.crt_bundle_attach = esp_crt_bundle_attach;
+    ESP_LOGI(TAG, "  TLS verificado pelo bundle de certificados");
+#endif
+
+    ESP_LOGI(TAG, "  Transporte: %s",
+             mqtt_tls_uri_is_secure(cfg->broker.address.uri) ? "TLS" : "TCP");
+    return ESP_OK;
+}
+
+bool mqtt_tls_uri_is_secure(const char *uri)
+{
+    return uri != NULL && strncmp(uri, "mqtts://", 8) == 0;
+}
+
+void mqtt_tls_connect_begin(void)
+{
+    /* Mínimo local: o global guarda o pior momento desde o boot */
+    if (s_connecting)
+    {
+        heap_caps_monitor_local_minimum_free_size_stop();
+    }
+
+    s_heap_before = esp_get_free_heap_size();
+    heap_caps_monitor_local_minimum_free_size_start();
+    s_connect_start_us = esp_timer_get_time();
+    s_connecting = true;
+}
+
+void mqtt_tls_connect_end(bool connected)
+{
+    if (!s_connecting)
+    {
+        return;
+    }
+    s_connecting = false;
+
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - s_connect_start_us) / 1000);
+    uint32_t min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    heap_caps_monitor_local_minimum_free_size_stop();
+
+    if (!connected)
+    {
+        return;
+    }
+
+    uint32_t peak = s_heap_before > min_free ? s_heap_before - min_free : 0;
+
+    __atomic_store_n(&s_connect_last_ms, elapsed_ms, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_connect_heap_peak, peak, __ATOMIC_RELAXED);
+    if (elapsed_ms > __atomic_load_n(&s_connect_max_ms, __ATOMIC_RELAXED))
+    {
+        __atomic_store_n(&s_connect_max_ms, elapsed_ms, __ATOMIC_RELAXED);
+    }
+
+    ESP_LOGI(TAG, "Conexao em %lu ms, pico de heap %lu bytes", elapsed_ms, peak);
+}
+
+void mqtt_tls_snapshot(mqtt_statistics_t *stats)
+{
+    stats->conexao_ultima_ms = __atomic_load_n(&s_connect_last_ms, __ATOMIC_RELAXED);
+    stats->conexao_max_ms = __atomic_load_n(&s_connect_max_ms, __ATOMIC_RELAXED);
+    stats->conexao_heap_pico = __atomic_load_n(&s_connect_heap_peak, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file mqtt_tls.h
+ * @brief TLS da conexão MQTT e medição do custo de cada conexão
+ *
+ * O URI do broker escolhe o transporte: "mqtt://" (TCP, porta 1883) ou
+ * "mqtts://" (TLS, porta 8883). A verificação do servidor é configurada
+ * sempre, então trocar de broker pelo app_config de um esquema para o
+ * outro não exige reboot:
+ *
+ * - padrão: bundle de certificados raiz do ESP-IDF (esp_crt_bundle), lido
+ *   direto da flash; o subconjunto comum (CONFIG_MBEDTLS_CERTIFICATE_
+ *   BUNDLE_DEFAULT_CMN) cobre os brokers públicos e encurta a busca;
+ * - CONFIG_MQTT_TLS_PSK: chave pré-compartilhada, sem certificados (sem
+ *   X.509 nem assinatura no handshake). Exige CONFIG_ESP_TLS_PSK_VERIFICATION
+ *   no sdkconfig e, nas build_flags,
+ *     -DCONFIG_MQTT_TLS_PSK_IDENTITY=\"<identidade>\"
+ *     -DCONFIG_MQTT_TLS_PSK_KEY=\"<chave em hexadecimal>\"
+ *
+ * Cada handshake custa centenas de ms e dezenas de KB de heap; o caminho
+ * barato é não repetir handshakes: sessão MQTT persistente, reconexão só
+ * com backoff (mqtt_system.h) e keepalive MQTT mantendo o link. No
+ * sdkconfig, os buffers do mbedTLS são alocados só durante o uso
+ * (CONFIG_MBEDTLS_DYNAMIC_BUFFER) e o certificado do servidor é liberado
+ * após a verificação.
+ *
+ * De MQTT_EVENT_BEFORE_CONNECT a MQTT_EVENT_CONNECTED são medidos a duração
+ * (TCP + handshake TLS + CONNECT) e a queda do heap livre (pico de uso da
+ * conexão, incluindo o que outras tasks alocarem no intervalo); saem no
+ * health check em connect_ms, connect_max_ms e connect_heap_peak.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef MQTT_TLS_H
+#define MQTT_TLS_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "mqtt_client.h"
+#include "mqtt_system.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define MQTT_TLS_PSK_MAX_KEY_LEN 64 ///< Chave PSK máxima (bytes)
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Preenche a verificação do servidor na configuração do cliente
+ *
+ * @param cfg Configuração passada a esp_mqtt_client_init()
+ *
+ * @return ESP_OK, ou ESP_ERR_INVALID_ARG se a chave PSK for inválida
+ */
+esp_err_t mqtt_tls_configure(esp_mqtt_client_config_t *cfg);
+
+/**
+ * @brief Indica se o URI usa TLS
+ */
+bool mqtt_tls_uri_is_secure(const char *uri);
+
+/**
+ * @brief Início de uma tentativa de conexão (MQTT_EVENT_BEFORE_CONNECT)
+ */
+void mqtt_tls_connect_begin(void);
+
+/**
+ * @brief Fim da tentativa (MQTT_EVENT_CONNECTED ou MQTT_EVENT_DISCONNECTED)
+ *
+ * @param connected true se a conexão foi estabelecida (medição registrada)
+ */
+void mqtt_tls_connect_end(bool connected);
+
+/**
+ * @brief Copia as medições de conexão para @p stats
+ */
+void mqtt_tls_snapshot(mqtt_statistics_t *stats);
+
+#endif /* MQTT_TLS_H */
@@ -0,0 +1,295 @@
+/**
+ * @file mqtt_v5.c
+ * @brief MQTT 5: aliases de tópico automáticos e content-type - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifdef CONFIG_MQTT_PROTOCOL_5
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "mqtt_v5.h"
+#include "mqtt_system.h"
+#include "rtos_config.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "mqtt5_client.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "MQTT_V5";
+
+/** Reason code do CONNACK do MQTT 5 para versão não suportada */
+#define CONNACK_UNSUPPORTED_PROTOCOL_V5 0x84
+
+/** Tópico publicado nesta conexão */
+typedef struct
+{
+    char topic[MQTT_V5_ALIAS_TOPIC_MAX_LEN];
+    uint16_t uses;    ///< Publicações QoS 0 nesta conexão
+    uint16_t alias; ///< 0 = sem alias
+    bool announced; ///< Broker já associou alias e tópico
+} alias_entry_t;
+
+/** Content-type por sufixo de tópico */
+typedef struct
+{
+    const char *suffix;
+    const char *content_type;
+    const char *format;
+    mqtt5_user_property_handle_t user_property;
+} content_tag_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/** A propriedade vale para a próxima publicação: trava do set ao publish */
+static SemaphoreHandle_t s_lock = NULL;
+RTOS_STATIC(StaticSemaphore_t, s_lock_buf);
+
+static bool s_active = true;
+
+/** Protegidos por s_lock */
+static esp_mqtt5_publish_property_config_t s_property;
+static alias_entry_t s_entries[MQTT_V5_ALIAS_TRACKED];
+static int s_entry_count = 0;
+static uint16_t s_next_alias = 1;
+static uint16_t s_alias_limit = MQTT_V5_ALIAS_MAX;
+static uint32_t s_bytes_saved = 0;
+
+static content_tag_t s_tags[] = {
+    {"/cbor", "application/cbor", "cbor", NULL},
+    {"/bin", "application/octet-stream", "packed", NULL},
+};
+
+#define TAG_COUNT (sizeof(s_tags) / sizeof(s_tags[0]))
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static const content_tag_t *find_tag(const char *topic)
+{
+    size_t topic_len = strlen(topic);
+
+    for (size_t i = 0; i < TAG_COUNT; i++)
+    {
+        size_t suffix_len = strlen(s_tags[i].suffix);
+        if (topic_len > suffix_len &&
+            memcmp(topic + topic_len - suffix_len, s_tags[i].suffix, suffix_len) == 0)
+        {
+            return &s_tags[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Entrada do tópico, criada se houver espaço (NULL = sem alias)
+ */
+static alias_entry_t *track_topic(const char *topic)
+{
+    for (int i = 0; i < s_entry_count; i++)
+    {
+        if (strcmp(s_entries[i].topic, topic) == 0)
+        {
+            return &s_entries[i];
+        }
+    }
+
+    if (s_entry_count >= MQTT_V5_ALIAS_TRACKED ||
+        strlen(topic) >= MQTT_V5_ALIAS_TOPIC_MAX_LEN)
+    {
+        return NULL;
+    }
+
+    alias_entry_t *entry = &s_entries[s_entry_count++];
+    memset(entry, 0, sizeof(*entry));
+    strcpy(entry->topic, topic);
+    return entry;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t mqtt_v5_init(esp_mqtt_client_handle_t client)
+{
+    if (s_lock == NULL)
+    {
+        s_lock = RTOS_MUTEX_CREATE(s_lock_buf);
+        if (s_lock == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+
+        for (size_t i = 0; i < TAG_COUNT; i++)
+        {
+            esp_mqtt5_user_property_item_t item = {"format", s_tags[i].format};
+            if (esp_mqtt5_client_set_user_property(&s_tags[i].user_property,
+                                                   &item, 1) != ESP_OK)
+            {
+                ESP_LOGW(TAG, "Sem user property para '%s'", s_tags[i].suffix);
+            }
+        }
+    }
+
+    esp_mqtt5_connection_property_config_t connect_property = {
+        .session_expiry_interval = MQTT_PERSISTENT_SESSION ? MQTT_V5_SESSION_EXPIRY_SEC : 0,
+        .request_problem_info = true,
+    };
+
+    esp_err_t ret = esp_mqtt5_client_set_connect_property(client, &connect_property);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    s_active = true;
+    ESP_LOGI(TAG, "  MQTT 5 (aliases em QoS 0, ate %d por conexao)", MQTT_V5_ALIAS_MAX);
+    return ESP_OK;
+}
+
+bool mqtt_v5_active(void)
+{
+    return s_active;
+}
+
+void mqtt_v5_on_connected(void)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_entry_count = 0;
+    s_next_alias = 1;
+    s_alias_limit = MQTT_V5_ALIAS_MAX;
+    xSemaphoreGive(s_lock);
+}
+
+bool mqtt_v5_check_fallback(const esp_mqtt_event_t *event)
+{
+    if (!s_active || event->error_handle == NULL ||
+        event->error_handle->error_type != MQTT_ERROR_TYPE_CONNECTION_REFUSED)
+    {
+        return false;
+    }
+
+    int code = event->error_handle->connect_return_code;
+    if (code != MQTT_CONNECTION_REFUSE_PROTOCOL && code != CONNACK_UNSUPPORTED_PROTOCOL_V5)
+    {
+        return false;
+    }
+
+    s_active = false;
+    ESP_LOGW(TAG, "Broker recusou MQTT 5 (codigo 0x%x), usando MQTT 3.1.1", code);
+    return true;
+}
+
+int mqtt_v5_publish(esp_mqtt_client_handle_t client, const char *topic,
+                    const char *data, int len, int qos, bool retain)
+{
+    const content_tag_t *tag = find_tag(topic);
+    const char *wire_topic = topic;
+    alias_entry_t *entry = NULL;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    memset(&s_property, 0, sizeof(s_property));
+    if (tag != NULL)
+    {
+        s_property.content_type = tag->content_type;
+        s_property.user_property = tag->user_property;
+    }
+
+    if (qos == 0 && s_alias_limit > 0)
+    {
+        entry = track_topic(topic);
+    }
+
+    if (entry != NULL)
+    {
+        entry->uses++;
+        if (entry->alias == 0 && entry->uses >= MQTT_V5_ALIAS_MIN_USES &&
+            s_next_alias <= s_alias_limit)
+        {
+            entry->alias = s_next_alias++;
+        }
+        if (entry->alias != 0)
+        {
+            s_property.topic_alias = entry->alias;
+            if (entry->announced)
+            {
+                wire_topic = "";
+            }
+        }
+    }
+
+    esp_err_t ret = esp_mqtt5_client_set_publish_property(client, &s_property);
+    if (ret != ESP_OK && s_property.topic_alias != 0)
+    {
+        /* Acima do Topic Alias Maximum do broker (0 = sem aliases) */
+        s_alias_limit = s_property.topic_alias - 1;
+        s_next_alias = s_alias_limit + 1;
+        entry->alias = 0;
+        ESP_LOGW(TAG, "Broker aceita %u aliases", s_alias_limit);
+
+        s_property.topic_alias = 0;
+        wire_topic = topic;
+        ret = esp_mqtt5_client_set_publish_property(client, &s_property);
+    }
+
+    int msg_id = -1;
+    if (ret == ESP_OK)
+    {
+        msg_id = esp_mqtt_client_publish(client, wire_topic, data, len, qos,
+                                         retain ? 1 : 0);
+    }
+
+    if (msg_id >= 0 && s_property.topic_alias != 0)
+    {
+        if (entry->announced)
+        {
+            s_bytes_saved += strlen(topic);
+        }
+        entry->announced = true;
+    }
+
+    xSemaphoreGive(s_lock);
+    return msg_id;
+}
+
+void mqtt_v5_print(void)
+{
+    if (!s_active)
+    {
+        ESP_LOGI(TAG, "MQTT 3.1.1 (fallback)");
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    int aliases = s_next_alias - 1;
+    uint32_t saved = s_bytes_saved;
+    xSemaphoreGive(s_lock);
+
+    ESP_LOGI(TAG, "MQTT 5: %d aliases nesta conexao (limite %u), %lu bytes de topico economizados",
+             aliases, s_alias_limit, saved);
+}
+
+#endif /* CONFIG_MQTT_PROTOCOL_5 */
@@ -0,0 +1,109 @@
+/**
+ * @file mqtt_v5.h
+ * @brief MQTT 5: aliases de tópico automáticos e content-type dos payloads
+ *
+ * Ativado por CONFIG_MQTT_PROTOCOL_5 no sdkconfig (componente mqtt do
+ * ESP-IDF); sem ele o cliente conecta em MQTT 3.1.1 e este módulo não
+ * participa.
+ *
+ * Todos os tópicos repetem MQTT_TOPIC_BASE, e em payloads pequenos o
+ * tópico costuma ser maior que o dado. Com MQTT 5 cada tópico publicado
+ * MQTT_V5_ALIAS_MIN_USES vezes na conexão ganha um alias (1..MQTT_V5_ALIAS_MAX):
+ * a publicação seguinte leva tópico e alias, e as demais só o alias (2
+ * bytes) com tópico vazio. O broker informa no CONNACK quantos aliases
+ * aceita; o cliente não expõe esse valor, então o limite é descoberto
+ * quando esp_mqtt5_client_set_publish_property() recusa um alias, e
+ * aliases acima dele deixam de ser atribuídos. Os aliases valem por
+ * conexão e a tabela recomeça a cada MQTT_EVENT_CONNECTED.
+ *
+ * Apenas publicações QoS 0 usam aliases: QoS 1/2 podem ser reenviadas pelo
+ * outbox após uma reconexão, quando o broker já esqueceu o alias e um
+ * tópico vazio seria erro de protocolo.
+ *
+ * Pelo sufixo do tópico os payloads binários recebem content-type e a
+ * user property "format" (ver payload_codec.h):
+ *
+ *   "/cbor" -> application/cbor,         format=cbor
+ *   "/bin"  -> application/octet-stream, format=packed
+ *
+ * Com MQTT_PERSISTENT_SESSION o CONNECT pede MQTT_V5_SESSION_EXPIRY_SEC de
+ * expiração da sessão (no MQTT 5 clean start desligado não basta).
+ *
+ * Broker só 3.1.1: o CONNACK de versão não suportada faz mqtt_system voltar
+ * o cliente para MQTT 3.1.1 até o próximo boot.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef MQTT_V5_H
+#define MQTT_V5_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "mqtt_client.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define MQTT_V5_ALIAS_MAX 8			   ///< Aliases atribuídos por conexão
+#define MQTT_V5_ALIAS_TRACKED 16	   ///< Tópicos contados por conexão
+#define MQTT_V5_ALIAS_MIN_USES 3	   ///< Publicações antes de ganhar alias
+#define MQTT_V5_ALIAS_TOPIC_MAX_LEN 64 ///< Tópico máximo com alias
+#define MQTT_V5_SESSION_EXPIRY_SEC 86400 ///< Expiração da sessão persistente
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Cria a trava das publicações e aplica as propriedades do CONNECT
+ *
+ * @param client Cliente criado com protocol_ver = MQTT_PROTOCOL_V_5
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM ou o erro do esp-mqtt
+ */
+esp_err_t mqtt_v5_init(esp_mqtt_client_handle_t client);
+
+/**
+ * @brief Indica se o cliente está em MQTT 5 (false após o fallback)
+ */
+bool mqtt_v5_active(void);
+
+/**
+ * @brief Zera os aliases (MQTT_EVENT_CONNECTED, antes de publicar)
+ */
+void mqtt_v5_on_connected(void);
+
+/**
+ * @brief Confere se a conexão foi recusada por versão de protocolo
+ *
+ * Na recusa o módulo se desativa; o chamador reconfigura o cliente para
+ * MQTT 3.1.1.
+ *
+ * @param event Evento MQTT_EVENT_ERROR
+ *
+ * @return true se é preciso voltar para MQTT 3.1.1
+ */
+bool mqtt_v5_check_fallback(const esp_mqtt_event_t *event);
+
+/**
+ * @brief Publica com alias e content-type
+ *
+ * Mesmos parâmetros e retorno de esp_mqtt_client_publish().
+ */
+int mqtt_v5_publish(esp_mqtt_client_handle_t client, const char *topic,
+					const char *data, int len, int qos, bool retain);
+
+/**
+ * @brief Imprime aliases em uso e bytes de tópico economizados
+ */
+void mqtt_v5_print(void);
+
+#endif /* MQTT_V5_H */
@@ -0,0 +1,336 @@
+/**
+ * @file payload_codec.c
+ * @brief Codificação de telemetria e health check - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "payload_codec.h"
+#include "json_writer.h"
+
+#include <string.h>
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+/** Tipos principais (major types) do CBOR */
+#define CBOR_MAJOR_UINT 0
+#define CBOR_MAJOR_NEGINT 1
+#define CBOR_MAJOR_MAP 5
+#define CBOR_FLOAT32 0xFA
+#define CBOR_FALSE 0xF4
+#define CBOR_TRUE 0xF5
+
+/** Buffer de saída com detecção de estouro */
+typedef struct
+{
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+} byte_writer_t;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES - ESCRITA DE BYTES
+ * =============================================================================
+ */
+
+static void put_u8(byte_writer_t *w, uint8_t value)
+{
+    if (w->len >= w->cap)
+    {
+        w->overflow = true;
+        return;
+    }
+    w->buf[w->len++] = value;
+}
+
+static void put_le(byte_writer_t *w, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+    {
+        put_u8(w, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+static void put_be(byte_writer_t *w, uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--)
+    {
+        put_u8(w, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+static int writer_result(const byte_writer_t *w)
+{
+    return w->overflow ? -1 : (int)w->len;
+}
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES - CBOR
+ * =============================================================================
+ */
+
+static void cbor_head(byte_writer_t *w, uint8_t major, uint64_t value)
+{
+    uint8_t mt = major << 5;
+
+    if (value < 24)
+    {
+        put_u8(w, mt | (uint8_t)value);
+    }
+    else if (value <= UINT8_MAX)
+    {
+        put_u8(w, mt | 24);
+        put_u8(w, (uint8_t)value);
+    }
+    else if (value <= UINT16_MAX)
+    {
+        put_u8(w, mt | 25);
+        put_be(w, value, 2);
+    }
+    else if (value <= UINT32_MAX)
+    {
+        put_u8(w, mt | 26);
+        put_be(w, value, 4);
+    }
+    else
+    {
+        put_u8(w, mt | 27);
+        put_be(w, value, 8);
+    }
+}
+
+static void cbor_uint(byte_writer_t *w, uint64_t value)
+{
+    cbor_head(w, CBOR_MAJOR_UINT, value);
+}
+
+static void cbor_int(byte_writer_t *w, int64_t value)
+{
+    if (value >= 0)
+    {
+        cbor_head(w, CBOR_MAJOR_UINT, (uint64_t)value);
+    }
+    else
+    {
+        cbor_head(w, CBOR_MAJOR_NEGINT, (uint64_t)(-1 - value));
+    }
+}
+
+static void cbor_float(byte_writer_t *w, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    put_u8(w, CBOR_FLOAT32);
+    put_be(w, bits, 4);
+}
+
+static void cbor_bool(byte_writer_t *w, bool value)
+{
+    put_u8(w, value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES - CONVERSÕES
+ * =============================================================================
+ */
+
+/** Converte para centésimos com arredondamento e saturação em 16 bits */
+static int32_t to_centi(float value, int32_t min, int32_t max)
+{
+    float scaled = value * 100.0f;
+    int32_t centi = (int32_t)(scaled >= 0 ? scaled + 0.5f : scaled - 0.5f);
+
+    if (centi < min)
+    {
+        return min;
+    }
+    if (centi > max)
+    {
+        return max;
+    }
+    return centi;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+int payload_encode_telemetry(mqtt_payload_format_t format,
+                             const telemetry_data_t *data,
+                             uint8_t *buf, size_t cap)
+{
+    byte_writer_t w = {.buf = buf, .cap = cap};
+
+    switch (format)
+    {
+    case MQTT_PAYLOAD_FORMAT_CBOR:
+        cbor_head(&w, CBOR_MAJOR_MAP, 5);
+        cbor_uint(&w, 0);
+        cbor_uint(&w, PAYLOAD_TELEMETRY_SCHEMA_VERSION);
+        cbor_uint(&w, 1);
+        cbor_float(&w, data->temperatura);
+        cbor_uint(&w, 2);
+        cbor_float(&w, data->umidade);
+        cbor_uint(&w, 3);
+        cbor_uint(&w, data->contador);
+        cbor_uint(&w, 4);
+        cbor_uint(&w, data->timestamp);
+        return writer_result(&w);
+
+    case MQTT_PAYLOAD_FORMAT_PACKED:
+        put_u8(&w, 'T');
+        put_u8(&w, PAYLOAD_TELEMETRY_SCHEMA_VERSION);
+        put_le(&w, (uint16_t)to_centi(data->temperatura, INT16_MIN, INT16_MAX), 2);
+        put_le(&w, (uint16_t)to_centi(data->umidade, 0, UINT16_MAX), 2);
+        put_le(&w, data->contador, 4);
+        put_le(&w, data->timestamp, 8);
+        return writer_result(&w);
+
+    case MQTT_PAYLOAD_FORMAT_JSON:
+    default:
+    {
+        json_writer_t jw;
+        json_writer_init(&jw, (char *)buf, cap);
+        json_begin_object(&jw);
+        json_add_fixed(&jw, "temperatura", data->temperatura, 2);
+        json_add_fixed(&jw, "umidade", data->umidade, 2);
+        json_add_uint(&jw, "contador", data->contador);
+        json_add_uint(&jw, "timestamp", data->timestamp);
+        json_end_object(&jw);
+        return json_writer_finish(&jw);
+    }
+    }
+}
+
+int payload_encode_health(mqtt_payload_format_t format,
+                          const health_status_t *health,
+                          const mqtt_statistics_t *stats,
+                          uint8_t *buf, size_t cap)
+{
+    byte_writer_t w = {.buf = buf, .cap = cap};
+
+    switch (format)
+    {
+    case MQTT_PAYLOAD_FORMAT_CBOR:
+        cbor_head(&w, CBOR_MAJOR_MAP, 22);
+        cbor_uint(&w, 0);
+        cbor_uint(&w, PAYLOAD_HEALTH_SCHEMA_VERSION);
+        cbor_uint(&w, 1);
+        cbor_uint(&w, health->free_heap);
+        cbor_uint(&w, 2);
+        cbor_uint(&w, health->min_free_heap);
+        cbor_uint(&w, 3);
+        cbor_int(&w, health->wifi_rssi);
+        cbor_uint(&w, 4);
+        cbor_uint(&w, health->uptime_sec);
+        cbor_uint(&w, 5);
+        cbor_bool(&w, health->mqtt_connected);
+        cbor_uint(&w, 6);
+        cbor_uint(&w, stats->total_publicadas);
+        cbor_uint(&w, 7);
+        cbor_uint(&w, stats->total_recebidas);
+        cbor_uint(&w, 8);
+        cbor_uint(&w, stats->falhas_publicacao);
+        cbor_uint(&w, 9);
+        cbor_uint(&w, stats->desconexoes);
+        cbor_uint(&w, 10);
+        cbor_uint(&w, health->power_mode);
+        cbor_uint(&w, 11);
+        cbor_uint(&w, health->corrente_estimada_ua);
+        cbor_uint(&w, 12);
+        cbor_uint(&w, stats->em_voo);
+        cbor_uint(&w, 13);
+        cbor_uint(&w, stats->ack_min_us);
+        cbor_uint(&w, 14);
+        cbor_uint(&w, stats->ack_avg_us);
+        cbor_uint(&w, 15);
+        cbor_uint(&w, stats->ack_p99_us);
+        cbor_uint(&w, 16);
+        cbor_uint(&w, stats->ack_timeouts);
+        cbor_uint(&w, 17);
+        cbor_uint(&w, stats->ttfp_ultimo_ms);
+        cbor_uint(&w, 18);
+        cbor_uint(&w, stats->ttfp_max_ms);
+        cbor_uint(&w, 19);
+        cbor_uint(&w, stats->conexao_ultima_ms);
+        cbor_uint(&w, 20);
+        cbor_uint(&w, stats->conexao_max_ms);
+        cbor_uint(&w, 21);
+        cbor_uint(&w, stats->conexao_heap_pico);
+        return writer_result(&w);
+
+    case MQTT_PAYLOAD_FORMAT_PACKED:
+        put_u8(&w, 'H');
+        put_u8(&w, PAYLOAD_HEALTH_SCHEMA_VERSION);
+        put_le(&w, health->free_heap, 4);
+        put_le(&w, health->min_free_heap, 4);
+        put_u8(&w, (uint8_t)(int8_t)health->wifi_rssi);
+        put_u8(&w, health->mqtt_connected ? 0x01 : 0x00);
+        put_le(&w, (uint32_t)health->uptime_sec, 4);
+        put_le(&w, stats->total_publicadas, 4);
+        put_le(&w, stats->total_recebidas, 4);
+        put_le(&w, stats->falhas_publicacao, 4);
+        put_le(&w, stats->desconexoes, 4);
+        put_u8(&w, health->power_mode);
+        put_le(&w, health->corrente_estimada_ua, 4);
+        put_le(&w, stats->em_voo, 2);
+        put_le(&w, stats->ack_min_us, 4);
+        put_le(&w, stats->ack_avg_us, 4);
+        put_le(&w, stats->ack_p99_us, 4);
+        put_le(&w, stats->ack_timeouts, 4);
+        put_le(&w, stats->ttfp_ultimo_ms, 4);
+        put_le(&w, stats->ttfp_max_ms, 4);
+        put_le(&w, stats->conexao_ultima_ms, 4);
+        put_le(&w, stats->conexao_max_ms, 4);
+        put_le(&w, stats->conexao_heap_pico, 4);
+        return writer_result(&w);
+
+    case MQTT_PAYLOAD_FORMAT_JSON:
+    default:
+    {
+        json_writer_t jw;
+        json_writer_init(&jw, (char *)buf, cap);
+        json_begin_object(&jw);
+        json_add_uint(&jw, "free_heap", health->free_heap);
+        json_add_uint(&jw, "min_free_heap", health->min_free_heap);
+        json_add_int(&jw, "wifi_rssi", health->wifi_rssi);
+        json_add_uint(&jw, "uptime_sec", health->uptime_sec);
+        json_add_uint(&jw, "mqtt_connected", health->mqtt_connected ? 1 : 0);
+        json_add_uint(&jw, "msgs_sent", stats->total_publicadas);
+        json_add_uint(&jw, "msgs_received", stats->total_recebidas);
+        json_add_uint(&jw, "mqtt_failures", stats->falhas_publicacao);
+        json_add_uint(&jw, "disconnects", stats->desconexoes);
+        json_add_uint(&jw, "power_mode", health->power_mode);
+        json_add_uint(&jw, "current_ua", health->corrente_estimada_ua);
+        json_add_uint(&jw, "inflight", stats->em_voo);
+        json_add_uint(&jw, "ack_min_us", stats->ack_min_us);
+        json_add_uint(&jw, "ack_avg_us", stats->ack_avg_us);
+        json_add_uint(&jw, "ack_p99_us", stats->ack_p99_us);
+        json_add_uint(&jw, "ack_timeouts", stats->ack_timeouts);
+        json_add_uint(&jw, "ttfp_ms", stats->ttfp_ultimo_ms);
+        json_add_uint(&jw, "ttfp_max_ms", stats->ttfp_max_ms);
+        json_add_uint(&jw, "connect_ms", stats->conexao_ultima_ms);
+        json_add_uint(&jw, "connect_max_ms", stats->conexao_max_ms);
+        json_add_uint(&jw, "connect_heap_peak", stats->conexao_heap_pico);
+        json_end_object(&jw);
+        return json_writer_finish(&jw);
+    }
+    }
+}
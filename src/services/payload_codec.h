@@ -0,0 +1,102 @@
+/**
+ * @file payload_codec.h
+ * @brief Codificação de telemetria e health check em formatos compactos
+ *
+ * Além do JSON original, oferece dois formatos binários versionados:
+ *
+ * - CBOR (RFC 8949): mapa com chaves inteiras, autodescritivo
+ * - PACKED: registro little-endian de tamanho fixo, o menor possível
+ *
+ * O formato é indicado pelo sufixo do tópico (sem sufixo = JSON,
+ * "/cbor" = CBOR, "/bin" = PACKED). O esquema de cada formato está
+ * documentado abaixo e em tools/payload_decoder.py, que decodifica as
+ * mensagens no lado do servidor.
+ *
+ * Cada tipo de mensagem tem sua própria versão de esquema; campos novos
+ * aumentam a versão do tipo correspondente.
+ *
+ * Esquema CBOR v1 - telemetria (mapa):
+ *   0: versão, 1: temperatura (float32), 2: umidade (float32),
+ *   3: contador (uint), 4: timestamp em ms (uint)
+ *
+ * Esquema CBOR v5 - health (mapa):
+ *   0: versão, 1: free_heap, 2: min_free_heap, 3: wifi_rssi (int),
+ *   4: uptime_sec, 5: mqtt_connected (bool), 6: msgs_sent,
+ *   7: msgs_received, 8: mqtt_failures, 9: disconnects,
+ *   10: power_mode (v2), 11: current_ua (v2), 12: inflight (v3),
+ *   13: ack_min_us (v3), 14: ack_avg_us (v3), 15: ack_p99_us (v3),
+ *   16: ack_timeouts (v3), 17: ttfp_ms (v4), 18: ttfp_max_ms (v4),
+ *   19: connect_ms (v5), 20: connect_max_ms (v5), 21: connect_heap_peak (v5)
+ *
+ * Esquema PACKED v1 - telemetria (18 bytes):
+ *   u8 'T', u8 versão, i16 temperatura*100, u16 umidade*100,
+ *   u32 contador, u64 timestamp_ms
+ *
+ * Esquema PACKED v5 - health (75 bytes; v1 tinha 32, v2 37, v3 55, v4 63):
+ *   u8 'H', u8 versão, u32 free_heap, u32 min_free_heap, i8 wifi_rssi,
+ *   u8 flags (bit0 = mqtt_connected), u32 uptime_sec, u32 msgs_sent,
+ *   u32 msgs_received, u32 mqtt_failures, u32 disconnects,
+ *   u8 power_mode (v2), u32 current_ua (v2), u16 inflight (v3),
+ *   u32 ack_min_us (v3), u32 ack_avg_us (v3), u32 ack_p99_us (v3),
+ *   u32 ack_timeouts (v3), u32 ttfp_ms (v4), u32 ttfp_max_ms (v4),
+ *   u32 connect_ms (v5), u32 connect_max_ms (v5), u32 connect_heap_peak (v5)
+ *
+ * As latências de ACK cobrem o intervalo desde o health check anterior;
+ * ttfp_* é o tempo entre recuperar o WiFi e a primeira publicação;
+ * connect_* são a duração e o pico de heap da conexão ao broker (mqtt_tls.h).
+ *
+ * Em lotes de telemetria, CBOR usa um array de tamanho indefinido
+ * (0x9F ... 0xFF) e PACKED concatena os registros.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef PAYLOAD_CODEC_H
+#define PAYLOAD_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "mqtt_system.h"
+
+/** Versões de esquema dos formatos binários */
+#define PAYLOAD_TELEMETRY_SCHEMA_VERSION 1
+#define PAYLOAD_HEALTH_SCHEMA_VERSION 5
+
+/** Tamanho de um registro PACKED de telemetria */
+#define PAYLOAD_PACKED_TELEMETRY_SIZE 18
+
+/** Tamanho de um registro PACKED de health check */
+#define PAYLOAD_PACKED_HEALTH_SIZE 75
+
+/**
+ * @brief Codifica uma amostra de telemetria
+ *
+ * @param format Formato de saída
+ * @param data   Amostra
+ * @param buf    Buffer de saída
+ * @param cap    Capacidade do buffer
+ *
+ * @return Bytes escritos, ou -1 se o buffer for pequeno demais
+ */
+int payload_encode_telemetry(mqtt_payload_format_t format,
+							 const telemetry_data_t *data,
+							 uint8_t *buf, size_t cap);
+
+/**
+ * @brief Codifica um health check
+ *
+ * @param format Formato de saída
+ * @param health Status de saúde
+ * @param stats  Estatísticas MQTT
+ * @param buf    Buffer de saída
+ * @param cap    Capacidade do buffer
+ *
+ * @return Bytes escritos, ou -1 se o buffer for pequeno demais
+ */
+int payload_encode_health(mqtt_payload_format_t format,
+						  const health_status_t *health,
+						  const mqtt_statistics_t *stats,
+						  uint8_t *buf, size_t cap);
+
+#endif /* PAYLOAD_CODEC_H */
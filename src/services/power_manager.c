@@ -0,0 +1,197 @@
+/**
+ * @file power_manager.c
+ * @brief Modo de baixo consumo para nós alimentados por bateria - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "power_manager.h"
+#include "mqtt_system.h"
+#include "job_scheduler.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "POWER_MGR";
+
+/** Listen interval (em beacons) derivado do keep-alive MQTT */
+#define POWER_LISTEN_INTERVAL                                   \
+    ((MQTT_KEEPALIVE_SEC * 1000) /                              \
+     (POWER_LISTENS_PER_KEEPALIVE * POWER_BEACON_INTERVAL_MS))
+
+#ifdef CONFIG_LOW_POWER_MODE
+#define POWER_ACTIVE_MODE POWER_MODE_LOW_POWER
+#else
+#define POWER_ACTIVE_MODE POWER_MODE_NORMAL
+#endif
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/** Início da janela de medição da estimativa de corrente */
+static int64_t s_window_start_us = 0;
+static uint64_t s_window_busy_us = 0;
+
+/** Estimativa da última janela completa (0 = nenhuma ainda) */
+static uint32_t s_last_estimate_ua = 0;
+
+/** Light sleep ativo de fato (PM habilitado e configurado) */
+static bool s_light_sleep = false;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static uint16_t listen_interval(void)
+{
+    return POWER_LISTEN_INTERVAL > 0 ? POWER_LISTEN_INTERVAL : 1;
+}
+
+/** Aplica o modelo de consumo a um intervalo com @p busy_us de CPU ativa */
+static uint32_t estimate_ua(uint64_t elapsed_us, uint64_t busy_us)
+{
+    if (elapsed_us == 0)
+    {
+        return 0;
+    }
+    if (busy_us > elapsed_us)
+    {
+        busy_us = elapsed_us;
+    }
+
+    uint32_t floor_ua = s_light_sleep ? POWER_CURRENT_LIGHT_SLEEP_UA
+                                      : POWER_CURRENT_IDLE_UA;
+    uint32_t beacons = POWER_ACTIVE_MODE == POWER_MODE_LOW_POWER
+                           ? listen_interval()
+                           : 1;
+
+    /* Piso ponderado pelo tempo ocioso + CPU ativa durante os jobs */
+    uint64_t cpu_ua = (floor_ua * (elapsed_us - busy_us) +
+                       (uint64_t)POWER_CURRENT_CPU_ACTIVE_UA * busy_us) /
+                      elapsed_us;
+
+    /* Escutas de beacon: rádio ligado POWER_BEACON_RX_MS a cada N beacons */
+    uint64_t radio_ua = (uint64_t)POWER_CURRENT_RADIO_RX_UA * POWER_BEACON_RX_MS /
+                        (beacons * POWER_BEACON_INTERVAL_MS);
+
+#ifdef CONFIG_QEMU_MODE
+    radio_ua = 0;
+#endif
+
+    return (uint32_t)(cpu_ua + radio_ua);
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t power_manager_init(void)
+{
+    s_window_start_us = esp_timer_get_time();
+    s_window_busy_us = job_scheduler_busy_us();
+
+#ifdef CONFIG_LOW_POWER_MODE
+#if CONFIG_PM_ENABLE && !defined(CONFIG_QEMU_MODE)
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = POWER_MIN_CPU_FREQ_MHZ,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#else
+        .light_sleep_enable = false,
+#endif
+    };
+
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao configurar PM: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    s_light_sleep = pm_config.light_sleep_enable;
+    ESP_LOGI(TAG, "  DFS %d-%d MHz, light sleep %s",
+             POWER_MIN_CPU_FREQ_MHZ, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+             s_light_sleep ? "habilitado" : "indisponivel (sem tickless idle)");
+#else
+    ESP_LOGW(TAG, "  CONFIG_PM_ENABLE desabilitado: sem DFS/light sleep");
+#endif
+
+    job_scheduler_set_wake_window(POWER_WAKE_WINDOW_MS);
+    ESP_LOGI(TAG, "  Jobs alinhados em janelas de %d ms", POWER_WAKE_WINDOW_MS);
+#else
+    ESP_LOGI(TAG, "  Modo de energia normal");
+#endif
+
+    return ESP_OK;
+}
+
+void power_manager_apply_wifi_config(wifi_config_t *config)
+{
+#ifdef CONFIG_LOW_POWER_MODE
+    config->sta.listen_interval = listen_interval();
+#else
+    (void)config;
+#endif
+}
+
+esp_err_t power_manager_apply_wifi_ps(void)
+{
+#ifdef CONFIG_LOW_POWER_MODE
+    ESP_LOGI(TAG, "  WiFi em modem sleep maximo (listen interval %u beacons)",
+             listen_interval());
+    return esp_wifi_set_ps(WIFI_PS_MAX_MODEM);
+#else
+    return esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+#endif
+}
+
+power_mode_t power_manager_get_mode(void)
+{
+    return POWER_ACTIVE_MODE;
+}
+
+uint32_t power_manager_estimate_current_ua(void)
+{
+    int64_t now = esp_timer_get_time();
+    uint64_t busy = job_scheduler_busy_us();
+
+    uint64_t elapsed_us = (uint64_t)(now - s_window_start_us);
+    uint64_t busy_us = busy - s_window_busy_us;
+
+    if (elapsed_us < (uint64_t)POWER_ESTIMATE_WINDOW_MS * 1000)
+    {
+        return s_last_estimate_ua != 0 ? s_last_estimate_ua
+                                       : estimate_ua(elapsed_us, busy_us);
+    }
+
+    s_last_estimate_ua = estimate_ua(elapsed_us, busy_us);
+    s_window_start_us = now;
+    s_window_busy_us = busy;
+
+    return s_last_estimate_ua;
+}
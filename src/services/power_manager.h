@@ -0,0 +1,124 @@
+/**
+ * @file power_manager.h
+ * @brief Modo de baixo consumo para nós alimentados por bateria
+ *
+ * Compilado com CONFIG_LOW_POWER_MODE (ambiente esp32-lowpower), o módulo:
+ *
+ * - configura DFS (frequência entre XTAL e CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+ *   e light sleep automático no idle (requer CONFIG_PM_ENABLE e
+ *   CONFIG_FREERTOS_USE_TICKLESS_IDLE no sdkconfig);
+ * - coloca o WiFi em modem sleep máximo, com listen interval derivado de
+ *   MQTT_KEEPALIVE_SEC;
+ * - alinha os jobs periódicos em janelas de despertar comuns
+ *   (POWER_WAKE_WINDOW_MS), para que telemetria, health e publicações
+ *   customizadas saiam na mesma rajada de rádio.
+ *
+ * Sem a flag, o sistema mantém o comportamento original (WiFi em modem
+ * sleep mínimo, CPU em frequência fixa) e apenas reporta a estimativa.
+ *
+ * A corrente média reportada no health check é uma estimativa por modelo:
+ * piso do modo + custo da CPU ativa (tempo medido executando jobs) + custo
+ * das escutas de beacon. As constantes abaixo vêm da folha de dados do
+ * ESP32 e devem ser calibradas com um medidor para dimensionar baterias.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+/** Janela de alinhamento dos jobs no modo de baixo consumo */
+#define POWER_WAKE_WINDOW_MS 10000
+
+/** Frequência mínima da CPU com DFS (XTAL) */
+#define POWER_MIN_CPU_FREQ_MHZ 40
+
+/** Janela de medição da estimativa de corrente */
+#define POWER_ESTIMATE_WINDOW_MS 60000
+
+/** Intervalo de beacon típico de um AP (100 TU) */
+#define POWER_BEACON_INTERVAL_MS 102
+
+/**
+ * Escutas de beacon por período de keep-alive
+ *
+ * O STA acorda POWER_LISTENS_PER_KEEPALIVE vezes por keep-alive para
+ * receber o tráfego retido no AP (PINGRESP, comandos), limitando a
+ * latência de entrada a MQTT_KEEPALIVE_SEC / POWER_LISTENS_PER_KEEPALIVE.
+ */
+#define POWER_LISTENS_PER_KEEPALIVE 20
+
+/** Modelo de consumo (folha de dados do ESP32, 3,3 V) */
+#define POWER_CURRENT_CPU_ACTIVE_UA 50000 ///< CPU ativa a 160 MHz, rádio em espera
+#define POWER_CURRENT_IDLE_UA 27000		  ///< CPU ociosa a 160 MHz, sem light sleep
+#define POWER_CURRENT_LIGHT_SLEEP_UA 800	  ///< Light sleep com RTC ativo
+#define POWER_CURRENT_RADIO_RX_UA 100000	  ///< Rádio recebendo beacon
+#define POWER_BEACON_RX_MS 3				  ///< Rádio ligado por escuta de beacon
+
+/*
+ * =============================================================================
+ * TIPOS
+ * =============================================================================
+ */
+
+/** Modo de energia em uso */
+typedef enum
+{
+	POWER_MODE_NORMAL = 0,	 ///< CPU em frequência fixa, modem sleep mínimo
+	POWER_MODE_LOW_POWER = 1 ///< DFS + light sleep + modem sleep máximo
+} power_mode_t;
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Aplica a configuração de energia do modo compilado
+ *
+ * Configura o gerenciamento de energia e a janela de despertar do
+ * job_scheduler. Deve ser chamada depois de job_scheduler_start() e antes
+ * de iniciar o WiFi.
+ *
+ * @return ESP_OK em sucesso, ou o erro de esp_pm_configure()
+ */
+esp_err_t power_manager_init(void);
+
+/**
+ * @brief Ajusta a configuração do STA antes de esp_wifi_set_config()
+ *
+ * Define o listen interval no modo de baixo consumo.
+ */
+void power_manager_apply_wifi_config(wifi_config_t *config);
+
+/**
+ * @brief Aplica o modo de economia do WiFi (após esp_wifi_start())
+ */
+esp_err_t power_manager_apply_wifi_ps(void);
+
+/**
+ * @brief Retorna o modo de energia em uso
+ */
+power_mode_t power_manager_get_mode(void);
+
+/**
+ * @brief Estima a corrente média (uA)
+ *
+ * Retorna a média da última janela completa de POWER_ESTIMATE_WINDOW_MS
+ * (ou da janela em andamento, antes da primeira completar).
+ */
+uint32_t power_manager_estimate_current_ua(void);
+
+#endif /* POWER_MANAGER_H */
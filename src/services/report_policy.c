@@ -0,0 +1,180 @@
+/**
+ * @file report_policy.c
+ * @brief Política de publicação por mudança (deadband) por tópico - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "report_policy.h"
+#include "mqtt_stats.h"
+
+#include <string.h>
+#include <math.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "REPORT_POLICY";
+
+/** Estado de um tópico registrado */
+typedef struct
+{
+    const char *topic;                    ///< Tópico
+    report_policy_t policy;               ///< Parâmetros
+    int count;                            ///< Valores por amostra
+    float last[REPORT_POLICY_MAX_VALUES]; ///< Último valor publicado
+    int64_t last_us;                      ///< Instante do último envio
+    bool has_last;                        ///< Já houve envio
+    uint32_t published;                   ///< Amostras publicadas
+    uint32_t suppressed;                  ///< Amostras suprimidas
+} report_entry_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+static report_entry_t s_entries[REPORT_POLICY_MAX_TOPICS];
+static int s_entry_count = 0;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static report_entry_t *find(const char *topic)
+{
+    for (int i = 0; i < s_entry_count; i++)
+    {
+        if (strcmp(s_entries[i].topic, topic) == 0)
+        {
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static bool changed(const report_entry_t *entry, const float *values)
+{
+    for (int i = 0; i < entry->count; i++)
+    {
+        float delta = fabsf(values[i] - entry->last[i]);
+        float band = entry->policy.deadband[i];
+
+        if (band > 0.0f ? delta >= band : delta > 0.0f)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t report_policy_register(const char *topic, const report_policy_t *policy,
+                                 int count)
+{
+    if (topic == NULL || policy == NULL || count <= 0 ||
+        count > REPORT_POLICY_MAX_VALUES)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    report_entry_t *entry = find(topic);
+    if (entry == NULL)
+    {
+        if (s_entry_count >= REPORT_POLICY_MAX_TOPICS)
+        {
+            ESP_LOGE(TAG, "Tabela cheia, '%s' sem politica", topic);
+            return ESP_ERR_NO_MEM;
+        }
+        entry = &s_entries[s_entry_count++];
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    entry->topic = topic;
+    entry->policy = *policy;
+    entry->count = count;
+
+    return ESP_OK;
+}
+
+bool report_policy_should_publish(const char *topic, const float *values)
+{
+    report_entry_t *entry = find(topic);
+    if (entry == NULL)
+    {
+        return true;
+    }
+
+    int64_t now = esp_timer_get_time();
+    int64_t since_ms = (now - entry->last_us) / 1000;
+    bool publish;
+
+    if (!entry->has_last)
+    {
+        publish = true;
+    }
+    else if (since_ms < entry->policy.min_interval_ms)
+    {
+        publish = false;
+    }
+    else
+    {
+        publish = changed(entry, values) ||
+                  (entry->policy.heartbeat_ms > 0 &&
+                   since_ms >= entry->policy.heartbeat_ms);
+    }
+
+    if (!publish)
+    {
+        entry->suppressed++;
+        mqtt_stats_inc(MQTT_STAT_SUPRIMIDAS);
+        return false;
+    }
+
+    memcpy(entry->last, values, entry->count * sizeof(float));
+    entry->last_us = now;
+    entry->has_last = true;
+    entry->published++;
+
+    return true;
+}
+
+void report_policy_invalidate(const char *topic)
+{
+    report_entry_t *entry = find(topic);
+    if (entry != NULL)
+    {
+        entry->has_last = false;
+    }
+}
+
+void report_policy_print(void)
+{
+    ESP_LOGI(TAG, "=== Politica de publicacao ===");
+
+    for (int i = 0; i < s_entry_count; i++)
+    {
+        const report_entry_t *entry = &s_entries[i];
+        ESP_LOGI(TAG, "%-28s publicadas=%lu suprimidas=%lu",
+                 entry->topic, entry->published, entry->suppressed);
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ * @file report_policy.h
+ * @brief Política de publicação por mudança (deadband) por tópico
+ *
+ * Em vez de publicar toda leitura periódica, cada tópico registrado decide
+ * se a amostra vale o envio:
+ *
+ * - a primeira amostra sempre é publicada;
+ * - antes de min_interval_ms desde o último envio, nada é publicado;
+ * - se algum valor se afastou do último publicado por deadband[i] ou
+ *   mais, publica;
+ * - se nada mudou mas heartbeat_ms se passou, publica (o consumidor sabe
+ *   que o nó está vivo e o valor continua o mesmo);
+ * - caso contrário a amostra é suprimida e contada em
+ *   mqtt_statistics_t.suprimidas.
+ *
+ * A comparação é sempre contra o último valor publicado, então uma deriva
+ * lenta acaba sendo reportada quando acumula um deadband.
+ *
+ * Cada tópico deve ser avaliado por uma única task (os jobs rodam todos
+ * na task do job_scheduler); o registro é feito na inicialização.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef REPORT_POLICY_H
+#define REPORT_POLICY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "mqtt_system.h"
+
+/** Parâmetros da política de um tópico */
+typedef struct
+{
+	float deadband[REPORT_POLICY_MAX_VALUES]; ///< Variação mínima por valor (0 = qualquer mudança)
+	uint32_t min_interval_ms;				   ///< Intervalo mínimo entre envios
+	uint32_t heartbeat_ms;					   ///< Envio forçado sem mudança (0 = nunca)
+} report_policy_t;
+
+/**
+ * @brief Registra (ou substitui) a política de um tópico
+ *
+ * @param topic  Tópico (deve permanecer válido)
+ * @param policy Parâmetros
+ * @param count  Quantidade de valores avaliados por amostra
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG ou ESP_ERR_NO_MEM (tabela cheia)
+ */
+esp_err_t report_policy_register(const char *topic, const report_policy_t *policy,
+								 int count);
+
+/**
+ * @brief Decide se a amostra deve ser publicada
+ *
+ * Se retornar true, a amostra passa a ser a referência do tópico. Tópicos
+ * sem política registrada sempre publicam.
+ *
+ * @param values Valores da amostra (count do registro)
+ */
+bool report_policy_should_publish(const char *topic, const float *values);
+
+/**
+ * @brief Descarta a referência do tópico (próxima amostra é publicada)
+ *
+ * Usada quando a publicação autorizada falhou.
+ */
+void report_policy_invalidate(const char *topic);
+
+/**
+ * @brief Imprime no log amostras publicadas e suprimidas por tópico
+ */
+void report_policy_print(void);
+
+#endif /* REPORT_POLICY_H */
@@ -0,0 +1,407 @@
+/**
+ * @file rtos_config.c
+ * @brief Plano de tasks: core, prioridade e stack de cada task da aplicação - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "rtos_config.h"
+#include "json_writer.h"
+
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "RTOS_CONFIG";
+
+#if defined(CONFIG_FREERTOS_USE_TRACE_FACILITY) && defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+#define RTOS_RUN_TIME_STATS 1
+#endif
+
+#if defined(CONFIG_STATIC_ALLOCATION) && \
+    CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS <= RTOS_TLS_INDEX
+#error "RTOS_TLS_INDEX exige CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS=2 (ver sdkconfig.defaults)"
+#endif
+
+#ifdef CONFIG_STATIC_ALLOCATION
+/* Stacks das tasks do plano (no ESP-IDF StackType_t tem 1 byte) */
+static StackType_t s_stack_job_worker[JOB_SCHEDULER_TASK_STACK_SIZE / sizeof(StackType_t)];
+static StackType_t s_stack_mqtt_dispatch[MQTT_DISPATCH_TASK_STACK_SIZE / sizeof(StackType_t)];
+static StackType_t s_stack_sensor_adc[SENSOR_ADC_TASK_STACK_SIZE / sizeof(StackType_t)];
+static StackType_t s_stack_log_sink[LOG_SINK_TASK_STACK_SIZE / sizeof(StackType_t)];
+#endif
+
+/** Plano de tasks da aplicação */
+static const rtos_task_config_t s_task_plan[RTOS_TASK_COUNT] = {
+    [RTOS_TASK_JOB_WORKER] = {
+        .name = JOB_SCHEDULER_TASK_NAME,
+        .stack_size = JOB_SCHEDULER_TASK_STACK_SIZE,
+        .priority = JOB_SCHEDULER_TASK_PRIORITY,
+        .core = JOB_SCHEDULER_TASK_CORE,
+#ifdef CONFIG_STATIC_ALLOCATION
+        .stack = s_stack_job_worker,
+#endif
+    },
+    [RTOS_TASK_MQTT_DISPATCH] = {
+        .name = MQTT_DISPATCH_TASK_NAME,
+        .stack_size = MQTT_DISPATCH_TASK_STACK_SIZE,
+        .priority = MQTT_DISPATCH_TASK_PRIORITY,
+        .core = MQTT_DISPATCH_TASK_CORE,
+#ifdef CONFIG_STATIC_ALLOCATION
+        .stack = s_stack_mqtt_dispatch,
+#endif
+    },
+    [RTOS_TASK_SENSOR_ADC] = {
+        .name = SENSOR_ADC_TASK_NAME,
+        .stack_size = SENSOR_ADC_TASK_STACK_SIZE,
+        .priority = SENSOR_ADC_TASK_PRIORITY,
+        .core = SENSOR_ADC_TASK_CORE,
+#ifdef CONFIG_STATIC_ALLOCATION
+        .stack = s_stack_sensor_adc,
+#endif
+    },
+    [RTOS_TASK_LOG_SINK] = {
+        .name = LOG_SINK_TASK_NAME,
+        .stack_size = LOG_SINK_TASK_STACK_SIZE,
+        .priority = LOG_SINK_TASK_PRIORITY,
+        .core = LOG_SINK_TASK_CORE,
+#ifdef CONFIG_STATIC_ALLOCATION
+        .stack = s_stack_log_sink,
+#endif
+    },
+};
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+#ifdef CONFIG_STATIC_ALLOCATION
+/** TCBs das tasks do plano */
+static StaticTask_t s_tcb[RTOS_TASK_COUNT];
+
+/** Slot com TCB ainda em uso (a task existe ou aguarda a limpeza da idle) */
+static volatile bool s_slot_busy[RTOS_TASK_COUNT];
+#endif
+
+#ifdef RTOS_RUN_TIME_STATS
+/** Contador de tempo de execução de cada task no relatório anterior */
+typedef struct
+{
+    TaskHandle_t handle;
+    uint32_t run_time;
+} task_baseline_t;
+
+static task_baseline_t s_baseline[RTOS_REPORT_MAX_TASKS];
+static int s_baseline_count = 0;
+static uint32_t s_baseline_total = 0;
+
+/** Estado das tasks (estático: não pesa na stack do JobWorker) */
+static TaskStatus_t s_status[RTOS_REPORT_MAX_TASKS];
+static task_baseline_t s_next[RTOS_REPORT_MAX_TASKS];
+#endif
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+#ifdef CONFIG_STATIC_ALLOCATION
+/**
+ * @brief Chamada pelo FreeRTOS ao liberar o TCB de uma task do plano
+ *
+ * Uma task apagada enquanto executa no outro core (ou que se apaga) só é
+ * liberada depois pela task idle; até lá a stack e o TCB do slot não
+ * podem ser reutilizados.
+ */
+static void on_task_reclaimed(int index, void *slot)
+{
+    (void)index;
+    s_slot_busy[(uintptr_t)slot] = false;
+}
+
+static bool wait_slot_free(rtos_task_id_t id)
+{
+    TickType_t start = xTaskGetTickCount();
+    while (s_slot_busy[id])
+    {
+        if (xTaskGetTickCount() - start >= pdMS_TO_TICKS(RTOS_SLOT_RECLAIM_TIMEOUT_MS))
+        {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+    return true;
+}
+#endif
+
+#ifdef RTOS_RUN_TIME_STATS
+static uint32_t previous_run_time(TaskHandle_t handle)
+{
+    for (int i = 0; i < s_baseline_count; i++)
+    {
+        if (s_baseline[i].handle == handle)
+        {
+            return s_baseline[i].run_time;
+        }
+    }
+    return 0; /* Task criada depois do relatório anterior */
+}
+
+static uint16_t permille(uint32_t part, uint32_t whole)
+{
+    if (whole == 0)
+    {
+        return 0;
+    }
+    uint64_t value = (uint64_t)part * 1000 / whole;
+    return value > 1000 ? 1000 : (uint16_t)value;
+}
+
+/**
+ * @brief Insere a task entre as mais ativas, mantendo a ordem decrescente
+ */
+static void insert_top(rtos_cpu_report_t *out, const TaskStatus_t *status,
+                       uint16_t load)
+{
+    int pos = out->task_count;
+    while (pos > 0 && out->tasks[pos - 1].load_permille < load)
+    {
+        pos--;
+    }
+    if (pos >= RTOS_REPORT_TOP_TASKS)
+    {
+        return;
+    }
+
+    int last = out->task_count < RTOS_REPORT_TOP_TASKS ? out->task_count
+                                                       : RTOS_REPORT_TOP_TASKS - 1;
+    memmove(&out->tasks[pos + 1], &out->tasks[pos],
+            (last - pos) * sizeof(out->tasks[0]));
+
+    rtos_task_load_t *entry = &out->tasks[pos];
+    strncpy(entry->name, status->pcTaskName, sizeof(entry->name) - 1);
+    entry->name[sizeof(entry->name) - 1] = '\0';
+    BaseType_t core = xTaskGetCoreID(status->xHandle);
+    entry->core = (core >= 0 && core < portNUM_PROCESSORS) ? (int8_t)core : -1;
+    entry->load_permille = load;
+    entry->stack_free = status->usStackHighWaterMark * sizeof(StackType_t);
+
+    if (out->task_count < RTOS_REPORT_TOP_TASKS)
+    {
+        out->task_count++;
+    }
+}
+#endif
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t rtos_task_create(rtos_task_id_t id, TaskFunction_t fn, void *arg,
+                           TaskHandle_t *handle)
+{
+    if (id >= RTOS_TASK_COUNT || fn == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const rtos_task_config_t *cfg = &s_task_plan[id];
+
+#ifdef CONFIG_STATIC_ALLOCATION
+    if (!wait_slot_free(id))
+    {
+        ESP_LOGE(TAG, "%s: TCB da instancia anterior ainda nao liberado", cfg->name);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_slot_busy[id] = true;
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(fn, cfg->name, cfg->stack_size,
+                                                      arg, cfg->priority, cfg->stack,
+                                                      &s_tcb[id], cfg->core);
+    if (task == NULL)
+    {
+        s_slot_busy[id] = false;
+        return ESP_ERR_NO_MEM;
+    }
+    vTaskSetThreadLocalStoragePointerAndDelCallback(task, RTOS_TLS_INDEX,
+                                                    (void *)(uintptr_t)id,
+                                                    on_task_reclaimed);
+    if (handle != NULL)
+    {
+        *handle = task;
+    }
+
+    return ESP_OK;
+#else
+    BaseType_t ret = xTaskCreatePinnedToCore(fn, cfg->name, cfg->stack_size,
+                                             arg, cfg->priority, handle,
+                                             cfg->core);
+
+    return ret == pdPASS ? ESP_OK : ESP_ERR_NO_MEM;
+#endif
+}
+
+const rtos_task_config_t *rtos_task_config(rtos_task_id_t id)
+{
+    return id < RTOS_TASK_COUNT ? &s_task_plan[id] : NULL;
+}
+
+uint32_t rtos_task_stack_peak(rtos_task_id_t id)
+{
+    if (id >= RTOS_TASK_COUNT)
+    {
+        return 0;
+    }
+
+    const rtos_task_config_t *cfg = &s_task_plan[id];
+    TaskHandle_t task = xTaskGetHandle(cfg->name);
+    if (task == NULL)
+    {
+        return 0;
+    }
+
+    uint32_t free_bytes = uxTaskGetStackHighWaterMark(task) * sizeof(StackType_t);
+    return free_bytes < cfg->stack_size ? cfg->stack_size - free_bytes : 0;
+}
+
+esp_err_t rtos_cpu_report(rtos_cpu_report_t *out, bool advance)
+{
+#ifdef RTOS_RUN_TIME_STATS
+    uint32_t total = 0;
+    UBaseType_t count = uxTaskGetSystemState(s_status, RTOS_REPORT_MAX_TASKS, &total);
+    if (count == 0)
+    {
+        ESP_LOGW(TAG, "Mais de %d tasks, relatorio de CPU indisponivel",
+                 RTOS_REPORT_MAX_TASKS);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(out, 0, sizeof(*out));
+
+    /* O contador usa o esp_timer: a unidade é 1 us, igual em todos os cores */
+    uint32_t elapsed = total - s_baseline_total;
+    out->window_ms = elapsed / 1000;
+
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        const TaskStatus_t *status = &s_status[i];
+        uint32_t delta = status->ulRunTimeCounter - previous_run_time(status->xHandle);
+        uint16_t load = permille(delta, elapsed);
+
+        s_next[i] = (task_baseline_t){status->xHandle, status->ulRunTimeCounter};
+
+        bool idle = false;
+        for (int core = 0; core < portNUM_PROCESSORS; core++)
+        {
+            if (status->xHandle == xTaskGetIdleTaskHandleForCore(core))
+            {
+                /* Carga do core = tempo em que a idle não executou */
+                out->core_load_permille[core] = 1000 - load;
+                idle = true;
+            }
+        }
+
+        if (!idle)
+        {
+            insert_top(out, status, load);
+        }
+    }
+
+    if (advance)
+    {
+        memcpy(s_baseline, s_next, count * sizeof(s_next[0]));
+        s_baseline_count = count;
+        s_baseline_total = total;
+    }
+
+    return ESP_OK;
+#else
+    (void)out;
+    (void)advance;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+int rtos_cpu_report_json(const rtos_cpu_report_t *report, char *buf, size_t cap)
+{
+    json_writer_t jw;
+    json_writer_init(&jw, buf, cap);
+
+    json_begin_object(&jw);
+    json_add_uint(&jw, "window_ms", report->window_ms);
+
+    json_begin_array(&jw, "core_load");
+    for (int core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        json_add_fixed(&jw, NULL, report->core_load_permille[core] / 10.0f, 1);
+    }
+    json_end_array(&jw);
+
+    json_begin_array(&jw, "tasks");
+    for (int i = 0; i < report->task_count; i++)
+    {
+        const rtos_task_load_t *task = &report->tasks[i];
+        json_begin_object(&jw);
+        json_add_string(&jw, "name", task->name);
+        json_add_int(&jw, "core", task->core);
+        json_add_fixed(&jw, "cpu", task->load_permille / 10.0f, 1);
+        json_add_uint(&jw, "stack_free", task->stack_free);
+        json_end_object(&jw);
+    }
+    json_end_array(&jw);
+
+    json_end_object(&jw);
+
+    return json_writer_finish(&jw);
+}
+
+void rtos_print_task_plan(void)
+{
+    ESP_LOGI(TAG, "=== Plano de tasks ===");
+
+    for (int i = 0; i < RTOS_TASK_COUNT; i++)
+    {
+        const rtos_task_config_t *cfg = &s_task_plan[i];
+        ESP_LOGI(TAG, "%-12s core %ld, prioridade %u, stack %lu",
+                 cfg->name, (long)cfg->core, (unsigned)cfg->priority,
+                 cfg->stack_size);
+    }
+}
+
+void rtos_print_memory_report(void)
+{
+    uint32_t stacks = 0;
+    for (int i = 0; i < RTOS_TASK_COUNT; i++)
+    {
+        stacks += s_task_plan[i].stack_size;
+    }
+
+    ESP_LOGI(TAG, "=== Memoria ===");
+#ifdef CONFIG_STATIC_ALLOCATION
+    ESP_LOGI(TAG, "Tasks do plano em .bss: %lu bytes de stack + %u de TCB",
+             stacks, (unsigned)sizeof(s_tcb));
+#else
+    ESP_LOGI(TAG, "Tasks do plano no heap: %lu bytes de stack", stacks);
+#endif
+    ESP_LOGI(TAG, "Heap livre: %u bytes (minimo %u), maior bloco: %u bytes",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
@@ -0,0 +1,239 @@
+/**
+ * @file rtos_config.h
+ * @brief Plano de tasks: core, prioridade e stack de cada task da aplicação
+ *
+ * O core 0 executa a pilha WiFi/lwIP; as tasks da aplicação que disputam
+ * a CPU com ela atrasam ACKs e keep-alives, e as que dela dependem
+ * (publicação, reconexão) ganham pouco estando em outro core. O plano:
+ *
+ *   core 0 (rede)     : WiFi, lwIP, esp-mqtt, esp_timer, JobWorker
+ *   core 1 (controle) : SensorAdc, MqttDispatch (regras e atuação), LogSink
+ *
+ * As tasks da aplicação são criadas por rtos_task_create() a partir da
+ * tabela em rtos_config.c, sempre fixadas em um core. Tasks do ESP-IDF são
+ * posicionadas pelo sdkconfig (CONFIG_MQTT_USE_CORE_0,
+ * CONFIG_ESP_TIMER_TASK_AFFINITY_CPU0). Os prazos do rule_engine vencem
+ * na task do esp_timer, no core 0, e só escrevem num GPIO.
+ *
+ * Prioridades: MqttDispatch acima do JobWorker, para que um comando
+ * recebido atue sem esperar um job; SensorAdc abaixo de ambos; LogSink
+ * abaixo de todas, escrevendo na UART só com o core ocioso.
+ *
+ * rtos_cpu_report() mede a carga de cada core e das tasks mais ativas
+ * desde a chamada anterior, a partir dos contadores de tempo de execução
+ * do FreeRTOS (CONFIG_FREERTOS_USE_TRACE_FACILITY e
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS no sdkconfig).
+ *
+ * Com CONFIG_STATIC_ALLOCATION, stacks e TCBs das tasks do plano ficam em
+ * buffers estáticos (.bss) dimensionados pela própria tabela, e os mutexes,
+ * semáforos e event groups dos módulos são criados pelas macros
+ * RTOS_*_CREATE() sobre armazenamento declarado com RTOS_STATIC(). O boot
+ * não aloca nada da aplicação no heap e a RAM reservada aparece no mapa de
+ * memória (firmware.map, ou "pio run -t size"); rtos_print_memory_report()
+ * a resume no log junto do estado do heap. Continuam no heap as estruturas
+ * do ESP-IDF: WiFi, lwIP, o cliente esp-mqtt e sua outbox e o esp_timer.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef RTOS_CONFIG_H
+#define RTOS_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+/** Cores do plano (em chip de um core, tudo no core 0) */
+#define RTOS_CORE_NETWORK 0
+#ifdef CONFIG_FREERTOS_UNICORE
+#define RTOS_CORE_CONTROL 0
+#else
+#define RTOS_CORE_CONTROL 1
+#endif
+
+/* Task de trabalho do job_scheduler (telemetria, health, publicações) */
+#define JOB_SCHEDULER_TASK_NAME "JobWorker"	   ///< Nome da task de trabalho
+#define JOB_SCHEDULER_TASK_STACK_SIZE 4096	   ///< Stack compartilhada pelos jobs
+#define JOB_SCHEDULER_TASK_PRIORITY 4		   ///< Prioridade da task de trabalho
+#define JOB_SCHEDULER_TASK_CORE RTOS_CORE_NETWORK ///< Publica: junto da pilha de rede
+
+/* Task de despacho das mensagens recebidas (router, regras, atuação) */
+#define MQTT_DISPATCH_TASK_NAME "MqttDispatch"	   ///< Nome da task de despacho
+#define MQTT_DISPATCH_TASK_STACK_SIZE 3072		   ///< Stack da task de despacho
+#define MQTT_DISPATCH_TASK_PRIORITY 5			   ///< Acima do JobWorker
+#define MQTT_DISPATCH_TASK_CORE RTOS_CORE_CONTROL ///< Regras e atuação
+
+/* Task de aquisição do ADC */
+#define SENSOR_ADC_TASK_NAME "SensorAdc"		   ///< Nome da task de aquisição
+#define SENSOR_ADC_TASK_STACK_SIZE 3072		   ///< Stack da task de aquisição
+#define SENSOR_ADC_TASK_PRIORITY 2			   ///< Abaixo das tasks MQTT e dos jobs
+#define SENSOR_ADC_TASK_CORE RTOS_CORE_CONTROL	   ///< Sensoriamento
+
+/* Task de escrita do log (log_sink) */
+#define LOG_SINK_TASK_NAME "LogSink"			   ///< Nome da task de log
+#define LOG_SINK_TASK_STACK_SIZE 3072		   ///< Stack (vprintf da newlib)
+#define LOG_SINK_TASK_PRIORITY 1			   ///< Abaixo de todas as tasks da aplicação
+#define LOG_SINK_TASK_CORE RTOS_CORE_CONTROL	   ///< Fora do core da rede
+
+/* Relatório de CPU */
+#define RTOS_REPORT_MAX_TASKS 24 ///< Tasks acompanhadas entre relatórios
+#define RTOS_REPORT_TOP_TASKS 6	 ///< Tasks mais ativas no relatório
+
+/* Alocação estática */
+/*
+ * O índice 0 dos ponteiros TLS é do pthread (e das tasks criadas com
+ * esp_pthread/std::thread); sdkconfig.defaults reserva dois ponteiros
+ * (CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS=2) e o plano usa o 1.
+ */
+#define RTOS_TLS_INDEX 1				   ///< Ponteiro TLS que avisa a liberação do TCB
+#define RTOS_SLOT_RECLAIM_TIMEOUT_MS 100 ///< Espera pela liberação de uma task apagada
+
+/*
+ * Armazenamento dos objetos de sincronização. Sem CONFIG_STATIC_ALLOCATION
+ * RTOS_STATIC() só declara o nome e as macros de criação usam o heap.
+ *
+ *   RTOS_STATIC(StaticSemaphore_t, s_lock_buf);
+ *   s_lock = RTOS_MUTEX_CREATE(s_lock_buf);
+ */
+#ifdef CONFIG_STATIC_ALLOCATION
+#define RTOS_STATIC(type, name) static type name
+#define RTOS_MUTEX_CREATE(storage) xSemaphoreCreateMutexStatic(&(storage))
+#define RTOS_RECURSIVE_MUTEX_CREATE(storage) xSemaphoreCreateRecursiveMutexStatic(&(storage))
+#define RTOS_BINARY_SEMAPHORE_CREATE(storage) xSemaphoreCreateBinaryStatic(&(storage))
+#define RTOS_EVENT_GROUP_CREATE(storage) xEventGroupCreateStatic(&(storage))
+#else
+#define RTOS_STATIC(type, name) extern type name
+#define RTOS_MUTEX_CREATE(storage) xSemaphoreCreateMutex()
+#define RTOS_RECURSIVE_MUTEX_CREATE(storage) xSemaphoreCreateRecursiveMutex()
+#define RTOS_BINARY_SEMAPHORE_CREATE(storage) xSemaphoreCreateBinary()
+#define RTOS_EVENT_GROUP_CREATE(storage) xEventGroupCreate()
+#endif
+
+/*
+ * =============================================================================
+ * TIPOS
+ * =============================================================================
+ */
+
+/** Tasks da aplicação */
+typedef enum
+{
+	RTOS_TASK_JOB_WORKER = 0, ///< job_scheduler
+	RTOS_TASK_MQTT_DISPATCH,  ///< mqtt_inbound
+	RTOS_TASK_SENSOR_ADC,	  ///< sensor_adc
+	RTOS_TASK_LOG_SINK,		  ///< log_sink
+	RTOS_TASK_COUNT
+} rtos_task_id_t;
+
+/** Entrada do plano de tasks */
+typedef struct
+{
+	const char *name;	  ///< Nome da task
+	uint32_t stack_size;  ///< Stack (bytes)
+	UBaseType_t priority; ///< Prioridade
+	BaseType_t core;	  ///< Core fixo
+#ifdef CONFIG_STATIC_ALLOCATION
+	StackType_t *stack;	  ///< Stack estática (stack_size bytes)
+#endif
+} rtos_task_config_t;
+
+/** Carga de uma task na janela do relatório */
+typedef struct
+{
+	char name[configMAX_TASK_NAME_LEN]; ///< Nome da task
+	int8_t core;						///< Core fixo (-1 = sem afinidade)
+	uint16_t load_permille;				///< Uso de um core (0,1%)
+	uint32_t stack_free;				///< Menor folga de stack (bytes)
+} rtos_task_load_t;
+
+/** Relatório de CPU desde o relatório anterior */
+typedef struct
+{
+	uint32_t window_ms;									///< Duração da janela
+	uint16_t core_load_permille[portNUM_PROCESSORS];	///< Carga por core (0,1%)
+	rtos_task_load_t tasks[RTOS_REPORT_TOP_TASKS];		///< Tasks mais ativas
+	int task_count;										///< Entradas em tasks
+} rtos_cpu_report_t;
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Cria uma task da aplicação com core, prioridade e stack do plano
+ *
+ * Com CONFIG_STATIC_ALLOCATION a task usa a stack e o TCB estáticos do
+ * seu slot; se a instância anterior foi apagada e o FreeRTOS ainda não
+ * liberou o TCB, espera até RTOS_SLOT_RECLAIM_TIMEOUT_MS.
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM se a task não puder ser criada, ou
+ *         ESP_ERR_INVALID_STATE se o slot estático continuar ocupado
+ */
+esp_err_t rtos_task_create(rtos_task_id_t id, TaskFunction_t fn, void *arg,
+						   TaskHandle_t *handle);
+
+/**
+ * @brief Entrada do plano de uma task
+ */
+const rtos_task_config_t *rtos_task_config(rtos_task_id_t id);
+
+/**
+ * @brief Maior uso de stack de uma task do plano desde a sua criação
+ *
+ * @return Bytes usados no pico, ou 0 se a task não estiver em execução
+ */
+uint32_t rtos_task_stack_peak(rtos_task_id_t id);
+
+/**
+ * @brief Mede a carga por core e das tasks mais ativas desde a última
+ *        chamada que avançou a referência
+ *
+ * A primeira chamada mede desde o boot.
+ *
+ * @param out     Relatório
+ * @param advance Avançar a referência (false = leitura avulsa, a janela
+ *                periódica continua)
+ *
+ * @return ESP_OK, ou ESP_ERR_NOT_SUPPORTED sem estatísticas de tempo de
+ *         execução no sdkconfig
+ *
+ * @note Não reentrante (referência e buffers estáticos): chamada apenas
+ *       pelo job de health, no JobWorker
+ */
+esp_err_t rtos_cpu_report(rtos_cpu_report_t *out, bool advance);
+
+/**
+ * @brief Serializa um relatório de CPU em JSON
+ *
+ * @return Bytes escritos, ou -1 se o buffer for insuficiente
+ */
+int rtos_cpu_report_json(const rtos_cpu_report_t *report, char *buf, size_t cap);
+
+/**
+ * @brief Imprime no log o plano de tasks
+ */
+void rtos_print_task_plan(void);
+
+/**
+ * @brief Imprime no log a RAM reservada às tasks do plano e o estado do heap
+ *
+ * Chamada ao fim da inicialização: o heap livre e o maior bloco contíguo
+ * nesse ponto são a referência para acompanhar a fragmentação.
+ */
+void rtos_print_memory_report(void);
+
+#endif /* RTOS_CONFIG_H */
@@ -0,0 +1,639 @@
+/**
+ * @file rule_engine.c
+ * @brief Regras locais de atuação - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "rule_engine.h"
+#include "mqtt_router.h"
+#include "deadline.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "driver/gpio.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "RULE_ENGINE";
+
+/** Chave NVS do texto das regras */
+#define RULE_NVS_KEY "texto"
+
+/** Maior valor aceito (em milésimos cabe em int32) */
+#define RULE_VALUE_MAX_MILLI 2000000000LL
+
+/** Regra compilada */
+typedef struct
+{
+    char topic[MQTT_ROUTER_FILTER_MAX_LEN]; ///< Tópico de origem
+    int32_t on_milli;                       ///< Limiar de acionamento (milésimos)
+    int32_t off_milli;                      ///< Limiar de desligamento (milésimos)
+    uint32_t hold_ms;                       ///< Permanência para desligar
+    uint8_t gpio;                           ///< Saída acionada
+    bool above;                             ///< '>' (true) ou '<' (false)
+    bool active;                            ///< Saída ligada
+    bool pending;                           ///< Contagem para desligar armada
+} rule_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/** Tabela em uso; o endereço de cada entrada é o contexto no roteador */
+static rule_t s_rules[RULE_ENGINE_MAX_RULES];
+static int s_rule_count = 0;
+
+/** Tabela compilada antes de substituir a atual */
+static rule_t s_staging[RULE_ENGINE_MAX_RULES];
+
+/** Um prazo de permanência por entrada da tabela (ctx = &s_rules[i]) */
+static deadline_id_t s_deadlines[RULE_ENGINE_MAX_RULES];
+static bool s_deadlines_ok = false;
+
+/** Texto em uso (para ignorar reenvios idênticos da configuração retida) */
+static char s_text[RULE_ENGINE_TEXT_MAX_LEN];
+
+/** Protege active/pending entre a task de despacho e a task do esp_timer */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+/**
+ * @brief Converte um número decimal em milésimos, sem exigir terminação em null
+ *
+ * Como o atoi() usado antes, ignora espaços iniciais e para no primeiro
+ * caractere não numérico; ao contrário dele, exige ao menos um dígito,
+ * para que lixo no payload não seja tratado como 0.
+ */
+static bool parse_milli(const char *s, int len, int32_t *out)
+{
+    int i = 0;
+    int64_t value = 0;
+    int digits = 0;
+    bool negative = false;
+
+    while (i < len && (s[i] == ' ' || s[i] == '\t'))
+    {
+        i++;
+    }
+
+    if (i < len && (s[i] == '-' || s[i] == '+'))
+    {
+        negative = (s[i] == '-');
+        i++;
+    }
+
+    for (; i < len && s[i] >= '0' && s[i] <= '9'; i++, digits++)
+    {
+        value = value * 10 + (s[i] - '0');
+        if (value > RULE_VALUE_MAX_MILLI / 1000)
+        {
+            return false;
+        }
+    }
+    value *= 1000;
+
+    if (i < len && s[i] == '.')
+    {
+        int32_t scale = 100;
+        for (i++; i < len && s[i] >= '0' && s[i] <= '9'; i++, digits++)
+        {
+            value += (s[i] - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    if (digits == 0)
+    {
+        return false;
+    }
+
+    *out = (int32_t)(negative ? -value : value);
+    return true;
+}
+
+static void rule_handler(const char *topic, int topic_len,
+                         const char *data, int data_len, void *ctx);
+
+/**
+ * @brief Compila uma regra ("<tópico> <gpio> <op> <limiar> <hist> <hold>")
+ */
+static bool compile_rule(char *line, rule_t *rule)
+{
+    char *save = NULL;
+    char *fields[6];
+    int n = 0;
+
+    for (char *tok = strtok_r(line, " \t\r", &save);
+         tok != NULL && n < 6;
+         tok = strtok_r(NULL, " \t\r", &save))
+    {
+        fields[n++] = tok;
+    }
+
+    if (n != 6 || strtok_r(NULL, " \t\r", &save) != NULL)
+    {
+        return false;
+    }
+
+    size_t topic_len = strlen(fields[0]);
+    if (topic_len >= sizeof(rule->topic) ||
+        strchr(fields[0], '+') != NULL || strchr(fields[0], '#') != NULL)
+    {
+        return false;
+    }
+
+    char *end = NULL;
+    long gpio = strtol(fields[1], &end, 10);
+    if (*end != '\0' || !GPIO_IS_VALID_OUTPUT_GPIO(gpio))
+    {
+        return false;
+    }
+
+    if ((fields[2][0] != '>' && fields[2][0] != '<') || fields[2][1] != '\0')
+    {
+        return false;
+    }
+
+    int32_t threshold;
+    int32_t hysteresis;
+    if (!parse_milli(fields[3], strlen(fields[3]), &threshold) ||
+        !parse_milli(fields[4], strlen(fields[4]), &hysteresis) ||
+        hysteresis < 0)
+    {
+        return false;
+    }
+
+    unsigned long long hold = strtoull(fields[5], &end, 10);
+    if (*end != '\0' || fields[5][0] == '-' || hold > UINT32_MAX)
+    {
+        return false;
+    }
+
+    memset(rule, 0, sizeof(*rule));
+    memcpy(rule->topic, fields[0], topic_len + 1);
+    rule->gpio = (uint8_t)gpio;
+    rule->above = (fields[2][0] == '>');
+    rule->on_milli = threshold;
+    rule->off_milli = rule->above ? threshold - hysteresis : threshold + hysteresis;
+    rule->hold_ms = (uint32_t)hold;
+
+    return true;
+}
+
+/**
+ * @brief Compila o texto inteiro em s_staging
+ *
+ * @return Quantidade de regras, -1 se houver regra inválida ou -2 se houver
+ *         regras demais (mensagem já registrada)
+ */
+static int compile_text(char *text)
+{
+    char *save = NULL;
+    int count = 0;
+
+    for (char *line = strtok_r(text, ";\n", &save);
+         line != NULL;
+         line = strtok_r(NULL, ";\n", &save))
+    {
+        /* Linhas em branco são ignoradas */
+        if (strspn(line, " \t\r") == strlen(line))
+        {
+            continue;
+        }
+
+        if (count >= RULE_ENGINE_MAX_RULES)
+        {
+            ESP_LOGE(TAG, "Mais de %d regras", RULE_ENGINE_MAX_RULES);
+            return -2;
+        }
+
+        if (!compile_rule(line, &s_staging[count]))
+        {
+            ESP_LOGE(TAG, "Regra %d invalida", count + 1);
+            return -1;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+static bool topic_in_table(const rule_t *table, int count, const char *topic)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(table[i].topic, topic) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Troca a tabela em uso por s_staging
+ */
+static void apply_staging(int count)
+{
+    /* Tópicos da tabela antiga, para ajustar inscrições depois */
+    static rule_t s_previous[RULE_ENGINE_MAX_RULES];
+    int previous_count = s_rule_count;
+    memcpy(s_previous, s_rules, sizeof(rule_t) * previous_count);
+
+    for (int i = 0; i < previous_count; i++)
+    {
+        mqtt_unregister_topic_handler(s_rules[i].topic, rule_handler, &s_rules[i]);
+        deadline_cancel(s_deadlines[i]);
+    }
+
+    /* Estado das saídas: herdado se o GPIO continuar com regra */
+    for (int i = 0; i < count; i++)
+    {
+        for (int j = 0; j < previous_count; j++)
+        {
+            if (s_previous[j].gpio == s_staging[i].gpio && s_previous[j].active)
+            {
+                s_staging[i].active = true;
+            }
+        }
+    }
+
+    for (int j = 0; j < previous_count; j++)
+    {
+        bool kept = false;
+        for (int i = 0; i < count; i++)
+        {
+            kept |= (s_staging[i].gpio == s_previous[j].gpio);
+        }
+
+        if (!kept)
+        {
+            gpio_set_level(s_previous[j].gpio, 0);
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        bool configured = false;
+        for (int j = 0; j < previous_count; j++)
+        {
+            configured |= (s_previous[j].gpio == s_staging[i].gpio);
+        }
+
+        if (!configured)
+        {
+            gpio_reset_pin(s_staging[i].gpio);
+            gpio_set_direction(s_staging[i].gpio, GPIO_MODE_OUTPUT);
+        }
+        gpio_set_level(s_staging[i].gpio, s_staging[i].active);
+    }
+
+    /* Prazos antigos podem estar vencendo agora: troca sob a trava */
+    portENTER_CRITICAL(&s_lock);
+    memcpy(s_rules, s_staging, sizeof(rule_t) * count);
+    s_rule_count = count;
+    portEXIT_CRITICAL(&s_lock);
+
+    for (int i = 0; i < count; i++)
+    {
+        mqtt_register_topic_handler(s_rules[i].topic, rule_handler, &s_rules[i]);
+    }
+
+    if (!mqtt_system_is_connected())
+    {
+        return;
+    }
+
+    for (int j = 0; j < previous_count; j++)
+    {
+        if (!topic_in_table(s_rules, count, s_previous[j].topic) &&
+            !topic_in_table(s_previous, j, s_previous[j].topic))
+        {
+            mqtt_unsubscribe_topic(s_previous[j].topic);
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!topic_in_table(s_previous, previous_count, s_rules[i].topic) &&
+            !topic_in_table(s_rules, i, s_rules[i].topic))
+        {
+            mqtt_subscribe_topic(s_rules[i].topic, 1);
+        }
+    }
+}
+
+static void save_text(const char *text, bool is_default)
+{
+    nvs_handle_t nvs;
+
+    if (nvs_open(RULE_ENGINE_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "NVS indisponivel, regras nao persistidas");
+        return;
+    }
+
+    if (is_default)
+    {
+        nvs_erase_key(nvs, RULE_NVS_KEY);
+    }
+    else
+    {
+        nvs_set_str(nvs, RULE_NVS_KEY, text);
+    }
+
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+/*
+ * =============================================================================
+ * HANDLERS
+ * =============================================================================
+ */
+
+/**
+ * @brief Avalia uma regra para o valor recebido no seu tópico
+ */
+static void rule_handler(const char *topic, int topic_len,
+                         const char *data, int data_len, void *ctx)
+{
+    rule_t *rule = (rule_t *)ctx;
+    int32_t value;
+
+    if (!parse_milli(data, data_len, &value))
+    {
+        ESP_LOGW(TAG, "Valor nao numerico em '%.*s'", topic_len, topic);
+        return;
+    }
+
+    bool on_zone = rule->above ? value > rule->on_milli : value < rule->on_milli;
+    bool off_zone = rule->above ? value <= rule->off_milli : value >= rule->off_milli;
+    bool switched_on = false;
+    bool switched_off = false;
+    bool arm = false;
+    bool cancel = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (on_zone)
+    {
+        cancel = rule->pending;
+        rule->pending = false;
+        if (!rule->active)
+        {
+            rule->active = true;
+            TRACE_BEGIN(t);
+            gpio_set_level(rule->gpio, 1);
+            TRACE_END(TRACE_ACTUATION, t, rule->gpio);
+            switched_on = true;
+        }
+    }
+    else if (off_zone && rule->active)
+    {
+        if (rule->hold_ms == 0)
+        {
+            rule->active = false;
+            TRACE_BEGIN(t);
+            gpio_set_level(rule->gpio, 0);
+            TRACE_END(TRACE_ACTUATION, t, rule->gpio);
+            switched_off = true;
+        }
+        else if (!rule->pending)
+        {
+            rule->pending = true;
+            arm = true;
+        }
+    }
+    else
+    {
+        /* Entre os limiares: a permanência precisa recomeçar */
+        cancel = rule->pending;
+        rule->pending = false;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    int index = rule - s_rules;
+    if (arm)
+    {
+        deadline_arm(s_deadlines[index], rule->hold_ms);
+        ESP_LOGW(TAG, "GPIO %d: valor %ld.%03ld, desliga em %lu s se persistir",
+                 rule->gpio, value / 1000, labs(value % 1000), rule->hold_ms / 1000);
+    }
+    else if (cancel)
+    {
+        deadline_cancel(s_deadlines[index]);
+        ESP_LOGD(TAG, "GPIO %d: contagem para desligar cancelada", rule->gpio);
+    }
+
+    if (switched_on || switched_off)
+    {
+        ESP_LOGI(TAG, "GPIO %d %s (%.*s = %ld.%03ld)", rule->gpio,
+                 switched_on ? "LIGADO" : "DESLIGADO", topic_len, topic,
+                 value / 1000, labs(value % 1000));
+    }
+}
+
+/**
+ * @brief Fim da permanência na região de desligamento (task do esp_timer)
+ */
+static void rule_deadline_callback(void *ctx)
+{
+    rule_t *rule = (rule_t *)ctx;
+    bool switched_off = false;
+
+    portENTER_CRITICAL(&s_lock);
+    /* Cancelada ou tabela trocada enquanto o callback aguardava */
+    if (rule->pending && rule->active)
+    {
+        rule->pending = false;
+        rule->active = false;
+        TRACE_BEGIN(t);
+        gpio_set_level(rule->gpio, 0);
+        TRACE_END(TRACE_ACTUATION, t, rule->gpio);
+        switched_off = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (switched_off)
+    {
+        ESP_LOGW(TAG, "GPIO %d DESLIGADO: %lu s na regiao de desligamento",
+                 rule->gpio, rule->hold_ms / 1000);
+    }
+}
+
+static void config_handler(const char *topic, int topic_len,
+                           const char *data, int data_len, void *ctx)
+{
+    esp_err_t ret = rule_engine_load(data, data_len, true);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Regras recebidas rejeitadas (%s), tabela mantida",
+                 esp_err_to_name(ret));
+    }
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t rule_engine_init(void)
+{
+    for (int i = 0; i < RULE_ENGINE_MAX_RULES && !s_deadlines_ok; i++)
+    {
+        s_deadlines[i] = deadline_register("RuleHold", rule_deadline_callback,
+                                           &s_rules[i]);
+        if (s_deadlines[i] < 0)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    s_deadlines_ok = true;
+
+    /* Regras persistidas, se houver e forem válidas */
+    static char stored[RULE_ENGINE_TEXT_MAX_LEN];
+    size_t size = sizeof(stored);
+    nvs_handle_t nvs;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    if (nvs_open(RULE_ENGINE_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK)
+    {
+        ret = nvs_get_str(nvs, RULE_NVS_KEY, stored, &size);
+        nvs_close(nvs);
+    }
+
+    if (ret == ESP_OK)
+    {
+        ret = rule_engine_load(stored, strlen(stored), false);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Regras do NVS invalidas, usando padrao");
+        }
+    }
+
+    if (ret != ESP_OK)
+    {
+        ret = rule_engine_load("", 0, false);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+
+    return mqtt_register_topic_handler(RULE_ENGINE_CONFIG_TOPIC,
+                                       config_handler, NULL);
+}
+
+esp_err_t rule_engine_load(const char *text, int len, bool persist)
+{
+    static char work[RULE_ENGINE_TEXT_MAX_LEN];
+
+    if (text == NULL || len < 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    bool is_default = (len == 0);
+    if (is_default)
+    {
+        text = RULE_ENGINE_DEFAULT_RULES;
+        len = strlen(text);
+    }
+
+    if (len >= RULE_ENGINE_TEXT_MAX_LEN)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    /* Configuração retida é reentregue a cada conexão */
+    if (s_rule_count > 0 && (int)strlen(s_text) == len &&
+        memcmp(s_text, text, len) == 0)
+    {
+        return ESP_OK;
+    }
+
+    memcpy(work, text, len);
+    work[len] = '\0';
+
+    int count = compile_text(work);
+    if (count < 0)
+    {
+        return count == -1 ? ESP_ERR_INVALID_ARG : ESP_ERR_NO_MEM;
+    }
+
+    apply_staging(count);
+
+    memcpy(s_text, text, len);
+    s_text[len] = '\0';
+
+    if (persist)
+    {
+        save_text(s_text, is_default);
+    }
+
+    rule_engine_print();
+    return ESP_OK;
+}
+
+int rule_engine_subscriptions(mqtt_subscription_t *out, int max)
+{
+    int n = 0;
+
+    if (n < max)
+    {
+        out[n++] = (mqtt_subscription_t){RULE_ENGINE_CONFIG_TOPIC, 1};
+    }
+
+    for (int i = 0; i < s_rule_count && n < max; i++)
+    {
+        if (!topic_in_table(s_rules, i, s_rules[i].topic))
+        {
+            out[n++] = (mqtt_subscription_t){s_rules[i].topic, 1};
+        }
+    }
+
+    return n;
+}
+
+void rule_engine_print(void)
+{
+    ESP_LOGI(TAG, "=== Regras (%d) ===", s_rule_count);
+
+    for (int i = 0; i < s_rule_count; i++)
+    {
+        const rule_t *rule = &s_rules[i];
+        int32_t hysteresis = rule->above ? rule->on_milli - rule->off_milli
+                                         : rule->off_milli - rule->on_milli;
+
+        ESP_LOGI(TAG, "%-28s GPIO %-2d %c %ld.%03ld hist %ld.%03ld hold %lu ms [%s]",
+                 rule->topic, rule->gpio, rule->above ? '>' : '<',
+                 rule->on_milli / 1000, labs(rule->on_milli % 1000),
+                 hysteresis / 1000, hysteresis % 1000, rule->hold_ms,
+                 rule->active ? "ligado" : "desligado");
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ * @file rule_engine.h
+ * @brief Regras locais de atuação: tópico -> GPIO com limiar, histerese e espera
+ *
+ * Cada regra liga uma saída quando o valor numérico recebido no tópico
+ * cruza o limiar e a desliga quando o valor volta além da histerese:
+ *
+ *   '>' : liga se v > limiar; desliga se v <= limiar - histerese
+ *   '<' : liga se v < limiar; desliga se v >= limiar + histerese
+ *
+ * Com hold_ms > 0 o valor precisa permanecer na região de desligamento por
+ * hold_ms; qualquer amostra fora dela cancela a contagem. O desligamento é
+ * feito por um prazo (deadline.h) armado na entrada da região, então ocorre
+ * no instante certo, sem job de varredura.
+ *
+ * Formato texto (regras separadas por ';' ou quebra de linha):
+ *
+ *   <tópico> <gpio> <'>'|'<'> <limiar> <histerese> <hold_ms>
+ *
+ *   ex.: "casa/sala/temperatura 19 > 23 4 600000"
+ *
+ * O texto vem do NVS na inicialização (ou de RULE_ENGINE_DEFAULT_RULES) e
+ * pode ser trocado em tempo de execução publicando em
+ * RULE_ENGINE_CONFIG_TOPIC; payload vazio restaura as regras padrão.
+ *
+ * Na carga o texto é compilado numa tabela com limiares em ponto fixo
+ * (milésimos) e cada regra é registrada no mqtt_router tendo a própria
+ * entrada como contexto: por mensagem há um lookup de hash, a conversão do
+ * payload e duas comparações inteiras. Um texto inválido é rejeitado por
+ * inteiro e a tabela em uso não muda.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "mqtt_system.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define RULE_ENGINE_MAX_RULES 8					   ///< Regras na tabela
+#define RULE_ENGINE_TEXT_MAX_LEN 512				   ///< Tamanho máximo do texto das regras
+#define RULE_ENGINE_CONFIG_TOPIC MQTT_TOPIC_CONFIG "/regras" ///< Tópico de configuração
+#define RULE_ENGINE_NVS_NAMESPACE "rules"			   ///< Namespace NVS do texto das regras
+
+/**
+ * Regras padrão, equivalentes à lógica fixa anterior:
+ * - AC (GPIO 19) liga acima de 23 e desliga após 10 min em 19 ou menos
+ *   (o antigo "< 20" com valores inteiros);
+ * - luzes (GPIO 18) acendem abaixo de 3 e apagam em 3 ou mais.
+ */
+#define RULE_ENGINE_DEFAULT_RULES                  \
+	MQTT_TOPIC_TEMPERATURA " 19 > 23 4 600000;" \
+	MQTT_TOPIC_LUMINOSIDADE " 18 < 3 0 0"
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Carrega as regras (NVS ou padrão) e registra o tópico de configuração
+ *
+ * @return ESP_OK, ou o erro do registro no mqtt_router
+ *
+ * @note Chamada por mqtt_system_init() após mqtt_router_init() e
+ *       deadline_init()
+ */
+esp_err_t rule_engine_init(void);
+
+/**
+ * @brief Compila e aplica um texto de regras
+ *
+ * Saídas que deixam de ter regra são desligadas; saídas que continuam
+ * com regra mantêm o estado atual.
+ *
+ * @param text    Texto das regras (não precisa ser terminado em null)
+ * @param len     Comprimento do texto
+ * @param persist Gravar o texto no NVS
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (texto inválido), ESP_ERR_INVALID_SIZE
+ *         (texto longo demais) ou ESP_ERR_NO_MEM (regras demais)
+ */
+esp_err_t rule_engine_load(const char *text, int len, bool persist);
+
+/**
+ * @brief Lista os tópicos das regras e o tópico de configuração
+ *
+ * Tópicos repetidos aparecem uma vez. Usada no MQTT_EVENT_CONNECTED para
+ * montar um único SUBSCRIBE.
+ *
+ * @param out Destino
+ * @param max Capacidade de @p out
+ *
+ * @return Filtros escritos
+ */
+int rule_engine_subscriptions(mqtt_subscription_t *out, int max);
+
+/**
+ * @brief Imprime a tabela de regras e o estado das saídas no log
+ */
+void rule_engine_print(void);
+
+#endif /* RULE_ENGINE_H */
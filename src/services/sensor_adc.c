@@ -0,0 +1,497 @@
+/**
+ * @file sensor_adc.c
+ * @brief Aquisição do potenciômetro (ADC1 canal 6, GPIO 34) via DMA - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "sensor_adc.h"
+#include "rtos_config.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#ifdef CONFIG_QEMU_MODE
+#include "esp_random.h"
+#else
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#endif
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "SENSOR_ADC";
+
+#define FILTER_LEN (1u << SENSOR_ADC_FILTER_SHIFT)
+#define ADC_MAX_RAW 4095
+
+#ifndef CONFIG_QEMU_MODE
+#define SENSOR_ADC_UNIT ADC_UNIT_1
+#define SENSOR_ADC_CHANNEL ADC_CHANNEL_6 ///< GPIO 34
+#define SENSOR_ADC_ATTEN ADC_ATTEN_DB_12
+#define FRAME_BYTES (SENSOR_ADC_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES)
+
+/** Espera máxima por um quadro durante uma rajada */
+#define BURST_FRAME_TIMEOUT_MS 100
+#endif
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/** Média móvel: anel pré-alocado e soma corrente */
+static uint16_t s_ring[FILTER_LEN];
+static uint32_t s_ring_sum = 0;
+static uint32_t s_ring_pos = 0;
+static uint32_t s_ring_fill = 0;
+
+/** Últimas médias de quadro, para a mediana de 3 */
+static uint16_t s_recent[3];
+static uint32_t s_recent_fill = 0;
+
+/** Leitura publicada para os consumidores */
+static sensor_reading_t s_reading;
+static bool s_has_reading = false;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/** Contadores de diagnóstico (escritos só pela task / ISR) */
+static uint32_t s_frames = 0;
+static volatile uint32_t s_overflows = 0;
+static uint64_t s_busy_us = 0;
+static int64_t s_started_us = 0;
+
+static TaskHandle_t s_task = NULL;
+
+#ifndef CONFIG_QEMU_MODE
+static adc_continuous_handle_t s_adc = NULL;
+static adc_cali_handle_t s_cali = NULL;
+static SemaphoreHandle_t s_request = NULL;
+#ifdef CONFIG_LOW_POWER_MODE
+RTOS_STATIC(StaticSemaphore_t, s_request_buf);
+#endif
+
+/** Quadro lido do driver (alocação estática) */
+static uint8_t s_frame[FRAME_BYTES];
+#endif
+
+/*
+ * =============================================================================
+ * FILTRO (ponto fixo)
+ * =============================================================================
+ */
+
+static void filter_reset(void)
+{
+    s_ring_sum = 0;
+    s_ring_pos = 0;
+    s_ring_fill = 0;
+    s_recent_fill = 0;
+}
+
+static uint16_t median3(uint16_t a, uint16_t b, uint16_t c)
+{
+    if (a > b)
+    {
+        uint16_t t = a;
+        a = b;
+        b = t;
+    }
+    /* a <= b */
+    if (c <= a)
+    {
+        return a;
+    }
+    return c < b ? c : b;
+}
+
+/**
+ * @brief Insere a média de um quadro e retorna o valor filtrado (raw)
+ */
+static uint32_t filter_push(uint16_t frame_mean)
+{
+    /* Mediana dos 3 últimos quadros remove picos isolados */
+    s_recent[s_recent_fill % 3] = frame_mean;
+    s_recent_fill++;
+
+    uint16_t value = s_recent_fill >= 3
+                         ? median3(s_recent[0], s_recent[1], s_recent[2])
+                         : frame_mean;
+
+    /* Média móvel com soma corrente: O(1) por quadro */
+    if (s_ring_fill == FILTER_LEN)
+    {
+        s_ring_sum -= s_ring[s_ring_pos];
+    }
+    else
+    {
+        s_ring_fill++;
+    }
+    s_ring[s_ring_pos] = value;
+    s_ring_sum += value;
+    s_ring_pos = (s_ring_pos + 1) % FILTER_LEN;
+
+    if (s_ring_fill == FILTER_LEN)
+    {
+        return (s_ring_sum + FILTER_LEN / 2) >> SENSOR_ADC_FILTER_SHIFT;
+    }
+    return (s_ring_sum + s_ring_fill / 2) / s_ring_fill;
+}
+
+static int32_t millivolts_to_centi_celsius(uint32_t mv)
+{
+    if (mv > SENSOR_ADC_FULL_SCALE_MV)
+    {
+        mv = SENSOR_ADC_FULL_SCALE_MV;
+    }
+
+    return SENSOR_TEMP_MIN_C * 100 +
+           (int32_t)(mv * (SENSOR_TEMP_MAX_C - SENSOR_TEMP_MIN_C) * 100 /
+                     SENSOR_ADC_FULL_SCALE_MV);
+}
+
+static void publish_reading(uint32_t mv)
+{
+    sensor_reading_t reading = {
+        .tensao_mv = mv,
+        .temperatura_centi = millivolts_to_centi_celsius(mv),
+        .quadros = s_frames,
+        .timestamp_us = esp_timer_get_time(),
+    };
+
+    portENTER_CRITICAL(&s_lock);
+    s_reading = reading;
+    s_has_reading = true;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/*
+ * =============================================================================
+ * DRIVER E TASK DE AQUISIÇÃO
+ * =============================================================================
+ */
+
+#ifndef CONFIG_QEMU_MODE
+
+static bool IRAM_ATTR on_conv_done(adc_continuous_handle_t handle,
+                                   const adc_continuous_evt_data_t *edata,
+                                   void *user_data)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_task, &woken);
+    return woken == pdTRUE;
+}
+
+static bool IRAM_ATTR on_pool_ovf(adc_continuous_handle_t handle,
+                                  const adc_continuous_evt_data_t *edata,
+                                  void *user_data)
+{
+    s_overflows++;
+    return false;
+}
+
+static uint32_t raw_to_millivolts(uint32_t raw)
+{
+    int mv;
+
+    if (s_cali != NULL && adc_cali_raw_to_voltage(s_cali, raw, &mv) == ESP_OK)
+    {
+        return mv;
+    }
+
+    /* Sem calibração no eFuse: aproximação linear */
+    return raw * SENSOR_ADC_FULL_SCALE_MV / ADC_MAX_RAW;
+}
+
+static void process_frame(const uint8_t *buf, uint32_t len)
+{
+    uint32_t sum = 0;
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len;
+         i += SOC_ADC_DIGI_RESULT_BYTES)
+    {
+        const adc_digi_output_data_t *sample = (const adc_digi_output_data_t *)&buf[i];
+
+        if (sample->type1.channel == SENSOR_ADC_CHANNEL)
+        {
+            sum += sample->type1.data;
+            count++;
+        }
+    }
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    s_frames++;
+    publish_reading(raw_to_millivolts(filter_push(sum / count)));
+}
+
+/** Processa todos os quadros prontos no driver; retorna quantos */
+static uint32_t drain_frames(void)
+{
+    uint32_t frames = 0;
+    uint32_t got = 0;
+
+    while (adc_continuous_read(s_adc, s_frame, FRAME_BYTES, &got, 0) == ESP_OK)
+    {
+        int64_t start = esp_timer_get_time();
+        process_frame(s_frame, got);
+        s_busy_us += esp_timer_get_time() - start;
+        frames++;
+    }
+
+    return frames;
+}
+
+static void acquisition_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Task de aquisicao iniciada");
+
+    while (1)
+    {
+#ifdef CONFIG_LOW_POWER_MODE
+        /* Rajada: liga o ADC só pelo tempo de preencher o filtro */
+        xSemaphoreTake(s_request, portMAX_DELAY);
+
+        filter_reset();
+        ulTaskNotifyTake(pdTRUE, 0);
+        adc_continuous_start(s_adc);
+
+        uint32_t frames = 0;
+        while (frames < SENSOR_ADC_BURST_FRAMES)
+        {
+            if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BURST_FRAME_TIMEOUT_MS)) == 0)
+            {
+                ESP_LOGW(TAG, "Timeout aguardando quadro do ADC");
+                break;
+            }
+            frames += drain_frames();
+        }
+
+        adc_continuous_stop(s_adc);
+#else
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        drain_frames();
+#endif
+    }
+}
+
+static esp_err_t init_calibration(void)
+{
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_config = {
+        .unit_id = SENSOR_ADC_UNIT,
+        .atten = SENSOR_ADC_ATTEN,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    return adc_cali_create_scheme_line_fitting(&cali_config, &s_cali);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static esp_err_t init_adc(void)
+{
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = FRAME_BYTES * 4,
+        .conv_frame_size = FRAME_BYTES,
+    };
+    esp_err_t ret = adc_continuous_new_handle(&handle_config, &s_adc);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    adc_digi_pattern_config_t pattern = {
+        .atten = SENSOR_ADC_ATTEN,
+        .channel = SENSOR_ADC_CHANNEL,
+        .unit = SENSOR_ADC_UNIT,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+    adc_continuous_config_t adc_config = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = SENSOR_ADC_SAMPLE_RATE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    ret = adc_continuous_config(s_adc, &adc_config);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    adc_continuous_evt_cbs_t callbacks = {
+        .on_conv_done = on_conv_done,
+        .on_pool_ovf = on_pool_ovf,
+    };
+    return adc_continuous_register_event_callbacks(s_adc, &callbacks, NULL);
+}
+
+#endif /* !CONFIG_QEMU_MODE */
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+esp_err_t sensor_adc_start(void)
+{
+    filter_reset();
+    s_started_us = esp_timer_get_time();
+
+#ifdef CONFIG_QEMU_MODE
+    ESP_LOGW(TAG, "  QEMU: ADC nao emulado, leitura simulada");
+    return ESP_OK;
+#else
+    if (s_task != NULL)
+    {
+        return ESP_OK;
+    }
+
+    if (init_calibration() != ESP_OK)
+    {
+        ESP_LOGW(TAG, "  Sem calibracao no eFuse, usando conversao linear");
+    }
+
+    esp_err_t ret = init_adc();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao configurar ADC: %s", esp_err_to_name(ret));
+        sensor_adc_stop();
+        return ret;
+    }
+
+#ifdef CONFIG_LOW_POWER_MODE
+    s_request = RTOS_BINARY_SEMAPHORE_CREATE(s_request_buf);
+    if (s_request == NULL)
+    {
+        sensor_adc_stop();
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+
+    if (rtos_task_create(RTOS_TASK_SENSOR_ADC, acquisition_task, NULL,
+                         &s_task) != ESP_OK)
+    {
+        s_task = NULL;
+        sensor_adc_stop();
+        return ESP_ERR_NO_MEM;
+    }
+
+#ifdef CONFIG_LOW_POWER_MODE
+    /* Primeira rajada imediata, para a telemetria ter leitura */
+    sensor_adc_request();
+    ESP_LOGI(TAG, "  ADC1 canal 6 em rajadas de %d quadros", SENSOR_ADC_BURST_FRAMES);
+#else
+    ret = adc_continuous_start(s_adc);
+    if (ret != ESP_OK)
+    {
+        sensor_adc_stop();
+        return ret;
+    }
+    ESP_LOGI(TAG, "  ADC1 canal 6 a %d Hz, quadros de %d amostras",
+             SENSOR_ADC_SAMPLE_RATE_HZ, SENSOR_ADC_FRAME_SAMPLES);
+#endif
+
+    return ESP_OK;
+#endif
+}
+
+void sensor_adc_stop(void)
+{
+#ifndef CONFIG_QEMU_MODE
+    if (s_task != NULL)
+    {
+        vTaskDelete(s_task);
+        s_task = NULL;
+    }
+
+    if (s_adc != NULL)
+    {
+        adc_continuous_stop(s_adc);
+        adc_continuous_deinit(s_adc);
+        s_adc = NULL;
+    }
+
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    if (s_cali != NULL)
+    {
+        adc_cali_delete_scheme_line_fitting(s_cali);
+        s_cali = NULL;
+    }
+#endif
+
+    if (s_request != NULL)
+    {
+        vSemaphoreDelete(s_request);
+        s_request = NULL;
+    }
+#endif
+
+    portENTER_CRITICAL(&s_lock);
+    s_has_reading = false;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t sensor_adc_get(sensor_reading_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#ifdef CONFIG_QEMU_MODE
+    /* Potenciômetro simulado girando aleatoriamente */
+    s_frames++;
+    publish_reading(esp_random() % (SENSOR_ADC_FULL_SCALE_MV + 1));
+#endif
+
+    portENTER_CRITICAL(&s_lock);
+    bool valid = s_has_reading;
+    *out = s_reading;
+    portEXIT_CRITICAL(&s_lock);
+
+    return valid ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+void sensor_adc_request(void)
+{
+#if defined(CONFIG_LOW_POWER_MODE) && !defined(CONFIG_QEMU_MODE)
+    if (s_request != NULL)
+    {
+        xSemaphoreGive(s_request);
+    }
+#endif
+}
+
+void sensor_adc_print_stats(void)
+{
+    int64_t elapsed_us = esp_timer_get_time() - s_started_us;
+    uint32_t cpu_permille = elapsed_us > 0
+                                ? (uint32_t)(s_busy_us * 1000 / elapsed_us)
+                                : 0;
+
+    ESP_LOGI(TAG, "ADC: %lu quadros, %lu estouros, CPU %lu.%lu%% (%llu us)",
+             s_frames, s_overflows, cpu_permille / 10, cpu_permille % 10,
+             s_busy_us);
+}
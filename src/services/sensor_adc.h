@@ -0,0 +1,109 @@
+/**
+ * @file sensor_adc.h
+ * @brief Aquisição do potenciômetro (ADC1 canal 6, GPIO 34) via DMA
+ *
+ * O driver contínuo do ADC preenche quadros de SENSOR_ADC_FRAME_SAMPLES
+ * amostras por DMA; a CPU só é acordada (por notificação a partir do ISR)
+ * uma vez por quadro, em vez de uma vez por amostra como no
+ * adc_oneshot_read(). A task de aquisição, de prioridade baixa, processa
+ * cada quadro:
+ *
+ *   quadro (média inteira) -> mediana de 3 quadros -> média móvel de
+ *   2^SENSOR_ADC_FILTER_SHIFT valores (anel pré-alocado, soma corrente)
+ *   -> calibração (line fitting do eFuse) -> mV -> temperatura
+ *
+ * O último valor filtrado fica disponível em sensor_adc_get(), que apenas
+ * copia a leitura numa seção crítica curta: o job de telemetria e as
+ * tasks MQTT nunca esperam pelo ADC.
+ *
+ * O potenciômetro simula um sensor de temperatura: a tensão é mapeada
+ * linearmente em SENSOR_TEMP_MIN_C..SENSOR_TEMP_MAX_C.
+ *
+ * Com CONFIG_LOW_POWER_MODE o driver mantém um lock de frequência do APB
+ * enquanto converte, o que impediria o light sleep; por isso a aquisição
+ * é feita em rajadas: cada sensor_adc_request() liga o ADC por
+ * SENSOR_ADC_BURST_FRAMES quadros e o desliga em seguida.
+ *
+ * No QEMU o ADC não é emulado e a leitura é simulada.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef SENSOR_ADC_H
+#define SENSOR_ADC_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define SENSOR_ADC_SAMPLE_RATE_HZ 20000 ///< Taxa de amostragem (mínimo do ESP32)
+#define SENSOR_ADC_FRAME_SAMPLES 256	   ///< Amostras por quadro de DMA
+#define SENSOR_ADC_FILTER_SHIFT 4		   ///< Média móvel de 2^N quadros
+#define SENSOR_ADC_BURST_FRAMES 24	   ///< Quadros por rajada (modo baixo consumo)
+
+#define SENSOR_ADC_FULL_SCALE_MV 3100 ///< Fundo de escala com atenuação de 12 dB
+#define SENSOR_TEMP_MIN_C 0		  ///< Temperatura no potenciômetro em 0 V
+#define SENSOR_TEMP_MAX_C 50		  ///< Temperatura no fundo de escala
+
+/* Core, prioridade e stack da task de aquisição: rtos_config.h */
+
+/*
+ * =============================================================================
+ * TIPOS
+ * =============================================================================
+ */
+
+/** Última leitura filtrada */
+typedef struct
+{
+	uint32_t tensao_mv;		///< Tensão calibrada (mV)
+	int32_t temperatura_centi; ///< Temperatura em centésimos de grau
+	uint32_t quadros;			///< Quadros processados desde o início
+	int64_t timestamp_us;		///< Instante da leitura (esp_timer)
+} sensor_reading_t;
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Configura o ADC contínuo e cria a task de aquisição
+ *
+ * @return ESP_OK em sucesso, ou o erro do driver
+ */
+esp_err_t sensor_adc_start(void);
+
+/**
+ * @brief Para a aquisição e libera o driver
+ */
+void sensor_adc_stop(void);
+
+/**
+ * @brief Copia a última leitura filtrada (não bloqueia)
+ *
+ * @return ESP_OK, ou ESP_ERR_INVALID_STATE se ainda não há leitura
+ */
+esp_err_t sensor_adc_get(sensor_reading_t *out);
+
+/**
+ * @brief Solicita uma nova rajada de aquisição
+ *
+ * Só tem efeito com CONFIG_LOW_POWER_MODE; em modo contínuo a leitura já
+ * está sempre atualizada.
+ */
+void sensor_adc_request(void);
+
+/**
+ * @brief Imprime no log quadros processados, estouros e custo de CPU
+ */
+void sensor_adc_print_stats(void);
+
+#endif /* SENSOR_ADC_H */
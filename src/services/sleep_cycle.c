@@ -0,0 +1,230 @@
+/**
+ * @file sleep_cycle.c
+ * @brief Ciclo de deep sleep com amostras guardadas na memória RTC - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "sleep_cycle.h"
+#include "sensor_adc.h"
+#include "mqtt_offline.h"
+#include "log_sink.h"
+
+#include <sys/time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "SLEEP_CYCLE";
+
+/** Marca de memória RTC válida (o conteúdo é indefinido no boot a frio) */
+#define RTC_STATE_MAGIC 0x534C4350
+
+/** Intervalo de verificação dos ACKs pendentes */
+#define FLUSH_POLL_MS 50
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/* Estado mantido entre despertares, na memória RTC lenta */
+RTC_DATA_ATTR static uint32_t s_magic;
+RTC_DATA_ATTR static uint32_t s_wakes;
+RTC_DATA_ATTR static uint32_t s_sample_counter;
+RTC_DATA_ATTR static uint32_t s_dropped;
+RTC_DATA_ATTR static uint32_t s_head;
+RTC_DATA_ATTR static uint32_t s_count;
+RTC_DATA_ATTR static telemetry_data_t s_samples[SLEEP_CYCLE_MAX_SAMPLES];
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+/**
+ * @brief Liga o ADC até o filtro assentar e copia a leitura
+ */
+static esp_err_t take_reading(sensor_reading_t *out)
+{
+    esp_err_t ret = sensor_adc_start();
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    int64_t timeout_us = esp_timer_get_time() +
+                         (int64_t)SLEEP_CYCLE_SENSOR_TIMEOUT_MS * 1000;
+    do
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        ret = sensor_adc_get(out);
+    } while ((ret != ESP_OK || out->quadros < SLEEP_CYCLE_SETTLE_FRAMES) &&
+             esp_timer_get_time() < timeout_us);
+
+    sensor_adc_stop();
+
+    return ret;
+}
+
+/**
+ * @brief Acrescenta a amostra ao anel, descartando a mais antiga se cheio
+ */
+static void store_sample(const sensor_reading_t *reading)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    telemetry_data_t *sample;
+    if (s_count == SLEEP_CYCLE_MAX_SAMPLES)
+    {
+        sample = &s_samples[s_head];
+        s_head = (s_head + 1) % SLEEP_CYCLE_MAX_SAMPLES;
+        s_dropped++;
+    }
+    else
+    {
+        sample = &s_samples[(s_head + s_count) % SLEEP_CYCLE_MAX_SAMPLES];
+        s_count++;
+    }
+
+    sample->temperatura = reading->temperatura_centi / 100.0f;
+    sample->umidade = 40.0f + (esp_random() % 400) / 10.0f; /* Sem sensor: simulada */
+    sample->timestamp = (uint64_t)tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+    sample->contador = ++s_sample_counter;
+}
+
+/**
+ * @brief Publica as amostras do anel e espera os ACKs
+ *
+ * @return true se tudo foi confirmado pelo broker
+ */
+static bool publish_samples(void)
+{
+    /* Anel em ordem cronológica, do mais antigo ao mais novo */
+    telemetry_data_t ordered[SLEEP_CYCLE_MAX_SAMPLES];
+    for (uint32_t i = 0; i < s_count; i++)
+    {
+        ordered[i] = s_samples[(s_head + i) % SLEEP_CYCLE_MAX_SAMPLES];
+    }
+
+    if (mqtt_publish_telemetry_samples(ordered, (int)s_count) < 0)
+    {
+        return false;
+    }
+    mqtt_publish_health_check();
+
+    mqtt_statistics_t stats;
+    int64_t timeout_us = esp_timer_get_time() +
+                         (int64_t)SLEEP_CYCLE_FLUSH_TIMEOUT_MS * 1000;
+    do
+    {
+        mqtt_get_statistics(&stats);
+        if (stats.em_voo == 0 && mqtt_offline_pending() == 0)
+        {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(FLUSH_POLL_MS));
+    } while (esp_timer_get_time() < timeout_us);
+
+    return false;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+void sleep_cycle_run(void)
+{
+    bool cold_boot = s_magic != RTC_STATE_MAGIC ||
+                     esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER;
+
+    if (cold_boot)
+    {
+        s_magic = RTC_STATE_MAGIC;
+        s_wakes = 0;
+        s_sample_counter = 0;
+        s_dropped = 0;
+        s_head = 0;
+        s_count = 0;
+        ESP_LOGI(TAG, "Boot a frio: amostra a cada %d s, publicacao a cada %d",
+                 SLEEP_CYCLE_INTERVAL_MS / 1000, SLEEP_CYCLE_PUBLISH_EVERY);
+    }
+    s_wakes++;
+
+    sensor_reading_t reading;
+    if (take_reading(&reading) == ESP_OK)
+    {
+        store_sample(&reading);
+        ESP_LOGI(TAG, "Despertar %lu: T=%ld.%02ld C, %lu amostras guardadas",
+                 s_wakes, reading.temperatura_centi / 100,
+                 reading.temperatura_centi % 100, s_count);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Despertar %lu: sem leitura do ADC", s_wakes);
+    }
+
+    /* Anel cheio não antecipa a publicação: com o broker fora, ligar o
+     * rádio a cada despertar esgotaria a bateria */
+    if (cold_boot || s_wakes % SLEEP_CYCLE_PUBLISH_EVERY == 0)
+    {
+        /* Status online e informações de boot saem na conexão */
+        if (mqtt_system_init() == ESP_OK &&
+            mqtt_system_wait_connected(SLEEP_CYCLE_CONNECT_TIMEOUT_MS) == ESP_OK)
+        {
+            uint32_t sent = s_count;
+            if (publish_samples())
+            {
+                s_head = 0;
+                s_count = 0;
+                ESP_LOGI(TAG, "%lu amostras publicadas (%lu descartadas desde o boot)",
+                         sent, s_dropped);
+            }
+            else
+            {
+                ESP_LOGW(TAG, "ACKs pendentes, amostras mantidas para o proximo ciclo");
+            }
+        }
+        else
+        {
+            ESP_LOGW(TAG, "Sem conexao, %lu amostras mantidas", s_count);
+        }
+
+        /* Publica "offline" (retido) e encerra o cliente antes de dormir */
+        mqtt_system_shutdown();
+        esp_wifi_stop();
+    }
+
+    uint64_t awake_us = (uint64_t)esp_timer_get_time();
+    uint64_t interval_us = (uint64_t)SLEEP_CYCLE_INTERVAL_MS * 1000;
+    uint64_t sleep_us = awake_us < interval_us ? interval_us - awake_us : 1000;
+
+    ESP_LOGI(TAG, "Acordado por %llu ms, dormindo %llu ms",
+             awake_us / 1000, sleep_us / 1000);
+
+    esp_sleep_enable_timer_wakeup(sleep_us);
+    log_sink_flush();
+    esp_deep_sleep_start();
+}
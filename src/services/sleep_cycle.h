@@ -0,0 +1,61 @@
+/**
+ * @file sleep_cycle.h
+ * @brief Ciclo de deep sleep com amostras guardadas na memória RTC
+ *
+ * Compilado com CONFIG_DEEP_SLEEP_MODE (ambiente esp32-deepsleep), o
+ * firmware não fica ligado: app_main() chama sleep_cycle_run(), que a
+ * cada despertar
+ *
+ * 1. lê o sensor (sensor_adc ligado só até o filtro assentar);
+ * 2. acrescenta a amostra a um anel na memória RTC lenta, que sobrevive
+ *    ao deep sleep;
+ * 3. a cada SLEEP_CYCLE_PUBLISH_EVERY despertares (e no boot a frio) sobe
+ *    WiFi e MQTT com mqtt_system_init(), publica as amostras guardadas
+ *    como um único lote, um health check e o status, e espera os ACKs;
+ * 4. dorme até completar SLEEP_CYCLE_INTERVAL_MS desde o despertar.
+ *
+ * O rádio só liga num de cada SLEEP_CYCLE_PUBLISH_EVERY despertares, e a
+ * resolução das amostras não muda. Se a conexão falhar, as amostras
+ * continuam no anel para o próximo ciclo de publicação; com o anel cheio
+ * a mais antiga é descartada (e contada).
+ *
+ * O timestamp das amostras vem do relógio do sistema, mantido pelo
+ * timer RTC durante o deep sleep (o esp_timer recomeça a cada despertar).
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef SLEEP_CYCLE_H
+#define SLEEP_CYCLE_H
+
+#include "mqtt_system.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define SLEEP_CYCLE_INTERVAL_MS 60000			   ///< Período entre amostras
+#define SLEEP_CYCLE_PUBLISH_EVERY 12			   ///< Despertares por publicação
+#define SLEEP_CYCLE_MAX_SAMPLES TELEMETRY_BATCH_MAX_SAMPLES ///< Anel na memória RTC (um lote)
+#define SLEEP_CYCLE_SETTLE_FRAMES 3				   ///< Quadros do ADC antes da leitura (mediana ativa)
+#define SLEEP_CYCLE_SENSOR_TIMEOUT_MS 500		   ///< Espera máxima pela leitura
+#define SLEEP_CYCLE_CONNECT_TIMEOUT_MS 15000	   ///< Espera máxima pelo broker
+#define SLEEP_CYCLE_FLUSH_TIMEOUT_MS 3000		   ///< Espera máxima pelos ACKs
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Executa um despertar do ciclo e entra em deep sleep
+ *
+ * @note Não retorna
+ */
+void sleep_cycle_run(void);
+
+#endif /* SLEEP_CYCLE_H */
@@ -0,0 +1,240 @@
+/**
+ * @file trace.c
+ * @brief Pontos de trace no caminho quente - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifdef CONFIG_TRACE_ENABLE
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "trace.h"
+#include "rtos_config.h"
+#include "json_writer.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "TRACE";
+
+_Static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0,
+               "TRACE_RING_SIZE deve ser potencia de 2");
+
+/** Registro do anel */
+typedef struct
+{
+    uint32_t start;  ///< Ciclos no início do trecho
+    uint32_t cycles; ///< Duração em ciclos
+    uint32_t arg;    ///< Dado do ponto
+    uint8_t point;   ///< trace_point_t
+} trace_entry_t;
+
+/** Somas de um ponto na janela do resumo */
+typedef struct
+{
+    uint32_t count;      ///< Registros
+    uint64_t cycles;     ///< Soma das durações
+    uint32_t max_cycles; ///< Maior duração
+} point_stats_t;
+
+/** Estado de um core: escrito só pelo próprio core, lido pelo resumo */
+typedef struct
+{
+    portMUX_TYPE lock;
+    uint32_t head; ///< Registros gravados desde o boot
+    trace_entry_t ring[TRACE_RING_SIZE];
+    point_stats_t stats[TRACE_POINT_COUNT];
+} core_trace_t;
+
+static const char *const s_point_names[TRACE_POINT_COUNT] = {
+    [TRACE_PUBLISH] = "publish",
+    [TRACE_EVENT_DATA] = "event",
+    [TRACE_DISPATCH] = "dispatch",
+    [TRACE_LOCAL] = "local",
+    [TRACE_ACTUATION] = "actuation",
+};
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+static core_trace_t s_cores[portNUM_PROCESSORS] = {
+    [0 ... portNUM_PROCESSORS - 1] = {.lock = portMUX_INITIALIZER_UNLOCKED},
+};
+
+/** Início da janela do resumo */
+static int64_t s_window_start_us = 0;
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+static uint32_t cycles_to_us(uint64_t cycles, uint32_t ticks_per_us)
+{
+    return ticks_per_us > 0 ? (uint32_t)(cycles / ticks_per_us) : 0;
+}
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+void trace_record(trace_point_t point, uint32_t start, uint32_t arg)
+{
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+
+    if (point >= TRACE_POINT_COUNT)
+    {
+        return;
+    }
+
+    core_trace_t *core = &s_cores[xPortGetCoreID()];
+
+    portENTER_CRITICAL_SAFE(&core->lock);
+    core->ring[core->head & (TRACE_RING_SIZE - 1)] =
+        (trace_entry_t){start, cycles, arg, (uint8_t)point};
+    core->head++;
+
+    point_stats_t *stats = &core->stats[point];
+    stats->count++;
+    stats->cycles += cycles;
+    if (cycles > stats->max_cycles)
+    {
+        stats->max_cycles = cycles;
+    }
+    portEXIT_CRITICAL_SAFE(&core->lock);
+}
+
+int trace_summary_json(char *buf, size_t cap)
+{
+    uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+    int64_t now_us = esp_timer_get_time();
+
+    json_writer_t jw;
+    json_writer_init(&jw, buf, cap);
+
+    json_begin_object(&jw);
+    json_add_uint(&jw, "window_ms", (now_us - s_window_start_us) / 1000);
+    json_add_uint(&jw, "cpu_mhz", ticks_per_us);
+    s_window_start_us = now_us;
+
+    json_begin_array(&jw, "points");
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+    {
+        core_trace_t *core = &s_cores[c];
+        point_stats_t stats[TRACE_POINT_COUNT];
+
+        portENTER_CRITICAL_SAFE(&core->lock);
+        memcpy(stats, core->stats, sizeof(stats));
+        memset(core->stats, 0, sizeof(core->stats));
+        portEXIT_CRITICAL_SAFE(&core->lock);
+
+        for (int p = 0; p < TRACE_POINT_COUNT; p++)
+        {
+            if (stats[p].count == 0)
+            {
+                continue;
+            }
+
+            float avg_us = ticks_per_us > 0
+                               ? (float)stats[p].cycles / stats[p].count / ticks_per_us
+                               : 0.0f;
+
+            json_begin_object(&jw);
+            json_add_int(&jw, "core", c);
+            json_add_string(&jw, "name", s_point_names[p]);
+            json_add_uint(&jw, "count", stats[p].count);
+            json_add_fixed(&jw, "avg_us", avg_us, 1);
+            json_add_uint(&jw, "max_us", cycles_to_us(stats[p].max_cycles, ticks_per_us));
+            json_end_object(&jw);
+        }
+    }
+    json_end_array(&jw);
+
+    json_begin_array(&jw, "stacks");
+    for (int i = 0; i < RTOS_TASK_COUNT; i++)
+    {
+        const rtos_task_config_t *cfg = rtos_task_config((rtos_task_id_t)i);
+
+        json_begin_object(&jw);
+        json_add_string(&jw, "name", cfg->name);
+        json_add_uint(&jw, "size", cfg->stack_size);
+        json_add_uint(&jw, "peak", rtos_task_stack_peak((rtos_task_id_t)i));
+        json_end_object(&jw);
+    }
+    json_end_array(&jw);
+
+    json_end_object(&jw);
+
+    return json_writer_finish(&jw);
+}
+
+void trace_dump(void)
+{
+    uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+    {
+        core_trace_t *core = &s_cores[c];
+
+        portENTER_CRITICAL_SAFE(&core->lock);
+        uint32_t head = core->head;
+        portEXIT_CRITICAL_SAFE(&core->lock);
+
+        uint32_t first = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+        uint32_t origin = 0;
+        bool has_origin = false;
+
+        ESP_LOGI(TAG, "=== Core %d: %lu registros ===", c, head - first);
+
+        /* Registro a registro: o log não pode executar na seção crítica, e
+         * os sobrescritos enquanto o dump imprime são pulados */
+        for (uint32_t i = first; i < head; i++)
+        {
+            trace_entry_t entry;
+            bool overwritten;
+
+            portENTER_CRITICAL_SAFE(&core->lock);
+            overwritten = core->head - i > TRACE_RING_SIZE;
+            entry = core->ring[i & (TRACE_RING_SIZE - 1)];
+            portEXIT_CRITICAL_SAFE(&core->lock);
+
+            if (overwritten)
+            {
+                continue;
+            }
+            if (!has_origin)
+            {
+                origin = entry.start;
+                has_origin = true;
+            }
+
+            ESP_LOGI(TAG, "+%9lu us %-9s %6lu us arg=%lu",
+                     cycles_to_us(entry.start - origin, ticks_per_us),
+                     s_point_names[entry.point],
+                     cycles_to_us(entry.cycles, ticks_per_us), entry.arg);
+        }
+    }
+}
+
+#endif /* CONFIG_TRACE_ENABLE */
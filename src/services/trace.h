@@ -0,0 +1,120 @@
+/**
+ * @file trace.h
+ * @brief Pontos de trace no caminho quente: ciclos de CPU por core
+ *
+ * Compilado com CONFIG_TRACE_ENABLE, cada ponto de trace mede em ciclos
+ * de CPU (esp_cpu_get_cycle_count) o trecho entre TRACE_BEGIN() e
+ * TRACE_END() e grava o registro no anel do core em que executou, junto
+ * de contagem, soma e máximo por ponto. Sem a flag as macros somem e o
+ * caminho quente não muda.
+ *
+ * Pontos instrumentados:
+ *
+ *   publish   : publicação no cliente esp-mqtt (arg = bytes)
+ *   event     : MQTT_EVENT_DATA, cópia para a fila de entrada (arg = bytes)
+ *   dispatch  : despacho de uma mensagem recebida aos handlers (arg = handlers)
+ *   local     : entrega local de uma publicação própria (arg = handlers)
+ *   actuation : escrita de um GPIO pelo rule_engine (arg = GPIO)
+ *
+ * Os anéis são por core porque o contador de ciclos é por core: os
+ * instantes só são comparáveis dentro do mesmo anel. Por isso os pontos
+ * ficam em tasks fixadas num core (plano do rtos_config, esp-mqtt e
+ * esp_timer no core 0); uma task sem afinidade que migre entre o início e
+ * o fim produz uma duração sem sentido. Com CONFIG_LOW_POWER_MODE a
+ * frequência muda (DFS) e a conversão para us usa a frequência do momento
+ * da leitura: as durações são aproximadas.
+ *
+ * trace_summary_json() resume a janela desde o resumo anterior (pontos e
+ * pico de stack das tasks do plano), publicado pelo job de health em
+ * MQTT_TOPIC_TRACE; a carga de CPU por task sai em MQTT_TOPIC_HEALTH
+ * "/cpu". Uma mensagem em MQTT_TOPIC_TRACE_DUMP imprime os anéis no log
+ * (trace_dump()) e antecipa o resumo.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_cpu.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define TRACE_RING_SIZE 128 ///< Registros por core (potência de 2)
+
+/*
+ * =============================================================================
+ * TIPOS
+ * =============================================================================
+ */
+
+/** Pontos de trace */
+typedef enum
+{
+	TRACE_PUBLISH = 0, ///< Publicação no cliente esp-mqtt
+	TRACE_EVENT_DATA,  ///< MQTT_EVENT_DATA na task do esp-mqtt
+	TRACE_DISPATCH,	   ///< Despacho de mensagem recebida
+	TRACE_LOCAL,	   ///< Entrega local de publicação própria
+	TRACE_ACTUATION,   ///< Escrita de GPIO pelas regras
+	TRACE_POINT_COUNT
+} trace_point_t;
+
+/*
+ * =============================================================================
+ * MACROS DE INSTRUMENTAÇÃO
+ * =============================================================================
+ */
+
+/*
+ *   TRACE_BEGIN(t);
+ *   gpio_set_level(gpio, 1);
+ *   TRACE_END(TRACE_ACTUATION, t, gpio);
+ */
+#ifdef CONFIG_TRACE_ENABLE
+#define TRACE_BEGIN(var) uint32_t var = esp_cpu_get_cycle_count()
+#define TRACE_END(point, var, arg) trace_record((point), (var), (uint32_t)(arg))
+#else
+#define TRACE_BEGIN(var) (void)0
+#define TRACE_END(point, var, arg) (void)0
+#endif
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Grava um registro no anel do core atual
+ *
+ * Pode ser chamada de task, ISR ou seção crítica.
+ *
+ * @param point Ponto de trace
+ * @param start Ciclos no início do trecho (TRACE_BEGIN)
+ * @param arg   Dado do ponto (bytes, handlers, GPIO)
+ */
+void trace_record(trace_point_t point, uint32_t start, uint32_t arg);
+
+/**
+ * @brief Serializa em JSON o resumo desde a chamada anterior e zera as somas
+ *
+ * Por core e ponto: contagem, média e máximo em us; por task do plano:
+ * stack configurada e pico de uso. Os anéis não são apagados.
+ *
+ * @return Bytes escritos, ou -1 se o buffer for insuficiente
+ */
+int trace_summary_json(char *buf, size_t cap);
+
+/**
+ * @brief Imprime no log os anéis em ordem cronológica, um core por vez
+ */
+void trace_dump(void);
+
+#endif /* TRACE_H */
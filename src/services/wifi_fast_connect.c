@@ -0,0 +1,413 @@
+/**
+ * @file wifi_fast_connect.c
+ * @brief Conexão WiFi rápida com canal, BSSID e endereço IP guardados na NVS - Implementação
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include "wifi_fast_connect.h"
+#include "deadline.h"
+
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_netif_net_stack.h"
+#include "lwip/dhcp.h"
+#include "nvs.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+static const char *TAG = "WIFI_FAST";
+
+/** Chave do cache e versão do seu layout */
+#define CACHE_NVS_KEY "ap"
+#define CACHE_VERSION 2
+
+/** Maior espera de um prazo de renovação; acima disso é rearmado */
+#define LEASE_CHECK_MAX_MS (24UL * 3600 * 1000)
+
+/** Cache gravado na NVS (endereços em ordem de rede, como no lwIP) */
+typedef struct
+{
+    uint8_t version;  ///< CACHE_VERSION
+    uint8_t channel;  ///< Canal primário do AP
+    uint8_t bssid[6]; ///< BSSID do AP
+    uint32_t ip;      ///< Endereço (0 = não guardado)
+    uint32_t netmask; ///< Máscara
+    uint32_t gw;      ///< Gateway
+    uint32_t dns;     ///< DNS principal
+    uint32_t lease_s; ///< Lease concedido pelo DHCP (s, 0 = desconhecido)
+    uint32_t bound_s; ///< Relógio do RTC (s) quando o lease foi obtido
+} wifi_cache_t;
+
+/*
+ * =============================================================================
+ * VARIÁVEIS PRIVADAS (static)
+ * =============================================================================
+ */
+
+/** Netif do STA */
+static esp_netif_t *s_netif = NULL;
+
+/** Tempo do boot até o primeiro IP (0 = ainda sem IP) */
+static uint32_t s_boot_ms = 0;
+
+/** Primeiro IP do boot obtido com o cache */
+static bool s_used = false;
+
+#ifdef CONFIG_WIFI_FAST_CONNECT
+/** Conteúdo atual do cache na NVS */
+static wifi_cache_t s_cache;
+
+/** Configuração do STA presa ao canal/BSSID do cache */
+static bool s_pinned = false;
+
+/** A configuração presa já obteve IP */
+static bool s_pinned_got_ip = false;
+
+/** Endereço do cache aplicado ao netif (DHCP parado) */
+static bool s_lease_applied = false;
+
+/** Volta ao DHCP na renovação (T1) do lease guardado */
+static deadline_id_t s_deadline_lease = -1;
+#endif
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+#if defined(CONFIG_WIFI_STATIC_IP) || defined(CONFIG_WIFI_FAST_CONNECT)
+/**
+ * @brief Fixa o endereço do netif, dispensando a troca DHCP
+ */
+static void apply_address(uint32_t ip, uint32_t netmask, uint32_t gw, uint32_t dns)
+{
+    esp_netif_ip_info_t info = {
+        .ip.addr = ip,
+        .netmask.addr = netmask,
+        .gw.addr = gw,
+    };
+
+    esp_netif_dhcpc_stop(s_netif);
+    esp_netif_set_ip_info(s_netif, &info);
+
+    if (dns != 0)
+    {
+        esp_netif_dns_info_t dns_info = {
+            .ip.u_addr.ip4.addr = dns,
+            .ip.type = ESP_IPADDR_TYPE_V4,
+        };
+        esp_netif_set_dns_info(s_netif, ESP_NETIF_DNS_MAIN, &dns_info);
+    }
+}
+#endif
+
+#ifdef CONFIG_WIFI_FAST_CONNECT
+static bool load_cache(void)
+{
+    nvs_handle_t nvs;
+    size_t size = sizeof(s_cache);
+
+    if (nvs_open(WIFI_FAST_CONNECT_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK)
+    {
+        return false;
+    }
+
+    esp_err_t ret = nvs_get_blob(nvs, CACHE_NVS_KEY, &s_cache, &size);
+    nvs_close(nvs);
+
+    if (ret != ESP_OK || size != sizeof(s_cache) ||
+        s_cache.version != CACHE_VERSION ||
+        s_cache.channel < 1 || s_cache.channel > 14)
+    {
+        memset(&s_cache, 0, sizeof(s_cache));
+        return false;
+    }
+
+    return true;
+}
+
+#ifndef CONFIG_WIFI_STATIC_IP
+/** Relógio do RTC em segundos: segue no deep sleep e no reset por software */
+static uint32_t rtc_now_s(void)
+{
+    return (uint32_t)time(NULL);
+}
+
+/**
+ * @brief Segundos até a renovação (T1, metade do lease) do endereço guardado
+ *
+ * @return 0 se o lease já passou de T1 ou não pode ser avaliado: lease
+ *         desconhecido ou relógio zerado (boot por energia ou brownout)
+ */
+static uint32_t lease_remaining_s(const wifi_cache_t *cache)
+{
+    esp_reset_reason_t reason = esp_reset_reason();
+    uint32_t now = rtc_now_s();
+
+    if (cache->lease_s == 0 || reason == ESP_RST_POWERON ||
+        reason == ESP_RST_BROWNOUT || now < cache->bound_s)
+    {
+        return 0;
+    }
+
+    uint32_t elapsed = now - cache->bound_s;
+    uint32_t renew = cache->lease_s / 2;
+
+    return elapsed < renew ? renew - elapsed : 0;
+}
+
+/** Lease concedido pelo servidor DHCP ao netif (s, 0 = desconhecido) */
+static uint32_t dhcp_lease_s(esp_netif_t *netif)
+{
+    struct netif *lwip_netif = esp_netif_get_netif_impl(netif);
+    struct dhcp *dhcp = lwip_netif != NULL ? netif_dhcp_data(lwip_netif) : NULL;
+
+    return dhcp != NULL ? dhcp->offered_t0_lease : 0;
+}
+
+/**
+ * @brief Prazo da renovação: devolve o netif ao DHCP
+ *
+ * O DHCP zera o endereço até obter o novo lease; as conexões caem e
+ * voltam com o IP_EVENT_STA_GOT_IP seguinte, que atualiza o cache.
+ */
+static void lease_deadline(void *ctx)
+{
+    if (!s_lease_applied)
+    {
+        return;
+    }
+
+    uint32_t remaining_s = lease_remaining_s(&s_cache);
+    if (remaining_s > 0)
+    {
+        uint32_t ms = remaining_s < LEASE_CHECK_MAX_MS / 1000 ? remaining_s * 1000
+                                                              : LEASE_CHECK_MAX_MS;
+        deadline_arm(s_deadline_lease, ms);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Lease guardado na renovacao, voltando ao DHCP");
+    s_lease_applied = false;
+    esp_netif_dhcpc_start(s_netif);
+}
+#endif
+
+static void store_cache(const wifi_cache_t *cache)
+{
+    nvs_handle_t nvs;
+
+    if (nvs_open(WIFI_FAST_CONNECT_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK)
+    {
+        return;
+    }
+
+    if (cache != NULL)
+    {
+        nvs_set_blob(nvs, CACHE_NVS_KEY, cache, sizeof(*cache));
+        s_cache = *cache;
+    }
+    else
+    {
+        nvs_erase_key(nvs, CACHE_NVS_KEY);
+        memset(&s_cache, 0, sizeof(s_cache));
+    }
+
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+#endif
+
+/*
+ * =============================================================================
+ * IMPLEMENTAÇÃO DAS FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+void wifi_fast_connect_apply(wifi_config_t *config, esp_netif_t *netif)
+{
+    s_netif = netif;
+
+#ifdef CONFIG_WIFI_STATIC_IP
+    apply_address(esp_ip4addr_aton(CONFIG_WIFI_STATIC_IP),
+                  esp_ip4addr_aton(CONFIG_WIFI_STATIC_NETMASK),
+                  esp_ip4addr_aton(CONFIG_WIFI_STATIC_GATEWAY),
+                  esp_ip4addr_aton(CONFIG_WIFI_STATIC_DNS));
+    ESP_LOGI(TAG, "  IP estatico: %s", CONFIG_WIFI_STATIC_IP);
+#endif
+
+#ifdef CONFIG_WIFI_FAST_CONNECT
+    if (!load_cache())
+    {
+        ESP_LOGI(TAG, "  Sem cache de conexao, varredura completa");
+        return;
+    }
+
+    config->sta.channel = s_cache.channel;
+    memcpy(config->sta.bssid, s_cache.bssid, sizeof(config->sta.bssid));
+    config->sta.bssid_set = true;
+    s_pinned = true;
+    s_pinned_got_ip = false;
+
+#ifndef CONFIG_WIFI_STATIC_IP
+    /* Endereço só até a renovação do lease; depois, canal e BSSID com DHCP */
+    if (s_cache.ip != 0 && lease_remaining_s(&s_cache) > 0)
+    {
+        if (s_deadline_lease < 0)
+        {
+            s_deadline_lease = deadline_register("WiFiLease", lease_deadline, NULL);
+        }
+        apply_address(s_cache.ip, s_cache.netmask, s_cache.gw, s_cache.dns);
+        s_lease_applied = true;
+    }
+#endif
+
+    ESP_LOGI(TAG, "  Conexao rapida: canal %u, BSSID %02x:%02x:%02x:%02x:%02x:%02x%s",
+             s_cache.channel,
+             s_cache.bssid[0], s_cache.bssid[1], s_cache.bssid[2],
+             s_cache.bssid[3], s_cache.bssid[4], s_cache.bssid[5],
+             s_lease_applied ? ", IP guardado" : "");
+#else
+    (void)config;
+#endif
+}
+
+void wifi_fast_connect_on_got_ip(const ip_event_got_ip_t *event)
+{
+    if (s_boot_ms == 0)
+    {
+        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        s_boot_ms = now_ms != 0 ? now_ms : 1;
+#ifdef CONFIG_WIFI_FAST_CONNECT
+        s_used = s_pinned;
+#endif
+        ESP_LOGI(TAG, "Primeiro IP %lu ms apos o boot%s",
+                 s_boot_ms, s_used ? " (conexao rapida)" : "");
+    }
+
+#ifdef CONFIG_WIFI_FAST_CONNECT
+    s_pinned_got_ip = true;
+
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK)
+    {
+        return;
+    }
+
+    wifi_cache_t cache = {
+        .version = CACHE_VERSION,
+        .channel = ap.primary,
+    };
+    memcpy(cache.bssid, ap.bssid, sizeof(cache.bssid));
+
+#if WIFI_FAST_CONNECT_CACHE_LEASE && !defined(CONFIG_WIFI_STATIC_IP)
+    if (s_lease_applied)
+    {
+        /* Endereço guardado em uso: o lease continua o do cache */
+        cache.ip = s_cache.ip;
+        cache.netmask = s_cache.netmask;
+        cache.gw = s_cache.gw;
+        cache.dns = s_cache.dns;
+        cache.lease_s = s_cache.lease_s;
+        cache.bound_s = s_cache.bound_s;
+
+        /* Nada renova o lease com o DHCP parado: o prazo devolve ao DHCP */
+        lease_deadline(NULL);
+    }
+    else
+    {
+        cache.lease_s = dhcp_lease_s(event->esp_netif);
+
+        /* Sem lease conhecido o endereço não é reaproveitado */
+        if (cache.lease_s != 0)
+        {
+            cache.bound_s = rtc_now_s();
+            cache.ip = event->ip_info.ip.addr;
+            cache.netmask = event->ip_info.netmask.addr;
+            cache.gw = event->ip_info.gw.addr;
+
+            esp_netif_dns_info_t dns_info;
+            if (esp_netif_get_dns_info(event->esp_netif, ESP_NETIF_DNS_MAIN,
+                                       &dns_info) == ESP_OK)
+            {
+                cache.dns = dns_info.ip.u_addr.ip4.addr;
+            }
+        }
+    }
+#else
+    (void)event;
+#endif
+
+    /* Grava só quando algo mudou: um boot normal não escreve na flash */
+    if (memcmp(&cache, &s_cache, sizeof(cache)) != 0)
+    {
+        store_cache(&cache);
+        ESP_LOGI(TAG, "Cache de conexao atualizado (canal %u)", cache.channel);
+    }
+#else
+    (void)event;
+#endif
+}
+
+bool wifi_fast_connect_on_disconnected(void)
+{
+#ifdef CONFIG_WIFI_FAST_CONNECT
+    if (!s_pinned)
+    {
+        return false;
+    }
+    s_pinned = false;
+
+    if (!s_pinned_got_ip)
+    {
+        /* AP mudou de canal, foi trocado ou recusou o endereço guardado */
+        ESP_LOGW(TAG, "Conexao rapida falhou, cache descartado");
+        store_cache(NULL);
+    }
+
+    /* Próximas tentativas varrem os canais, como sem cache */
+    wifi_config_t config;
+    if (esp_wifi_get_config(WIFI_IF_STA, &config) == ESP_OK)
+    {
+        config.sta.bssid_set = false;
+        config.sta.channel = 0;
+        esp_wifi_set_config(WIFI_IF_STA, &config);
+    }
+
+    if (s_lease_applied)
+    {
+        s_lease_applied = false;
+        deadline_cancel(s_deadline_lease);
+        esp_netif_dhcpc_start(s_netif);
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t wifi_fast_connect_boot_ms(void)
+{
+    return s_boot_ms;
+}
+
+bool wifi_fast_connect_used(void)
+{
+    return s_used;
+}
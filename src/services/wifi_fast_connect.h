@@ -0,0 +1,97 @@
+/**
+ * @file wifi_fast_connect.h
+ * @brief Conexão WiFi rápida com canal, BSSID e endereço IP guardados na NVS
+ *
+ * Sem cache, todo boot faz uma varredura de canais e uma troca DHCP
+ * completa, segundos de rádio ligado que dominam o consumo de um nó que
+ * acorda para publicar e volta a dormir.
+ *
+ * Compilado com CONFIG_WIFI_FAST_CONNECT, o módulo:
+ *
+ * - após cada conexão bem-sucedida grava na NVS o canal e o BSSID do AP e
+ *   o endereço obtido por DHCP (máscara, gateway e DNS), apenas quando
+ *   algo mudou, para não desgastar a flash;
+ * - no boot seguinte preenche o wifi_config_t com esse canal e BSSID (o
+ *   STA associa sem varrer) e aplica o endereço guardado no netif, com o
+ *   cliente DHCP parado;
+ * - se a tentativa com cache cair antes de obter IP, apaga o cache, volta
+ *   à varredura completa e ao DHCP e tenta de novo imediatamente.
+ *
+ * Com CONFIG_WIFI_STATIC_IP (e CONFIG_WIFI_STATIC_NETMASK/GATEWAY/DNS) o
+ * endereço configurado é usado em vez do guardado, com ou sem
+ * CONFIG_WIFI_FAST_CONNECT, e nunca é trocado pelo DHCP.
+ *
+ * O endereço guardado vale até a renovação (T1, metade do lease) contada
+ * pelo relógio do RTC a partir da troca DHCP que o obteve. Depois disso, ou
+ * após um boot por energia (relógio zerado), o boot usa o DHCP; se T1 chega
+ * com o STA conectado, o cliente DHCP é religado e o endereço renovado.
+ *
+ * O tempo do boot até o primeiro IP é medido com ou sem a flag e publicado
+ * nas informações de boot.
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef WIFI_FAST_CONNECT_H
+#define WIFI_FAST_CONNECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+
+/*
+ * =============================================================================
+ * CONFIGURAÇÕES
+ * =============================================================================
+ */
+
+#define WIFI_FAST_CONNECT_NVS_NAMESPACE "wifi_fc" ///< Namespace NVS do cache
+#define WIFI_FAST_CONNECT_CACHE_LEASE 1			  ///< Reutilizar o endereço do DHCP
+
+/*
+ * =============================================================================
+ * FUNÇÕES PÚBLICAS
+ * =============================================================================
+ */
+
+/**
+ * @brief Aplica o cache (ou o IP estático) antes de esp_wifi_set_config()
+ *
+ * @param config Configuração do STA a completar com canal e BSSID
+ * @param netif  Netif do STA (recebe o endereço fixo)
+ */
+void wifi_fast_connect_apply(wifi_config_t *config, esp_netif_t *netif);
+
+/**
+ * @brief Registra a conexão (IP_EVENT_STA_GOT_IP)
+ *
+ * Atualiza o cache se o AP ou o endereço mudaram e, na primeira conexão
+ * do boot, o tempo do boot até o IP.
+ */
+void wifi_fast_connect_on_got_ip(const ip_event_got_ip_t *event);
+
+/**
+ * @brief Trata uma desconexão (WIFI_EVENT_STA_DISCONNECTED)
+ *
+ * Se o STA ainda estava preso ao canal/BSSID guardados, volta à varredura
+ * completa e ao DHCP; se a tentativa com cache nem obteve IP, o cache é
+ * apagado.
+ *
+ * @return true se a configuração mudou e a tentativa deve ser imediata
+ */
+bool wifi_fast_connect_on_disconnected(void);
+
+/**
+ * @brief Tempo do boot até o primeiro IP em ms (0 = ainda sem IP)
+ */
+uint32_t wifi_fast_connect_boot_ms(void);
+
+/**
+ * @brief Informa se o primeiro IP do boot veio do cache
+ */
+bool wifi_fast_connect_used(void);
+
+#endif /* WIFI_FAST_CONNECT_H */
@@ -1,6 +1,6 @@
 /**
  * @file custom_publish_task.c
- * @brief Implementação da task de publicação de dados customizados
+ * @brief Implementação do job de publicação de dados customizados
  *
  * @author Moacyr Francischetti Correa
  * @date 2025
@@ -8,100 +8,94 @@
 
 #include "tasks/custom_publish_task.h"
 #include "services/mqtt_system.h"
+#include "services/json_writer.h"
+#include "services/report_policy.h"
 #include "esp_log.h"
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
 #include "esp_random.h"
 
 static const char *TAG = "CUSTOM_PUB_TASK";
 
-void custom_publish_task(void *pvParameters)
+esp_err_t custom_publish_init(void)
 {
-    uint32_t publish_count = 0;
-    srand(time(NULL));
-
-    ESP_LOGI(TAG, "Task de publicacao customizada iniciada");
-
-    while (1)
+    const report_policy_t policy = {
+        .deadband = {CUSTOM_PUBLISH_DEADBAND},
+        .min_interval_ms = 0,
+        .heartbeat_ms = CUSTOM_PUBLISH_HEARTBEAT_MS,
+    };
+
+    esp_err_t ret = report_policy_register(MQTT_TOPIC_LUMINOSIDADE, &policy, 1);
+    if (ret == ESP_OK)
     {
-        /* Aguardar intervalo de publicação */
-        vTaskDelay(pdMS_TO_TICKS(CUSTOM_PUBLISH_INTERVAL_MS));
-
-        /* Verificar se MQTT está conectado antes de publicar */
-        if (mqtt_system_is_connected())
-        {
-            publish_count++;
-
-            int luminosidade = esp_random() % 11; 
-            char lum_str[4];
-            snprintf(lum_str, sizeof(lum_str), "%d", luminosidade);
-
-            int ret_lum = mqtt_publish_data(
-                "casa/externo/luminosidade",
-                lum_str,
-                0,
-                1,
-                false);
+        ret = report_policy_register(MQTT_TOPIC_TEMPERATURA, &policy, 1);
+    }
 
-            if (ret_lum >= 0)
-            {
-                ESP_LOGI(TAG, "Luminosidade: %d (Publicado)", luminosidade);
-            }
-            else
-            {
-                ESP_LOGW(TAG, "Falha ao publicar luminosidade");
-            }
+    return ret;
+}
 
-            int temperatura = (esp_random() % 49) - 3;
-            char temp_str[4];
-            snprintf(temp_str, sizeof(temp_str), "%d", temperatura);
+void custom_publish_job(void *ctx)
+{
+    static uint32_t publish_count = 0;
 
-            int ret_temp = mqtt_publish_data(
-                "casa/sala/temperatura",
-                temp_str,
-                0,
-                1,
-                false);
+    /* Sem conexão, as publicações vão para o buffer offline */
+    publish_count++;
 
-            if (ret_temp >= 0)
-            {
-                ESP_LOGI(TAG, "Temperatura: %d (Publicado)", temperatura);
-            }
-            else
-            {
-                ESP_LOGW(TAG, "Falha ao publicar temperatura");
-            }
+    int luminosidade = esp_random() % 11;
+    int ret_lum = mqtt_publish_value(MQTT_TOPIC_LUMINOSIDADE, luminosidade,
+                                     0, 1, false);
 
-            /* Preparar mensagem customizada em formato JSON */
-            char custom_msg[128];
-            snprintf(custom_msg, sizeof(custom_msg),
-                     "{\"publish_count\":%lu,\"status\":\"operational\"}",
-                     publish_count);
+    if (ret_lum >= 0)
+    {
+        ESP_LOGD(TAG, "Luminosidade: %d (Publicado)", luminosidade);
+    }
+    else if (ret_lum == MQTT_PUBLISH_SUPPRESSED)
+    {
+        ESP_LOGD(TAG, "Luminosidade: %d (sem mudanca)", luminosidade);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Falha ao publicar luminosidade");
+    }
 
-            /* Publicar dados customizados */
-            esp_err_t ret = mqtt_publish_data(
-                CUSTOM_PUBLISH_TOPIC,
-                custom_msg,
-                0,      // strlen automático
-                0,      // QoS 0
-                false); // sem retain
+    int temperatura = (esp_random() % 49) - 3;
+    int ret_temp = mqtt_publish_value(MQTT_TOPIC_TEMPERATURA, temperatura,
+                                      0, 1, false);
 
-            if (ret == ESP_OK)
-            {
-                ESP_LOGI(TAG, "Dados customizados publicados (#%lu)", publish_count);
-            }
-            else
-            {
-                ESP_LOGW(TAG, "Falha ao publicar dados customizados");
-            }
-        }
-        else
-        {
-            ESP_LOGW(TAG, "MQTT desconectado, aguardando reconexao...");
-        }
+    if (ret_temp >= 0)
+    {
+        ESP_LOGD(TAG, "Temperatura: %d (Publicado)", temperatura);
+    }
+    else if (ret_temp == MQTT_PUBLISH_SUPPRESSED)
+    {
+        ESP_LOGD(TAG, "Temperatura: %d (sem mudanca)", temperatura);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Falha ao publicar temperatura");
     }
 
-    /* Task nunca deve chegar aqui */
-    vTaskDelete(NULL);
+    /* Preparar mensagem customizada em formato JSON */
+    char custom_msg[128];
+    json_writer_t jw;
+    json_writer_init(&jw, custom_msg, sizeof(custom_msg));
+    json_begin_object(&jw);
+    json_add_uint(&jw, "publish_count", publish_count);
+    json_add_string(&jw, "status", "operational");
+    json_end_object(&jw);
+
+    /* Publicar dados customizados */
+    esp_err_t ret = mqtt_publish_data(
+        CUSTOM_PUBLISH_TOPIC,
+        custom_msg,
+        json_writer_finish(&jw),
+        0,      // QoS 0
+        false); // sem retain
+
+    if (ret == ESP_OK)
+    {
+        ESP_LOGD(TAG, "Dados customizados publicados (#%lu)", publish_count);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Falha ao publicar dados customizados");
+    }
 }
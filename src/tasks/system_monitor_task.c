@@ -1,6 +1,6 @@
 /**
  * @file system_monitor_task.c
- * @brief Implementação da task de monitoramento do sistema
+ * @brief Implementação do job de monitoramento do sistema
  *
  * @author Moacyr Francischetti Correa
  * @date 2025
@@ -8,76 +8,58 @@
 
 #include "tasks/system_monitor_task.h"
 #include "services/mqtt_system.h"
+#include "services/app_config.h"
+#include "services/sensor_adc.h"
+#include "services/report_policy.h"
+#include "services/deadline.h"
 #include "esp_log.h"
 
 static const char *TAG = "MONITOR_TASK";
 
-void system_monitor_task(void *pvParameters)
+void system_monitor_job(void *ctx)
 {
-    uint32_t loop_count = 0;
+    static uint32_t loop_count = 0;
 
-    ESP_LOGI(TAG, "Task de monitoramento iniciada");
+    loop_count++;
 
-    while (1)
+    /* Poucas linhas por ciclo: cada uma ocupa a UART por alguns ms */
+    if (mqtt_system_is_connected())
     {
-        /* Aguardar intervalo de monitoramento */
-        vTaskDelay(pdMS_TO_TICKS(MONITOR_INTERVAL_MS));
-        loop_count++;
-
-        ESP_LOGI(TAG, "");
-        ESP_LOGI(TAG, "════════════════════════════════════════");
-        ESP_LOGI(TAG, "  Status do Sistema (Loop #%lu)", loop_count);
-        ESP_LOGI(TAG, "════════════════════════════════════════");
+        mqtt_statistics_t stats;
+        if (mqtt_get_statistics(&stats) == ESP_OK)
+        {
+            ESP_LOGI(TAG, "#%lu MQTT conectado: pub=%lu rec=%lu falhas=%lu desconexoes=%lu",
+                     loop_count, stats.total_publicadas, stats.total_recebidas,
+                     stats.falhas_publicacao, stats.desconexoes);
+        }
 
-        /* Verificar se MQTT está conectado */
-        if (mqtt_system_is_connected())
+        health_status_t health;
+        if (mqtt_get_health_status(&health) == ESP_OK)
         {
-            ESP_LOGI(TAG, "MQTT: Conectado e operacional");
+            ESP_LOGI(TAG, "Heap livre=%lu bytes, RSSI=%d dBm, uptime=%llu s",
+                     health.free_heap, health.wifi_rssi, health.uptime_sec);
 
-            /* Obter e exibir estatísticas */
-            mqtt_statistics_t stats;
-            if (mqtt_get_statistics(&stats) == ESP_OK)
+            /* Verificar alertas */
+            app_config_t cfg;
+            app_config_get(&cfg);
+
+            if (health.free_heap < cfg.heap_warn_bytes)
             {
-                ESP_LOGI(TAG, "Mensagens publicadas: %lu",
-                         stats.total_publicadas);
-                ESP_LOGI(TAG, "Mensagens recebidas: %lu",
-                         stats.total_recebidas);
-                ESP_LOGI(TAG, "Falhas de publicacao: %lu",
-                         stats.falhas_publicacao);
-                ESP_LOGI(TAG, "Desconexoes: %lu",
-                         stats.desconexoes);
+                ESP_LOGW(TAG, "Alerta: heap abaixo de %lu bytes", cfg.heap_warn_bytes);
             }
 
-            /* Obter status de saúde */
-            health_status_t health;
-            if (mqtt_get_health_status(&health) == ESP_OK)
+            if (health.wifi_rssi < -80)
             {
-                ESP_LOGI(TAG, "Heap livre: %lu bytes", health.free_heap);
-                ESP_LOGI(TAG, "WiFi RSSI: %d dBm", health.wifi_rssi);
-                ESP_LOGI(TAG, "Uptime: %llu segundos", health.uptime_sec);
-
-                /* Verificar alertas */
-                if (health.free_heap < 30000)
-                {
-                    ESP_LOGW(TAG, "Alerta: Memoria heap abaixo de 30KB!");
-                }
-
-                if (health.wifi_rssi < -80)
-                {
-                    ESP_LOGW(TAG, "Alerta: Sinal WiFi fraco!");
-                }
+                ESP_LOGW(TAG, "Alerta: Sinal WiFi fraco!");
             }
         }
-        else
-        {
-            ESP_LOGW(TAG, "MQTT: Desconectado");
-            ESP_LOGI(TAG, "Sistema tentando reconectar automaticamente...");
-        }
-
-        ESP_LOGI(TAG, "════════════════════════════════════════");
-        ESP_LOGI(TAG, "");
+    }
+    else
+    {
+        ESP_LOGW(TAG, "#%lu MQTT desconectado, reconexao automatica em curso", loop_count);
     }
 
-    /* Task nunca deve chegar aqui */
-    vTaskDelete(NULL);
+    sensor_adc_print_stats();
+    report_policy_print();
+    deadline_print();
 }
@@ -0,0 +1,157 @@
+/**
+ * @file test_publish_bench.c
+ * @brief Suíte Unity dos caminhos de publicação e de recepção MQTT
+ *
+ * Roda os casos de src/bench/publish_bench.h, com o mesmo cliente
+ * substituto, como testes do PlatformIO. Além das linhas BENCH (ciclos,
+ * latência, stack e heap, comparáveis com tools/bench_check.py), cada
+ * caso falha se houver erro de publicação, mensagem perdida no despacho
+ * ou folga de stack abaixo do mínimo.
+ *
+ * Comandos:
+ *   pio test -e esp32-bench                # hardware
+ *   pio test -e esp32-bench-qemu           # QEMU (test_testing_command)
+ *
+ * @author Moacyr Francischetti Correa
+ * @date 2025
+ */
+
+#ifndef CONFIG_BENCHMARK_MODE
+#error "A suite usa o cliente substituto: rode nos ambientes esp32-bench ou esp32-bench-qemu"
+#endif
+
+/*
+ * =============================================================================
+ * INCLUDES
+ * =============================================================================
+ */
+#include <unity.h>
+
+#include "bench/publish_bench.h"
+#include "bench/bench_report.h"
+
+/*
+ * =============================================================================
+ * DEFINIÇÕES PRIVADAS
+ * =============================================================================
+ */
+
+/** Folga mínima de stack das tasks medidas */
+#define TEST_MIN_STACK_FREE_BYTES 512
+
+/** Variação de heap tolerada por caso (timers e log de outras tasks) */
+#define TEST_HEAP_SLACK_BYTES 256
+
+/*
+ * =============================================================================
+ * FUNÇÕES AUXILIARES
+ * =============================================================================
+ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void run_publish_case(const char *name)
+{
+    publish_bench_result_t result;
+    int index = publish_bench_find_case(name);
+
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(0, index, name);
+    TEST_ASSERT_EQUAL(ESP_OK, publish_bench_run_case(index, &result));
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, result.failures, name);
+    TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE(0, result.bytes, name);
+    TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE(0, result.cycles, name);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(
+        PUBLISH_BENCH_TASK_STACK_SIZE - TEST_MIN_STACK_FREE_BYTES,
+        result.stack_used, name);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(TEST_HEAP_SLACK_BYTES,
+                                             result.heap_used, name);
+}
+
+/*
+ * =============================================================================
+ * TESTES
+ * =============================================================================
+ */
+
+static void test_setup(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, publish_bench_setup());
+}
+
+static void test_publish_data_qos0(void)
+{
+    run_publish_case("publish_data_qos0");
+}
+
+static void test_publish_data_qos1(void)
+{
+    run_publish_case("publish_data_qos1");
+}
+
+static void test_publish_value_local(void)
+{
+    run_publish_case("publish_value_local");
+}
+
+static void test_publish_telemetry(void)
+{
+    run_publish_case("publish_telemetry");
+}
+
+static void test_publish_health_check(void)
+{
+    run_publish_case("publish_health_check");
+}
+
+static void test_dispatch_burst(void)
+{
+    publish_bench_dispatch_t dispatch;
+
+    TEST_ASSERT_EQUAL(ESP_OK, publish_bench_run_dispatch(&dispatch));
+    TEST_ASSERT_EQUAL_UINT32(0, dispatch.dropped);
+    TEST_ASSERT_EQUAL_UINT32(PUBLISH_BENCH_BURSTS * PUBLISH_BENCH_BURST_SIZE,
+                             dispatch.delivered);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(dispatch.latency_max_us, dispatch.latency_avg_us);
+}
+
+static void test_memory(void)
+{
+    publish_bench_memory_t memory;
+    publish_bench_memory(&memory);
+
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(TEST_MIN_STACK_FREE_BYTES,
+                                        memory.job_worker_stack_free);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(TEST_MIN_STACK_FREE_BYTES,
+                                        memory.mqtt_dispatch_stack_free);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(memory.free_heap, memory.largest_block);
+}
+
+/*
+ * =============================================================================
+ * PONTO DE ENTRADA
+ * =============================================================================
+ */
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_setup);
+    RUN_TEST(test_publish_data_qos0);
+    RUN_TEST(test_publish_data_qos1);
+    RUN_TEST(test_publish_value_local);
+    RUN_TEST(test_publish_telemetry);
+    RUN_TEST(test_publish_health_check);
+    RUN_TEST(test_dispatch_burst);
+    RUN_TEST(test_memory);
+
+    bench_report_done("publish");
+    UNITY_END();
+}
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Extrai os resultados dos benchmarks do log do firmware e detecta regressões.
+
+O firmware compilado com CONFIG_BENCHMARK_MODE (ambientes esp32-bench e
+esp32-bench-qemu) imprime uma linha por resultado e uma por suíte
+concluída (ver src/bench/bench_report.h):
+
+  BENCH {"suite":"publish","case":"publish_data_qos0","cycles":1834,...}
+  BENCH_DONE {"suite":"publish"}
+
+Uso:
+  pio device monitor -e esp32-bench | tee bench.log
+  python3 tools/bench_check.py bench.log --write-baseline bench_baseline.json
+  python3 tools/bench_check.py bench.log --baseline bench_baseline.json
+
+O gerador de carga (CONFIG_LOADGEN_MODE, src/bench/loadgen.h) usa o mesmo
+formato, na suíte "loadgen"; compare execuções contra o mesmo broker.
+
+Sem --baseline, imprime os resultados em JSON. Com --baseline, compara cada
+métrica com a referência e termina com código 1 se alguma piorar mais que
+--tolerance por cento, se um caso da referência faltar ou se uma suíte não
+terminar (o firmware travou ou reiniciou no meio).
+"""
+
+import argparse
+import json
+import sys
+
+RESULT_PREFIX = "BENCH "
+DONE_PREFIX = "BENCH_DONE "
+
+# Métricas em que valor maior é melhor; nas demais, menor é melhor
+HIGHER_IS_BETTER = {"free_heap", "min_free_heap", "largest_block", "delivered",
+                    "connected", "target_msgs_s", "msgs_s", "acked_msgs_s",
+                    "bytes_s"}
+
+# Métricas que não devem variar: qualquer aumento é regressão
+EXACT = {"failures", "dropped"}
+
+
+def higher_is_better(metric):
+    return metric in HIGHER_IS_BETTER or metric.endswith("_stack_free")
+
+
+def parse_log(lines):
+    """Retorna ({"suite/case": {métrica: valor}}, {suítes concluídas})."""
+    results = {}
+    done = set()
+
+    for line in lines:
+        # O monitor pode acrescentar cores ou prefixos antes da linha
+        for prefix, kind in ((DONE_PREFIX, "done"), (RESULT_PREFIX, "result")):
+            pos = line.find(prefix)
+            if pos < 0:
+                continue
+            try:
+                record = json.loads(line[pos + len(prefix):].strip())
+            except json.JSONDecodeError:
+                break
+            if kind == "done":
+                done.add(record["suite"])
+            else:
+                key = f'{record.pop("suite")}/{record.pop("case")}'
+                results[key] = record
+            break
+
+    return results, done
+
+
+def compare(results, done, baseline, tolerance):
+    """Retorna a lista de regressões encontradas."""
+    problems = []
+
+    suites = {key.split("/", 1)[0] for key in baseline}
+    for suite in sorted(suites - done):
+        problems.append(f"suite '{suite}' nao terminou")
+
+    for key, reference in sorted(baseline.items()):
+        current = results.get(key)
+        if current is None:
+            problems.append(f"{key}: ausente")
+            continue
+
+        for metric, ref in reference.items():
+            value = current.get(metric)
+            if value is None:
+                problems.append(f"{key}.{metric}: ausente")
+                continue
+
+            if metric in EXACT:
+                worse = value > ref
+            elif higher_is_better(metric):
+                worse = value < ref * (1 - tolerance / 100.0)
+            else:
+                worse = value > ref * (1 + tolerance / 100.0)
+
+            if worse:
+                problems.append(f"{key}.{metric}: {value} (referencia {ref})")
+
+    return problems
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("log", nargs="?", help="log do monitor serial (padrao: stdin)")
+    parser.add_argument("--baseline", help="referencia gerada com --write-baseline")
+    parser.add_argument("--write-baseline", metavar="ARQUIVO",
+                        help="grava os resultados como nova referencia")
+    parser.add_argument("--tolerance", type=float, default=10.0,
+                        help="piora tolerada em %% (padrao: 10)")
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log, encoding="utf-8", errors="replace") as f:
+            results, done = parse_log(f)
+    else:
+        results, done = parse_log(sys.stdin)
+
+    if not results:
+        print("nenhuma linha BENCH encontrada", file=sys.stderr)
+        return 1
+
+    if args.write_baseline:
+        with open(args.write_baseline, "w", encoding="utf-8") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+            f.write("\n")
+
+    if not args.baseline:
+        json.dump(results, sys.stdout, indent=2, sort_keys=True)
+        print()
+        return 0
+
+    with open(args.baseline, encoding="utf-8") as f:
+        baseline = json.load(f)
+
+    problems = compare(results, done, baseline, args.tolerance)
+    for problem in problems:
+        print(f"REGRESSAO {problem}")
+
+    print(f"{len(results)} resultados, {len(problems)} regressoes")
+    return 1 if problems else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
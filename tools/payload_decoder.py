@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+"""
+Decodificador dos payloads de telemetria e health check publicados pelo firmware.
+
+Formatos (ver src/services/payload_codec.h):
+  - sem sufixo  -> JSON
+  - "/cbor"     -> CBOR (mapa com chaves inteiras, lote = array indefinido)
+  - "/bin"      -> registros PACKED little-endian concatenados
+
+Uso com o mosquitto:
+  mosquitto_sub -h <broker> -t 'demo/central/#' -v -F '%t %x' | python3 tools/payload_decoder.py
+
+Cada linha de entrada deve conter o tópico e o payload em hexadecimal.
+"""
+
+import json
+import struct
+import sys
+
+# Versões de esquema conhecidas por tipo de mensagem
+TELEMETRY_VERSIONS = {1}
+HEALTH_VERSIONS = {1, 2, 3, 4, 5}
+
+TELEMETRY_CBOR_KEYS = {
+    0: "versao",
+    1: "temperatura",
+    2: "umidade",
+    3: "contador",
+    4: "timestamp",
+}
+
+HEALTH_CBOR_KEYS = {
+    0: "versao",
+    1: "free_heap",
+    2: "min_free_heap",
+    3: "wifi_rssi",
+    4: "uptime_sec",
+    5: "mqtt_connected",
+    6: "msgs_sent",
+    7: "msgs_received",
+    8: "mqtt_failures",
+    9: "disconnects",
+    10: "power_mode",
+    11: "current_ua",
+    12: "inflight",
+    13: "ack_min_us",
+    14: "ack_avg_us",
+    15: "ack_p99_us",
+    16: "ack_timeouts",
+    17: "ttfp_ms",
+    18: "ttfp_max_ms",
+    19: "connect_ms",
+    20: "connect_max_ms",
+    21: "connect_heap_peak",
+}
+
+PACKED_TELEMETRY = struct.Struct("<cBhHIQ")  # 18 bytes
+PACKED_HEALTH = {
+    1: struct.Struct("<cBIIbBIIIII"),  # 32 bytes
+    2: struct.Struct("<cBIIbBIIIIIBI"),  # 37 bytes
+    3: struct.Struct("<cBIIbBIIIIIBIHIIII"),  # 55 bytes
+    4: struct.Struct("<cBIIbBIIIIIBIHIIIIII"),  # 63 bytes
+    5: struct.Struct("<cBIIbBIIIIIBIHIIIIIIIII"),  # 75 bytes
+}
+
+
+# -----------------------------------------------------------------------------
+# CBOR (subconjunto usado pelo firmware)
+# -----------------------------------------------------------------------------
+
+_BREAK = object()
+
+
+def _cbor_item(data, pos):
+    initial = data[pos]
+    pos += 1
+    major = initial >> 5
+    info = initial & 0x1F
+
+    if major == 7:
+        if info == 20:
+            return False, pos
+        if info == 21:
+            return True, pos
+        if info == 22:
+            return None, pos
+        if info == 26:
+            return struct.unpack(">f", data[pos:pos + 4])[0], pos + 4
+        if info == 27:
+            return struct.unpack(">d", data[pos:pos + 8])[0], pos + 8
+        if info == 31:
+            return _BREAK, pos
+        raise ValueError(f"valor simples CBOR nao suportado: {info}")
+
+    if info < 24:
+        value = info
+    elif info in (24, 25, 26, 27):
+        size = 1 << (info - 24)
+        value = int.from_bytes(data[pos:pos + size], "big")
+        pos += size
+    elif info == 31:
+        value = None
+    else:
+        raise ValueError(f"informacao adicional CBOR invalida: {info}")
+
+    if major == 0:
+        return value, pos
+    if major == 1:
+        return -1 - value, pos
+    if major in (2, 3):
+        raw = data[pos:pos + value]
+        return (raw if major == 2 else raw.decode("utf-8")), pos + value
+    if major == 4:
+        items = []
+        while value is None or len(items) < value:
+            item, pos = _cbor_item(data, pos)
+            if item is _BREAK:
+                break
+            items.append(item)
+        return items, pos
+    if major == 5:
+        result = {}
+        while value is None or len(result) < value:
+            key, pos = _cbor_item(data, pos)
+            if key is _BREAK:
+                break
+            result[key], pos = _cbor_item(data, pos)
+        return result, pos
+
+    raise ValueError(f"tipo CBOR nao suportado: {major}")
+
+
+def cbor_decode(data):
+    value, pos = _cbor_item(data, 0)
+    if pos != len(data):
+        raise ValueError(f"{len(data) - pos} bytes sobrando apos o item CBOR")
+    return value
+
+
+def _rename(record, keys):
+    return {keys.get(k, k): v for k, v in record.items()}
+
+
+# -----------------------------------------------------------------------------
+# PACKED
+# -----------------------------------------------------------------------------
+
+
+def _packed_telemetry(chunk):
+    _, ver, temp, hum, contador, ts = PACKED_TELEMETRY.unpack(chunk)
+    return {
+        "versao": ver,
+        "temperatura": temp / 100.0,
+        "umidade": hum / 100.0,
+        "contador": contador,
+        "timestamp": ts,
+    }
+
+
+def _packed_health(chunk):
+    fields = PACKED_HEALTH[chunk[1]].unpack(chunk)
+    (_, ver, free_heap, min_free, rssi, flags, uptime,
+     sent, recv, failures, disconnects) = fields[:11]
+    record = {
+        "versao": ver,
+        "free_heap": free_heap,
+        "min_free_heap": min_free,
+        "wifi_rssi": rssi,
+        "uptime_sec": uptime,
+        "mqtt_connected": bool(flags & 0x01),
+        "msgs_sent": sent,
+        "msgs_received": recv,
+        "mqtt_failures": failures,
+        "disconnects": disconnects,
+    }
+    if ver >= 2:
+        record["power_mode"], record["current_ua"] = fields[11:13]
+    if ver >= 3:
+        (record["inflight"], record["ack_min_us"], record["ack_avg_us"],
+         record["ack_p99_us"], record["ack_timeouts"]) = fields[13:18]
+    if ver >= 4:
+        record["ttfp_ms"], record["ttfp_max_ms"] = fields[18:20]
+    if ver >= 5:
+        (record["connect_ms"], record["connect_max_ms"],
+         record["connect_heap_peak"]) = fields[20:23]
+    return record
+
+
+def packed_decode(data):
+    records = []
+    pos = 0
+    while pos < len(data):
+        kind = data[pos:pos + 1]
+        if kind == b"T":
+            layout, decoder = PACKED_TELEMETRY, _packed_telemetry
+        elif kind == b"H":
+            ver = data[pos + 1] if pos + 1 < len(data) else None
+            if ver not in PACKED_HEALTH:
+                raise ValueError(f"versao de health PACKED desconhecida: {ver}")
+            layout, decoder = PACKED_HEALTH[ver], _packed_health
+        else:
+            raise ValueError(f"registro PACKED desconhecido: {kind!r}")
+
+        chunk = data[pos:pos + layout.size]
+        if len(chunk) < layout.size:
+            raise ValueError("registro PACKED truncado")
+        records.append(decoder(chunk))
+        pos += layout.size
+    return records
+
+
+# -----------------------------------------------------------------------------
+# Interface
+# -----------------------------------------------------------------------------
+
+
+def decode(topic, payload):
+    """Decodifica um payload conforme o sufixo do tópico."""
+    if topic.endswith("/bin"):
+        records = packed_decode(payload)
+    elif topic.endswith("/cbor"):
+        value = cbor_decode(payload)
+        items = value if isinstance(value, list) else [value]
+        keys = HEALTH_CBOR_KEYS if "/health" in topic else TELEMETRY_CBOR_KEYS
+        records = [_rename(item, keys) for item in items]
+    else:
+        value = json.loads(payload.decode("utf-8"))
+        records = value if isinstance(value, list) else [value]
+
+    known = HEALTH_VERSIONS if "/health" in topic else TELEMETRY_VERSIONS
+    for record in records:
+        ver = record.get("versao")
+        if ver is not None and ver not in known:
+            print(f"[aviso] versao de esquema {ver} desconhecida", file=sys.stderr)
+    return records
+
+
+def main():
+    for line in sys.stdin:
+        line = line.strip()
+        if not line:
+            continue
+        try:
+            topic, hex_payload = line.split(" ", 1)
+            records = decode(topic, bytes.fromhex(hex_payload))
+        except ValueError as exc:
+            print(f"[erro] {line[:60]}: {exc}", file=sys.stderr)
+            continue
+        for record in records:
+            print(f"{topic} {json.dumps(record, ensure_ascii=False)}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())